@@ -7,6 +7,12 @@
 
 //#define ENABLE_IMAGE_2D_INPUT 0
 
+/*
+ * THUMBNAIL_BIN, 0 writes the planar bayer for the rest of the pipe;
+ * 2 or 4 writes an RGBA thumbnail instead, one pixel per 2x2 or 4x4
+ * bayer pixels, with the same blc, wb and gamma as the stats.
+ */
+
 /*
  * GROUP_PIXEL_X_SIZE = 2 * GROUP_CELL_X_SIZE
  * GROUP_PIXEL_Y_SIZE = 2 * GROUP_CELL_Y_SIZE
@@ -56,6 +62,17 @@ inline void gamma_correct(float8 *in_out, __global float *table)
     in_out->s7 = table[clamp(convert_int(in_out->s7 * 255.0f), 0, 255)];
 }
 
+inline float4 gamma_correct_float4 (float4 in, __global float *table)
+{
+    return (float4) (
+               table[clamp(convert_int(in.s0 * 255.0f), 0, 255)],
+               table[clamp(convert_int(in.s1 * 255.0f), 0, 255)],
+               table[clamp(convert_int(in.s2 * 255.0f), 0, 255)],
+               table[clamp(convert_int(in.s3 * 255.0f), 0, 255)]);
+}
+
+#define WRITE_THUMBNAIL(i) write_imagef (output, (int2)(thumb_x + i, thumb_y), (float4)(thumb_r.s##i, thumb_g.s##i, thumb_b.s##i, 1.0f))
+
 inline float avg_float8 (float8 data)
 {
     return (data.s0 + data.s1 + data.s2 + data.s3 + data.s4 + data.s5 + data.s6 + data.s7) * 0.125f;
@@ -228,6 +245,53 @@ __kernel void kernel_bayer_basic (
     data_gb = ((__local float8*)slm_gb)[index];
     data_gb = data_gb * wb_config.gb_gain;
 
+#if THUMBNAIL_BIN == 2
+    float8 thumb_r = data_r;
+    float8 thumb_g = (data_gr + data_gb) * 0.5f;
+    float8 thumb_b = data_b;
+    int thumb_x = x * 8;
+    int thumb_y = y;
+
+#if ENABLE_GAMMA
+    gamma_correct (&thumb_r, gamma_table);
+    gamma_correct (&thumb_g, gamma_table);
+    gamma_correct (&thumb_b, gamma_table);
+#endif
+    WRITE_THUMBNAIL (0);
+    WRITE_THUMBNAIL (1);
+    WRITE_THUMBNAIL (2);
+    WRITE_THUMBNAIL (3);
+    WRITE_THUMBNAIL (4);
+    WRITE_THUMBNAIL (5);
+    WRITE_THUMBNAIL (6);
+    WRITE_THUMBNAIL (7);
+
+#elif THUMBNAIL_BIN == 4
+    // even cell rows add the row below, group rows come in pairs
+    if (y % 2 == 0) {
+        int below = index + SLM_X_SIZE / 2;
+        float8 sum_r = mad (((__local float8*)slm_r)[below], wb_config.r_gain, data_r);
+        float8 sum_g = mad (((__local float8*)slm_gr)[below], wb_config.gr_gain, data_gr) +
+                       mad (((__local float8*)slm_gb)[below], wb_config.gb_gain, data_gb);
+        float8 sum_b = mad (((__local float8*)slm_b)[below], wb_config.b_gain, data_b);
+        float4 thumb_r = (sum_r.even + sum_r.odd) * 0.25f;
+        float4 thumb_g = (sum_g.even + sum_g.odd) * 0.125f;
+        float4 thumb_b = (sum_b.even + sum_b.odd) * 0.25f;
+        int thumb_x = x * 4;
+        int thumb_y = y / 2;
+
+#if ENABLE_GAMMA
+        thumb_r = gamma_correct_float4 (thumb_r, gamma_table);
+        thumb_g = gamma_correct_float4 (thumb_g, gamma_table);
+        thumb_b = gamma_correct_float4 (thumb_b, gamma_table);
+#endif
+        WRITE_THUMBNAIL (0);
+        WRITE_THUMBNAIL (1);
+        WRITE_THUMBNAIL (2);
+        WRITE_THUMBNAIL (3);
+    }
+
+#else
 #if ENABLE_GAMMA
     gamma_correct (&data_gr, gamma_table);
     gamma_correct (&data_r, gamma_table);
@@ -250,6 +314,7 @@ __kernel void kernel_bayer_basic (
     write_imageui (output, (int2)(x, y + out_height), as_uint4 (convert_ushort8 (data_r * 65536.0f)));
     write_imageui (output, (int2)(x, y + out_height * 2), as_uint4 (convert_ushort8 (data_b * 65536.0f)));
     write_imageui (output, (int2)(x, y + out_height * 3), as_uint4 (convert_ushort8 (data_gb * 65536.0f)));
+#endif
 
     stats_3a_calculate (slm_gr, slm_r, slm_b, slm_gb, stats_output, &wb_config);
 }
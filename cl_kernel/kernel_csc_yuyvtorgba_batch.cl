@@ -0,0 +1,66 @@
+/*
+ * function: kernel_csc_yuyvtorgba_batch
+ *     kernel_csc_yuyvtorgba for up to 8 streams of the same size,
+ *     global id 2 selects the stream
+ * input0..7:  image2d_t as read only
+ * output0..7: image2d_t as write only
+ * params:     per stream, s0 v to r, s1 u to g, s2 v to g, s3 u to b
+ * count:      streams in this launch
+ */
+
+#define READ_STREAM(i) case i: pixel_in = read_imagef (input##i, sampler, (int2)(x, y)); break;
+#define WRITE_STREAM(i) case i: write_imagef (output##i, (int2)(2 * x, y), pixel_out1); write_imagef (output##i, (int2)(2 * x + 1, y), pixel_out2); break;
+
+__kernel void kernel_csc_yuyvtorgba_batch (
+    __read_only image2d_t input0, __read_only image2d_t input1,
+    __read_only image2d_t input2, __read_only image2d_t input3,
+    __read_only image2d_t input4, __read_only image2d_t input5,
+    __read_only image2d_t input6, __read_only image2d_t input7,
+    __write_only image2d_t output0, __write_only image2d_t output1,
+    __write_only image2d_t output2, __write_only image2d_t output3,
+    __write_only image2d_t output4, __write_only image2d_t output5,
+    __write_only image2d_t output6, __write_only image2d_t output7,
+    __global const float8 *params, uint count)
+{
+    int x = get_global_id (0);
+    int y = get_global_id (1);
+    uint index = get_global_id (2);
+    sampler_t sampler = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_NONE | CLK_FILTER_NEAREST;
+    float4 pixel_in = 0.0f;
+    float4 pixel_out1, pixel_out2;
+
+    if (index >= count)
+        return;
+
+    switch (index) {
+        READ_STREAM (0)
+        READ_STREAM (1)
+        READ_STREAM (2)
+        READ_STREAM (3)
+        READ_STREAM (4)
+        READ_STREAM (5)
+        READ_STREAM (6)
+        READ_STREAM (7)
+    }
+
+    float8 coeff = params[index];
+    pixel_out1.x = pixel_in.x + coeff.s0 * (pixel_in.w - 0.5);
+    pixel_out1.y = pixel_in.x - coeff.s1 * (pixel_in.y - 0.5) - coeff.s2 * (pixel_in.w - 0.5);
+    pixel_out1.z = pixel_in.x + coeff.s3 * (pixel_in.y - 0.5);
+    pixel_out1.w = 0.0;
+    pixel_out2.x = pixel_in.z + coeff.s0 * (pixel_in.w - 0.5);
+    pixel_out2.y = pixel_in.z - coeff.s1 * (pixel_in.y - 0.5) - coeff.s2 * (pixel_in.w - 0.5);
+    pixel_out2.z = pixel_in.z + coeff.s3 * (pixel_in.y - 0.5);
+    pixel_out2.w = 0.0;
+
+    switch (index) {
+        WRITE_STREAM (0)
+        WRITE_STREAM (1)
+        WRITE_STREAM (2)
+        WRITE_STREAM (3)
+        WRITE_STREAM (4)
+        WRITE_STREAM (5)
+        WRITE_STREAM (6)
+        WRITE_STREAM (7)
+    }
+}
@@ -0,0 +1,83 @@
+/*
+ * function: kernel_lut3d
+ *     whole color chain (color matrix, macc, gamma, csc) in one 3D lut lookup
+ * input:    image2d_t as read only, RGB48 planar as the yuv pipe reads it,
+ *           8 pixels of 16 bits each texel, g and b planes below r
+ * output_y, output_uv: image2d_t as write only, nv12 planes, 8 pixels each texel,
+ *           uv averaged on 2x2
+ * plannar_offset: rows of one input plane
+ * lut:      baked table, entry (r, g, b) at (b * lut_size + g) * lut_size + r
+ * lut_size: entries of each axis
+ * tetrahedral: 0, trilinear; otherwise tetrahedral interpolation
+ */
+
+float4 lut3d_sample (__global const float4 *lut, uint lut_size, uint tetrahedral, float4 color)
+{
+    float4 pos = clamp (color, 0.0f, 1.0f) * (float)(lut_size - 1);
+    uint4 index = min (convert_uint4 (pos), (uint4)(lut_size - 2));
+    float4 f = pos - convert_float4 (index);
+    uint stride_g = lut_size;
+    uint stride_b = lut_size * lut_size;
+    __global const float4 *c000 = lut + index.z * stride_b + index.y * stride_g + index.x;
+
+    if (tetrahedral == 0) {
+        float4 c00 = mix (c000[0], c000[1], f.x);
+        float4 c10 = mix (c000[stride_g], c000[stride_g + 1], f.x);
+        float4 c01 = mix (c000[stride_b], c000[stride_b + 1], f.x);
+        float4 c11 = mix (c000[stride_b + stride_g], c000[stride_b + stride_g + 1], f.x);
+        return mix (mix (c00, c10, f.y), mix (c01, c11, f.y), f.z);
+    }
+
+    // walk from c000 to c111 along the axes in order of decreasing fraction
+    uint s0 = 1, s1 = stride_g, s2 = stride_b, st;
+    float f0 = f.x, f1 = f.y, f2 = f.z, ft;
+    if (f0 < f1) {
+        ft = f0; f0 = f1; f1 = ft;
+        st = s0; s0 = s1; s1 = st;
+    }
+    if (f1 < f2) {
+        ft = f1; f1 = f2; f2 = ft;
+        st = s1; s1 = s2; s2 = st;
+    }
+    if (f0 < f1) {
+        ft = f0; f0 = f1; f1 = ft;
+        st = s0; s0 = s1; s1 = st;
+    }
+
+    return c000[0] * (1.0f - f0) + c000[s0] * (f0 - f1) +
+           c000[s0 + s1] * (f1 - f2) + c000[s0 + s1 + s2] * f2;
+}
+
+__kernel void kernel_lut3d (
+    __read_only image2d_t input, __write_only image2d_t output_y, __write_only image2d_t output_uv,
+    uint plannar_offset, __global const float4 *lut, uint lut_size, uint tetrahedral)
+{
+    int x = get_global_id (0);
+    int y = get_global_id (1);
+    sampler_t sampler = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_NONE | CLK_FILTER_NEAREST;
+    float in_r[16], in_g[16], in_b[16];
+    float out_y[16], out_uv[8];
+
+    for (int row = 0; row < 2; ++row) {
+        int in_y = 2 * y + row;
+        vstore8 (convert_float8 (as_ushort8 (read_imageui (input, sampler, (int2)(x, in_y)))) / 65535.0f, row, in_r);
+        vstore8 (convert_float8 (as_ushort8 (read_imageui (input, sampler, (int2)(x, in_y + plannar_offset)))) / 65535.0f, row, in_g);
+        vstore8 (convert_float8 (as_ushort8 (read_imageui (input, sampler, (int2)(x, in_y + plannar_offset * 2)))) / 65535.0f, row, in_b);
+    }
+
+    for (int i = 0; i < 8; i += 2) {
+        float4 sum = (float4)(0.0f);
+        for (int k = 0; k < 4; ++k) {
+            int p = (k >> 1) * 8 + i + (k & 1);
+            float4 yuv = lut3d_sample (lut, lut_size, tetrahedral, (float4)(in_r[p], in_g[p], in_b[p], 0.0f));
+            out_y[p] = yuv.x;
+            sum += yuv;
+        }
+        out_uv[i] = sum.y * 0.25f;
+        out_uv[i + 1] = sum.z * 0.25f;
+    }
+
+    write_imageui (output_y, (int2)(x, 2 * y), convert_uint4 (as_ushort4 (convert_uchar8_sat (vload8 (0, out_y) * 255.0f))));
+    write_imageui (output_y, (int2)(x, 2 * y + 1), convert_uint4 (as_ushort4 (convert_uchar8_sat (vload8 (1, out_y) * 255.0f))));
+    write_imageui (output_uv, (int2)(x, y), convert_uint4 (as_ushort4 (convert_uchar8_sat (vload8 (0, out_uv) * 255.0f))));
+}
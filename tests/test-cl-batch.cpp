@@ -0,0 +1,207 @@
+/*
+ * test-cl-batch.cpp - benchmark batched csc launches of several streams
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#include "test_common.h"
+#include "cl_device.h"
+#include "cl_context.h"
+#include "cl_csc_handler.h"
+#include "cl_batch_launcher.h"
+#include "drm_bo_buffer.h"
+#include "xcam_thread.h"
+#include <getopt.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <vector>
+
+/*
+ * N streams, one thread and one YUYV to RGBA csc handler each, all
+ * converting their frames as fast as they can. Runs once launching
+ * every stream alone and once through a shared CLBatchLauncher, then
+ * prints the aggregate frame rate of both.
+ */
+
+using namespace XCam;
+
+static double
+now_ms ()
+{
+    struct timeval tv;
+    gettimeofday (&tv, NULL);
+    return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+}
+
+class StreamThread
+    : public Thread
+{
+public:
+    StreamThread (
+        const SmartPtr<CLImageHandler> &handler, const SmartPtr<DrmBoBuffer> &input, uint32_t frames)
+        : Thread ("cl_batch_stream")
+        , _handler (handler)
+        , _input (input)
+        , _frames (frames)
+        , _done (0)
+        , _ret (XCAM_RETURN_NO_ERROR)
+    {}
+
+    XCamReturn get_result () const {
+        return _ret;
+    }
+
+protected:
+    virtual bool loop () {
+        SmartPtr<DrmBoBuffer> output;
+
+        _ret = _handler->execute (_input, output);
+        if (_ret != XCAM_RETURN_NO_ERROR || ++_done >= _frames) {
+            // leave the batch, the others must not wait for this stream
+            _handler->emit_stop ();
+            return false;
+        }
+        return true;
+    }
+
+private:
+    SmartPtr<CLImageHandler>  _handler;
+    SmartPtr<DrmBoBuffer>     _input;
+    uint32_t                  _frames;
+    uint32_t                  _done;
+    XCamReturn                _ret;
+};
+
+static double
+run_streams (
+    SmartPtr<CLContext> &context, const SmartPtr<CLBatchLauncher> &launcher,
+    const SmartPtr<DrmBoBuffer> &input, uint32_t streams, uint32_t frames)
+{
+    std::vector<SmartPtr<StreamThread> > threads;
+
+    for (uint32_t i = 0; i < streams; ++i) {
+        SmartPtr<CLImageHandler> handler = create_cl_csc_image_handler (context, CL_CSC_TYPE_YUYVTORGBA);
+        SmartPtr<CLCscImageHandler> csc = handler.dynamic_cast_ptr<CLCscImageHandler> ();
+        CHECK_DECLARE (ERROR, csc.ptr (), return -1.0, "create csc handler failed");
+        if (launcher.ptr ()) {
+            CHECK_DECLARE (
+                ERROR, csc->set_batch_launcher (launcher),
+                return -1.0, "set batch launcher failed");
+        }
+        csc->set_pool_type (CLImageHandler::DrmBoPoolType);
+        threads.push_back (new StreamThread (handler, input, frames));
+    }
+
+    double start = now_ms ();
+    for (uint32_t i = 0; i < streams; ++i)
+        threads[i]->start ();
+    for (uint32_t i = 0; i < streams; ++i) {
+        while (threads[i]->is_running ())
+            usleep (1000);
+    }
+    context->finish ();
+    double elapsed = now_ms () - start;
+
+    for (uint32_t i = 0; i < streams; ++i) {
+        CHECK_DECLARE (
+            ERROR, threads[i]->get_result () == XCAM_RETURN_NO_ERROR,
+            return -1.0, "stream(%d) execute failed", i);
+    }
+    return elapsed;
+}
+
+static void
+print_help (const char *bin_name)
+{
+    printf ("Usage: %s [-n streams] [-w width] [-h height] [-f frames] [-t wait]\n"
+            "\t -n streams    stream count, default 8\n"
+            "\t -w width      frame width, default 640\n"
+            "\t -h height     frame height, default 480\n"
+            "\t -f frames     frames per stream, default 300\n"
+            "\t -t wait       batch wait time in us, default %d\n"
+            "\t -H            help\n"
+            , bin_name, XCAM_CL_BATCH_DEFAULT_WAIT_US);
+}
+
+int main (int argc, char *argv[])
+{
+    uint32_t streams = 8;
+    uint32_t width = 640, height = 480;
+    uint32_t frames = 300;
+    uint32_t wait_us = XCAM_CL_BATCH_DEFAULT_WAIT_US;
+    int opt;
+
+    while ((opt = getopt (argc, argv, "n:w:h:f:t:H")) != -1) {
+        switch (opt) {
+        case 'n':
+            streams = atoi (optarg);
+            break;
+        case 'w':
+            width = atoi (optarg);
+            break;
+        case 'h':
+            height = atoi (optarg);
+            break;
+        case 'f':
+            frames = atoi (optarg);
+            break;
+        case 't':
+            wait_us = atoi (optarg);
+            break;
+        case 'H':
+            print_help (argv[0]);
+            return 0;
+        default:
+            print_help (argv[0]);
+            return -1;
+        }
+    }
+    if (!streams || !width || !height || !frames) {
+        print_help (argv[0]);
+        return -1;
+    }
+
+    SmartPtr<CLContext> context = CLDevice::instance ()->get_context ();
+    CHECK_EXP (context.ptr (), "get cl context failed");
+
+    VideoBufferInfo input_info;
+    input_info.init (V4L2_PIX_FMT_YUYV, width, height);
+    SmartPtr<DrmDisplay> display = DrmDisplay::instance ();
+    SmartPtr<DrmBoBufferPool> buf_pool = new DrmBoBufferPool (display);
+    buf_pool->set_video_info (input_info);
+    CHECK_EXP (buf_pool->reserve (2), "init buffer pool failed");
+
+    SmartPtr<BufferProxy> tmp_buf = buf_pool->get_buffer (buf_pool);
+    SmartPtr<DrmBoBuffer> input = tmp_buf.dynamic_cast_ptr<DrmBoBuffer> ();
+    CHECK_EXP (input.ptr (), "get input buffer failed");
+
+    SmartPtr<CLBatchLauncher> launcher = new CLBatchLauncher ();
+    launcher->set_wait_time (wait_us);
+
+    double alone_ms = run_streams (context, NULL, input, streams, frames);
+    double batch_ms = run_streams (context, launcher, input, streams, frames);
+    if (alone_ms < 0.0 || batch_ms < 0.0) {
+        printf ("cl batch test FAILED\n");
+        return -1;
+    }
+
+    printf ("%d streams %dx%d, %d frames each\n", streams, width, height, frames);
+    printf ("launch alone:  %8.1f fps\n", streams * frames * 1000.0 / alone_ms);
+    printf ("launch batch:  %8.1f fps\n", streams * frames * 1000.0 / batch_ms);
+    printf ("cl batch test PASSED\n");
+    return 0;
+}
@@ -0,0 +1,203 @@
+/*
+ * test-cpf-reader.cpp - benchmark cpf reading against the shared mapping
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#include "test_common.h"
+#include "xcam_cpf_reader.h"
+#include "cpf_map.h"
+#include <getopt.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <vector>
+
+/*
+ * init time of the AIQ record: xcam_cpf_read against CpfMap.
+ * cold runs drop the file from the page cache first (best effort, clean
+ * pages only), warm runs repeat with the file cached and, for CpfMap,
+ * the map shared in process. The generated file is on a writable
+ * filesystem, so CpfMap copies it rather than mapping it.
+ */
+
+using namespace XCam;
+
+#define GENERATED_CPF_FILE "/tmp/test-cpf-reader.cpf"
+
+static double
+now_ms ()
+{
+    struct timeval tv;
+    gettimeofday (&tv, NULL);
+    return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+}
+
+static bool
+add_record (std::vector<uint8_t> &cpf, size_t &size, tbd_class_t record_class, uint32_t record_size)
+{
+    std::vector<uint8_t> record (record_size);
+    for (uint32_t i = 0; i < record_size; ++i)
+        record[i] = (i * 31 + record_class) & 0xff;
+
+    cpf.resize (size + record_size + sizeof (tbd_record_header_t));
+    return tbd_insert_record (
+               &cpf[0], cpf.size (), record_class, tbd_format_any,
+               &record[0], record_size, &size) == tbd_err_none;
+}
+
+static bool
+generate_cpf (const char *path, uint32_t aiq_size)
+{
+    std::vector<uint8_t> cpf (sizeof (tbd_header_t));
+    size_t size = 0;
+
+    CHECK_DECLARE (
+        ERROR, tbd_create (&cpf[0], cpf.size (), tbd_tag_cpff, &size) == tbd_err_none,
+        return false, "tbd create failed");
+    CHECK_DECLARE (
+        ERROR,
+        add_record (cpf, size, tbd_class_drv, 64 * 1024) &&
+        add_record (cpf, size, tbd_class_aiq, aiq_size) &&
+        add_record (cpf, size, tbd_class_hal, 256 * 1024),
+        return false, "tbd insert record failed");
+
+    FILE *fp = fopen (path, "wb");
+    CHECK_DECLARE (ERROR, fp, return false, "open %s failed", path);
+    bool ok = (fwrite (&cpf[0], 1, size, fp) == size);
+    ok = (fflush (fp) == 0) && ok;
+    ok = (fsync (fileno (fp)) == 0) && ok;
+    fclose (fp);
+    return ok;
+}
+
+static void
+drop_page_cache (const char *path)
+{
+    int fd = open (path, O_RDONLY);
+    if (fd < 0)
+        return;
+    posix_fadvise (fd, 0, 0, POSIX_FADV_DONTNEED);
+    close (fd);
+}
+
+static double
+read_legacy (const char *path, std::vector<uint8_t> *copy)
+{
+    XCamCpfBlob *blob = xcam_cpf_blob_new ();
+    double start = now_ms ();
+    boolean ret = xcam_cpf_read (path, blob, NULL);
+    double elapsed = now_ms () - start;
+
+    if (ret && copy)
+        copy->assign (blob->data, blob->data + blob->size);
+    xcam_cpf_blob_free (blob);
+    return ret ? elapsed : -1.0;
+}
+
+static double
+read_map (const char *path, std::vector<uint8_t> *copy)
+{
+    const uint8_t *data = NULL;
+    uint32_t size = 0;
+
+    double start = now_ms ();
+    SmartPtr<CpfMap> map = CpfMap::open (path);
+    bool ret = map.ptr () && map->get_record (tbd_class_aiq, data, size);
+    double elapsed = now_ms () - start;
+
+    if (ret && copy)
+        copy->assign (data, data + size);
+    return ret ? elapsed : -1.0;
+}
+
+static void
+print_help (const char *bin_name)
+{
+    printf ("Usage: %s [-i cpf] [-s size] [-n rounds]\n"
+            "\t -i cpf       cpf file to read, default generate %s\n"
+            "\t -s size      AIQ record size of the generated file in KB, default 4096\n"
+            "\t -n rounds    warm rounds, default 20\n"
+            "\t -h           help\n"
+            , bin_name, GENERATED_CPF_FILE);
+}
+
+int main (int argc, char *argv[])
+{
+    const char *path = NULL;
+    uint32_t aiq_size = 4096 * 1024;
+    uint32_t rounds = 20;
+    int opt;
+
+    while ((opt = getopt (argc, argv, "i:s:n:h")) != -1) {
+        switch (opt) {
+        case 'i':
+            path = optarg;
+            break;
+        case 's':
+            aiq_size = atoi (optarg) * 1024;
+            break;
+        case 'n':
+            rounds = atoi (optarg);
+            break;
+        case 'h':
+            print_help (argv[0]);
+            return 0;
+        default:
+            print_help (argv[0]);
+            return -1;
+        }
+    }
+    if (!aiq_size || !rounds) {
+        print_help (argv[0]);
+        return -1;
+    }
+
+    if (!path) {
+        path = GENERATED_CPF_FILE;
+        CHECK_EXP (generate_cpf (path, aiq_size), "generate cpf %s failed", path);
+    }
+
+    std::vector<uint8_t> legacy_record, map_record;
+
+    drop_page_cache (path);
+    double legacy_cold = read_legacy (path, &legacy_record);
+    double legacy_warm = 0.0;
+    for (uint32_t i = 0; i < rounds; ++i)
+        legacy_warm += read_legacy (path, NULL);
+
+    CpfMap::clear_cache ();
+    drop_page_cache (path);
+    double map_cold = read_map (path, &map_record);
+    double map_warm = 0.0;
+    for (uint32_t i = 0; i < rounds; ++i)
+        map_warm += read_map (path, NULL);
+    CpfMap::clear_cache ();
+
+    CHECK_EXP (legacy_cold >= 0.0 && map_cold >= 0.0, "read cpf %s failed", path);
+
+    printf ("cpf %s, AIQ record %d bytes\n", path, (uint32_t)legacy_record.size ());
+    printf ("xcam_cpf_read  cold: %8.3fms  warm: %8.3fms\n", legacy_cold, legacy_warm / rounds);
+    printf ("CpfMap         cold: %8.3fms  warm: %8.3fms\n", map_cold, map_warm / rounds);
+
+    if (legacy_record != map_record) {
+        printf ("cpf reader test FAILED, AIQ records differ\n");
+        return -1;
+    }
+    printf ("cpf reader test PASSED\n");
+    return 0;
+}
@@ -22,8 +22,11 @@
 #include "atomisp_device.h"
 #include "uvc_device.h"
 #include "fake_v4l2_device.h"
+#include "sim_sensor.h"
 #include "isp_controller.h"
 #include "isp_image_processor.h"
+#include "soft_image_processor.h"
+#include "soft_csc_handler.h"
 #include "x3a_analyzer_simple.h"
 #if HAVE_IA_AIQ
 #include "x3a_analyzer_aiq.h"
@@ -35,6 +38,7 @@
 #include "cl_csc_image_processor.h"
 #include "cl_hdr_handler.h"
 #include "cl_tnr_handler.h"
+#include "cl_profile_selector.h"
 #endif
 #if HAVE_LIBDRM
 #include "drm_display.h"
@@ -47,12 +51,16 @@
 #include <signal.h>
 #include <stdlib.h>
 #include <string>
+#include <vector>
 #include <getopt.h>
+#include <sys/time.h>
 #include "test_common.h"
 
 using namespace XCam;
 
 #define IMX185_WDR_CPF "/etc/atomisp/imx185_wdr.cpf"
+#define DEFAULT_QUALITY_RANKING \
+    "cl_handler_newwavelet_denoise,cl_handler_wavelet_denoise,cl_handler_retinex,cl_handler_tnr"
 
 static Mutex g_mutex;
 static Cond  g_cond;
@@ -72,9 +80,6 @@ public:
         , _frame_save (0)
         , _enable_display (false)
     {
-#if HAVE_LIBDRM
-        _display = DrmDisplay::instance();
-#endif
         XCAM_OBJ_PROFILING_INIT;
     }
 
@@ -104,6 +109,11 @@ public:
 
     void enable_display(bool value) {
         _enable_display = value;
+#if HAVE_LIBDRM
+        // drm is only opened when displaying
+        if (value)
+            _display = DrmDisplay::instance();
+#endif
     }
 
     void set_display_mode(DrmDisplayMode mode) {
@@ -296,15 +306,20 @@ void print_help (const char *bin_name)
             "\t               specify [/dev/video4, /dev/video5] depending on which node USB camera is attached\n"
             "\t --resolution  specify the resolution of usb camera\n"
             "\t               select from [1920x1080, 1280x720 ...], default is [1920x1080]\n"
+            "\t --soft-csc    convert usb camera YUYV/UYVY frames to NV12 on cpu\n"
             "\t -e display_mode    preview mode\n"
             "\t                select from [primary, overlay], default is [primary]\n"
             "\t --sync        set analyzer in sync mode\n"
+            "\t --motion      detect motion on 3a statistics grids\n"
+            "\t --restart num stop and start the stream num times, 2s apart, print the latency\n"
             "\t -r raw_input  specify the path of raw image as fake source instead of live camera\n"
+            "\t --sim fps     use a synthetic sensor at fps as source instead of live camera\n"
             "\t -h            help\n"
 #if HAVE_LIBCL
             "CL features:\n"
             "\t --capture capture_stage      specify the capture stage of image\n"
-            "\t               capture_stage select from [bayer, tonemapping], default is [tonemapping]\n"
+            "\t               capture_stage select from [bayer, tonemapping, stats], default is [tonemapping]\n"
+            "\t               stats outputs 3a stats and a 4x4 binned RGBA thumbnail only, no cl post processing\n"
             "\t --hdr         specify hdr type, default is hdr off\n"
             "\t               select from [rgb, lab]\n"
             "\t --tnr         specify temporal noise reduction type, default is tnr off\n"
@@ -316,15 +331,24 @@ void print_help (const char *bin_name)
             "\t --enable-ee   enable YEENR\n"
             "\t --enable-bnr  enable bayer noise reduction\n"
             "\t --enable-dpc  enable defect pixel correction\n"
+            "\t --enable-lut3d  3D LUT color stage instead of the yuv pipe, no yuv tnr\n"
             "\t --enable-retinex  enable retinex\n"
             "\t --wavelet-mode  specify wavelet mode\n"
             "\t --pipeline    pipe mode\n"
             "\t               select from [basic, advance, extreme], default is [basic]\n"
             "\t --disable-post disable cl post image processor\n"
+            "\t --enable-dvs  enable digital video stabilization in cl post image processor\n"
+            "\t --target-fps fps  switch optional cl handlers by measured cost to keep fps\n"
+            "\t --quality names   handlers the target fps may switch, best first, comma separated\n"
+            "\t                   default is [%s]\n"
             "(e.g.: xxxx --hdr=xx --tnr=xx --tnr-level=xx --bilateral --enable-snr --enable-ee --enable-bnr --enable-dpc)\n\n"
 #endif
             , bin_name
-            , DEFAULT_SAVE_FILE_NAME);
+            , DEFAULT_SAVE_FILE_NAME
+#if HAVE_LIBCL
+            , DEFAULT_QUALITY_RANKING
+#endif
+           );
 }
 
 int main (int argc, char *argv[])
@@ -340,9 +364,6 @@ int main (int argc, char *argv[])
     SmartPtr<ImageProcessor> isp_processor;
     AnalyzerType  analyzer_type = AnalyzerTypeSimple;
     DrmDisplayMode display_mode = DRM_DISPLAY_MODE_PRIMARY;
-#if HAVE_LIBDRM
-    SmartPtr<DrmDisplay> drm_disp = DrmDisplay::instance();
-#endif
 
 #if HAVE_LIBCL
     SmartPtr<CL3aImageProcessor> cl_processor;
@@ -352,9 +373,12 @@ int main (int argc, char *argv[])
     uint32_t denoise_type = 0;
     uint8_t tnr_level = 0;
     bool dpc_type = false;
+    bool lut3d_type = false;
     CL3aImageProcessor::PipelineProfile pipeline_mode = CL3aImageProcessor::BasicPipelineProfile;
     CL3aImageProcessor::CaptureStage capture_stage = CL3aImageProcessor::TonemappingStage;
     CL3aImageProcessor::CLTonemappingMode wdr_mode = CL3aImageProcessor::WDRdisabled;
+    SmartPtr<CLProfileSelector> profile_selector;
+    const char *quality_ranking = DEFAULT_QUALITY_RANKING;
 #endif
     bool have_cl_processor = false;
     bool have_cl_post_processor = true;
@@ -366,17 +390,23 @@ int main (int argc, char *argv[])
     uint32_t pixel_format = V4L2_PIX_FMT_NV12;
     bool wdr_type = false;
     bool retinex_type = false;
+    bool dvs_type = false;
     CLWaveletBasis wavelet_mode = CL_WAVELET_DISABLED;
     uint32_t wavelet_channel = CL_WAVELET_CHANNEL_UV;
 
     int32_t brightness_level = 128;
     bool    have_usbcam = 0;
     SmartPtr<char> usb_device_name;
+    bool have_soft_csc = false;
+    SmartPtr<SoftImageProcessor> soft_csc_processor;
     bool sync_mode = false;
+    bool motion_detection = false;
+    int restart_count = 0;
     int frame_rate;
     int frame_width = 1920;
     int frame_height = 1080;
     SmartPtr<char> path_to_fake = NULL;
+    int sim_fps = 0;
 
     const char *short_opts = "sca:n:m:f:d:b:pi:e:r:h";
     const struct option long_opts[] = {
@@ -389,14 +419,22 @@ int main (int argc, char *argv[])
         {"enable-ee", no_argument, NULL, 'E'},
         {"enable-bnr", no_argument, NULL, 'B'},
         {"enable-dpc", no_argument, NULL, 'D'},
+        {"enable-lut3d", no_argument, NULL, 'A'},
         {"enable-retinex", no_argument, NULL, 'X'},
         {"wavelet-mode", required_argument, NULL, 'V'},
         {"usb", required_argument, NULL, 'U'},
         {"resolution", required_argument, NULL, 'R'},
+        {"soft-csc", no_argument, NULL, 'Z'},
         {"sync", no_argument, NULL, 'Y'},
+        {"motion", no_argument, NULL, 'M'},
+        {"restart", required_argument, NULL, 'K'},
+        {"sim", required_argument, NULL, 'G'},
         {"capture", required_argument, NULL, 'C'},
         {"pipeline", required_argument, NULL, 'P'},
         {"disable-post", no_argument, NULL, 'O'},
+        {"enable-dvs", no_argument, NULL, 'J'},
+        {"target-fps", required_argument, NULL, 'F'},
+        {"quality", required_argument, NULL, 'Q'},
         {0, 0, 0, 0},
     };
 
@@ -476,6 +514,9 @@ int main (int argc, char *argv[])
             usb_device_name = strndup(optarg, XCAM_MAX_STR_SIZE);
             XCAM_LOG_DEBUG("using USB camera plugged in at node: %s", XCAM_STR(usb_device_name.ptr ()));
             break;
+        case 'Z':
+            have_soft_csc = true;
+            break;
         case 'R':
             XCAM_ASSERT (optarg);
             sscanf (optarg, "%d%*c%d", &frame_width, &frame_height);
@@ -498,6 +539,12 @@ int main (int argc, char *argv[])
         case 'Y':
             sync_mode = true;
             break;
+        case 'M':
+            motion_detection = true;
+            break;
+        case 'K':
+            restart_count = atoi (optarg);
+            break;
 #if HAVE_LIBCL
         case 'H': {
             XCAM_ASSERT (optarg);
@@ -562,6 +609,10 @@ int main (int argc, char *argv[])
             dpc_type = true;
             break;
         }
+        case 'A': {
+            lut3d_type = true;
+            break;
+        }
         case 'T': {
             XCAM_ASSERT (optarg);
             if (!strcasecmp (optarg, "yuv"))
@@ -615,12 +666,29 @@ int main (int argc, char *argv[])
             XCAM_ASSERT (optarg);
             if (!strcmp (optarg, "bayer"))
                 capture_stage = CL3aImageProcessor::BasicbayerStage;
+            else if (!strcmp (optarg, "stats")) {
+                capture_stage = CL3aImageProcessor::StatsOnlyStage;
+                have_cl_post_processor = false;
+            }
             break;
         }
         case 'O': {
             have_cl_post_processor = false;
             break;
         }
+        case 'J': {
+            dvs_type = true;
+            break;
+        }
+        case 'F': {
+            double target_fps = atof (optarg);
+            CHECK_EXP (target_fps > 0.0, "invalid target fps:%s\n", optarg);
+            profile_selector = new CLProfileSelector (target_fps);
+            break;
+        }
+        case 'Q':
+            quality_ranking = optarg;
+            break;
 #endif
         case 'r': {
             if (optarg) {
@@ -629,6 +697,10 @@ int main (int argc, char *argv[])
             }
             break;
         }
+        case 'G':
+            sim_fps = atoi (optarg);
+            CHECK_EXP (sim_fps > 0, "invalid sim fps:%s\n", optarg);
+            break;
         case 'h':
             print_help (bin_name);
             return 0;
@@ -646,7 +718,14 @@ int main (int argc, char *argv[])
         device_manager->set_display_mode (display_mode);
     }
     if (!device.ptr ())  {
-        if (path_to_fake.ptr ()) {
+        if (sim_fps) {
+            SimSensorConfig sim_config;
+            sim_config.width = frame_width;
+            sim_config.height = frame_height;
+            sim_config.format = pixel_format;
+            sim_config.fps_n = sim_fps;
+            device = new SimSensorDevice (sim_config);
+        } else if (path_to_fake.ptr ()) {
             device = new FakeV4l2Device ();
         } else if (have_usbcam) {
             device = new UVCDevice (usb_device_name.ptr ());
@@ -698,6 +777,7 @@ int main (int argc, char *argv[])
     }
     XCAM_ASSERT (analyzer.ptr ());
     analyzer->set_sync_mode (sync_mode);
+    analyzer->set_motion_detection (motion_detection);
 
     signal(SIGINT, dev_stop_handler);
 
@@ -706,7 +786,11 @@ int main (int argc, char *argv[])
     //device->set_mem_type (V4L2_MEMORY_DMABUF);
     device->set_mem_type (v4l2_mem_type);
     device->set_buffer_count (8);
-    if (pixel_format == V4L2_PIX_FMT_SGRBG12) {
+    if (sim_fps) {
+        frame_rate = sim_fps;
+        device->set_framerate (frame_rate, 1);
+    }
+    else if (pixel_format == V4L2_PIX_FMT_SGRBG12) {
         frame_rate = 30;
         device->set_framerate (frame_rate, 1);
     }
@@ -723,7 +807,8 @@ int main (int argc, char *argv[])
     ret = device->set_format (frame_width, frame_height, pixel_format, V4L2_FIELD_NONE, frame_width * 2);
     CHECK (ret, "device(%s) set format failed", device->get_device_name());
 
-    ret = event_device->open ();
+    // the synthetic sensor sends its own 3a stats events
+    ret = sim_fps ? XCAM_RETURN_ERROR_PARAM : event_device->open ();
     if (ret == XCAM_RETURN_NO_ERROR) {
         CHECK (ret, "event device(%s) open failed", event_device->get_device_name());
         int event = V4L2_EVENT_ATOMISP_3A_STATS_READY;
@@ -754,11 +839,36 @@ int main (int argc, char *argv[])
 
     XCAM_ASSERT (isp_processor.ptr ());
     device_manager->add_image_processor (isp_processor);
+
+    if (have_soft_csc) {
+        CHECK_EXP (
+            have_usbcam && (pixel_format == V4L2_PIX_FMT_YUYV || pixel_format == V4L2_PIX_FMT_UYVY),
+            "soft csc only supports usb camera with YUYV/UYVY format");
+        SmartPtr<SoftImageHandler> csc_handler = create_soft_csc_image_handler (V4L2_PIX_FMT_NV12);
+        soft_csc_processor = new SoftImageProcessor ("soft_csc_processor");
+        soft_csc_processor->add_handler (csc_handler);
+        device_manager->add_image_processor (soft_csc_processor);
+    }
 #if HAVE_LIBCL
+    if (profile_selector.ptr ()) {
+        std::vector<std::string> names;
+        std::string ranking (quality_ranking);
+        size_t begin = 0, end;
+        do {
+            end = ranking.find (',', begin);
+            std::string name = ranking.substr (begin, end == std::string::npos ? end : end - begin);
+            if (!name.empty ())
+                names.push_back (name);
+            begin = end + 1;
+        } while (end != std::string::npos);
+        profile_selector->set_quality_ranking (names);
+    }
+
     if (have_cl_processor) {
         cl_processor = new CL3aImageProcessor ();
         cl_processor->set_stats_callback(device_manager);
         cl_processor->set_dpc(dpc_type);
+        cl_processor->set_lut3d (lut3d_type);
         cl_processor->set_hdr (hdr_type);
         cl_processor->set_denoise (denoise_type);
         cl_processor->set_tonemapping(wdr_mode);
@@ -771,6 +881,8 @@ int main (int argc, char *argv[])
         }
         cl_processor->set_tnr (tnr_type, tnr_level);
         cl_processor->set_profile (pipeline_mode);
+        if (profile_selector.ptr ())
+            cl_processor->set_profile_selector (profile_selector);
         analyzer->set_parameter_brightness((brightness_level - 128) / 128.0);
         device_manager->add_image_processor (cl_processor);
     }
@@ -779,6 +891,9 @@ int main (int argc, char *argv[])
         cl_post_processor = new CLPostImageProcessor ();
 
         cl_post_processor->set_retinex (retinex_type);
+        cl_post_processor->set_dvs (dvs_type);
+        if (profile_selector.ptr ())
+            cl_post_processor->set_profile_selector (profile_selector);
 
         if (need_display) {
             cl_post_processor->set_output_format (V4L2_PIX_FMT_XBGR32);
@@ -788,7 +903,9 @@ int main (int argc, char *argv[])
 #endif
 
     SmartPtr<PollThread> poll_thread;
-    if (path_to_fake.ptr ())
+    if (sim_fps)
+        poll_thread = new SimSensorPollThread ();
+    else if (path_to_fake.ptr ())
         poll_thread = new FakePollThread (path_to_fake.ptr ());
     else
         poll_thread = new PollThread ();
@@ -806,6 +923,20 @@ int main (int argc, char *argv[])
         analyzer->set_ae_max_analog_gain (3.98); // 12dB
     }
 
+    for (int i = 0; i < restart_count && !g_stop; ++i) {
+        struct timeval begin, end;
+
+        sleep (2);
+        gettimeofday (&begin, NULL);
+        ret = device_manager->stop ();
+        CHECK (ret, "device manager stop failed");
+        ret = device_manager->start ();
+        CHECK (ret, "device manager restart failed");
+        gettimeofday (&end, NULL);
+        printf ("restart(%d) took %.1fms\n", i,
+                (end.tv_sec - begin.tv_sec) * 1000.0 + (end.tv_usec - begin.tv_usec) / 1000.0);
+    }
+
     // wait for interruption
     {
         SmartLock locker (g_mutex);
@@ -0,0 +1,201 @@
+/*
+ * test-dvs.cpp - check and benchmark projection dvs on synthetic shaking frames
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#include "test_common.h"
+#include "projection_dvs.h"
+#include <getopt.h>
+#include <math.h>
+#include <vector>
+
+using namespace XCam;
+
+#define TEST_DVS_SHAKE 12
+// frames whose motion was found, of all but the first
+#define TEST_DVS_MIN_MATCHED 0.9
+#define TEST_DVS_MAX_SHIFT_ERROR 1.0
+// output frame motion over input frame motion
+#define TEST_DVS_MAX_JITTER_RATIO 0.5
+
+static double
+time_ms (const struct timeval &start, const struct timeval &end)
+{
+    return (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_usec - start.tv_usec) / 1000.0;
+}
+
+// smooth random blobs over a gradient
+static void
+generate_scene (std::vector<uint8_t> &scene, uint32_t width, uint32_t height)
+{
+    uint32_t seed = 7;
+    std::vector<float> value (width * height, 0.0f);
+
+    for (uint32_t i = 0; i < 400; ++i) {
+        seed = seed * 1103515245 + 12345;
+        float cx = (seed >> 8) % width;
+        seed = seed * 1103515245 + 12345;
+        float cy = (seed >> 8) % height;
+        seed = seed * 1103515245 + 12345;
+        float radius = 8.0f + (seed >> 8) % 40;
+        float amp = ((seed >> 4) & 1) ? 60.0f : -60.0f;
+        int32_t x0 = XCAM_MAX ((int32_t)(cx - radius), 0), x1 = XCAM_MIN ((int32_t)(cx + radius), (int32_t)width - 1);
+        int32_t y0 = XCAM_MAX ((int32_t)(cy - radius), 0), y1 = XCAM_MIN ((int32_t)(cy + radius), (int32_t)height - 1);
+        for (int32_t y = y0; y <= y1; ++y)
+            for (int32_t x = x0; x <= x1; ++x) {
+                float d2 = ((x - cx) * (x - cx) + (y - cy) * (y - cy)) / (radius * radius);
+                if (d2 < 1.0f)
+                    value[y * width + x] += amp * (1.0f - d2);
+            }
+    }
+
+    scene.resize (width * height);
+    for (uint32_t y = 0; y < height; ++y)
+        for (uint32_t x = 0; x < width; ++x) {
+            float v = 80.0f + 60.0f * x / width + 30.0f * y / height + value[y * width + x];
+            scene[y * width + x] = (uint8_t)XCAM_MIN (XCAM_MAX (v, 0.0f), 255.0f);
+        }
+}
+
+static void
+print_help (const char *bin_name)
+{
+    printf ("Usage: %s [-W width] [-H height] [-n frames] [-m margin] [-s smooth]\n"
+            "\t -W width     specify frame width, default: 1920\n"
+            "\t -H height    specify frame height, default: 1080\n"
+            "\t -n frames    specify frame count, default: 300\n"
+            "\t -m margin    specify crop margin of each side, default: 0.05\n"
+            "\t -s smooth    specify path smooth weight, default: 0.1\n"
+            "\t -h           help\n"
+            , bin_name);
+}
+
+int main (int argc, char *argv[])
+{
+    uint32_t width = 1920;
+    uint32_t height = 1080;
+    uint32_t frames = 300;
+    float margin = 0.05f;
+    float smooth = 0.1f;
+    int opt = 0;
+
+    while ((opt =  getopt(argc, argv, "W:H:n:m:s:h")) != -1) {
+        switch (opt) {
+        case 'W':
+            width = atoi (optarg);
+            break;
+        case 'H':
+            height = atoi (optarg);
+            break;
+        case 'n':
+            frames = atoi (optarg);
+            break;
+        case 'm':
+            margin = atof (optarg);
+            break;
+        case 's':
+            smooth = atof (optarg);
+            break;
+        case 'h':
+            print_help (argv[0]);
+            return 0;
+        default:
+            print_help (argv[0]);
+            return -1;
+        }
+    }
+    CHECK_EXP (width >= 64 && height >= 64 && frames > 1, "invalid frame size or count");
+
+    // camera pans slowly right while shaking, brightness drifts like AE
+    uint32_t border = TEST_DVS_SHAKE * 2 + 2;
+    uint32_t scene_width = width + 2 * border + frames / 2;
+    uint32_t scene_height = height + 2 * border;
+    std::vector<uint8_t> scene, frame (width * height);
+    generate_scene (scene, scene_width, scene_height);
+
+    ProjectionDvs dvs;
+    CHECK_EXP (dvs.set_margin (margin) && dvs.set_smooth (smooth), "invalid margin or smooth");
+
+    uint32_t seed = 11;
+    double total_ms = 0.0, shift_err = 0.0, raw_jitter = 0.0, out_jitter = 0.0;
+    int32_t prev_x = 0, prev_y = 0, prev_out_x = 0, prev_out_y = 0;
+    uint32_t matched = 0;
+
+    for (uint32_t i = 0; i < frames; ++i) {
+        seed = seed * 1103515245 + 12345;
+        int32_t cam_x = border + i / 2 + (int32_t)((seed >> 8) % (2 * TEST_DVS_SHAKE + 1)) - TEST_DVS_SHAKE;
+        seed = seed * 1103515245 + 12345;
+        int32_t cam_y = border + (int32_t)((seed >> 8) % (2 * TEST_DVS_SHAKE + 1)) - TEST_DVS_SHAKE;
+        float gain = 1.0f + 0.1f * sinf (i * 0.05f);
+
+        for (uint32_t y = 0; y < height; ++y) {
+            const uint8_t *src = &scene[(cam_y + y) * scene_width + cam_x];
+            for (uint32_t x = 0; x < width; ++x)
+                frame[y * width + x] = (uint8_t)XCAM_MIN (src[x] * gain, 255.0f);
+        }
+
+        XCam3AWindow crop;
+        struct timeval start, end;
+        gettimeofday (&start, NULL);
+        CHECK (dvs.process (&frame[0], width, height, width, crop), "dvs process failed");
+        gettimeofday (&end, NULL);
+        total_ms += time_ms (start, end);
+
+        // content moves against the camera
+        const DvsMotion &motion = dvs.get_last_motion ();
+        int32_t out_x = cam_x + crop.x_start, out_y = cam_y + crop.y_start;
+        if (i > 0) {
+            if (motion.hor_corr > 0.0f && motion.ver_corr > 0.0f) {
+                shift_err = XCAM_MAX (shift_err, fabs (motion.hor_shift + (cam_x - prev_x)));
+                shift_err = XCAM_MAX (shift_err, fabs (motion.ver_shift + (cam_y - prev_y)));
+                ++matched;
+            }
+            raw_jitter += abs (cam_x - prev_x) + abs (cam_y - prev_y);
+            out_jitter += abs (out_x - prev_out_x) + abs (out_y - prev_out_y);
+        }
+        prev_x = cam_x;
+        prev_y = cam_y;
+        prev_out_x = out_x;
+        prev_out_y = out_y;
+    }
+
+    printf ("projection dvs %dx%d, %d frames\n", width, height, frames);
+    printf ("average time:       %.3f ms/frame\n", total_ms / frames);
+    printf ("matched frames:     %d/%d\n", matched, frames - 1);
+    printf ("max shift error:    %.2f pixels\n", shift_err);
+    printf ("mean frame motion:  %.2f pixels in, %.2f pixels out\n",
+            raw_jitter / (frames - 1), out_jitter / (frames - 1));
+
+    bool passed = true;
+    CHECK_DECLARE (
+        ERROR, matched >= TEST_DVS_MIN_MATCHED * (frames - 1), passed = false,
+        "matched %d of %d frames, expected at least %.0f%%", matched, frames - 1, TEST_DVS_MIN_MATCHED * 100);
+    CHECK_DECLARE (
+        ERROR, shift_err <= TEST_DVS_MAX_SHIFT_ERROR, passed = false,
+        "max shift error %.2f over %.2f pixels", shift_err, TEST_DVS_MAX_SHIFT_ERROR);
+    CHECK_DECLARE (
+        ERROR, out_jitter <= TEST_DVS_MAX_JITTER_RATIO * raw_jitter, passed = false,
+        "frame motion only reduced from %.2f to %.2f pixels", raw_jitter / (frames - 1), out_jitter / (frames - 1));
+
+    if (!passed) {
+        printf ("projection dvs test FAILED\n");
+        return -1;
+    }
+    printf ("projection dvs test PASSED\n");
+    return 0;
+}
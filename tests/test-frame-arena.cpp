@@ -0,0 +1,201 @@
+/*
+ * test-frame-arena.cpp - check frame arena object lifetime across threads
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#include "test_common.h"
+#include "frame_arena.h"
+#include "xcam_thread.h"
+#include <getopt.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace XCam;
+
+/*
+ * objects are made inside a FrameArenaScope and shared with release
+ * threads that only start after the scope ended, so every arena is given
+ * back by a thread which never had it in scope. Checks that the arena
+ * stays pinned until the last object died, that all of them return to
+ * the pool, that ArenaObject pointers use the embedded ref count and
+ * that a full arena or no scope falls back to the heap.
+ */
+
+static std::atomic<int32_t> live_objects (0);
+
+struct TestFrameObject
+    : public ArenaObject
+{
+    uint32_t   frame;
+    uint8_t    payload[200];
+
+    explicit TestFrameObject (uint32_t id)
+        : frame (id)
+    {
+        memset (payload, (int)(id & 0xFF), sizeof (payload));
+        ++live_objects;
+    }
+    ~TestFrameObject () {
+        --live_objects;
+    }
+};
+
+typedef std::vector<SmartPtr<TestFrameObject> > TestObjectList;
+
+class ReleaseThread
+    : public Thread
+{
+public:
+    explicit ReleaseThread (const TestObjectList &objects)
+        : Thread ("arena_release")
+        , _objects (objects)
+        , _corrupted (0)
+    {}
+
+    uint32_t get_corrupted () const {
+        return _corrupted;
+    }
+
+protected:
+    virtual bool loop () {
+        // drop from the back while other threads drop their own copies
+        while (!_objects.empty ()) {
+            const SmartPtr<TestFrameObject> &obj = _objects.back ();
+            if (obj->payload[0] != (uint8_t)(obj->frame & 0xFF))
+                ++_corrupted;
+            _objects.pop_back ();
+        }
+        return false;
+    }
+
+private:
+    TestObjectList   _objects;
+    uint32_t         _corrupted;
+};
+
+static void
+print_help (const char *bin_name)
+{
+    printf ("Usage: %s [-f frames] [-n objects] [-t threads]\n"
+            "\t -f frames     frames to run, default 200\n"
+            "\t -n objects    objects per frame, default 64\n"
+            "\t -t threads    release threads per frame, default 4\n"
+            "\t -h            help\n"
+            , bin_name);
+}
+
+int main (int argc, char *argv[])
+{
+    uint32_t frames = 200;
+    uint32_t object_count = 64;
+    uint32_t thread_count = 4;
+    uint32_t corrupted = 0;
+    FrameArenaStats stats;
+    int opt;
+
+    while ((opt =  getopt(argc, argv, "f:n:t:h")) != -1) {
+        switch (opt) {
+        case 'f':
+            frames = atoi (optarg);
+            break;
+        case 'n':
+            object_count = atoi (optarg);
+            break;
+        case 't':
+            thread_count = atoi (optarg);
+            break;
+        case 'h':
+            print_help (argv[0]);
+            return 0;
+        default:
+            print_help (argv[0]);
+            return -1;
+        }
+    }
+    CHECK_EXP (frames > 0 && object_count > 0 && thread_count > 0, "invalid arguments");
+
+    // derived pointers must take the embedded count, not a heap RefCount
+    {
+        SmartPtr<TestFrameObject> obj = new TestFrameObject (0);
+        CHECK_EXP (obj.ptr (), "allocating object out of scope failed");
+        CHECK_EXP (
+            new_ref_count (obj.ptr ()) == arena_object_ref_count (obj.ptr ()),
+            "ArenaObject did not pick the embedded ref count");
+    }
+
+    for (uint32_t f = 0; f < frames; ++f) {
+        std::vector<SmartPtr<ReleaseThread> > threads;
+        {
+            FrameArenaScope scope;
+            TestObjectList objects;
+            for (uint32_t i = 0; i < object_count; ++i) {
+                SmartPtr<TestFrameObject> obj = new TestFrameObject (f);
+                CHECK_EXP (obj.ptr (), "frame(%d) allocating object failed", f);
+                objects.push_back (obj);
+            }
+            for (uint32_t i = 0; i < thread_count; ++i)
+                threads.push_back (new ReleaseThread (objects));
+        }
+
+        // scope ended, the objects must still pin their arena
+        FrameArena::get_stats (stats);
+        CHECK_EXP (
+            stats.arenas_free < stats.arenas_created,
+            "frame(%d) arena went back to the pool while objects alive", f);
+
+        for (uint32_t i = 0; i < thread_count; ++i)
+            threads[i]->start ();
+        for (uint32_t i = 0; i < thread_count; ++i) {
+            while (threads[i]->is_running ())
+                usleep (100);
+            corrupted += threads[i]->get_corrupted ();
+        }
+        threads.clear ();
+
+        FrameArena::get_stats (stats);
+        CHECK_EXP (
+            live_objects == 0 && stats.arenas_free == stats.arenas_created,
+            "frame(%d) leaked, live objects:%d arenas free:%d created:%d",
+            f, (int32_t)live_objects, stats.arenas_free, stats.arenas_created);
+    }
+    CHECK_EXP (corrupted == 0, "%d objects corrupted before release", corrupted);
+
+    // arena full, the rest goes to the heap and is freed the same way
+    uint64_t heap_before = stats.heap_allocs;
+    {
+        FrameArenaScope scope;
+        TestObjectList objects;
+        uint32_t overflow = XCAM_FRAME_ARENA_SIZE / sizeof (TestFrameObject) + 8;
+        for (uint32_t i = 0; i < overflow; ++i) {
+            SmartPtr<TestFrameObject> obj = new TestFrameObject (i);
+            CHECK_EXP (obj.ptr (), "allocating object(%d) in a full arena failed", i);
+            objects.push_back (obj);
+        }
+    }
+    FrameArena::get_stats (stats);
+    CHECK_EXP (stats.heap_allocs > heap_before, "full arena did not fall back to the heap");
+    CHECK_EXP (
+        live_objects == 0 && stats.arenas_free == stats.arenas_created,
+        "heap fallback leaked, live objects:%d", (int32_t)live_objects);
+
+    printf ("arenas created:%d, arena allocs:%" PRIu64 ", heap allocs:%" PRIu64 "\n",
+            stats.arenas_created, stats.arena_allocs, stats.heap_allocs);
+    printf ("frame arena test PASSED\n");
+    return 0;
+}
@@ -0,0 +1,370 @@
+/*
+ * test-pipeline.cpp - test frame pipeline C interface
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#include "test_common.h"
+#include <base/xcam_pipeline.h>
+#include <getopt.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <inttypes.h>
+#include <atomic>
+#include <vector>
+
+/*
+ * YUYV frames with luma (x + y + index) & 0xff through the csc stage,
+ * completions are checked for order, status and luma of the NV12 output.
+ * Then RGB24 planar frames through hdr_lab, hdr_lab and yuv_pipe with
+ * every fail_interval-th frame on a dma-buf the first stage cannot map;
+ * only those may fail, the frames ahead of them in later stages must
+ * still come out in order.
+ */
+
+struct TestContext {
+    uint32_t                width;
+    uint32_t                height;
+    bool                    multi_stage;
+    uint32_t                fail_interval;
+    int                     bad_fd;
+    std::atomic<uint32_t>   completed;
+    std::atomic<uint32_t>   errors;
+    uint32_t                expected;
+
+    TestContext ()
+        : width (0)
+        , height (0)
+        , multi_stage (false)
+        , fail_interval (0)
+        , bad_fd (-1)
+        , completed (0)
+        , errors (0)
+        , expected (0)
+    {}
+
+    bool is_bad_frame (uint32_t index) const {
+        return multi_stage && fail_interval && index % fail_interval == fail_interval - 1;
+    }
+};
+
+static void
+fill_frame (uint8_t *data, uint32_t width, uint32_t height, uint32_t index)
+{
+    for (uint32_t y = 0; y < height; ++y) {
+        uint8_t *line = data + y * width * 2;
+        for (uint32_t x = 0; x < width; ++x) {
+            line[x * 2] = (x + y + index) & 0xff;
+            line[x * 2 + 1] = 128;
+        }
+    }
+}
+
+static bool
+check_result (TestContext &context, const XCamFrameResult &result)
+{
+    uint32_t index = (uint32_t)(uintptr_t)result.cookie;
+    bool ok = true;
+
+    if (index != context.expected) {
+        XCAM_LOG_ERROR ("frame(%d) completed, expected frame(%d)", index, context.expected);
+        ok = false;
+    }
+    context.expected = index + 1;
+
+    if (context.is_bad_frame (index)) {
+        if (result.status != XCAM_RETURN_ERROR_UNKNOWN || result.output) {
+            XCAM_LOG_ERROR ("bad frame(%d) did not fail, status:%d", index, result.status);
+            ok = false;
+        }
+        if (result.output)
+            xcam_video_buffer_unref (result.output);
+        return ok;
+    }
+    if (result.status != XCAM_RETURN_NO_ERROR || !result.output) {
+        XCAM_LOG_ERROR ("frame(%d) failed, status:%d", index, result.status);
+        return false;
+    }
+    if (result.output->timestamp != (int64_t)index * 33333) {
+        XCAM_LOG_ERROR ("frame(%d) output timestamp(%" PRId64 ") wrong", index, result.output->timestamp);
+        ok = false;
+    }
+    if (context.multi_stage) {
+        // tone mapped, only the output format is known
+        if (result.output->info.format != V4L2_PIX_FMT_NV12) {
+            XCAM_LOG_ERROR ("frame(%d) output is not NV12", index);
+            ok = false;
+        }
+        xcam_video_buffer_unref (result.output);
+        return ok;
+    }
+
+    uint8_t *mem = xcam_video_buffer_map (result.output);
+    const XCamVideoBufferInfo &info = result.output->info;
+    for (uint32_t y = 0; ok && mem && y < context.height; ++y) {
+        const uint8_t *line = mem + info.offsets[0] + y * info.strides[0];
+        for (uint32_t x = 0; x < context.width; ++x) {
+            if (line[x] != ((x + y + index) & 0xff)) {
+                XCAM_LOG_ERROR ("frame(%d) luma mismatch at (%d, %d)", index, x, y);
+                ok = false;
+                break;
+            }
+        }
+    }
+    xcam_video_buffer_unmap (result.output);
+    xcam_video_buffer_unref (result.output);
+    return ok && mem;
+}
+
+static void
+pipeline_done (XCamPipeline *pipeline, const XCamFrameResult *results, uint32_t count, void *user_data)
+{
+    TestContext *context = (TestContext *)user_data;
+    XCAM_UNUSED (pipeline);
+
+    for (uint32_t i = 0; i < count; ++i) {
+        if (!check_result (*context, results[i]))
+            ++context->errors;
+    }
+    context->completed += count;
+}
+
+static uint32_t
+reap_results (XCamPipeline *pipeline, TestContext &context, int timeout_ms)
+{
+    XCamFrameResult results[32];
+    struct pollfd fd;
+    uint32_t count = 0;
+
+    fd.fd = xcam_pipeline_get_event_fd (pipeline);
+    fd.events = POLLIN;
+    if (poll (&fd, 1, timeout_ms) <= 0)
+        return 0;
+
+    uint32_t reaped = 0;
+    while ((reaped = xcam_pipeline_reap (pipeline, results, sizeof (results) / sizeof (results[0]))) > 0) {
+        for (uint32_t i = 0; i < reaped; ++i) {
+            if (!check_result (context, results[i]))
+                ++context.errors;
+        }
+        count += reaped;
+    }
+    context.completed += count;
+    return count;
+}
+
+static void
+fill_rgb_frame (uint8_t *data, uint32_t width, uint32_t height, uint32_t index)
+{
+    for (uint32_t y = 0; y < height * 3; ++y) {
+        uint8_t *line = data + y * width;
+        for (uint32_t x = 0; x < width; ++x)
+            line[x] = (x + y + index) & 0xff;
+    }
+}
+
+static void
+print_help (const char *bin_name)
+{
+    printf ("Usage: %s [-W width] [-H height] [-n frames] [-b batch] [-m max] [-f interval] [-c]\n"
+            "\t -W width     frame width, default 1920\n"
+            "\t -H height    frame height, default 1080\n"
+            "\t -n frames    frames to process, default 300\n"
+            "\t -b batch     frames per submit, default 4\n"
+            "\t -m max       frames in flight, default %d\n"
+            "\t -f interval  multi-stage run fails every interval-th frame, default 5, 0 skips the run\n"
+            "\t -c           completions by callback, default poll eventfd and reap\n"
+            "\t -h           help\n"
+            , bin_name, XCAM_PIPELINE_DEFAULT_IN_FLIGHT);
+}
+
+static bool
+run_pipeline (
+    TestContext &context, uint32_t frame_count, uint32_t batch, uint32_t max_in_flight, bool use_callback)
+{
+    XCamPipelineConfig config;
+    xcam_mem_clear (config);
+    if (context.multi_stage) {
+        config.stages[0] = XCAM_PIPELINE_STAGE_HDR_LAB;
+        config.stages[1] = XCAM_PIPELINE_STAGE_HDR_LAB;
+        config.stages[2] = XCAM_PIPELINE_STAGE_YUV_PIPE;
+        config.stage_count = 3;
+    } else {
+        config.stages[0] = XCAM_PIPELINE_STAGE_CSC;
+        config.stage_count = 1;
+    }
+    config.max_in_flight = max_in_flight;
+
+    XCamPipeline *pipeline = xcam_pipeline_create (&config);
+    CHECK_DECLARE (ERROR, pipeline, return false, "create pipeline failed");
+    if (use_callback)
+        xcam_pipeline_set_callback (pipeline, pipeline_done, &context);
+    CHECK_DECLARE (
+        ERROR, xcam_pipeline_start (pipeline) == XCAM_RETURN_NO_ERROR,
+        xcam_pipeline_destroy (pipeline); return false, "start pipeline failed");
+
+    // a slot is filled again only after its frame completed
+    uint32_t format = context.multi_stage ? XCAM_PIX_FMT_RGB24_planar : V4L2_PIX_FMT_YUYV;
+    uint32_t slot_count = max_in_flight + batch;
+    uint32_t frame_size = context.width * context.height * (context.multi_stage ? 3 : 2);
+    std::vector<uint8_t> memory ((size_t)slot_count * frame_size);
+    std::vector<XCamFrame> frames (batch);
+
+    struct timeval start, end;
+    gettimeofday (&start, NULL);
+
+    uint32_t submitted = 0;
+    uint32_t submit_calls = 0;
+    while (submitted < frame_count) {
+        uint32_t count = XCAM_MIN (batch, frame_count - submitted);
+        for (uint32_t i = 0; i < count; ++i) {
+            uint32_t index = submitted + i;
+            XCamFrame &frame = frames[i];
+            xcam_mem_clear (frame);
+            xcam_video_buffer_info_reset (
+                &frame.info, format, context.width, context.height,
+                context.width, context.height, 0);
+            frame.timestamp = (int64_t)index * 33333;
+            frame.cookie = (void *)(uintptr_t)index;
+            if (context.is_bad_frame (index)) {
+                frame.data = NULL;
+                frame.dma_fd = context.bad_fd;
+                continue;
+            }
+            frame.data = &memory[(size_t)(index % slot_count) * frame_size];
+            frame.dma_fd = -1;
+            if (context.multi_stage)
+                fill_rgb_frame (frame.data, context.width, context.height, index);
+            else
+                fill_frame (frame.data, context.width, context.height, index);
+        }
+
+        uint32_t accepted = 0;
+        XCamReturn ret = xcam_pipeline_submit (pipeline, &frames[0], count, &accepted);
+        CHECK_DECLARE (
+            ERROR, ret == XCAM_RETURN_NO_ERROR || ret == XCAM_RETURN_BYPASS,
+            break, "submit failed, ret:%d", ret);
+        submitted += accepted;
+        ++submit_calls;
+
+        if (accepted < count) {
+            if (use_callback)
+                usleep (500);
+            else
+                reap_results (pipeline, context, 100);
+        }
+    }
+
+    bool drained = (xcam_pipeline_drain (pipeline, 5000000) == XCAM_RETURN_NO_ERROR);
+    if (!drained)
+        XCAM_LOG_ERROR ("drain pipeline failed");
+    if (!use_callback) {
+        while (context.completed < submitted && reap_results (pipeline, context, 100) > 0);
+    }
+    xcam_pipeline_stop (pipeline);
+    gettimeofday (&end, NULL);
+    xcam_pipeline_destroy (pipeline);
+
+    double elapsed_ms = (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_usec - start.tv_usec) / 1000.0;
+    printf ("pipeline %s %s: %d frames %dx%d, %d submits, %.2f fps, completed:%d errors:%d\n",
+            context.multi_stage ? "multi-stage" : "csc", use_callback ? "callback" : "eventfd",
+            submitted, context.width, context.height,
+            submit_calls, elapsed_ms > 0 ? submitted * 1000.0 / elapsed_ms : 0.0,
+            (uint32_t)context.completed, (uint32_t)context.errors);
+
+    return drained && context.completed == frame_count && !context.errors;
+}
+
+int main (int argc, char *argv[])
+{
+    uint32_t width = 1920;
+    uint32_t height = 1080;
+    uint32_t frame_count = 300;
+    uint32_t batch = 4;
+    uint32_t max_in_flight = XCAM_PIPELINE_DEFAULT_IN_FLIGHT;
+    uint32_t fail_interval = 5;
+    bool use_callback = false;
+    int opt;
+
+    while ((opt = getopt (argc, argv, "W:H:n:b:m:f:ch")) != -1) {
+        switch (opt) {
+        case 'W':
+            width = atoi (optarg);
+            break;
+        case 'H':
+            height = atoi (optarg);
+            break;
+        case 'n':
+            frame_count = atoi (optarg);
+            break;
+        case 'b':
+            batch = atoi (optarg);
+            break;
+        case 'm':
+            max_in_flight = atoi (optarg);
+            break;
+        case 'f':
+            fail_interval = atoi (optarg);
+            break;
+        case 'c':
+            use_callback = true;
+            break;
+        case 'h':
+            print_help (argv[0]);
+            return 0;
+        default:
+            print_help (argv[0]);
+            return -1;
+        }
+    }
+    if (!width || !height || !batch || !max_in_flight) {
+        print_help (argv[0]);
+        return -1;
+    }
+
+    bool passed = true;
+    {
+        TestContext context;
+        context.width = width;
+        context.height = height;
+        passed = run_pipeline (context, frame_count, batch, max_in_flight, use_callback);
+    }
+
+    if (passed && fail_interval) {
+        // a pipe cannot be mapped, the first stage fails on it
+        int fds[2];
+        CHECK_DECLARE (ERROR, pipe (fds) == 0, return -1, "create pipe failed");
+
+        TestContext context;
+        context.width = width;
+        context.height = height;
+        context.multi_stage = true;
+        context.fail_interval = fail_interval;
+        context.bad_fd = fds[0];
+        passed = run_pipeline (context, frame_count, batch, max_in_flight, use_callback);
+        close (fds[0]);
+        close (fds[1]);
+    }
+
+    if (!passed) {
+        printf ("pipeline test FAILED\n");
+        return -1;
+    }
+    printf ("pipeline test PASSED\n");
+    return 0;
+}
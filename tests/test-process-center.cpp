@@ -0,0 +1,236 @@
+/*
+ * test-process-center.cpp - test fan-out and join of the process center
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#include "test_common.h"
+#include "x3a_image_process_center.h"
+#include "xcam_mutex.h"
+#include <getopt.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace XCam;
+
+/*
+ * every capture frame goes to four branches at once: one failing on
+ * some frames, one dropping some frames and reporting it, one losing a
+ * single frame silently, and the output branch. Each output must come
+ * out in capture order right after its frame was put, a frame held
+ * until XCAM_PROCESS_CENTER_MAX_PENDING later frames force it out fails
+ * the test. The silently lost frame must come out once the join timed
+ * out.
+ */
+
+#define TEST_OUTPUT_WAIT_US 200000
+
+enum BranchMode {
+    BranchPass = 0,
+    BranchFail,
+    BranchDrop,
+    BranchLose,
+};
+
+class TestBuffer
+    : public VideoBuffer
+{
+public:
+    explicit TestBuffer (int64_t timestamp)
+        : VideoBuffer (timestamp)
+    {}
+
+    virtual uint8_t *map () {
+        return NULL;
+    }
+    virtual bool unmap () {
+        return true;
+    }
+    virtual int get_fd () {
+        return -1;
+    }
+};
+
+class BranchProcessor
+    : public ImageProcessor
+{
+public:
+    explicit BranchProcessor (const char *name, BranchMode mode, int64_t interval)
+        : ImageProcessor (name)
+        , _mode (mode)
+        , _interval (interval)
+    {
+        set_input (InputCapture);
+    }
+
+protected:
+    virtual bool can_process_result (SmartPtr<X3aResult> &result) {
+        XCAM_UNUSED (result);
+        return false;
+    }
+    virtual XCamReturn apply_3a_results (X3aResultList &results) {
+        XCAM_UNUSED (results);
+        return XCAM_RETURN_NO_ERROR;
+    }
+    virtual XCamReturn apply_3a_result (SmartPtr<X3aResult> &result) {
+        XCAM_UNUSED (result);
+        return XCAM_RETURN_NO_ERROR;
+    }
+    virtual XCamReturn process_buffer (SmartPtr<VideoBuffer> &input, SmartPtr<VideoBuffer> &output) {
+        int64_t frame = input->get_timestamp ();
+        bool hit = (_interval > 0 && frame % _interval == _interval - 1);
+
+        switch (_mode) {
+        case BranchFail:
+            if (hit)
+                return XCAM_RETURN_ERROR_UNKNOWN;
+            break;
+        case BranchDrop:
+            if (hit) {
+                notify_process_buffer_dropped (input);
+                return XCAM_RETURN_BYPASS;
+            }
+            break;
+        case BranchLose:
+            if (frame == _interval)
+                return XCAM_RETURN_BYPASS;
+            break;
+        default:
+            break;
+        }
+        output = input;
+        return XCAM_RETURN_NO_ERROR;
+    }
+
+private:
+    BranchMode   _mode;
+    int64_t      _interval;
+};
+
+class TestOutputCallback
+    : public ImageProcessCallback
+{
+public:
+    TestOutputCallback ()
+        : _disorders (0)
+    {}
+
+    virtual void process_buffer_done (ImageProcessor *processor, const SmartPtr<VideoBuffer> &buf) {
+        XCAM_UNUSED (processor);
+        SmartLock locker (_mutex);
+        int64_t frame = buf->get_timestamp ();
+        if (!_outputs.empty () && frame <= _outputs.back ()) {
+            XCAM_LOG_ERROR ("frame(%d) delivered after frame(%d)", (int32_t)frame, (int32_t)_outputs.back ());
+            ++_disorders;
+        }
+        _outputs.push_back (frame);
+        _cond.broadcast ();
+    }
+    virtual void process_buffer_failed (ImageProcessor *processor, const SmartPtr<VideoBuffer> &buf) {
+        XCAM_UNUSED (processor);
+        XCAM_UNUSED (buf);
+    }
+
+    bool wait_outputs (uint32_t count, uint32_t timeout_us) {
+        SmartLock locker (_mutex);
+        while (_outputs.size () < count) {
+            if (_cond.timedwait (_mutex, timeout_us) != 0)
+                return _outputs.size () >= count;
+        }
+        return true;
+    }
+    uint32_t get_disorders () {
+        SmartLock locker (_mutex);
+        return _disorders;
+    }
+
+private:
+    Mutex                  _mutex;
+    Cond                   _cond;
+    std::vector<int64_t>   _outputs;
+    uint32_t               _disorders;
+};
+
+static void
+print_help (const char *bin_name)
+{
+    printf ("Usage: %s [-n frames]\n"
+            "\t -n frames     frames to put, default 100\n"
+            "\t -h            help\n"
+            , bin_name);
+}
+
+int main (int argc, char *argv[])
+{
+    uint32_t frame_count = 100;
+    TestOutputCallback callback;
+    int opt;
+
+    while ((opt =  getopt(argc, argv, "n:h")) != -1) {
+        switch (opt) {
+        case 'n':
+            frame_count = atoi (optarg);
+            break;
+        case 'h':
+            print_help (argv[0]);
+            return 0;
+        default:
+            print_help (argv[0]);
+            return -1;
+        }
+    }
+    CHECK_EXP (frame_count >= 4, "at least 4 frames");
+
+    uint32_t lost_frame = frame_count / 2;
+    SmartPtr<ImageProcessor> processors[] = {
+        new BranchProcessor ("branch_fail", BranchFail, 5),
+        new BranchProcessor ("branch_drop", BranchDrop, 7),
+        new BranchProcessor ("branch_lose", BranchLose, lost_frame),
+        // inserted last, its outputs go to the callback
+        new BranchProcessor ("branch_output", BranchPass, 0),
+    };
+
+    SmartPtr<X3aImageProcessCenter> center = new X3aImageProcessCenter;
+    for (uint32_t i = 0; i < sizeof (processors) / sizeof (processors[0]); ++i)
+        center->insert_processor (processors[i]);
+    center->set_image_callback (&callback);
+    CHECK (center->start (), "process center start failed");
+
+    int failed = 0;
+    for (uint32_t i = 0; i < frame_count && !failed; ++i) {
+        SmartPtr<VideoBuffer> buf = new TestBuffer (i);
+        CHECK_DECLARE (ERROR, center->put_buffer (buf), failed = -1; break, "put frame(%d) failed", i);
+
+        if (i == lost_frame) {
+            // only the next frame checks the join timeout
+            usleep ((XCAM_PROCESS_CENTER_JOIN_TIMEOUT + 50) * 1000);
+            continue;
+        }
+        CHECK_DECLARE (
+            ERROR, callback.wait_outputs (i + 1, TEST_OUTPUT_WAIT_US), failed = -1,
+            "frame(%d) output held back by the join", i);
+    }
+    center->stop ();
+
+    CHECK_DECLARE (ERROR, !callback.get_disorders (), failed = -1, "outputs out of capture order");
+    if (failed) {
+        printf ("process center test FAILED\n");
+        return -1;
+    }
+    printf ("process center test PASSED\n");
+    return 0;
+}
@@ -0,0 +1,183 @@
+/*
+ * test-sensor-descriptor.cpp - test sensor descriptor lookup tables
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#include "test_common.h"
+#include "sensor_descriptor.h"
+#include <math.h>
+#include <sys/time.h>
+
+/*
+ * every conversion with lookup tables must equal the direct computation,
+ * times are swept microsecond by microsecond past the end of the table,
+ * gains densely and ulp by ulp around each code step
+ */
+
+using namespace XCam;
+
+struct SensorMode {
+    const char *name;
+    uint32_t    pixel_clock;
+    uint32_t    line_length;
+    uint32_t    frame_length;
+};
+
+static const SensorMode sensor_modes[] = {
+    {"1080p30", 74250000, 2200, 1125},
+    {"imx185-wdr", 37125000, 1110, 1125},
+    {"5m", 199200000, 4572, 1984},
+    {"odd", 96000001, 3001, 777},
+    {"vga", 24000000, 800, 525},
+};
+
+static double
+now_ms ()
+{
+    struct timeval tv;
+    gettimeofday (&tv, NULL);
+    return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+}
+
+static bool
+check_times (SensorDescriptor &table, SensorDescriptor &direct, const SensorMode &mode)
+{
+    // four frames in the table, run twice as far to cover the direct fallback
+    int32_t max_time = (int64_t)mode.frame_length * mode.line_length * 8 * 1000000 / mode.pixel_clock;
+    uint32_t errors = 0;
+
+    for (int32_t time = -2; time <= max_time; ++time) {
+        uint32_t coarse[2] = {0, 0}, fine[2] = {0, 0};
+        bool ret[2];
+        ret[0] = table.exposure_time_to_integration (time, coarse[0], fine[0]);
+        ret[1] = direct.exposure_time_to_integration (time, coarse[1], fine[1]);
+        if (ret[0] != ret[1] || coarse[0] != coarse[1] || fine[0] != fine[1]) {
+            if (errors++ < 8) {
+                XCAM_LOG_ERROR (
+                    "%s: time %d to (%d, %d), expected (%d, %d)",
+                    mode.name, time, coarse[0], fine[0], coarse[1], fine[1]);
+            }
+        }
+    }
+    return errors == 0;
+}
+
+static bool
+check_gain (SensorDescriptor &table, SensorDescriptor &direct, double gain)
+{
+    int32_t code[2] = {-1, -1}, digital[2] = {-1, -1};
+    table.exposure_gain_to_code (gain, 1.0, code[0], digital[0]);
+    direct.exposure_gain_to_code (gain, 1.0, code[1], digital[1]);
+    if (code[0] != code[1] || digital[0] != digital[1]) {
+        XCAM_LOG_ERROR ("gain %.17g to code %d, expected %d", gain, code[0], code[1]);
+        return false;
+    }
+    return true;
+}
+
+static bool
+check_gains (SensorDescriptor &table, SensorDescriptor &direct)
+{
+    uint32_t errors = 0;
+
+    for (double gain = 0.5; gain < 300.0; gain *= 1.0001)
+        errors += !check_gain (table, direct, gain);
+
+    // code steps lie near the gains the codes convert back to
+    for (int32_t code = -4; code <= XCAM_SENSOR_GAIN_MAX_CODE + 4; ++code) {
+        double gain[2], digital[2];
+        table.exposure_code_to_gain (code, 0, gain[0], digital[0]);
+        direct.exposure_code_to_gain (code, 0, gain[1], digital[1]);
+        if (gain[0] != gain[1] || digital[0] != digital[1]) {
+            XCAM_LOG_ERROR ("code %d to gain %.17g, expected %.17g", code, gain[0], gain[1]);
+            ++errors;
+        }
+        if (gain[1] < 1.0)
+            continue;
+
+        double low = gain[1], high = gain[1];
+        for (uint32_t i = 0; i < 256; ++i) {
+            low = nextafter (low, 0.0);
+            high = nextafter (high, HUGE_VAL);
+            errors += !check_gain (table, direct, low);
+            errors += !check_gain (table, direct, high);
+        }
+    }
+    errors += !check_gain (table, direct, 1.0);
+    errors += !check_gain (table, direct, 256.0);
+    errors += !check_gain (table, direct, 1e6);
+
+    return errors == 0;
+}
+
+static void
+bench (SensorDescriptor &sensor, const char *name, int32_t max_time)
+{
+    uint32_t coarse = 0, fine = 0, sum = 0;
+    int32_t analog = 0, digital = 0;
+    const uint32_t rounds = 1000000;
+
+    double start = now_ms ();
+    for (uint32_t i = 0; i < rounds; ++i) {
+        sensor.exposure_time_to_integration (i % max_time, coarse, fine);
+        sensor.exposure_gain_to_code (1.0 + (i % 2000) * 0.1, 1.0, analog, digital);
+        sum += coarse + fine + analog;
+    }
+    double elapsed = now_ms () - start;
+    printf ("%s: %.1fns per exposure (checksum %u)\n", name, elapsed * 1000000.0 / rounds, sum);
+}
+
+int main (int argc, char *argv[])
+{
+    SensorDescriptor table, direct;
+    bool ok = true;
+
+    XCAM_UNUSED (argc);
+    XCAM_UNUSED (argv);
+    direct.set_lookup_enable (false);
+
+    for (uint32_t i = 0; i < sizeof (sensor_modes) / sizeof (sensor_modes[0]); ++i) {
+        const SensorMode &mode = sensor_modes[i];
+        struct atomisp_sensor_mode_data data;
+        xcam_mem_clear (data);
+        data.vt_pix_clk_freq_mhz = mode.pixel_clock;
+        data.line_length_pck = mode.line_length;
+        data.frame_length_lines = mode.frame_length;
+        table.set_sensor_data (data);
+        direct.set_sensor_data (data);
+
+        bool mode_ok = check_times (table, direct, mode);
+        printf ("sensor mode %s: exposure time %s\n", mode.name, mode_ok ? "exact" : "MISMATCH");
+        ok = ok && mode_ok;
+    }
+
+    bool gain_ok = check_gains (table, direct);
+    printf ("exposure gain: %s\n", gain_ok ? "exact" : "MISMATCH");
+    ok = ok && gain_ok;
+
+    int32_t frame_time = 33333;
+    bench (table, "table", frame_time);
+    bench (direct, "direct", frame_time);
+
+    if (!ok) {
+        printf ("sensor descriptor test FAILED\n");
+        return -1;
+    }
+    printf ("sensor descriptor test PASSED\n");
+    return 0;
+}
@@ -0,0 +1,703 @@
+/*
+ * test-soak.cpp - long running pipeline, tracks memory, queues and latency
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#include "device_manager.h"
+#include "fake_v4l2_device.h"
+#include "fake_poll_thread.h"
+#include "sim_sensor.h"
+#include "isp_controller.h"
+#include "isp_image_processor.h"
+#include "soft_image_processor.h"
+#include "soft_csc_handler.h"
+#include "x3a_analyzer_simple.h"
+#include "introspection.h"
+#if HAVE_LIBCL
+#include "cl_3a_image_processor.h"
+#endif
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <getopt.h>
+#include <math.h>
+#include <inttypes.h>
+#include <time.h>
+#include "test_common.h"
+
+using namespace XCam;
+
+// latency entries of frames never coming out are pruned after this
+#define SOAK_LATENCY_TIMEOUT 10000000 // us
+// fewer samples after warmup than this can't tell a trend
+#define SOAK_MIN_TREND_SAMPLES 8
+
+static Mutex g_mutex;
+static Cond  g_cond;
+static bool  g_stop = false;
+
+struct SoakSample {
+    double                  time;          // seconds since start
+    uint64_t                rss_kb;
+    uint32_t                frames;
+    double                  fps;
+    double                  latency[4];    // p50, p90, p99, max in ms
+    std::vector<double>     values;        // SoakTimeline columns
+};
+
+static const char *latency_names[4] = {"latency_p50_ms", "latency_p90_ms", "latency_p99_ms", "latency_max_ms"};
+
+static int64_t
+soak_get_time ()
+{
+    struct timespec now;
+    clock_gettime (CLOCK_MONOTONIC, &now);
+    return XCAM_TIMESPEC_2_USEC (now);
+}
+
+static uint64_t
+soak_get_rss_kb ()
+{
+    unsigned long size = 0, resident = 0;
+    FILE *fp = fopen ("/proc/self/statm", "r");
+    if (!fp)
+        return 0;
+    if (fscanf (fp, "%lu %lu", &size, &resident) != 2)
+        resident = 0;
+    fclose (fp);
+    return (uint64_t)resident * (sysconf (_SC_PAGESIZE) / 1024);
+}
+
+/*
+ * flattens numeric leaves of an introspection snapshot into keys like
+ * "process_center.processors.IspImageProcessor.input_queue",
+ * array elements are named by their "name" member when it comes first
+ */
+static void
+flatten_introspection (const std::string &text, std::vector<std::pair<std::string, double> > &values)
+{
+    struct Level {
+        std::string   path;
+        bool          array;
+        uint32_t      index;
+    };
+    std::vector<Level> levels;
+    std::string key;
+    bool value_expected = false;
+
+    for (size_t i = 0; i < text.size (); ++i) {
+        char c = text[i];
+        std::string path = levels.empty () ? std::string () : levels.back ().path;
+
+        if (c == '{' || c == '[') {
+            Level level;
+            if (!levels.empty () && levels.back ().array) {
+                char index[16];
+                snprintf (index, sizeof (index), "[%d]", levels.back ().index);
+                level.path = path + index;
+            } else if (value_expected)
+                level.path = path.empty () ? key : path + "." + key;
+            level.array = (c == '[');
+            level.index = 0;
+            levels.push_back (level);
+            value_expected = false;
+        } else if (c == '}' || c == ']') {
+            if (!levels.empty ())
+                levels.pop_back ();
+        } else if (c == ',') {
+            if (!levels.empty () && levels.back ().array)
+                ++levels.back ().index;
+        } else if (c == ':') {
+            value_expected = true;
+        } else if (c == '"') {
+            std::string str;
+            for (++i; i < text.size () && text[i] != '"'; ++i) {
+                if (text[i] == '\\')
+                    ++i;
+                str += text[i];
+            }
+            if (!value_expected) {
+                key = str;
+                continue;
+            }
+            value_expected = false;
+            // {"name":"xxx", ...} inside an array, use the name as path
+            if (key == "name" && levels.size () > 1 && levels[levels.size () - 2].array) {
+                Level &parent = levels[levels.size () - 2];
+                levels.back ().path = parent.path + "." + str;
+            }
+        } else if (value_expected && (c == '-' || isdigit (c) || c == 't' || c == 'f')) {
+            double value = 0.0;
+            size_t end = i;
+            if (c == 't' || c == 'f') {
+                value = (c == 't') ? 1.0 : 0.0;
+                end = i + (c == 't' ? 4 : 5);
+            } else {
+                char *stop = NULL;
+                value = strtod (text.c_str () + i, &stop);
+                end = stop - text.c_str ();
+            }
+            values.push_back (std::make_pair (path.empty () ? key : path + "." + key, value));
+            value_expected = false;
+            i = end - 1;
+        } else if (value_expected && c == 'n') {
+            // null
+            value_expected = false;
+            i += 3;
+        }
+    }
+}
+
+class SoakDeviceManager
+    : public DeviceManager
+{
+public:
+    SoakDeviceManager ()
+        : _frames (0)
+    {}
+
+    // frames out since the last call and their latency percentiles
+    uint32_t collect_latency (double latency[4]);
+
+protected:
+    virtual void handle_message (const SmartPtr<XCamMessage> &msg) {
+        XCAM_UNUSED (msg);
+    }
+    virtual void handle_buffer (const SmartPtr<VideoBuffer> &buf);
+    virtual XCamReturn poll_buffer_ready (SmartPtr<VideoBuffer> &buf);
+
+private:
+    Mutex                         _lock;
+    // capture timestamp to arrival time
+    std::map<int64_t, int64_t>    _in_flight;
+    std::vector<double>           _latencies;
+    uint32_t                      _frames;
+};
+
+XCamReturn
+SoakDeviceManager::poll_buffer_ready (SmartPtr<VideoBuffer> &buf)
+{
+    int64_t now = soak_get_time ();
+
+    // raw file source doesn't timestamp, processors carry it to the output
+    if (buf->get_timestamp () == InvalidTimestamp || buf->get_timestamp () == 0)
+        buf->set_timestamp (now);
+    {
+        SmartLock locker (_lock);
+        _in_flight[buf->get_timestamp ()] = now;
+    }
+    return DeviceManager::poll_buffer_ready (buf);
+}
+
+void
+SoakDeviceManager::handle_buffer (const SmartPtr<VideoBuffer> &buf)
+{
+    int64_t now = soak_get_time ();
+
+    SmartLock locker (_lock);
+    std::map<int64_t, int64_t>::iterator i = _in_flight.find (buf->get_timestamp ());
+    if (i == _in_flight.end ())
+        return;
+    _latencies.push_back ((now - i->second) / 1000.0);
+    _in_flight.erase (i);
+    ++_frames;
+}
+
+uint32_t
+SoakDeviceManager::collect_latency (double latency[4])
+{
+    std::vector<double> latencies;
+    uint32_t frames = 0;
+    int64_t now = soak_get_time ();
+
+    {
+        SmartLock locker (_lock);
+        latencies.swap (_latencies);
+        frames = _frames;
+        _frames = 0;
+
+        for (std::map<int64_t, int64_t>::iterator i = _in_flight.begin (); i != _in_flight.end ();) {
+            if (now - i->second > SOAK_LATENCY_TIMEOUT)
+                _in_flight.erase (i++);
+            else
+                ++i;
+        }
+    }
+
+    for (uint32_t i = 0; i < 4; ++i)
+        latency[i] = 0.0;
+    if (latencies.empty ())
+        return frames;
+
+    std::sort (latencies.begin (), latencies.end ());
+    const size_t last = latencies.size () - 1;
+    latency[0] = latencies[last * 50 / 100];
+    latency[1] = latencies[last * 90 / 100];
+    latency[2] = latencies[last * 99 / 100];
+    latency[3] = latencies[last];
+    return frames;
+}
+
+/*
+ * SoakTimeline
+ * one row per sample. Columns are rss, fps, latency percentiles and the
+ * queue, pool and sensor counters found in the first introspection
+ * snapshot.
+ */
+class SoakTimeline
+{
+public:
+    SoakTimeline (double warmup, double rss_growth_kb, double drift)
+        : _warmup (warmup)
+        , _rss_growth_kb (rss_growth_kb)
+        , _drift (drift)
+    {}
+
+    void add (SoakSample &sample, const std::string &snapshot);
+    bool write (const char *path, bool json);
+    // prints what regressed, returns the number of findings
+    uint32_t check ();
+
+private:
+    static bool is_tracked (const std::string &key);
+    static bool is_growth_checked (const std::string &key);
+    void check_growth (
+        const char *name, const std::vector<double> &values,
+        double tolerance, uint32_t &findings);
+
+private:
+    double                      _warmup;
+    double                      _rss_growth_kb;
+    double                      _drift;
+    std::vector<std::string>    _columns;
+    std::vector<SoakSample>     _samples;
+};
+
+bool
+SoakTimeline::is_tracked (const std::string &key)
+{
+    return key.find ("queue") != std::string::npos ||
+           key.find ("pending") != std::string::npos ||
+           key.find ("pool.") != std::string::npos ||
+           key.find ("sim_sensor.") != std::string::npos;
+}
+
+bool
+SoakTimeline::is_growth_checked (const std::string &key)
+{
+    static const char *skipped[] = {".free", ".frames", ".dropped", ".late", ".exposure_time_us", ".gain"};
+
+    if (key.find ("sim_sensor.") != std::string::npos && key.find ("queued_buffers") == std::string::npos)
+        return false;
+    for (uint32_t i = 0; i < sizeof (skipped) / sizeof (skipped[0]); ++i) {
+        size_t len = strlen (skipped[i]);
+        if (key.size () >= len && key.compare (key.size () - len, len, skipped[i]) == 0)
+            return false;
+    }
+    return true;
+}
+
+void
+SoakTimeline::add (SoakSample &sample, const std::string &snapshot)
+{
+    std::vector<std::pair<std::string, double> > values;
+    flatten_introspection (snapshot, values);
+
+    // columns are fixed by the first sample, processors don't change later
+    if (_samples.empty ()) {
+        for (size_t i = 0; i < values.size (); ++i) {
+            if (is_tracked (values[i].first))
+                _columns.push_back (values[i].first);
+        }
+    }
+
+    sample.values.assign (_columns.size (), 0.0);
+    for (size_t i = 0; i < values.size (); ++i) {
+        std::vector<std::string>::iterator col = std::find (_columns.begin (), _columns.end (), values[i].first);
+        if (col != _columns.end ())
+            sample.values[col - _columns.begin ()] = values[i].second;
+    }
+    _samples.push_back (sample);
+}
+
+bool
+SoakTimeline::write (const char *path, bool json)
+{
+    FILE *fp = fopen (path, "w");
+    if (!fp) {
+        XCAM_LOG_ERROR ("open timeline file(%s) failed", path);
+        return false;
+    }
+
+    if (json)
+        fprintf (fp, "[\n");
+    else {
+        fprintf (fp, "time_s,rss_kb,frames,fps");
+        for (uint32_t i = 0; i < 4; ++i)
+            fprintf (fp, ",%s", latency_names[i]);
+        for (size_t i = 0; i < _columns.size (); ++i)
+            fprintf (fp, ",%s", _columns[i].c_str ());
+        fprintf (fp, "\n");
+    }
+
+    for (size_t s = 0; s < _samples.size (); ++s) {
+        const SoakSample &sample = _samples[s];
+        if (json) {
+            fprintf (fp, "  {\"time_s\":%.1f,\"rss_kb\":%" PRIu64 ",\"frames\":%d,\"fps\":%.2f",
+                     sample.time, sample.rss_kb, sample.frames, sample.fps);
+            for (uint32_t i = 0; i < 4; ++i)
+                fprintf (fp, ",\"%s\":%.3f", latency_names[i], sample.latency[i]);
+            for (size_t i = 0; i < _columns.size (); ++i)
+                fprintf (fp, ",\"%s\":%g", _columns[i].c_str (), sample.values[i]);
+            fprintf (fp, "}%s\n", s + 1 < _samples.size () ? "," : "");
+        } else {
+            fprintf (fp, "%.1f,%" PRIu64 ",%d,%.2f", sample.time, sample.rss_kb, sample.frames, sample.fps);
+            for (uint32_t i = 0; i < 4; ++i)
+                fprintf (fp, ",%.3f", sample.latency[i]);
+            for (size_t i = 0; i < _columns.size (); ++i)
+                fprintf (fp, ",%g", sample.values[i]);
+            fprintf (fp, "\n");
+        }
+    }
+
+    if (json)
+        fprintf (fp, "]\n");
+    fclose (fp);
+    return true;
+}
+
+/*
+ * a value grew when even its lowest reading in the last quarter is above
+ * the highest one in the first quarter, so sawtooth queues don't trip it
+ */
+void
+SoakTimeline::check_growth (
+    const char *name, const std::vector<double> &values,
+    double tolerance, uint32_t &findings)
+{
+    const size_t quarter = values.size () / 4;
+    double first_max = *std::max_element (values.begin (), values.begin () + quarter);
+    double last_min = *std::min_element (values.end () - quarter, values.end ());
+
+    if (last_min > first_max + tolerance) {
+        printf ("GROWTH  %s: %g -> %g\n", name, first_max, last_min);
+        ++findings;
+    }
+}
+
+static double
+soak_median (std::vector<double> values)
+{
+    if (values.empty ())
+        return 0.0;
+    std::sort (values.begin (), values.end ());
+    return values[values.size () / 2];
+}
+
+uint32_t
+SoakTimeline::check ()
+{
+    std::vector<const SoakSample *> samples;
+    uint32_t findings = 0;
+
+    for (size_t i = 0; i < _samples.size (); ++i) {
+        if (_samples[i].time >= _warmup)
+            samples.push_back (&_samples[i]);
+    }
+    if (samples.size () < SOAK_MIN_TREND_SAMPLES) {
+        printf ("only %d samples after warmup, at least %d needed to check trends\n",
+                (int)samples.size (), SOAK_MIN_TREND_SAMPLES);
+        return 0;
+    }
+
+    std::vector<double> values;
+    for (size_t i = 0; i < samples.size (); ++i)
+        values.push_back (samples[i]->rss_kb);
+    check_growth ("rss_kb", values, _rss_growth_kb, findings);
+
+    for (size_t col = 0; col < _columns.size (); ++col) {
+        if (!is_growth_checked (_columns[col]))
+            continue;
+        values.clear ();
+        for (size_t i = 0; i < samples.size (); ++i)
+            values.push_back (samples[i]->values[col]);
+        check_growth (_columns[col].c_str (), values, 0.0, findings);
+    }
+
+    // percentile drift, medians of the first and last quarter windows
+    const size_t quarter = samples.size () / 4;
+    for (uint32_t p = 0; p < 3; ++p) {
+        std::vector<double> first, last;
+        for (size_t i = 0; i < quarter; ++i) {
+            first.push_back (samples[i]->latency[p]);
+            last.push_back (samples[samples.size () - quarter + i]->latency[p]);
+        }
+        double before = soak_median (first), after = soak_median (last);
+        // below 1ms it's scheduling noise
+        if (after > before * (1.0 + _drift) && after - before > 1.0) {
+            printf ("DRIFT   %s: %.2fms -> %.2fms\n", latency_names[p], before, after);
+            ++findings;
+        }
+    }
+
+    return findings;
+}
+
+void soak_stop_handler (int sig)
+{
+    XCAM_UNUSED (sig);
+
+    SmartLock locker (g_mutex);
+    g_stop = true;
+    g_cond.broadcast ();
+}
+
+void print_help (const char *bin_name)
+{
+    printf ("Usage: %s [--sim | --raw file] [options]\n"
+            "Runs a capture -> 3a analyzer -> processors pipeline for a long time and\n"
+            "samples memory, queue depths and frame latency into a timeline\n"
+            "\t --sim          synthetic sensor as source, default\n"
+            "\t --raw file     replay a raw file as source\n"
+            "\t -W width       frame width, default 1920\n"
+            "\t -H height      frame height, default 1080\n"
+            "\t -f pixel_fmt   fourcc, default NV12\n"
+            "\t --fps fps      sensor framerate, default 30\n"
+            "\t --noise value  sensor noise stddev, default 2.0\n"
+            "\t --pan pixels   sensor pan per frame, default 0\n"
+            "\t --soft-csc     add a cpu YUYV to NV12 processor\n"
+#if HAVE_LIBCL
+            "\t -c             add the cl 3a image processor\n"
+#endif
+            "\t -d seconds     duration, default 3600\n"
+            "\t -i seconds     sample interval, default 10\n"
+            "\t -w seconds     warmup excluded from checks, default 60\n"
+            "\t -o file        timeline output, default soak.csv\n"
+            "\t --json         write the timeline as json instead of csv\n"
+            "\t --rss-growth kb  rss growth allowed after warmup, default 4096\n"
+            "\t --drift ratio  latency percentile drift allowed, default 0.2\n"
+            "\t -h             help\n"
+            "exit code is 1 when growth or drift is found\n"
+            , bin_name);
+}
+
+int main (int argc, char *argv[])
+{
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+    SmartPtr<SoakDeviceManager> device_manager = new SoakDeviceManager;
+    SmartPtr<V4l2Device> device;
+    SmartPtr<IspController> isp_controller;
+    SmartPtr<X3aAnalyzer> analyzer;
+    SmartPtr<ImageProcessor> isp_processor;
+    SmartPtr<PollThread> poll_thread;
+    SimSensorConfig sim_config;
+    const char *raw_path = NULL;
+    uint32_t pixel_format = V4L2_PIX_FMT_NV12;
+    bool have_soft_csc = false;
+#if HAVE_LIBCL
+    bool have_cl_processor = false;
+#endif
+    double duration = 3600.0;
+    double interval = 10.0;
+    double warmup = 60.0;
+    const char *output = "soak.csv";
+    bool json = false;
+    double rss_growth_kb = 4096.0;
+    double drift = 0.2;
+    int opt;
+
+    const char *short_opts = "W:H:f:cd:i:w:o:h";
+    const struct option long_opts[] = {
+        {"sim", no_argument, NULL, 'S'},
+        {"raw", required_argument, NULL, 'r'},
+        {"fps", required_argument, NULL, 'F'},
+        {"noise", required_argument, NULL, 'N'},
+        {"pan", required_argument, NULL, 'P'},
+        {"soft-csc", no_argument, NULL, 'Z'},
+        {"json", no_argument, NULL, 'J'},
+        {"rss-growth", required_argument, NULL, 'G'},
+        {"drift", required_argument, NULL, 'D'},
+        {0, 0, 0, 0},
+    };
+
+    while ((opt = getopt_long (argc, argv, short_opts, long_opts, NULL)) != -1) {
+        switch (opt) {
+        case 'S':
+            raw_path = NULL;
+            break;
+        case 'r':
+            raw_path = optarg;
+            break;
+        case 'W':
+            sim_config.width = atoi (optarg);
+            break;
+        case 'H':
+            sim_config.height = atoi (optarg);
+            break;
+        case 'f':
+            CHECK_EXP ((strlen (optarg) == 4), "invalid pixel format\n");
+            pixel_format = v4l2_fourcc ((unsigned)optarg[0], (unsigned)optarg[1],
+                                        (unsigned)optarg[2], (unsigned)optarg[3]);
+            break;
+        case 'F':
+            sim_config.fps_n = atoi (optarg);
+            break;
+        case 'N':
+            sim_config.noise = atof (optarg);
+            break;
+        case 'P':
+            sim_config.pan_x = atof (optarg);
+            break;
+        case 'Z':
+            have_soft_csc = true;
+            break;
+#if HAVE_LIBCL
+        case 'c':
+            have_cl_processor = true;
+            break;
+#endif
+        case 'd':
+            duration = atof (optarg);
+            break;
+        case 'i':
+            interval = atof (optarg);
+            break;
+        case 'w':
+            warmup = atof (optarg);
+            break;
+        case 'o':
+            output = optarg;
+            break;
+        case 'J':
+            json = true;
+            break;
+        case 'G':
+            rss_growth_kb = atof (optarg);
+            break;
+        case 'D':
+            drift = atof (optarg);
+            break;
+        case 'h':
+            print_help (argv[0]);
+            return 0;
+        default:
+            print_help (argv[0]);
+            return -1;
+        }
+    }
+    CHECK_EXP (duration > 0 && interval > 0 && sim_config.fps_n > 0, "invalid duration, interval or fps");
+    CHECK_EXP (
+        !have_soft_csc || pixel_format == V4L2_PIX_FMT_YUYV,
+        "soft csc needs YUYV input");
+    sim_config.format = pixel_format;
+
+    if (raw_path) {
+        device = new FakeV4l2Device ();
+        poll_thread = new FakePollThread (raw_path);
+    } else {
+        device = new SimSensorDevice (sim_config);
+        poll_thread = new SimSensorPollThread ();
+    }
+    isp_controller = new IspController (device);
+    analyzer = new X3aAnalyzerSimple ();
+
+    device->set_sensor_id (0);
+    device->set_mem_type (V4L2_MEMORY_MMAP);
+    device->set_buffer_count (8);
+    device->set_framerate (sim_config.fps_n, 1);
+    ret = device->open ();
+    CHECK (ret, "device(%s) open failed", device->get_device_name ());
+    ret = device->set_format (
+              sim_config.width, sim_config.height, pixel_format, V4L2_FIELD_NONE, sim_config.width * 2);
+    CHECK (ret, "device(%s) set format failed", device->get_device_name ());
+
+    device_manager->set_capture_device (device);
+    device_manager->set_isp_controller (isp_controller);
+    device_manager->set_3a_analyzer (analyzer);
+    device_manager->set_poll_thread (poll_thread);
+
+    // exposure results go back to the sensor, closing the 3a loop
+    isp_processor = new IspImageProcessor (isp_controller);
+    device_manager->add_image_processor (isp_processor);
+
+    if (have_soft_csc) {
+        SmartPtr<SoftImageProcessor> soft_processor = new SoftImageProcessor ("soft_csc_processor");
+        SmartPtr<SoftImageHandler> csc_handler = create_soft_csc_image_handler (V4L2_PIX_FMT_NV12);
+        soft_processor->add_handler (csc_handler);
+        device_manager->add_image_processor (soft_processor);
+    }
+#if HAVE_LIBCL
+    if (have_cl_processor) {
+        SmartPtr<CL3aImageProcessor> cl_processor = new CL3aImageProcessor ();
+        cl_processor->set_stats_callback (device_manager);
+        device_manager->add_image_processor (cl_processor);
+    }
+#endif
+
+    signal (SIGINT, soak_stop_handler);
+    signal (SIGTERM, soak_stop_handler);
+
+    ret = device_manager->start ();
+    CHECK (ret, "device manager start failed");
+
+    SoakTimeline timeline (warmup, rss_growth_kb, drift);
+    const int64_t begin = soak_get_time ();
+    int64_t last = begin;
+    while (true) {
+        int64_t next = last + (int64_t)(interval * 1000000);
+        {
+            SmartLock locker (g_mutex);
+            while (!g_stop && soak_get_time () < next)
+                g_cond.timedwait (g_mutex, 100000);
+            if (g_stop)
+                break;
+        }
+
+        int64_t now = soak_get_time ();
+        SoakSample sample;
+        sample.time = (now - begin) / 1000000.0;
+        sample.rss_kb = soak_get_rss_kb ();
+        sample.frames = device_manager->collect_latency (sample.latency);
+        sample.fps = sample.frames * 1000000.0 / (now - last);
+
+        IntrospectionWriter writer;
+        writer.begin_object ();
+        device_manager->introspect (writer);
+        writer.end_object ();
+        timeline.add (sample, writer.get_text ());
+        // rewritten each sample so a crashed run still leaves its timeline
+        timeline.write (output, json);
+        last = now;
+
+        printf ("%.0fs rss:%" PRIu64 "KB fps:%.1f latency p50:%.2fms p99:%.2fms\n",
+                sample.time, sample.rss_kb, sample.fps, sample.latency[0], sample.latency[2]);
+        if (sample.time >= duration)
+            break;
+    }
+
+    device_manager->stop ();
+    device->close ();
+
+    uint32_t findings = timeline.check ();
+    printf ("timeline written to %s, %d finding(s)\n", output, findings);
+    return findings ? 1 : 0;
+}
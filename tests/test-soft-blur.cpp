@@ -0,0 +1,292 @@
+/*
+ * test-soft-blur.cpp - benchmark and check soft(cpu) blur
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#include "test_common.h"
+#include "soft_blur.h"
+#include <getopt.h>
+#include <math.h>
+#include <vector>
+
+using namespace XCam;
+
+static const float test_sigmas[] = {1.0f, 2.0f, 4.0f, 8.0f, 16.0f, 32.0f};
+
+/*
+ * every output is checked against the same filter run line by line with
+ * SoftBlur::filter_line on the plane converted to float, so the SIMD
+ * conversions, transposes and worker split are covered for each type.
+ * tolerance is in units of the plane type: one step for u8 and u16
+ * (rounding after a different summation order), 0.01 for f32.
+ * -c also checks gaussian f32 against a direct gaussian in double within
+ * 0.01. box3 only approximates a gaussian, its distance to it is
+ * printed for reference and not checked.
+ */
+#define TEST_BLUR_INT_TOLERANCE 1.0
+#define TEST_BLUR_F32_TOLERANCE 0.01
+
+static double
+time_ms (const struct timeval &start, const struct timeval &end)
+{
+    return (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_usec - start.tv_usec) / 1000.0;
+}
+
+// direct 2D-separable gaussian in double, clamped edges
+static void
+reference_gaussian (
+    const std::vector<float> &in, std::vector<float> &out,
+    uint32_t width, uint32_t height, float sigma)
+{
+    int32_t radius = (int32_t)ceilf (sigma * 3.0f);
+    std::vector<double> kernel (radius * 2 + 1);
+    std::vector<double> tmp (width * height);
+    double sum = 0.0;
+
+    for (int32_t i = -radius; i <= radius; ++i) {
+        kernel[i + radius] = exp (-(double)(i * i) / (2.0 * sigma * sigma));
+        sum += kernel[i + radius];
+    }
+    for (int32_t i = 0; i <= radius * 2; ++i)
+        kernel[i] /= sum;
+
+    for (int32_t y = 0; y < (int32_t)height; ++y)
+        for (int32_t x = 0; x < (int32_t)width; ++x) {
+            double acc = 0.0;
+            for (int32_t i = -radius; i <= radius; ++i) {
+                int32_t sx = XCAM_MIN (XCAM_MAX (x + i, 0), (int32_t)width - 1);
+                acc += in[y * width + sx] * kernel[i + radius];
+            }
+            tmp[y * width + x] = acc;
+        }
+
+    out.resize (width * height);
+    for (int32_t y = 0; y < (int32_t)height; ++y)
+        for (int32_t x = 0; x < (int32_t)width; ++x) {
+            double acc = 0.0;
+            for (int32_t i = -radius; i <= radius; ++i) {
+                int32_t sy = XCAM_MIN (XCAM_MAX (y + i, 0), (int32_t)height - 1);
+                acc += tmp[sy * width + x] * kernel[i + radius];
+            }
+            out[y * width + x] = acc;
+        }
+}
+
+// the filter of blur, rows then columns, scalar and single threaded
+static void
+reference_filter (
+    const SoftBlur &blur, const std::vector<float> &in, std::vector<float> &out,
+    uint32_t width, uint32_t height)
+{
+    uint32_t pad = blur.get_pad ();
+    uint32_t n_max = XCAM_MAX (width, height);
+    std::vector<float> line (n_max + pad * 2), filtered (n_max);
+    std::vector<float> tmp (width * height);
+
+    for (uint32_t y = 0; y < height; ++y) {
+        memcpy (&line[pad], &in[y * width], width * sizeof (float));
+        blur.filter_line (&line[pad], width, &filtered[0]);
+        memcpy (&tmp[y * width], &filtered[0], width * sizeof (float));
+    }
+
+    out.resize (width * height);
+    for (uint32_t x = 0; x < width; ++x) {
+        for (uint32_t y = 0; y < height; ++y)
+            line[pad + y] = tmp[y * width + x];
+        blur.filter_line (&line[pad], height, &filtered[0]);
+        for (uint32_t y = 0; y < height; ++y)
+            out[y * width + x] = filtered[y];
+    }
+}
+
+template <typename T>
+static double
+max_error (const T *out, const std::vector<float> &reference)
+{
+    double error = 0.0;
+    for (uint32_t i = 0; i < reference.size (); ++i)
+        error = XCAM_MAX (error, fabs ((double)out[i] - reference[i]));
+    return error;
+}
+
+static XCamReturn
+bench_blur (SoftBlur &blur, const SoftPlane &in, const SoftPlane &out, uint32_t loops, double &mpix_per_sec)
+{
+    struct timeval start, end;
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+
+    // warm up, workers and intermediate buffer are created here
+    ret = blur.blur (in, out);
+    if (ret != XCAM_RETURN_NO_ERROR)
+        return ret;
+
+    gettimeofday (&start, NULL);
+    for (uint32_t i = 0; i < loops; ++i) {
+        ret = blur.blur (in, out);
+        if (ret != XCAM_RETURN_NO_ERROR)
+            return ret;
+    }
+    gettimeofday (&end, NULL);
+
+    mpix_per_sec = (double)in.width * in.height * loops / (time_ms (start, end) * 1000.0);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+static void
+print_help (const char *bin_name)
+{
+    printf ("Usage: %s [-W width] [-H height] [-p loops] [-t threads] [-c]\n"
+            "\t -W width     specify plane width, default: 1920\n"
+            "\t -H height    specify plane height, default: 1080\n"
+            "\t -p loops     specify blur loop count of each case, default: 20\n"
+            "\t -t threads   specify worker threads, default: 0 (online cpus)\n"
+            "\t -c           also check gaussian against a direct one in double, slow on large sigma\n"
+            "\t -h           help\n"
+            , bin_name);
+}
+
+int main (int argc, char *argv[])
+{
+    uint32_t width = 1920;
+    uint32_t height = 1080;
+    uint32_t loops = 20;
+    uint32_t threads = 0;
+    bool check = false;
+    int opt = 0;
+
+    while ((opt =  getopt(argc, argv, "W:H:p:t:ch")) != -1) {
+        switch (opt) {
+        case 'W':
+            width = atoi (optarg);
+            break;
+        case 'H':
+            height = atoi (optarg);
+            break;
+        case 'p':
+            loops = atoi (optarg);
+            break;
+        case 't':
+            threads = atoi (optarg);
+            break;
+        case 'c':
+            check = true;
+            break;
+        case 'h':
+            print_help (argv[0]);
+            return 0;
+        default:
+            print_help (argv[0]);
+            return -1;
+        }
+    }
+    CHECK_EXP (width && height && loops, "invalid size or loop count");
+
+    SmartPtr<SoftWorkerPool> workers = new SoftWorkerPool ("soft_blur_bench", threads);
+    std::vector<uint8_t> u8_in (width * height), u8_out (width * height);
+    std::vector<uint16_t> u16_in (width * height), u16_out (width * height);
+    std::vector<float> f32_in (width * height), f32_out (width * height);
+
+    // smooth gradient plus pseudo random noise
+    uint32_t seed = 1;
+    for (uint32_t i = 0; i < width * height; ++i) {
+        seed = seed * 1103515245 + 12345;
+        float v = ((i % width) * 128.0f / width) + (i / width) * 64.0f / height + ((seed >> 16) & 0x3f);
+        u8_in[i] = (uint8_t)v;
+        u16_in[i] = (uint16_t)(v * 256.0f);
+        f32_in[i] = v;
+    }
+
+    SoftPlane planes[][2] = {
+        {
+            SoftPlane (SoftPlaneU8, &u8_in[0], width, height, width),
+            SoftPlane (SoftPlaneU8, &u8_out[0], width, height, width)
+        },
+        {
+            SoftPlane (SoftPlaneU16, (uint8_t *)&u16_in[0], width, height, width * 2),
+            SoftPlane (SoftPlaneU16, (uint8_t *)&u16_out[0], width, height, width * 2)
+        },
+        {
+            SoftPlane (SoftPlaneF32, (uint8_t *)&f32_in[0], width, height, width * 4),
+            SoftPlane (SoftPlaneF32, (uint8_t *)&f32_out[0], width, height, width * 4)
+        },
+    };
+    const char *type_names[] = {"u8", "u16", "f32"};
+    const double tolerances[] = {TEST_BLUR_INT_TOLERANCE, TEST_BLUR_INT_TOLERANCE, TEST_BLUR_F32_TOLERANCE};
+    std::vector<float> float_in[3];
+    float_in[0].assign (u8_in.begin (), u8_in.end ());
+    float_in[1].assign (u16_in.begin (), u16_in.end ());
+    float_in[2] = f32_in;
+    uint32_t failures = 0;
+
+    printf ("soft blur %dx%d, %d worker threads\n", width, height, workers->get_thread_count ());
+    printf ("%-6s %-8s %-6s %12s %12s %12s\n", "sigma", "method", "type", "MPix/s", "max_err", "gauss_err");
+
+    for (uint32_t s = 0; s < sizeof (test_sigmas) / sizeof (test_sigmas[0]); ++s) {
+        SoftBlurMethod methods[] = {SoftBlurGaussian, SoftBlurBoxCascade};
+        std::vector<float> gauss_reference;
+
+        if (check)
+            reference_gaussian (f32_in, gauss_reference, width, height, test_sigmas[s]);
+
+        for (uint32_t m = 0; m < sizeof (methods) / sizeof (methods[0]); ++m) {
+            SoftBlur blur;
+            blur.set_workers (workers);
+            if (!blur.set_gaussian (test_sigmas[s], methods[m]))
+                continue;
+
+            for (uint32_t t = 0; t < sizeof (planes) / sizeof (planes[0]); ++t) {
+                double mpix_per_sec = 0.0;
+                XCamReturn ret = bench_blur (blur, planes[t][0], planes[t][1], loops, mpix_per_sec);
+                CHECK (ret, "blur sigma:%f type:%s failed", test_sigmas[s], type_names[t]);
+
+                std::vector<float> reference;
+                double error = 0.0;
+                reference_filter (blur, float_in[t], reference, width, height);
+                if (planes[t][1].type == SoftPlaneU8)
+                    error = max_error (&u8_out[0], reference);
+                else if (planes[t][1].type == SoftPlaneU16)
+                    error = max_error (&u16_out[0], reference);
+                else
+                    error = max_error (&f32_out[0], reference);
+
+                bool failed = (error > tolerances[t]);
+                char gauss_error[32] = "-";
+                if (check && planes[t][1].type == SoftPlaneF32) {
+                    double distance = max_error (&f32_out[0], gauss_reference);
+                    snprintf (gauss_error, sizeof (gauss_error), "%.4f", distance);
+                    if (methods[m] == SoftBlurGaussian && distance > TEST_BLUR_F32_TOLERANCE)
+                        failed = true;
+                }
+
+                printf (
+                    "%-6.1f %-8s %-6s %12.1f %12.4f %12s%s\n",
+                    test_sigmas[s], (methods[m] == SoftBlurGaussian ? "gauss" : "box3"),
+                    type_names[t], mpix_per_sec, error, gauss_error, (failed ? "  FAILED" : ""));
+                if (failed)
+                    ++failures;
+            }
+        }
+    }
+
+    if (failures) {
+        printf ("soft blur test FAILED, %d cases out of tolerance\n", failures);
+        return -1;
+    }
+    printf ("soft blur test PASSED\n");
+    return 0;
+}
@@ -0,0 +1,326 @@
+/*
+ * test-soft-image.cpp - test soft(cpu) image handlers
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#include "test_common.h"
+#include "soft_buffer_pool.h"
+#include "soft_yuv_pipe_handler.h"
+#include "soft_csc_handler.h"
+#include "soft_lut3d_handler.h"
+#include "soft_lab_handler.h"
+#include <getopt.h>
+
+using namespace XCam;
+
+enum TestHandlerType {
+    TestHandlerUnknown  = 0,
+    TestHandlerYuvPipe,
+    TestHandlerCsc,
+    TestHandlerLut3d,
+    TestHandlerLab,
+    TestHandlerLabHdr,
+};
+
+struct TestFileHandle {
+    FILE *fp;
+    TestFileHandle ()
+        : fp (NULL)
+    {}
+    ~TestFileHandle ()
+    {
+        if (fp)
+            fclose (fp);
+    }
+};
+
+static XCamReturn
+read_buf (SmartPtr<VideoBuffer> &buf, TestFileHandle &file)
+{
+    const VideoBufferInfo info = buf->get_video_info ();
+    VideoBufferPlanarInfo planar;
+    uint8_t *memory = NULL;
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+
+    memory = buf->map ();
+    for (uint32_t index = 0; index < info.components; index++) {
+        info.get_planar_info (planar, index);
+        uint32_t line_bytes = planar.width * planar.pixel_bytes;
+
+        for (uint32_t i = 0; i < planar.height; i++) {
+            if (fread (memory + info.offsets [index] + i * info.strides [index], 1, line_bytes, file.fp) != line_bytes) {
+                if (feof (file.fp))
+                    ret = XCAM_RETURN_BYPASS;
+                else {
+                    XCAM_LOG_ERROR ("read file failed, size doesn't match");
+                    ret = XCAM_RETURN_ERROR_FILE;
+                }
+            }
+        }
+    }
+    buf->unmap ();
+    return ret;
+}
+
+static XCamReturn
+write_buf (SmartPtr<VideoBuffer> &buf, TestFileHandle &file)
+{
+    const VideoBufferInfo info = buf->get_video_info ();
+    VideoBufferPlanarInfo planar;
+    uint8_t *memory = NULL;
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+
+    memory = buf->map ();
+    for (uint32_t index = 0; index < info.components; index++) {
+        info.get_planar_info (planar, index);
+        uint32_t line_bytes = planar.width * planar.pixel_bytes;
+
+        for (uint32_t i = 0; i < planar.height; i++) {
+            if (fwrite (memory + info.offsets [index] + i * info.strides [index], 1, line_bytes, file.fp) != line_bytes) {
+                XCAM_LOG_ERROR ("write file failed, size doesn't match");
+                ret = XCAM_RETURN_ERROR_FILE;
+            }
+        }
+    }
+    buf->unmap ();
+    return ret;
+}
+
+static XCamReturn
+handler_loop (SmartPtr<SoftImageHandler> &image_handler, SmartPtr<VideoBuffer> &input_buf, uint32_t loop_count)
+{
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+    for (uint32_t i = 0; i < loop_count; i++) {
+        SmartPtr<VideoBuffer> output_buf;
+        PROFILING_START (soft_handler);
+        ret = image_handler->execute (input_buf, output_buf);
+        PROFILING_END (soft_handler, loop_count)
+        if (ret != XCAM_RETURN_NO_ERROR)
+            break;
+    }
+    return ret;
+}
+
+static void
+print_help (const char *bin_name)
+{
+    printf ("Usage: %s -t type -f format -i input -o output\n"
+            "\t -t type      specify image handler type\n"
+            "\t              select from [yuvpipe, csc, lut3d, lab, labhdr]\n"
+            "\t -f input_format    specify a input format\n"
+            "\t              select from [RGB48P, RGB24P, YUYV, UYVY]\n"
+            "\t -g output_format   specify a output format\n"
+            "\t              select from [NV12, YUV420, RGB24P], default: NV12\n"
+            "\t -W image width     specify input image width\n"
+            "\t -H image height    specify input image height\n"
+            "\t -i input     specify input file path\n"
+            "\t -o output    specify output file path\n"
+            "\t -p count     specify handler loop count for profiling\n"
+            "\t -n           enable yuv temporal noise reduction, default: disable\n"
+            "\t -l size      specify 3D lut size, default: 17\n"
+            "\t -x           use tetrahedral 3D lut interpolation, default: trilinear\n"
+            "\t -h           help\n"
+            , bin_name);
+}
+
+int main (int argc, char *argv[])
+{
+    uint32_t input_format = 0;
+    uint32_t output_format = V4L2_PIX_FMT_NV12;
+    uint32_t width = 1920;
+    uint32_t height = 1080;
+    uint32_t buf_count = 0;
+    int32_t loop_count = 0;
+    const char *input_file = NULL, *output_file = NULL;
+    TestFileHandle input_fp, output_fp;
+    const char *bin_name = argv[0];
+    TestHandlerType handler_type = TestHandlerUnknown;
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+    SmartPtr<SoftImageHandler> image_handler;
+    VideoBufferInfo input_buf_info;
+    SmartPtr<BufferPool> buf_pool;
+    bool enable_tnr = false;
+    uint32_t lut_size = XCAM_LUT3D_SIZE_SMALL;
+    Lut3dInterpolation lut_interp = Lut3dTrilinear;
+    int opt = 0;
+
+    while ((opt =  getopt(argc, argv, "f:g:W:H:i:o:t:p:nl:xh")) != -1) {
+        switch (opt) {
+        case 'i':
+            input_file = optarg;
+            break;
+        case 'o':
+            output_file = optarg;
+            break;
+        case 'f': {
+            if (!strcasecmp (optarg, "rgb48p"))
+                input_format = XCAM_PIX_FMT_RGB48_planar;
+            else if (!strcasecmp (optarg, "rgb24p"))
+                input_format = XCAM_PIX_FMT_RGB24_planar;
+            else if (!strcasecmp (optarg, "yuyv"))
+                input_format = V4L2_PIX_FMT_YUYV;
+            else if (!strcasecmp (optarg, "uyvy"))
+                input_format = V4L2_PIX_FMT_UYVY;
+            else
+                print_help (bin_name);
+            break;
+        }
+        case 'g': {
+            if (!strcasecmp (optarg, "nv12"))
+                output_format = V4L2_PIX_FMT_NV12;
+            else if (!strcasecmp (optarg, "yuv420"))
+                output_format = V4L2_PIX_FMT_YUV420;
+            else if (!strcasecmp (optarg, "rgb24p"))
+                output_format = XCAM_PIX_FMT_RGB24_planar;
+            else
+                print_help (bin_name);
+            break;
+        }
+        case 'W':
+            width = atoi (optarg);
+            break;
+        case 'H':
+            height = atoi (optarg);
+            break;
+        case 't': {
+            if (!strcasecmp (optarg, "yuvpipe"))
+                handler_type = TestHandlerYuvPipe;
+            else if (!strcasecmp (optarg, "csc"))
+                handler_type = TestHandlerCsc;
+            else if (!strcasecmp (optarg, "lut3d"))
+                handler_type = TestHandlerLut3d;
+            else if (!strcasecmp (optarg, "lab"))
+                handler_type = TestHandlerLab;
+            else if (!strcasecmp (optarg, "labhdr"))
+                handler_type = TestHandlerLabHdr;
+            else
+                print_help (bin_name);
+            break;
+        }
+        case 'p':
+            loop_count = atoi (optarg);
+            XCAM_ASSERT (loop_count >= 0 && loop_count < INT32_MAX);
+            break;
+        case 'n':
+            enable_tnr = true;
+            break;
+        case 'l':
+            lut_size = atoi (optarg);
+            break;
+        case 'x':
+            lut_interp = Lut3dTetrahedral;
+            break;
+        case 'h':
+            print_help (bin_name);
+            return 0;
+        default:
+            print_help (bin_name);
+            return -1;
+        }
+    }
+
+    if (!input_format || !input_file || !output_file || handler_type == TestHandlerUnknown) {
+        print_help (bin_name);
+        return -1;
+    }
+
+    input_fp.fp = fopen (input_file, "rb");
+    output_fp.fp = fopen (output_file, "wb");
+    if (!input_fp.fp || !output_fp.fp) {
+        XCAM_LOG_ERROR ("open input/output file failed");
+        return -1;
+    }
+
+    switch (handler_type) {
+    case TestHandlerYuvPipe: {
+        image_handler = create_soft_yuv_pipe_image_handler ();
+        SmartPtr<SoftYuvPipeImageHandler> yuv_pipe = image_handler.dynamic_cast_ptr<SoftYuvPipeImageHandler> ();
+        XCAM_ASSERT (yuv_pipe.ptr ());
+        if (enable_tnr) {
+            XCam3aResultTemporalNoiseReduction tnr;
+            xcam_mem_clear (tnr);
+            tnr.gain = 0.5;
+            tnr.threshold[0] = 0.05;
+            tnr.threshold[1] = 0.05;
+            yuv_pipe->set_tnr_yuv_config (tnr);
+        }
+        yuv_pipe->set_tnr_enable (enable_tnr);
+        break;
+    }
+    case TestHandlerCsc:
+        image_handler = create_soft_csc_image_handler (output_format);
+        break;
+    case TestHandlerLut3d: {
+        image_handler = create_soft_lut3d_image_handler (lut_size, lut_interp);
+        SmartPtr<SoftLut3dImageHandler> lut3d = image_handler.dynamic_cast_ptr<SoftLut3dImageHandler> ();
+        if (lut3d.ptr () && !lut3d->set_output_format (output_format))
+            return -1;
+        break;
+    }
+    case TestHandlerLab:
+        image_handler = create_soft_lab_image_handler (SoftLabCsc);
+        break;
+    case TestHandlerLabHdr:
+        image_handler = create_soft_lab_image_handler (SoftLabHdr);
+        break;
+    default:
+        XCAM_LOG_ERROR ("unsupported image handler type:%d", handler_type);
+        return -1;
+    }
+    if (!image_handler.ptr ()) {
+        XCAM_LOG_ERROR ("create image_handler failed");
+        return -1;
+    }
+
+    input_buf_info.init (input_format, width, height);
+    buf_pool = new SoftBufferPool;
+    XCAM_ASSERT (buf_pool.ptr ());
+    buf_pool->set_video_info (input_buf_info);
+    if (!buf_pool->reserve (6)) {
+        XCAM_LOG_ERROR ("init buffer pool failed");
+        return -1;
+    }
+
+    while (!feof (input_fp.fp)) {
+        SmartPtr<VideoBuffer> input_buf, output_buf;
+        input_buf = buf_pool->get_buffer (buf_pool);
+        XCAM_ASSERT (input_buf.ptr ());
+
+        ret = read_buf (input_buf, input_fp);
+        if (ret == XCAM_RETURN_BYPASS)
+            break;
+        CHECK (ret, "read buffer from %s failed", input_file);
+
+        if (loop_count != 0) {
+            ret = handler_loop (image_handler, input_buf, loop_count);
+            CHECK (ret, "execute soft handler failed");
+            return 0;
+        }
+
+        ret = image_handler->execute (input_buf, output_buf);
+        CHECK (ret, "execute soft handler failed");
+        XCAM_ASSERT (output_buf.ptr ());
+
+        ret = write_buf (output_buf, output_fp);
+        CHECK (ret, "write buffer to %s failed", output_file);
+
+        ++buf_count;
+    }
+    XCAM_LOG_INFO ("processed %d buffers successfully", buf_count);
+    return 0;
+}
@@ -0,0 +1,312 @@
+/*
+ * test-soft-lab.cpp - benchmark and check soft(cpu) lab conversion and lab hdr
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#include "test_common.h"
+#include "soft_lab_handler.h"
+#include "soft_fast_math.h"
+#include <getopt.h>
+#include <math.h>
+#include <vector>
+
+using namespace XCam;
+
+// bounds stated in soft_fast_math.h and soft_lab_handler.h
+#define TEST_LOG2_BOUND 1.1e-6
+#define TEST_EXP2_BOUND 2.5e-7
+#define TEST_POW_BOUND 8.0e-7
+#define TEST_CBRT_BOUND 2.5e-7
+#define TEST_RGB_TO_LAB_BOUND 1.6e-4
+#define TEST_HDR_LAB_BOUND 2.4e-3
+
+typedef void (*LabLineFunc) (
+    const float *r, const float *g, const float *b,
+    float *o0, float *o1, float *o2, uint32_t width);
+
+static double
+time_ms (const struct timeval &start, const struct timeval &end)
+{
+    return (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_usec - start.tv_usec) / 1000.0;
+}
+
+static double
+reference_f (double t)
+{
+    return t > 0.008856 ? cbrt (t) : 7.787 * t + 16.0 / 116.0;
+}
+
+static void
+reference_lab (double r, double g, double b, const double *m, double &l, double &a, double &lab_b)
+{
+    double x = m[0] * r + m[1] * g + m[2] * b;
+    double y = m[3] * r + m[4] * g + m[5] * b;
+    double z = m[6] * r + m[7] * g + m[8] * b;
+
+    l = y > 0.008856 ? 116.0 * cbrt (y) - 16.0 : 903.3 * y;
+    a = 500.0 * (reference_f (x) - reference_f (y));
+    lab_b = 200.0 * (reference_f (y) - reference_f (z));
+}
+
+// kernel_csc_rgbatolab in double precision libm
+static void
+reference_rgb_to_lab (
+    const float *r, const float *g, const float *b,
+    float *l, float *a, float *lab_b, uint32_t width)
+{
+    static const double m[9] = {
+        0.433910, 0.376220, 0.189860,
+        0.212649, 0.715169, 0.072182,
+        0.017756, 0.109478, 0.872915
+    };
+    for (uint32_t i = 0; i < width; ++i) {
+        double vl, va, vb;
+        reference_lab (r[i], g[i], b[i], m, vl, va, vb);
+        l[i] = vl;
+        a[i] = va;
+        lab_b[i] = vb;
+    }
+}
+
+// kernel_hdr_lab in double precision libm
+static void
+reference_hdr_lab (
+    const float *r, const float *g, const float *b,
+    float *out_r, float *out_g, float *out_b, uint32_t width)
+{
+    static const double m[9] = {
+        0.412453, 0.357580, 0.180423,
+        0.212671, 0.715160, 0.072169,
+        0.019334, 0.119193, 0.950227
+    };
+    const float *table = soft_hdr_lab_table ();
+
+    for (uint32_t i = 0; i < width; ++i) {
+        double l, a, lab_b, x, y, z, fx, fy, fz;
+        reference_lab (r[i], g[i], b[i], m, l, a, lab_b);
+        uint32_t index = (uint32_t)(XCAM_MAX (l, 0.0) * 10.0);
+        l = table[XCAM_MIN (index, (uint32_t)XCAM_SOFT_LAB_HDR_TABLE_SIZE - 1)];
+
+        y = pow (l / 116.0, 3.0);
+        y = y < 0.008856 ? l / 903.3 : y;
+        fy = reference_f (y);
+        fx = a / 500.0 + fy;
+        x = fx * fx * fx;
+        x = x < 0.008865 ? (fx - 16.0 / 116.0) / 7.787 : x;
+        fz = fy - lab_b / 200.0;
+        z = fz * fz * fz;
+        z = z < 0.008865 ? (fz - 16.0 / 116.0) / 7.787 : z;
+
+        out_r[i] = 3.240479 * x - 1.537150 * y - 0.498535 * z;
+        out_g[i] = -0.969256 * x + 1.875992 * y + 0.041556 * z;
+        out_b[i] = 0.055648 * x - 0.204043 * y + 1.204043 * z;
+    }
+}
+
+class LabLineTask
+    : public SoftBandTask
+{
+public:
+    LabLineFunc   func;
+    const float  *in[3];
+    float        *out[3];
+    uint32_t      width;
+
+    virtual XCamReturn work (uint32_t begin, uint32_t end) {
+        for (uint32_t y = begin; y < end; ++y) {
+            uint32_t offset = y * width;
+            func (in[0] + offset, in[1] + offset, in[2] + offset,
+                  out[0] + offset, out[1] + offset, out[2] + offset, width);
+        }
+        return XCAM_RETURN_NO_ERROR;
+    }
+};
+
+static double
+bench_lines (LabLineTask &task, uint32_t height, uint32_t loops, SmartPtr<SoftWorkerPool> workers)
+{
+    struct timeval start, end;
+
+    gettimeofday (&start, NULL);
+    for (uint32_t i = 0; i < loops; ++i) {
+        if (workers.ptr ())
+            workers->run (task, height);
+        else
+            task.work (0, height);
+    }
+    gettimeofday (&end, NULL);
+
+    return (double)task.width * height * loops / (time_ms (start, end) * 1000.0);
+}
+
+static double
+max_error (const std::vector<float> &a, const std::vector<float> &b)
+{
+    double error = 0.0;
+    for (uint32_t i = 0; i < a.size (); ++i)
+        error = XCAM_MAX (error, fabs ((double)a[i] - b[i]));
+    return error;
+}
+
+// sweep float bit patterns with a stride over [min, max]
+static bool
+check_fast_math ()
+{
+    double log2_err = 0.0, exp2_err = 0.0, pow_err = 0.0, cbrt_err = 0.0;
+    const float pow_y[] = {1.0f / 3.0f, 0.45f, 1.0f / 2.4f, 2.2f, 2.4f};
+
+    for (int32_t bits = fast_float_to_bits (9.31322575e-10f); bits <= fast_float_to_bits (1073741824.0f); bits += 7) {
+        float x = fast_bits_to_float (bits);
+        log2_err = XCAM_MAX (log2_err, fabs (fast_log2 (x) - log2 ((double)x)));
+        cbrt_err = XCAM_MAX (cbrt_err, fabs (fast_cbrt (x) / cbrt ((double)x) - 1.0));
+    }
+    for (float x = -30.0f; x <= 30.0f; x += 0.0001f)
+        exp2_err = XCAM_MAX (exp2_err, fabs (fast_exp2 (x) / exp2 ((double)x) - 1.0));
+    for (uint32_t i = 0; i < sizeof (pow_y) / sizeof (pow_y[0]); ++i) {
+        for (float x = 1.0f / 1024.0f; x <= 1.0f; x += 1.0f / 65536.0f) {
+            if (fabs (pow_y[i] * log2 (x)) > 16.0)
+                continue;
+            pow_err = XCAM_MAX (pow_err, fabs (fast_pow (x, pow_y[i]) / pow ((double)x, (double)pow_y[i]) - 1.0));
+        }
+    }
+
+    printf ("fast_log2 max absolute error: %.3g, bound %.3g\n", log2_err, TEST_LOG2_BOUND);
+    printf ("fast_exp2 max relative error: %.3g, bound %.3g\n", exp2_err, TEST_EXP2_BOUND);
+    printf ("fast_pow  max relative error: %.3g, bound %.3g\n", pow_err, TEST_POW_BOUND);
+    printf ("fast_cbrt max relative error: %.3g, bound %.3g\n", cbrt_err, TEST_CBRT_BOUND);
+
+    return log2_err <= TEST_LOG2_BOUND && exp2_err <= TEST_EXP2_BOUND &&
+           pow_err <= TEST_POW_BOUND && cbrt_err <= TEST_CBRT_BOUND;
+}
+
+static void
+print_help (const char *bin_name)
+{
+    printf ("Usage: %s [-W width] [-H height] [-p loops] [-t threads] [-c]\n"
+            "\t -W width     specify image width, default: 1920\n"
+            "\t -H height    specify image height, default: 1080\n"
+            "\t -p loops     specify loop count of each case, default: 10\n"
+            "\t -t threads   specify worker threads, default: 0 (online cpus)\n"
+            "\t -c           check fast math and outputs against libm, fail over the stated bounds\n"
+            "\t -h           help\n"
+            , bin_name);
+}
+
+int main (int argc, char *argv[])
+{
+    uint32_t width = 1920;
+    uint32_t height = 1080;
+    uint32_t loops = 10;
+    uint32_t threads = 0;
+    bool check = false;
+    bool passed = true;
+    int opt = 0;
+
+    while ((opt =  getopt(argc, argv, "W:H:p:t:ch")) != -1) {
+        switch (opt) {
+        case 'W':
+            width = atoi (optarg);
+            break;
+        case 'H':
+            height = atoi (optarg);
+            break;
+        case 'p':
+            loops = atoi (optarg);
+            break;
+        case 't':
+            threads = atoi (optarg);
+            break;
+        case 'c':
+            check = true;
+            break;
+        case 'h':
+            print_help (argv[0]);
+            return 0;
+        default:
+            print_help (argv[0]);
+            return -1;
+        }
+    }
+    CHECK_EXP (width && height && loops, "invalid size or loop count");
+
+    if (check && !check_fast_math ()) {
+        XCAM_LOG_ERROR ("fast math error over its bound");
+        passed = false;
+    }
+
+    uint32_t size = width * height;
+    std::vector<float> in (size * 3), fast_out (size * 3), ref_out (size * 3);
+    SmartPtr<SoftWorkerPool> workers = new SoftWorkerPool ("soft_lab_bench", threads);
+
+    // gradients over the whole cube plus pseudo random noise, dark areas included
+    uint32_t seed = 1;
+    for (uint32_t i = 0; i < size; ++i) {
+        float fx = (float)(i % width) / width, fy = (float)(i / width) / height;
+        seed = seed * 1103515245 + 12345;
+        float noise = ((seed >> 16) & 0xff) / 2048.0f;
+        in[i] = XCAM_MIN (fx * fx + noise, 1.0f);
+        in[size + i] = XCAM_MIN (fy * fy * fy + noise, 1.0f);
+        in[size * 2 + i] = XCAM_MIN (fx * fy + noise, 1.0f);
+    }
+
+    const char *names[] = {"rgb2lab", "hdr_lab"};
+    LabLineFunc fast_funcs[] = {soft_rgb_to_lab, soft_hdr_lab};
+    LabLineFunc ref_funcs[] = {reference_rgb_to_lab, reference_hdr_lab};
+    const double bounds[] = {TEST_RGB_TO_LAB_BOUND, TEST_HDR_LAB_BOUND};
+
+    printf ("soft lab %dx%d, %d worker threads\n", width, height, workers->get_thread_count ());
+    printf ("%-8s %14s %14s %14s %12s\n", "case", "libm MPix/s", "fast MPix/s", "pool MPix/s", "max_err");
+
+    for (uint32_t f = 0; f < sizeof (names) / sizeof (names[0]); ++f) {
+        LabLineTask task;
+        task.width = width;
+        for (uint32_t c = 0; c < 3; ++c)
+            task.in[c] = &in[size * c];
+
+        for (uint32_t c = 0; c < 3; ++c)
+            task.out[c] = &ref_out[size * c];
+        task.func = ref_funcs[f];
+        double ref_speed = bench_lines (task, height, loops, NULL);
+
+        for (uint32_t c = 0; c < 3; ++c)
+            task.out[c] = &fast_out[size * c];
+        task.func = fast_funcs[f];
+        double fast_speed = bench_lines (task, height, loops, NULL);
+        double pool_speed = bench_lines (task, height, loops, workers);
+
+        char error[32] = "-";
+        double max_err = 0.0;
+        if (check) {
+            max_err = max_error (fast_out, ref_out);
+            snprintf (error, sizeof (error), "%.4g", max_err);
+        }
+
+        printf ("%-8s %14.1f %14.1f %14.1f %12s\n", names[f], ref_speed, fast_speed, pool_speed, error);
+        if (max_err > bounds[f]) {
+            XCAM_LOG_ERROR ("%s max error %.4g over bound %.4g", names[f], max_err, bounds[f]);
+            passed = false;
+        }
+    }
+
+    if (!passed) {
+        printf ("soft lab test FAILED\n");
+        return -1;
+    }
+    printf ("soft lab test PASSED\n");
+    return 0;
+}
@@ -77,6 +77,11 @@ using namespace GstXCam;
 #define DEFAULT_PROP_ANALYZER           SIMPLE_ANALYZER
 #define DEFAULT_PROP_CL_PIPE_PROFILE    0
 
+// capture to push latency above this is a timestamp of another clock
+#define LATENCY_SAMPLE_LIMIT            GST_SECOND
+// reported latency is updated when measured one moves further
+#define LATENCY_TOLERANCE               (2 * GST_MSECOND)
+
 #define DEFAULT_VIDEO_WIDTH             1920
 #define DEFAULT_VIDEO_HEIGHT            1080
 
@@ -298,6 +303,8 @@ static gboolean gst_xcam_src_stop (GstBaseSrc *src);
 static gboolean gst_xcam_src_unlock (GstBaseSrc *src);
 static gboolean gst_xcam_src_unlock_stop (GstBaseSrc *src);
 static GstFlowReturn gst_xcam_src_alloc (GstBaseSrc *src, guint64 offset, guint size, GstBuffer **buffer);
+static gboolean gst_xcam_src_query (GstBaseSrc *src, GstQuery *query);
+static void gst_xcam_src_reset_latency (GstXCamSrc *src, GstClockTime latency);
 static GstFlowReturn gst_xcam_src_fill (GstPushSrc *src, GstBuffer *out);
 
 /* GstXCamInterface implementation */
@@ -474,6 +481,7 @@ gst_xcam_src_class_init (GstXCamSrcClass * klass)
     basesrc_class->unlock = GST_DEBUG_FUNCPTR (gst_xcam_src_unlock);
     basesrc_class->unlock_stop = GST_DEBUG_FUNCPTR (gst_xcam_src_unlock_stop);
     basesrc_class->alloc = GST_DEBUG_FUNCPTR (gst_xcam_src_alloc);
+    basesrc_class->query = GST_DEBUG_FUNCPTR (gst_xcam_src_query);
     pushsrc_class->fill = GST_DEBUG_FUNCPTR (gst_xcam_src_fill);
 }
 
@@ -499,6 +507,9 @@ gst_xcam_src_init (GstXCamSrc *xcamsrc)
     xcamsrc->time_offset_ready = FALSE;
     xcamsrc->time_offset = -1;
     xcamsrc->buf_mark = 0;
+    xcamsrc->latency_index = 0;
+    xcamsrc->latency_count = 0;
+    xcamsrc->latency_reported = 0;
     xcamsrc->duration = 0;
     xcamsrc->mem_type = DEFAULT_PROP_MEM_MODE;
     xcamsrc->field = DEFAULT_PROP_FIELD;
@@ -1007,6 +1018,8 @@ gst_xcam_src_stop (GstBaseSrc *src)
     if (event_device.ptr())
         event_device->close ();
 
+    // start builds devices, analyzers and processors again
+    device_manager->release_pipeline ();
     device_manager->pause_dequeue ();
     return TRUE;
 }
@@ -1136,6 +1149,9 @@ gst_xcam_src_set_caps (GstBaseSrc *src, GstCaps *caps)
                             GST_VIDEO_INFO_FPS_N(&xcamsrc->gst_video_info));
     xcamsrc->pool = gst_xcam_buffer_pool_new (xcamsrc, caps, xcamsrc->device_manager);
 
+    // new pipeline profile, one frame of processing until measured
+    gst_xcam_src_reset_latency (xcamsrc, xcamsrc->duration);
+
     return TRUE;
 }
 
@@ -1184,6 +1200,71 @@ gst_xcam_src_alloc (GstBaseSrc *src, guint64 offset, guint size, GstBuffer **buf
     return ret;
 }
 
+static void
+gst_xcam_src_reset_latency (GstXCamSrc *src, GstClockTime latency)
+{
+    GST_OBJECT_LOCK (src);
+    src->latency_index = 0;
+    src->latency_count = 0;
+    src->latency_reported = latency;
+    GST_OBJECT_UNLOCK (src);
+
+    gst_element_post_message (GST_ELEMENT_CAST (src), gst_message_new_latency (GST_OBJECT_CAST (src)));
+}
+
+static void
+gst_xcam_src_update_latency (GstXCamSrc *src, GstClockTime latency)
+{
+    GstClockTime worst = 0;
+    gboolean changed = FALSE;
+
+    GST_OBJECT_LOCK (src);
+    src->latency_samples[src->latency_index] = latency;
+    src->latency_index = (src->latency_index + 1) % GST_XCAM_SRC_LATENCY_WINDOW;
+    if (src->latency_count < GST_XCAM_SRC_LATENCY_WINDOW)
+        ++src->latency_count;
+
+    for (uint32_t i = 0; i < src->latency_count; ++i)
+        worst = XCAM_MAX (worst, src->latency_samples[i]);
+
+    // wait for a quarter window before trusting a decrease
+    if (worst > src->latency_reported + LATENCY_TOLERANCE ||
+            (src->latency_count >= GST_XCAM_SRC_LATENCY_WINDOW / 4 &&
+             worst + LATENCY_TOLERANCE < src->latency_reported)) {
+        src->latency_reported = worst;
+        changed = TRUE;
+    }
+    GST_OBJECT_UNLOCK (src);
+
+    if (changed) {
+        GST_INFO_OBJECT (src, "processing latency changed to %" GST_TIME_FORMAT, GST_TIME_ARGS (worst));
+        gst_element_post_message (GST_ELEMENT_CAST (src), gst_message_new_latency (GST_OBJECT_CAST (src)));
+    }
+}
+
+static gboolean
+gst_xcam_src_query (GstBaseSrc *src, GstQuery *query)
+{
+    GstXCamSrc *xcamsrc = GST_XCAM_SRC_CAST (src);
+    GstClockTime min_latency, max_latency;
+
+    if (GST_QUERY_TYPE (query) != GST_QUERY_LATENCY || !xcamsrc->duration)
+        return GST_BASE_SRC_CLASS (parent_class)->query (src, query);
+
+    // a frame is exposed for a duration then processed, frames not yet
+    // pushed wait at most in the rest of the buffers
+    GST_OBJECT_LOCK (xcamsrc);
+    min_latency = xcamsrc->duration + xcamsrc->latency_reported;
+    max_latency = min_latency + xcamsrc->duration * (XCAM_MAX (xcamsrc->buf_count, 1) - 1);
+    GST_OBJECT_UNLOCK (xcamsrc);
+
+    gst_query_set_latency (query, TRUE, min_latency, max_latency);
+    GST_DEBUG_OBJECT (
+        xcamsrc, "latency min %" GST_TIME_FORMAT " max %" GST_TIME_FORMAT,
+        GST_TIME_ARGS (min_latency), GST_TIME_ARGS (max_latency));
+    return TRUE;
+}
+
 static GstFlowReturn
 gst_xcam_src_fill (GstPushSrc *basesrc, GstBuffer *buf)
 {
@@ -1196,6 +1277,13 @@ gst_xcam_src_fill (GstPushSrc *basesrc, GstBuffer *buf)
     if (!GST_CLOCK_TIME_IS_VALID (GST_BUFFER_TIMESTAMP (buf)))
         return GST_FLOW_OK;
 
+    // capture timestamps of v4l2 are on the monotonic clock
+    GstClockTime now = g_get_monotonic_time () * GST_USECOND;
+    GstClockTime capture_time = GST_BUFFER_TIMESTAMP (buf);
+    gboolean monotonic = (capture_time <= now && now - capture_time < LATENCY_SAMPLE_LIMIT);
+    if (monotonic)
+        gst_xcam_src_update_latency (src, now - capture_time);
+
     if (!src->time_offset_ready) {
         GstClock *clock = GST_ELEMENT_CLOCK (src);
         GstClockTime actual_time = 0;
@@ -1204,7 +1292,8 @@ gst_xcam_src_fill (GstPushSrc *basesrc, GstBuffer *buf)
             return GST_FLOW_OK;
 
         actual_time = gst_clock_get_time (clock) - GST_ELEMENT_CAST (src)->base_time;
-        src->time_offset = actual_time - GST_BUFFER_TIMESTAMP (buf);
+        // keep the processing latency in timestamps, it is reported in latency query
+        src->time_offset = actual_time - (monotonic ? now : capture_time);
         src->time_offset_ready = TRUE;
         gst_object_ref (clock);
     }
@@ -1463,6 +1552,11 @@ gst_xcam_src_set_dvs (GstXCam3A *xcam3a, gboolean enable)
 {
     GST_XCAM_INTERFACE_HEADER (xcam3a, src, device_manager, analyzer);
 
+#if HAVE_LIBCL
+    SmartPtr<CLPostImageProcessor> processor = device_manager->get_cl_post_image_processor ();
+    if (processor.ptr () && !processor->set_dvs (enable))
+        return FALSE;
+#endif
     return analyzer->set_dvs (enable);
 }
 
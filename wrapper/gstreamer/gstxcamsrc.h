@@ -47,6 +47,9 @@ XCAM_BEGIN_DECLARE
 #define GST_XCAM_SRC_BUF_COUNT(src) ((GST_XCAM_SRC_CAST(src))->buf_count)
 #define GST_XCAM_SRC_OUT_VIDEO_INFO(src) (&(GST_XCAM_SRC_CAST(src))->gst_video_info)
 
+// capture to push latency of last frames, worst of them is reported
+#define GST_XCAM_SRC_LATENCY_WINDOW 64
+
 
 typedef enum {
     ISP_IMAGE_PROCESSOR = 0,
@@ -99,6 +102,12 @@ struct _GstXCamSrc
     int64_t                      buf_mark;
     GstClockTime                 duration;
 
+    /* protected by object lock, read in latency query */
+    GstClockTime                 latency_samples[GST_XCAM_SRC_LATENCY_WINDOW];
+    uint32_t                     latency_index;
+    uint32_t                     latency_count;
+    GstClockTime                 latency_reported;
+
     enum v4l2_memory             mem_type;
     enum v4l2_field              field;
     uint32_t                     in_format;
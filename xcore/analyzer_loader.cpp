@@ -19,6 +19,7 @@
  */
 
 #include "analyzer_loader.h"
+#include "startup_tracer.h"
 #include <dlfcn.h>
 
 namespace XCam {
@@ -45,6 +46,8 @@ void *
 AnalyzerLoader::load_library (const char *lib_path)
 {
     void *desc = NULL;
+    const char *lib_name = lib_path ? strrchr (lib_path, '/') : NULL;
+    StartupPhase phase ("dlopen", lib_name ? lib_name + 1 : lib_path);
 
     void *handle = open_handle (lib_path);
     //XCAM_ASSERT (handle);
@@ -83,6 +83,7 @@ typedef enum _XCam3aResultType {
     //Smart Analysis Type
     XCAM_3A_RESULT_FACE_DETECTION = 0x4000,
     XCAM_3A_RESULT_DVS,
+    XCAM_3A_RESULT_MOTION_DETECTION,
 
     XCAM_3A_RESULT_USER_DEFINED_TYPE = 0x8000,
 } XCam3aResultType;
@@ -0,0 +1,142 @@
+/*
+ * xcam_pipeline.h - frame-at-a-time processing pipeline, C interface
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#ifndef C_XCAM_PIPELINE_H
+#define C_XCAM_PIPELINE_H
+
+#include <base/xcam_common.h>
+#include <base/xcam_buffer.h>
+
+XCAM_BEGIN_DECLARE
+
+/*
+ * Processes frames owned by the caller without DeviceManager or V4L2.
+ * Frames are submitted in batches and complete asynchronously, in
+ * submission order, through a callback or by polling an eventfd and
+ * reaping. Every stage runs on its own thread so consecutive frames
+ * overlap; submit only queues and never waits for processing.
+ */
+
+#define XCAM_PIPELINE_MAX_STAGES 8
+#define XCAM_PIPELINE_DEFAULT_IN_FLIGHT 8
+
+typedef enum {
+    XCAM_PIPELINE_STAGE_CSC = 0,    /* YUYV/UYVY -> NV12 */
+    XCAM_PIPELINE_STAGE_YUV_PIPE,   /* RGB48/RGB24 planar -> NV12 */
+    XCAM_PIPELINE_STAGE_LUT3D,      /* RGB48/RGB24 planar -> NV12, default color lut */
+    XCAM_PIPELINE_STAGE_LAB,        /* RGB48/RGB24 planar -> LAB */
+    XCAM_PIPELINE_STAGE_HDR_LAB,    /* RGB48/RGB24 planar, tone mapped on L, same format */
+} XCamPipelineStage;
+
+typedef struct _XCamPipelineConfig XCamPipelineConfig;
+struct _XCamPipelineConfig {
+    XCamPipelineStage   stages[XCAM_PIPELINE_MAX_STAGES];
+    uint32_t            stage_count;
+    /*
+     * frames submitted and not reaped yet, 0 for default. Results count
+     * until reaped or until the callback returned; an output kept after
+     * that still holds a stage buffer, hold fewer than max_in_flight.
+     */
+    uint32_t            max_in_flight;
+};
+
+/*
+ * one input frame, either host memory (data) or a dma-buf (dma_fd >= 0,
+ * data NULL) described by info. Memory must stay valid and unchanged
+ * until the frame completes. dma-buf frames are mapped read only.
+ */
+typedef struct _XCamFrame XCamFrame;
+struct _XCamFrame {
+    XCamVideoBufferInfo   info;
+    uint8_t              *data;
+    int                   dma_fd;
+    int64_t               timestamp;
+    void                 *cookie;
+};
+
+/*
+ * status XCAM_RETURN_NO_ERROR with output, XCAM_RETURN_BYPASS for frames
+ * dropped or discarded by stop, XCAM_RETURN_ERROR_UNKNOWN when a stage
+ * failed on the frame.
+ * output carries one reference owned by the receiver, release it with
+ * xcam_video_buffer_unref; its timestamp is the one submitted.
+ */
+typedef struct _XCamFrameResult XCamFrameResult;
+struct _XCamFrameResult {
+    void              *cookie;
+    XCamReturn         status;
+    int64_t            timestamp;
+    XCamVideoBuffer   *output;
+};
+
+typedef struct _XCamPipeline XCamPipeline;
+
+/*
+ * called on the pipeline completion thread, results valid during the
+ * call. It may submit, drain and stop; results left by a stop called
+ * here come in later calls on the same thread. It must not call start
+ * or destroy the pipeline.
+ */
+typedef void (*XCamPipelineCallback) (
+    XCamPipeline *pipeline, const XCamFrameResult *results, uint32_t count, void *user_data);
+
+XCamPipeline *
+xcam_pipeline_create (const XCamPipelineConfig *config);
+
+/* stops if running, unreaped outputs are released */
+void
+xcam_pipeline_destroy (XCamPipeline *pipeline);
+
+/* before start; without callback results are reaped */
+XCamReturn
+xcam_pipeline_set_callback (XCamPipeline *pipeline, XCamPipelineCallback callback, void *user_data);
+
+XCamReturn
+xcam_pipeline_start (XCamPipeline *pipeline);
+
+/* frames still in flight complete with XCAM_RETURN_BYPASS */
+XCamReturn
+xcam_pipeline_stop (XCamPipeline *pipeline);
+
+/*
+ * queues frames in order until max_in_flight is reached, accepted gets
+ * the number queued. Returns XCAM_RETURN_BYPASS when none fit, the
+ * caller retries after completions. An invalid frame or one the stages
+ * refused returns an error, the frames before it stay queued.
+ */
+XCamReturn
+xcam_pipeline_submit (
+    XCamPipeline *pipeline, const XCamFrame *frames, uint32_t count, uint32_t *accepted);
+
+/* waits until every submitted frame completed, timeout 0 waits forever */
+XCamReturn
+xcam_pipeline_drain (XCamPipeline *pipeline, uint32_t timeout_us);
+
+/* readable while results wait to be reaped, never with a callback */
+int
+xcam_pipeline_get_event_fd (XCamPipeline *pipeline);
+
+/* moves up to max completed results out, returns the number moved */
+uint32_t
+xcam_pipeline_reap (XCamPipeline *pipeline, XCamFrameResult *results, uint32_t max);
+
+XCAM_END_DECLARE
+
+#endif //C_XCAM_PIPELINE_H
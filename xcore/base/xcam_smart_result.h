@@ -51,6 +51,30 @@ typedef struct _XCamFDResult {
     XCamFaceInfo          faces[0];
 } XCamFDResult;
 
+typedef enum _XCamMotionEvent {
+    XCAM_MOTION_EVENT_NONE = 0,
+    XCAM_MOTION_EVENT_START,   // first frame of a motion period
+    XCAM_MOTION_EVENT_ACTIVE,  // motion continues
+    XCAM_MOTION_EVENT_STOP,    // first quiet frame after hold time
+} XCamMotionEvent;
+
+/*
+ * Motion detection result on 3a statistics grids
+ * head.type = XCAM_3A_RESULT_MOTION_DETECTION;
+ * head.process_type = XCAM_IMAGE_PROCESS_POST;
+ * mask[grid_height][grid_width], 0 still, otherwise motion level 1~255
+ */
+
+typedef struct _XCamMotionResult {
+    XCam3aResultHead      head;
+    uint32_t              grid_pixel_size;
+    uint32_t              grid_width;
+    uint32_t              grid_height;
+    uint32_t              motion_grids;
+    XCamMotionEvent       event;
+    uint8_t               mask[0];
+} XCamMotionResult;
+
 XCAM_END_DECLARE
 
 #endif //C_XCAM_SMART_RESULT_H
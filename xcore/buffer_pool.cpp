@@ -20,6 +20,7 @@
 
 #include "xcam_utils.h"
 #include "buffer_pool.h"
+#include "xcam_probes.h"
 
 namespace XCam {
 
@@ -208,6 +209,7 @@ BufferPool::get_buffer (const SmartPtr<BufferPool> &self)
     }
     ret_buf = create_buffer_from_data (data);
     ret_buf->set_buf_pool (self);
+    XCAM_PROBE2 (pool_get, this, data.ptr ());
 
     return ret_buf;
 }
@@ -223,13 +225,35 @@ BufferPool::stop ()
 }
 
 void
-BufferPool::release (SmartPtr<BufferData> &data)
+BufferPool::resume ()
 {
     {
         SmartLock lock (_mutex);
-        if (!_started)
+        if (!_allocated_num)
             return;
+        _started = true;
     }
+    _buf_list.resume_pop ();
+}
+
+uint32_t
+BufferPool::get_allocated_count ()
+{
+    SmartLock lock (_mutex);
+    return _allocated_num;
+}
+
+uint32_t
+BufferPool::get_free_count ()
+{
+    return _buf_list.size ();
+}
+
+void
+BufferPool::release (SmartPtr<BufferData> &data)
+{
+    // parked while stopped, so a restart needn't reallocate
+    XCAM_PROBE2 (pool_release, this, data.ptr ());
     _buf_list.push (data);
 }
 
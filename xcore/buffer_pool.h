@@ -99,11 +99,17 @@ public:
     SmartPtr<BufferProxy> get_buffer (const SmartPtr<BufferPool> &self);
 
     void stop ();
+    // re-arm after stop, buffers returned meanwhile are kept
+    void resume ();
 
     const VideoBufferInfo & get_video_info () const {
         return _buffer_info;
     }
 
+    // occupancy, buffers held downstream = allocated - free
+    uint32_t get_allocated_count ();
+    uint32_t get_free_count ();
+
 protected:
     virtual bool fixate_video_info (VideoBufferInfo &info);
     virtual SmartPtr<BufferData> allocate_data (const VideoBufferInfo &buffer_info) = 0;
@@ -23,6 +23,7 @@
 #include "cl_3a_stats_calculator.h"
 #include "cl_bayer_pipe_handler.h"
 #include "cl_yuv_pipe_handler.h"
+#include "cl_lut3d_handler.h"
 #if ENABLE_YEENR_HANDLER
 #include "cl_ee_handler.h"
 #endif
@@ -36,6 +37,7 @@
 
 #define XCAM_CL_3A_IMAGE_MAX_POOL_SIZE 6
 #define XCAM_CL_3A_IMAGE_SCALER_FACTOR 1.0
+#define XCAM_CL_3A_DEFAULT_THUMBNAIL_BIN 4
 
 namespace XCam {
 
@@ -43,6 +45,7 @@ CL3aImageProcessor::CL3aImageProcessor ()
     : CLImageProcessor ("CL3aImageProcessor")
     , _output_fourcc (V4L2_PIX_FMT_NV12)
     , _3a_stats_bits (8)
+    , _stats_thumbnail_bin (XCAM_CL_3A_DEFAULT_THUMBNAIL_BIN)
     , _pipeline_profile (BasicPipelineProfile)
     , _capture_stage (TonemappingStage)
     , _wdr_mode (WDRdisabled)
@@ -51,6 +54,7 @@ CL3aImageProcessor::CL3aImageProcessor ()
     , _enable_gamma (true)
     , _enable_macc (true)
     , _enable_dpc (false)
+    , _enable_lut3d (false)
     , _wavelet_basis (CL_WAVELET_DISABLED)
     , _wavelet_channel (CL_WAVELET_CHANNEL_UV)
     , _snr_mode (0)
@@ -106,6 +110,19 @@ CL3aImageProcessor::set_3a_stats_bits (uint32_t bits)
     return true;
 }
 
+bool
+CL3aImageProcessor::set_stats_thumbnail_bin (uint32_t bin)
+{
+    XCAM_FAIL_RETURN (
+        WARNING,
+        bin == 2 || bin == 4,
+        false,
+        "cl image processor stats thumbnail doesn't support %dx%d bin", bin, bin);
+
+    _stats_thumbnail_bin = bin;
+    return true;
+}
+
 bool
 CL3aImageProcessor::can_process_result (SmartPtr<X3aResult> &result)
 {
@@ -199,6 +216,10 @@ CL3aImageProcessor::apply_3a_result (SmartPtr<X3aResult> &result)
             _yuv_pipe->set_rgbtoyuv_matrix (csc_res->get_standard_result ());
             _yuv_pipe->set_3a_result (result);
         }
+        if (_lut3d.ptr ()) {
+            _lut3d->apply_3a_result (result);
+            _lut3d->set_3a_result (result);
+        }
         break;
     }
 
@@ -209,6 +230,10 @@ CL3aImageProcessor::apply_3a_result (SmartPtr<X3aResult> &result)
             _yuv_pipe->set_macc_table (macc_res->get_standard_result ());
             _yuv_pipe->set_3a_result (result);
         }
+        if (_lut3d.ptr ()) {
+            _lut3d->apply_3a_result (result);
+            _lut3d->set_3a_result (result);
+        }
         break;
     }
     case XCAM_3A_RESULT_R_GAMMA:
@@ -309,7 +334,9 @@ CL3aImageProcessor::create_handlers ()
     XCAM_ASSERT (context.ptr ());
 
     /* bayer pipeline */
-    image_handler = create_cl_bayer_basic_image_handler (context, _enable_gamma, _3a_stats_bits);
+    image_handler = create_cl_bayer_basic_image_handler (
+                        context, _enable_gamma, _3a_stats_bits,
+                        (_capture_stage == StatsOnlyStage ? _stats_thumbnail_bin : 0));
     _bayer_basic_pipe = image_handler.dynamic_cast_ptr<CLBayerBasicImageHandler> ();
     XCAM_FAIL_RETURN (
         WARNING,
@@ -320,6 +347,10 @@ CL3aImageProcessor::create_handlers ()
     _bayer_basic_pipe->set_stats_callback (_stats_callback);
     add_handler (image_handler);
 
+    // the thumbnail is the output, stats go to the analyzer as usual
+    if (_capture_stage == StatsOnlyStage)
+        return XCAM_RETURN_NO_ERROR;
+
     /* tone mapping */
     switch(_wdr_mode) {
     case Gaussian: {
@@ -369,16 +400,33 @@ CL3aImageProcessor::create_handlers ()
     if(_capture_stage == BasicbayerStage)
         return XCAM_RETURN_NO_ERROR;
 
-    image_handler = create_cl_yuv_pipe_image_handler (context);
-    _yuv_pipe = image_handler.dynamic_cast_ptr<CLYuvPipeImageHandler> ();
-    XCAM_FAIL_RETURN (
-        WARNING,
-        _yuv_pipe.ptr (),
-        XCAM_RETURN_ERROR_CL,
-        "CL3aImageProcessor create yuv pipe handler failed");
-    _yuv_pipe->set_tnr_enable (_tnr_mode & CL_TNR_TYPE_YUV);
-    image_handler->set_pool_size (XCAM_CL_3A_IMAGE_MAX_POOL_SIZE * 2);
-    add_handler (image_handler);
+    if (_enable_lut3d) {
+        image_handler = create_cl_lut3d_image_handler (context);
+        _lut3d = image_handler.dynamic_cast_ptr<CLLut3dImageHandler> ();
+        XCAM_FAIL_RETURN (
+            WARNING,
+            _lut3d.ptr (),
+            XCAM_RETURN_ERROR_CL,
+            "CL3aImageProcessor create lut3d handler failed");
+        // bayer pipe applied gamma already
+        _lut3d->get_color_lut ()->enable_gamma (false);
+        _lut3d->get_color_lut ()->enable_macc (_enable_macc);
+        if (_tnr_mode & CL_TNR_TYPE_YUV)
+            XCAM_LOG_WARNING ("CL3aImageProcessor yuv tnr not available with lut3d");
+        image_handler->set_pool_size (XCAM_CL_3A_IMAGE_MAX_POOL_SIZE * 2);
+        add_handler (image_handler);
+    } else {
+        image_handler = create_cl_yuv_pipe_image_handler (context);
+        _yuv_pipe = image_handler.dynamic_cast_ptr<CLYuvPipeImageHandler> ();
+        XCAM_FAIL_RETURN (
+            WARNING,
+            _yuv_pipe.ptr (),
+            XCAM_RETURN_ERROR_CL,
+            "CL3aImageProcessor create yuv pipe handler failed");
+        _yuv_pipe->set_tnr_enable (_tnr_mode & CL_TNR_TYPE_YUV);
+        image_handler->set_pool_size (XCAM_CL_3A_IMAGE_MAX_POOL_SIZE * 2);
+        add_handler (image_handler);
+    }
 
 #if ENABLE_YEENR_HANDLER
     /* ee */
@@ -487,6 +535,26 @@ CL3aImageProcessor::post_config ()
     return ret;
 }
 
+void
+CL3aImageProcessor::introspect (IntrospectionWriter &writer)
+{
+    static const char *profile_names[] = {"basic", "advanced", "extreme"};
+    static const char *stage_names[] = {"bayer", "tonemapping", "stats"};
+    // xcam_fourcc_to_string is not reentrant
+    char fourcc[5] = {0};
+    memcpy (fourcc, &_output_fourcc, 4);
+
+    CLImageProcessor::introspect (writer);
+    writer.add ("profile", profile_names[_pipeline_profile]);
+    writer.add ("output_format", fourcc);
+    writer.add ("capture_stage", stage_names[_capture_stage]);
+    writer.add ("hdr_mode", _hdr_mode);
+    writer.add ("tnr_mode", _tnr_mode);
+    writer.add ("snr_mode", _snr_mode);
+    writer.add ("wdr_mode", (uint32_t)_wdr_mode);
+    writer.add ("lut3d", _enable_lut3d);
+}
+
 bool
 CL3aImageProcessor::set_profile (const CL3aImageProcessor::PipelineProfile value)
 {
@@ -578,6 +646,16 @@ CL3aImageProcessor::set_tonemapping (CLTonemappingMode wdr_mode)
     return true;
 }
 
+bool
+CL3aImageProcessor::set_lut3d (bool enable)
+{
+    _enable_lut3d = enable;
+
+    STREAM_LOCK;
+
+    return true;
+}
+
 bool
 CL3aImageProcessor::set_tnr (uint32_t mode, uint8_t level)
 {
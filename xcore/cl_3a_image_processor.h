@@ -33,6 +33,7 @@ class CLEeImageHandler;
 class CLBayerBasicImageHandler;
 class CLBayerPipeImageHandler;
 class CLYuvPipeImageHandler;
+class CLLut3dImageHandler;
 class CLTonemappingImageHandler;
 class CLNewTonemappingImageHandler;
 class CLImageScaler;
@@ -60,6 +61,8 @@ public:
     enum CaptureStage {
         BasicbayerStage,
         TonemappingStage,
+        // 3a stats and a binned RGBA thumbnail from raw only, no demosaic
+        StatsOnlyStage,
     };
 
     enum CLTonemappingMode {
@@ -78,6 +81,7 @@ public:
     bool set_output_format (uint32_t fourcc);
     bool set_capture_stage (CaptureStage capture_stage);
     bool set_3a_stats_bits (uint32_t bits);
+    bool set_stats_thumbnail_bin (uint32_t bin);
 
     virtual bool set_hdr (uint32_t mode);
     virtual bool set_denoise (uint32_t mode);
@@ -87,11 +91,16 @@ public:
     virtual bool set_tnr (uint32_t mode, uint8_t level);
     virtual bool set_wavelet (CLWaveletBasis basis, uint32_t channel);
     virtual bool set_tonemapping (CLTonemappingMode wdr_mode);
+    // 3D LUT color stage instead of the yuv pipe, no yuv tnr
+    virtual bool set_lut3d (bool enable);
 
     PipelineProfile get_profile () const {
         return _pipeline_profile;
     }
 
+    //derived from CLImageProcessor
+    virtual void introspect (IntrospectionWriter &writer);
+
 protected:
 
     //derive from ImageProcessor
@@ -108,6 +117,7 @@ private:
 private:
     uint32_t                            _output_fourcc;
     uint32_t                            _3a_stats_bits;
+    uint32_t                            _stats_thumbnail_bin;
     PipelineProfile                     _pipeline_profile;
     CaptureStage                        _capture_stage;
     CLTonemappingMode                   _wdr_mode;
@@ -126,12 +136,14 @@ private:
     SmartPtr<CLBayerBasicImageHandler>  _bayer_basic_pipe;
     SmartPtr<CLBayerPipeImageHandler>   _bayer_pipe;
     SmartPtr<CLYuvPipeImageHandler>     _yuv_pipe;
+    SmartPtr<CLLut3dImageHandler>       _lut3d;
 
     uint32_t                            _hdr_mode;
     uint32_t                            _tnr_mode;
     bool                                _enable_gamma;
     bool                                _enable_macc;
     bool                                _enable_dpc;
+    bool                                _enable_lut3d;
     CLWaveletBasis                      _wavelet_basis;
     uint32_t                            _wavelet_channel;
     uint32_t                            _snr_mode; // spatial nr mode
@@ -85,6 +85,7 @@ CL3AStatsCalculatorKernel::post_execute (SmartPtr<DrmBoBuffer> &output)
     //context->finish ();
     _image_in.release ();
     //copy out and post 3a stats
+    XCAM_FAIL_RETURN (WARNING, event.ptr (), XCAM_RETURN_ERROR_MEM, "3a stats allocating event failed");
     buffer = _stats_pool->get_buffer (_stats_pool);
     XCAM_FAIL_RETURN (WARNING, buffer.ptr (), XCAM_RETURN_ERROR_MEM, "3a stats pool stopped.");
 
@@ -112,6 +113,13 @@ CL3AStatsCalculatorKernel::post_execute (SmartPtr<DrmBoBuffer> &output)
     return _image->post_stats (stats);
 }
 
+void
+CL3AStatsCalculatorKernel::pre_start ()
+{
+    if (_stats_pool.ptr ())
+        _stats_pool->resume ();
+}
+
 void
 CL3AStatsCalculatorKernel::pre_stop ()
 {
@@ -47,6 +47,7 @@ public:
 
     virtual XCamReturn post_execute (SmartPtr<DrmBoBuffer> &output);
 
+    virtual void pre_start ();
     virtual void pre_stop ();
 
 private:
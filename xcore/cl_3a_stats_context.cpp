@@ -21,6 +21,7 @@
 
 #include "xcam_utils.h"
 #include "cl_3a_stats_context.h"
+#include "perf_counters.h"
 
 namespace XCam {
 CL3AStatsCalculatorContext::CL3AStatsCalculatorContext (const SmartPtr<CLContext> &context)
@@ -90,6 +91,14 @@ CL3AStatsCalculatorContext::allocate_data (const VideoBufferInfo &buffer_info, u
     return true;
 }
 
+void
+CL3AStatsCalculatorContext::pre_start ()
+{
+    if (_stats_pool.ptr ())
+        _stats_pool->resume ();
+    _stats_cl_buffers.resume_pop ();
+}
+
 void
 CL3AStatsCalculatorContext::pre_stop ()
 {
@@ -193,9 +202,11 @@ CL3AStatsCalculatorContext::copy_stats_out (const SmartPtr<CLBuffer> &stats_cl_b
     XCamReturn ret = XCAM_RETURN_NO_ERROR;
     void *buf_ptr = NULL;
     const CL3AStatsStruct *cl_buf_ptr = NULL;
+    PerfStage perf_stage ("stats", "cl_copy_out");
 
     XCAM_ASSERT (stats_cl_buf.ptr ());
 
+    XCAM_FAIL_RETURN (WARNING, event.ptr (), NULL, "3a stats allocating event failed");
     buffer = _stats_pool->get_buffer (_stats_pool);
     XCAM_FAIL_RETURN (WARNING, buffer.ptr (), NULL, "3a stats pool stopped.");
 
@@ -247,6 +258,7 @@ CL3AStatsCalculatorContext::copy_stats_out (const SmartPtr<CLBuffer> &stats_cl_b
     event.release ();
 
     SmartPtr<CLEvent>  unmap_event = new CLEvent;
+    XCAM_FAIL_RETURN (WARNING, unmap_event.ptr (), NULL, "3a stats allocating unmap event failed");
     ret = stats_cl_buf->enqueue_unmap (buf_ptr, CLEvent::EmptyList, unmap_event);
     XCAM_FAIL_RETURN (WARNING, ret == XCAM_RETURN_NO_ERROR, NULL, "3a stats buffer enqueue unmap failed");
     ret = unmap_event->wait ();
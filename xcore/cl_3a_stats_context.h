@@ -53,6 +53,7 @@ public:
         return _data_allocated;
     }
     bool allocate_data (const VideoBufferInfo &buffer_info, uint32_t width_factor, uint32_t height_factor);
+    void pre_start ();
     void pre_stop ();
     void clean_up_data ();
 
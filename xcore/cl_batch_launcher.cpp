@@ -0,0 +1,236 @@
+/*
+ * cl_batch_launcher.cpp - merge kernel launches of several streams
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#include "cl_batch_launcher.h"
+#include "cl_memory.h"
+#include <errno.h>
+
+namespace XCam {
+
+CLBatchItem::CLBatchItem ()
+    : launched (false)
+    , ret (XCAM_RETURN_NO_ERROR)
+{
+    xcam_mem_clear (params);
+}
+
+CLBatchKernel::CLBatchKernel (SmartPtr<CLContext> &context, const char *name)
+    : CLKernel (context, name)
+{
+}
+
+XCamReturn
+CLBatchKernel::launch (CLBatchItem *items[], uint32_t count, const CLWorkSize &stream_size)
+{
+    SmartPtr<CLContext> context = get_context ();
+    float params[XCAM_CL_BATCH_MAX_IMAGES * XCAM_CL_BATCH_MAX_PARAMS];
+    size_t global[XCAM_CL_KERNEL_MAX_WORK_DIM];
+    size_t local[XCAM_CL_KERNEL_MAX_WORK_DIM];
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+
+    XCAM_ASSERT (count > 0 && count <= XCAM_CL_BATCH_MAX_IMAGES);
+    XCAM_ASSERT (stream_size.dim == 2);
+
+    xcam_mem_clear (params);
+    for (uint32_t i = 0; i < XCAM_CL_BATCH_MAX_IMAGES; ++i) {
+        CLBatchItem *item = items[i < count ? i : 0];
+        if (i < count)
+            memcpy (&params[i * XCAM_CL_BATCH_MAX_PARAMS], item->params, sizeof (item->params));
+
+        ret = set_argument (i, &item->input->get_mem_id (), sizeof (cl_mem));
+        if (ret == XCAM_RETURN_NO_ERROR)
+            ret = set_argument (XCAM_CL_BATCH_MAX_IMAGES + i, &item->output->get_mem_id (), sizeof (cl_mem));
+        XCAM_FAIL_RETURN (
+            WARNING, ret == XCAM_RETURN_NO_ERROR, ret,
+            "cl batch kernel(%s) set image(%d) failed", get_kernel_name (), i);
+    }
+
+    // copied at creation, the buffer may be released right after enqueue
+    SmartPtr<CLBuffer> param_buffer = new CLBuffer (
+        context, sizeof (params), CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, params);
+    XCAM_FAIL_RETURN (
+        WARNING, param_buffer->is_valid (), XCAM_RETURN_ERROR_MEM,
+        "cl batch kernel(%s) create parameter buffer failed", get_kernel_name ());
+
+    uint32_t arg_index = XCAM_CL_BATCH_MAX_IMAGES * 2;
+    ret = set_argument (arg_index++, &param_buffer->get_mem_id (), sizeof (cl_mem));
+    if (ret == XCAM_RETURN_NO_ERROR)
+        ret = set_argument (arg_index++, &count, sizeof (count));
+    XCAM_FAIL_RETURN (
+        WARNING, ret == XCAM_RETURN_NO_ERROR, ret,
+        "cl batch kernel(%s) set parameters failed", get_kernel_name ());
+
+    global[0] = stream_size.global[0];
+    global[1] = stream_size.global[1];
+    global[2] = count;
+    local[0] = stream_size.local[0];
+    local[1] = stream_size.local[1];
+    local[2] = (local[0] && local[1]) ? 1 : 0;
+    ret = set_work_size (3, global, local);
+    XCAM_FAIL_RETURN (
+        WARNING, ret == XCAM_RETURN_NO_ERROR, ret,
+        "cl batch kernel(%s) set work size failed", get_kernel_name ());
+
+    return execute ();
+}
+
+CLBatchLauncher::Group::Group ()
+    : members (0)
+    , launches (0)
+    , items (0)
+    , partial (0)
+{
+}
+
+CLBatchLauncher::CLBatchLauncher ()
+    : _wait_us (XCAM_CL_BATCH_DEFAULT_WAIT_US)
+{
+}
+
+CLBatchLauncher::~CLBatchLauncher ()
+{
+    XCAM_ASSERT (_groups.empty ());
+}
+
+XCamReturn
+CLBatchLauncher::join (
+    const std::string &key, SmartPtr<CLContext> &context, CLBatchKernelCreator creator)
+{
+    SmartLock locker (_mutex);
+    Group &group = _groups[key];
+
+    if (!group.kernel.ptr ()) {
+        group.kernel = creator (context);
+        if (!group.kernel.ptr () || !group.kernel->is_valid ()) {
+            XCAM_LOG_WARNING ("cl batch group(%s) create kernel failed", key.c_str ());
+            _groups.erase (key);
+            return XCAM_RETURN_ERROR_CL;
+        }
+    }
+
+    ++group.members;
+    XCAM_LOG_INFO ("cl batch group(%s) joined, %d streams", key.c_str (), group.members);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+void
+CLBatchLauncher::leave (const std::string &key)
+{
+    SmartLock locker (_mutex);
+    GroupMap::iterator i_group = _groups.find (key);
+    if (i_group == _groups.end ())
+        return;
+
+    Group &group = i_group->second;
+    XCAM_ASSERT (group.members);
+    --group.members;
+
+    // the ones left may all be waiting for this stream
+    if (!group.pending.empty () && group.pending.size () >= group.members)
+        flush (group);
+
+    if (!group.members) {
+        XCAM_ASSERT (group.pending.empty ());
+        _groups.erase (i_group);
+    }
+}
+
+XCamReturn
+CLBatchLauncher::submit (const std::string &key, CLBatchItem &item, const CLWorkSize &stream_size)
+{
+    SmartLock locker (_mutex);
+    GroupMap::iterator i_group = _groups.find (key);
+    XCAM_FAIL_RETURN (
+        WARNING, i_group != _groups.end (), XCAM_RETURN_ERROR_PARAM,
+        "cl batch group(%s) not joined", key.c_str ());
+
+    Group &group = i_group->second;
+    item.launched = false;
+    item.ret = XCAM_RETURN_NO_ERROR;
+    group.stream_size = stream_size;
+    group.pending.push_back (&item);
+
+    if (group.pending.size () >= group.members) {
+        flush (group);
+        return item.ret;
+    }
+
+    struct timeval deadline;
+    gettimeofday (&deadline, NULL);
+    int64_t deadline_us = deadline.tv_sec * 1000000LL + deadline.tv_usec + _wait_us;
+
+    while (!item.launched) {
+        struct timeval now;
+        gettimeofday (&now, NULL);
+        int64_t remain_us = deadline_us - (now.tv_sec * 1000000LL + now.tv_usec);
+        if (remain_us <= 0 || _launched.timedwait (_mutex, remain_us) == ETIMEDOUT) {
+            if (!item.launched) {
+                ++group.partial;
+                flush (group);
+            }
+        }
+    }
+    return item.ret;
+}
+
+void
+CLBatchLauncher::flush (Group &group)
+{
+    for (uint32_t begin = 0; begin < group.pending.size (); begin += XCAM_CL_BATCH_MAX_IMAGES) {
+        uint32_t count = XCAM_MIN (group.pending.size () - begin, (uint32_t)XCAM_CL_BATCH_MAX_IMAGES);
+        XCamReturn ret = group.kernel->launch (&group.pending[begin], count, group.stream_size);
+        if (ret != XCAM_RETURN_NO_ERROR) {
+            XCAM_LOG_WARNING (
+                "cl batch kernel(%s) launch of %d streams failed", group.kernel->get_kernel_name (), count);
+        }
+
+        for (uint32_t i = begin; i < begin + count; ++i) {
+            group.pending[i]->ret = ret;
+            group.pending[i]->launched = true;
+        }
+        ++group.launches;
+        group.items += count;
+    }
+
+    group.pending.clear ();
+    _launched.broadcast ();
+}
+
+void
+CLBatchLauncher::introspect (IntrospectionWriter &writer)
+{
+    SmartLock locker (_mutex);
+
+    writer.add ("wait_us", _wait_us);
+    writer.begin_array ("groups");
+    for (GroupMap::iterator i_group = _groups.begin (); i_group != _groups.end (); ++i_group) {
+        const Group &group = i_group->second;
+        writer.begin_object ();
+        writer.add ("key", i_group->first.c_str ());
+        writer.add ("streams", group.members);
+        writer.add ("launches", group.launches);
+        writer.add ("frames", group.items);
+        writer.add ("partial", group.partial);
+        writer.end_object ();
+    }
+    writer.end_array ();
+}
+
+};
@@ -0,0 +1,129 @@
+/*
+ * cl_batch_launcher.h - merge kernel launches of several streams
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#ifndef XCAM_CL_BATCH_LAUNCHER_H
+#define XCAM_CL_BATCH_LAUNCHER_H
+
+#include "xcam_utils.h"
+#include "xcam_mutex.h"
+#include "cl_image_handler.h"
+#include "introspection.h"
+#include <map>
+#include <string>
+#include <vector>
+
+// image slots of one launch, OpenCL 1.2 guarantees 8 write image arguments
+#define XCAM_CL_BATCH_MAX_IMAGES 8
+// floats of per-stream parameters, one float8 per stream in the kernel
+#define XCAM_CL_BATCH_MAX_PARAMS 8
+// longest a stream waits for the others before launching without them
+#define XCAM_CL_BATCH_DEFAULT_WAIT_US 2000
+
+namespace XCam {
+
+struct CLBatchItem {
+    SmartPtr<CLImage>   input;
+    SmartPtr<CLImage>   output;
+    float               params[XCAM_CL_BATCH_MAX_PARAMS];
+    bool                launched;
+    XCamReturn          ret;
+
+    CLBatchItem ();
+};
+
+/*
+ * CLBatchKernel
+ * one launch for up to XCAM_CL_BATCH_MAX_IMAGES streams. Kernel arguments
+ * are input0..7, output0..7, a buffer with one float8 of parameters per
+ * stream and the stream count; global id 2 selects the stream. Unused
+ * image slots repeat the first stream's images.
+ */
+class CLBatchKernel
+    : public CLKernel
+{
+public:
+    explicit CLBatchKernel (SmartPtr<CLContext> &context, const char *name);
+
+    // stream_size is the work size of a single stream
+    XCamReturn launch (CLBatchItem *items[], uint32_t count, const CLWorkSize &stream_size);
+
+private:
+    XCAM_DEAD_COPY (CLBatchKernel);
+};
+
+typedef SmartPtr<CLBatchKernel> (*CLBatchKernelCreator) (SmartPtr<CLContext> &context);
+
+/*
+ * CLBatchLauncher
+ * shared by the processors of several streams, opt in per handler.
+ * Kernels of the same key (kernel name, input and output format and
+ * size) join a group; each frame a stream submits its images and waits
+ * until every member submitted, then one launch covers them all. A
+ * stream waiting longer than the wait time launches the group without
+ * the late ones, so streams at different rates only lose batching.
+ * Submit returns once the batch is enqueued, not finished.
+ */
+class CLBatchLauncher
+    : public Introspectable
+{
+    struct Group {
+        SmartPtr<CLBatchKernel>      kernel;
+        CLWorkSize                   stream_size;
+        uint32_t                     members;
+        std::vector<CLBatchItem *>   pending;
+        uint64_t                     launches;
+        uint64_t                     items;
+        uint64_t                     partial;    // launched on wait timeout
+
+        Group ();
+    };
+    typedef std::map<std::string, Group> GroupMap;
+
+public:
+    explicit CLBatchLauncher ();
+    virtual ~CLBatchLauncher ();
+
+    void set_wait_time (uint32_t us) {
+        _wait_us = us;
+    }
+
+    XCamReturn join (
+        const std::string &key, SmartPtr<CLContext> &context, CLBatchKernelCreator creator);
+    void leave (const std::string &key);
+    XCamReturn submit (const std::string &key, CLBatchItem &item, const CLWorkSize &stream_size);
+
+    //derived from Introspectable
+    virtual void introspect (IntrospectionWriter &writer);
+
+private:
+    void flush (Group &group);
+
+    XCAM_DEAD_COPY (CLBatchLauncher);
+
+private:
+    GroupMap           _groups;
+    uint32_t           _wait_us;
+    Mutex              _mutex;
+    Cond               _launched;
+};
+
+};
+
+#endif //XCAM_CL_BATCH_LAUNCHER_H
@@ -21,6 +21,7 @@
 #include "xcam_utils.h"
 #include "cl_bayer_basic_handler.h"
 #include "xcam_thread.h"
+#include "frame_arena.h"
 
 #define GROUP_CELL_X_SIZE 64
 #define GROUP_CELL_Y_SIZE 4
@@ -34,7 +35,9 @@
 
 namespace XCam {
 
-struct BayerPostData {
+struct BayerPostData
+    : public ArenaObject
+{
     SmartPtr<DrmBoBuffer> image_buffer;
     SmartPtr<CLBuffer>    stats_cl_buf;
 };
@@ -49,6 +52,7 @@ public:
     {}
     ~CLBayer3AStatsThread () {}
 
+    void triger_start ();
     virtual bool emit_stop ();
     bool queue_stats (SmartPtr<DrmBoBuffer> &buf, SmartPtr<CLBuffer> &stats);
     SmartPtr<DrmBoBuffer> pop_buf ();
@@ -62,6 +66,13 @@ private:
     SafeList<DrmBoBuffer>        _buffer_done_list;
 };
 
+void
+CLBayer3AStatsThread::triger_start ()
+{
+    _stats_process_list.resume_pop ();
+    _buffer_done_list.resume_pop ();
+}
+
 bool
 CLBayer3AStatsThread::emit_stop ()
 {
@@ -84,7 +95,7 @@ CLBayer3AStatsThread::queue_stats (SmartPtr<DrmBoBuffer> &buf, SmartPtr<CLBuffer
         "cl bayer 3a-stats thread has error buffer/stats to queue");
 
     SmartPtr<BayerPostData> data = new BayerPostData;
-    XCAM_ASSERT (data.ptr ());
+    XCAM_FAIL_RETURN (WARNING, data.ptr (), false, "cl bayer 3a-stats thread out of memory");
     data->image_buffer = buf;
     data->stats_cl_buf = stats;
 
@@ -100,6 +111,15 @@ CLBayer3AStatsThread::pop_buf ()
 void
 CLBayer3AStatsThread::stopped ()
 {
+    // hand pending stats buffers back, or each restart would lose them
+    _stats_process_list.resume_pop ();
+    while (!_stats_process_list.is_empty ()) {
+        SmartPtr<BayerPostData> data = _stats_process_list.pop (0);
+        if (data.ptr ())
+            _kernel->_3a_stats_context->release_buffer (data->stats_cl_buf);
+    }
+    _stats_process_list.pause_pop ();
+
     _stats_process_list.clear ();
     _buffer_done_list.clear ();
 }
@@ -119,6 +139,7 @@ CLBayer3AStatsThread::loop ()
     XCAM_ASSERT (data->stats_cl_buf.ptr ());
     XCAM_ASSERT (_kernel);
 
+    FrameArenaScope arena_scope;
     ret = _kernel->process_stats_buffer (data->image_buffer, data->stats_cl_buf);
     XCAM_FAIL_RETURN (
         WARNING,
@@ -138,6 +159,7 @@ CLBayerBasicImageKernel::CLBayerBasicImageKernel (SmartPtr<CLContext> &context,
     : CLImageKernel (context, "kernel_bayer_basic")
     , _input_aligned_width (0)
     , _out_aligned_height (0)
+    , _thumbnail_bin (0)
     , _is_first_buf (true)
     , _handler (handler)
 {
@@ -216,6 +238,8 @@ CLBayerBasicImageKernel::prepare_arguments (
     const VideoBufferInfo & out_video_info = output->get_video_info ();
     CLImageDesc in_image_info;
     CLImageDesc out_image_info;
+    uint32_t cell_width = out_video_info.width;
+    uint32_t cell_height = out_video_info.aligned_height;
 
     if (!_3a_stats_context->is_ready () &&
             !_3a_stats_context->allocate_data (
@@ -252,9 +276,18 @@ CLBayerBasicImageKernel::prepare_arguments (
     _buffer_in = new CLVaBuffer (context, input);
 #endif
     _input_aligned_width = in_video_info.strides[0] / (2 * 8); // ushort8
-    _image_out = new CLVaImage (context, output, out_image_info);
 
-    _out_aligned_height = out_video_info.aligned_height;
+    if (_thumbnail_bin) {
+        // work items still walk the bayer cells, as for the planar output
+        VideoBufferInfo planar_info;
+        planar_info.init (XCAM_PIX_FMT_SGRBG16_planar, in_video_info.width / 2, in_video_info.height / 2);
+        cell_width = planar_info.width;
+        cell_height = planar_info.aligned_height;
+        _image_out = new CLVaImage (context, output);
+    } else
+        _image_out = new CLVaImage (context, output, out_image_info);
+
+    _out_aligned_height = cell_height;
     _blc_config.color_bits = in_video_info.color_bits;
 
     _gamma_table_buffer = new CLBuffer(
@@ -316,8 +349,8 @@ CLBayerBasicImageKernel::prepare_arguments (
     work_size.dim = XCAM_DEFAULT_IMAGE_DIM;
     work_size.local[0] = 16;
     work_size.local[1] = 2;
-    work_size.global[0] = XCAM_ALIGN_UP(out_video_info.width, GROUP_CELL_X_SIZE) / GROUP_CELL_X_SIZE * work_size.local[0];
-    work_size.global[1] = XCAM_ALIGN_UP(out_video_info.aligned_height, GROUP_CELL_Y_SIZE) / GROUP_CELL_Y_SIZE * work_size.local[1];
+    work_size.global[0] = XCAM_ALIGN_UP(cell_width, GROUP_CELL_X_SIZE) / GROUP_CELL_X_SIZE * work_size.local[0];
+    work_size.global[1] = XCAM_ALIGN_UP(cell_height, GROUP_CELL_Y_SIZE) / GROUP_CELL_Y_SIZE * work_size.local[1];
 
     //printf ("work_size:g(%d, %d), l(%d, %d)\n", work_size.global[0], work_size.global[1], work_size.local[0], work_size.local[1]);
 
@@ -382,6 +415,15 @@ CLBayerBasicImageKernel::process_stats_buffer (SmartPtr<DrmBoBuffer> &buffer, Sm
     return _handler->post_stats (stats_3a);
 }
 
+void
+CLBayerBasicImageKernel::pre_start ()
+{
+    _3a_stats_context->pre_start ();
+    _3a_stats_thread->triger_start ();
+    // restart the one frame delay and the stats thread on next buffer
+    _is_first_buf = true;
+}
+
 void
 CLBayerBasicImageKernel::pre_stop ()
 {
@@ -427,7 +469,13 @@ CLBayerBasicImageHandler::prepare_buffer_pool_video_info (
     VideoBufferInfo &output)
 {
     uint32_t format = XCAM_PIX_FMT_SGRBG16_planar;
-    bool format_inited = output.init (format, input.width / 2 , input.height / 2);
+    uint32_t bin = 2;
+
+    if (_bayer_kernel->get_thumbnail_bin ()) {
+        format = V4L2_PIX_FMT_RGBA32;
+        bin = _bayer_kernel->get_thumbnail_bin ();
+    }
+    bool format_inited = output.init (format, input.width / bin, input.height / bin);
 
     XCAM_FAIL_RETURN (
         WARNING,
@@ -450,12 +498,19 @@ CLBayerBasicImageHandler::post_stats (const SmartPtr<X3aStats> &stats)
 
 
 SmartPtr<CLImageHandler>
-create_cl_bayer_basic_image_handler (SmartPtr<CLContext> &context, bool enable_gamma, uint32_t stats_bits)
+create_cl_bayer_basic_image_handler (
+    SmartPtr<CLContext> &context, bool enable_gamma, uint32_t stats_bits, uint32_t thumbnail_bin)
 {
     SmartPtr<CLBayerBasicImageHandler> bayer_planar_handler;
     SmartPtr<CLBayerBasicImageKernel> basic_kernel;
     XCamReturn ret = XCAM_RETURN_NO_ERROR;
 
+    XCAM_FAIL_RETURN (
+        WARNING,
+        thumbnail_bin == 0 || thumbnail_bin == 2 || thumbnail_bin == 4,
+        NULL,
+        "cl bayer basic thumbnail bin(%d) unsupported, select from 2 or 4", thumbnail_bin);
+
     bayer_planar_handler = new CLBayerBasicImageHandler ("cl_handler_bayer_basic");
     basic_kernel = new CLBayerBasicImageKernel (context, bayer_planar_handler);
     {
@@ -465,10 +520,12 @@ create_cl_bayer_basic_image_handler (SmartPtr<CLContext> &context, bool enable_g
         snprintf (build_options, sizeof (build_options),
                   " -DENABLE_GAMMA=%d "
                   " -DENABLE_IMAGE_2D_INPUT=%d "
-                  " -DSTATS_BITS=%d ",
+                  " -DSTATS_BITS=%d "
+                  " -DTHUMBNAIL_BIN=%d ",
                   (enable_gamma ? 1 : 0),
                   ENABLE_IMAGE_2D_INPUT,
-                  stats_bits);
+                  stats_bits,
+                  thumbnail_bin);
 
         XCAM_CL_KERNEL_FUNC_SOURCE_BEGIN (kernel_bayer_basic)
 #include "kernel_bayer_basic.clx"
@@ -485,6 +542,7 @@ create_cl_bayer_basic_image_handler (SmartPtr<CLContext> &context, bool enable_g
     }
     XCAM_ASSERT (basic_kernel->is_valid ());
     basic_kernel->set_stats_bits (stats_bits);
+    basic_kernel->set_thumbnail_bin (thumbnail_bin);
     bayer_planar_handler->set_bayer_kernel (basic_kernel);
 
     return bayer_planar_handler;
@@ -42,12 +42,20 @@ public:
     explicit CLBayerBasicImageKernel (SmartPtr<CLContext> &context, SmartPtr<CLBayerBasicImageHandler>& handler);
     virtual ~CLBayerBasicImageKernel ();
     void set_stats_bits (uint32_t stats_bits);
+    // 0 for the planar bayer output, 2 or 4 for a binned RGBA thumbnail
+    void set_thumbnail_bin (uint32_t bin) {
+        _thumbnail_bin = bin;
+    }
+    uint32_t get_thumbnail_bin () const {
+        return _thumbnail_bin;
+    }
 
     bool set_blc (const XCam3aResultBlackLevel &blc);
     bool set_wb (const XCam3aResultWhiteBalance &wb);
     bool set_gamma_table (const XCam3aResultGammaTable &gamma);
 
     virtual XCamReturn post_execute (SmartPtr<DrmBoBuffer> &output);
+    virtual void pre_start ();
     virtual void pre_stop ();
 
 protected:
@@ -64,6 +72,7 @@ private:
 private:
     uint32_t                  _input_aligned_width;
     uint32_t                  _out_aligned_height;
+    uint32_t                  _thumbnail_bin;
     SmartPtr<CLBuffer>        _buffer_in;
     CLBLCConfig               _blc_config;
     CLWBConfig                _wb_config;
@@ -111,11 +120,16 @@ private:
 };
 
 
+/*
+ * thumbnail_bin 2 or 4 makes the handler output a binned V4L2_PIX_FMT_RGBA32
+ * thumbnail instead of the planar bayer, for stats only processing
+ */
 SmartPtr<CLImageHandler>
 create_cl_bayer_basic_image_handler (
     SmartPtr<CLContext> &context,
     bool enable_gamma = true,
-    uint32_t stats_bits = 8);
+    uint32_t stats_bits = 8,
+    uint32_t thumbnail_bin = 0);
 
 };
 
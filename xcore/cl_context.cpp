@@ -22,6 +22,7 @@
 #include "cl_context.h"
 #include "cl_kernel.h"
 #include "cl_device.h"
+#include "xcam_probes.h"
 #include <utility>
 
 #undef XCAM_CL_MAX_STR_SIZE
@@ -263,6 +264,9 @@ CLContext::execute_kernel (
         "execute kernel(%s) failed with error_code:%d",
         kernel->get_kernel_name (), error_code);
 
+    XCAM_PROBE4 (
+        kernel_enqueue, kernel->get_kernel_name (), work_dims,
+        global_sizes[0], (work_dims > 1 ? global_sizes[1] : 1));
     return XCAM_RETURN_NO_ERROR;
 }
 
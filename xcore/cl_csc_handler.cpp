@@ -25,6 +25,29 @@ float default_rgbtoyuv_matrix[XCAM_COLOR_MATRIX_SIZE] = {0.299, 0.587, 0.114, -0
 
 namespace XCam {
 
+// v to r, u to g, v to g, u to b, as in kernel_csc_yuyvtorgba
+static const float default_yuvtorgb_coeffs[4] = {1.13983, 0.39465, 0.5806, 2.03211};
+
+static SmartPtr<CLBatchKernel>
+create_cl_csc_batch_kernel (SmartPtr<CLContext> &context)
+{
+    SmartPtr<CLBatchKernel> batch_kernel;
+
+    XCAM_CL_KERNEL_FUNC_SOURCE_BEGIN(kernel_csc_yuyvtorgba_batch)
+#include "kernel_csc_yuyvtorgba_batch.clx"
+    XCAM_CL_KERNEL_FUNC_END;
+
+    batch_kernel = new CLBatchKernel (context, "kernel_csc_yuyvtorgba_batch");
+    XCAM_FAIL_RETURN (
+        WARNING,
+        batch_kernel->load_from_source (
+            kernel_csc_yuyvtorgba_batch_body, strlen (kernel_csc_yuyvtorgba_batch_body)) == XCAM_RETURN_NO_ERROR,
+        NULL,
+        "CL csc batch kernel load source failed");
+
+    return batch_kernel;
+}
+
 CLCscImageKernel::CLCscImageKernel (SmartPtr<CLContext> &context, const char *name)
     : CLImageKernel (context, name)
     , _kernel_csc_type (CL_CSC_TYPE_RGBATONV12)
@@ -32,6 +55,11 @@ CLCscImageKernel::CLCscImageKernel (SmartPtr<CLContext> &context, const char *na
     set_matrix (default_rgbtoyuv_matrix);
 }
 
+CLCscImageKernel::~CLCscImageKernel ()
+{
+    leave_batch ();
+}
+
 bool
 CLCscImageKernel::set_matrix (const float * matrix)
 {
@@ -46,6 +74,84 @@ CLCscImageKernel::set_csc_kernel_type (CLCscType type)
     return true;
 }
 
+bool
+CLCscImageKernel::set_batch_launcher (const SmartPtr<CLBatchLauncher> &launcher)
+{
+    XCAM_FAIL_RETURN (
+        WARNING,
+        !launcher.ptr () || _kernel_csc_type == CL_CSC_TYPE_YUYVTORGBA,
+        false,
+        "cl kernel(%s) only batches YUYV to RGBA", get_kernel_name ());
+
+    leave_batch ();
+    _batch_launcher = launcher;
+    return true;
+}
+
+XCamReturn
+CLCscImageKernel::join_batch (const VideoBufferInfo &in_info, const VideoBufferInfo &out_info)
+{
+    char in_format[5], out_format[5], key[XCAM_MAX_STR_SIZE];
+
+    // xcam_fourcc_to_string returns a static buffer
+    strncpy (in_format, xcam_fourcc_to_string (in_info.format), sizeof (in_format));
+    strncpy (out_format, xcam_fourcc_to_string (out_info.format), sizeof (out_format));
+    snprintf (
+        key, sizeof (key), "%s|%s %dx%d|%s %dx%d", get_kernel_name (),
+        in_format, in_info.width, in_info.height, out_format, out_info.width, out_info.height);
+
+    if (_batch_key == key)
+        return XCAM_RETURN_NO_ERROR;
+
+    leave_batch ();
+    XCamReturn ret = _batch_launcher->join (key, get_context (), create_cl_csc_batch_kernel);
+    XCAM_FAIL_RETURN (
+        WARNING, ret == XCAM_RETURN_NO_ERROR, ret,
+        "cl kernel(%s) join batch(%s) failed", get_kernel_name (), key);
+
+    _batch_key = key;
+    return XCAM_RETURN_NO_ERROR;
+}
+
+void
+CLCscImageKernel::leave_batch ()
+{
+    if (_batch_key.empty ())
+        return;
+
+    XCAM_ASSERT (_batch_launcher.ptr ());
+    _batch_launcher->leave (_batch_key);
+    _batch_key.clear ();
+}
+
+XCamReturn
+CLCscImageKernel::launch ()
+{
+    if (_batch_key.empty ())
+        return CLImageKernel::launch ();
+
+    CLBatchItem item;
+    CLWorkSize work_size;
+
+    item.input = _image_in;
+    item.output = _image_out;
+    memcpy (item.params, default_yuvtorgb_coeffs, sizeof (default_yuvtorgb_coeffs));
+
+    work_size.dim = get_work_dims ();
+    for (uint32_t i = 0; i < work_size.dim; ++i) {
+        work_size.global[i] = get_work_global_size ()[i];
+        work_size.local[i] = get_work_local_size ()[i];
+    }
+    return _batch_launcher->submit (_batch_key, item, work_size);
+}
+
+void
+CLCscImageKernel::pre_stop ()
+{
+    leave_batch ();
+    CLImageKernel::pre_stop ();
+}
+
 XCamReturn
 CLCscImageKernel::prepare_arguments (
     SmartPtr<DrmBoBuffer> &input, SmartPtr<DrmBoBuffer> &output,
@@ -81,6 +187,11 @@ CLCscImageKernel::prepare_arguments (
     work_size.local[0] = 4;
     work_size.local[1] = 4;
 
+    if (_batch_launcher.ptr () && join_batch (in_video_info, out_video_info) != XCAM_RETURN_NO_ERROR) {
+        XCAM_LOG_WARNING ("cl kernel(%s) falls back to launch alone", get_kernel_name ());
+        _batch_launcher.release ();
+    }
+
     //set args;
     arg_count = 0;
     args[arg_count].arg_adress = &_image_in->get_mem_id ();
@@ -180,6 +291,13 @@ CLCscImageHandler::set_rgbtoyuv_matrix (const XCam3aResultColorMatrix &matrix)
     return true;
 }
 
+bool
+CLCscImageHandler::set_batch_launcher (const SmartPtr<CLBatchLauncher> &launcher)
+{
+    XCAM_ASSERT (_csc_kernel.ptr ());
+    return _csc_kernel->set_batch_launcher (launcher);
+}
+
 bool
 CLCscImageHandler::set_output_format (uint32_t fourcc)
 {
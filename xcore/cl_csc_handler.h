@@ -23,7 +23,9 @@
 
 #include "xcam_utils.h"
 #include "cl_image_handler.h"
+#include "cl_batch_launcher.h"
 #include "base/xcam_3a_result.h"
+#include <string>
 
 namespace XCam {
 
@@ -41,8 +43,14 @@ class CLCscImageKernel
 {
 public:
     explicit CLCscImageKernel (SmartPtr<CLContext> &context, const char *name);
+    virtual ~CLCscImageKernel ();
     bool set_matrix (const float *matrix);
     bool set_csc_kernel_type(CLCscType type);
+    // YUYV to RGBA only, NULL launches alone again
+    bool set_batch_launcher (const SmartPtr<CLBatchLauncher> &launcher);
+
+    virtual XCamReturn launch ();
+    virtual void pre_stop ();
 
 protected:
     virtual XCamReturn prepare_arguments (
@@ -52,12 +60,17 @@ protected:
     virtual XCamReturn post_execute (SmartPtr<DrmBoBuffer> &output);
 
 private:
+    XCamReturn join_batch (const VideoBufferInfo &in_info, const VideoBufferInfo &out_info);
+    void leave_batch ();
+
     XCAM_DEAD_COPY (CLCscImageKernel);
 
     float                   _rgbtoyuv_matrix[XCAM_COLOR_MATRIX_SIZE];
     CLCscType               _kernel_csc_type;
     SmartPtr<CLBuffer>      _matrix_buffer;
     SmartPtr<CLImage>       _image_uv;
+    SmartPtr<CLBatchLauncher> _batch_launcher;
+    std::string             _batch_key;
 };
 
 class CLCscImageHandler
@@ -68,6 +81,7 @@ public:
     bool set_csc_kernel(SmartPtr<CLCscImageKernel> &kernel);
     bool set_rgbtoyuv_matrix (const XCam3aResultColorMatrix &matrix);
     bool set_output_format (uint32_t fourcc);
+    bool set_batch_launcher (const SmartPtr<CLBatchLauncher> &launcher);
 
 protected:
     virtual XCamReturn prepare_buffer_pool_video_info (
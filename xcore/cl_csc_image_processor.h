@@ -24,6 +24,7 @@
 #include "xcam_utils.h"
 #include "cl_image_processor.h"
 #include "stats_callback_interface.h"
+#include "cl_batch_launcher.h"
 
 namespace XCam {
 
@@ -37,12 +38,18 @@ public:
     explicit CLCscImageProcessor ();
     virtual ~CLCscImageProcessor ();
 
+    // shared with the processors of the other streams, set before start
+    void set_batch_launcher (const SmartPtr<CLBatchLauncher> &launcher) {
+        _batch_launcher = launcher;
+    }
+
 private:
     virtual XCamReturn create_handlers ();
     XCAM_DEAD_COPY (CLCscImageProcessor);
 
 private:
     SmartPtr<CLCscImageHandler>        _csc;
+    SmartPtr<CLBatchLauncher>          _batch_launcher;
 };
 
 };
@@ -20,6 +20,7 @@
 
 #include "cl_device.h"
 #include "cl_context.h"
+#include "startup_tracer.h"
 
 namespace XCam {
 
@@ -33,6 +34,7 @@ CLDevice::instance ()
     if (_instance.ptr())
         return _instance;
 
+    StartupPhase phase ("cl_device");
     _instance = new CLDevice ();
     // create default context
     if (_instance->is_inited() &&
@@ -108,11 +110,15 @@ CLDevice::init ()
             "\tmax_compute_unit:%d"
             "\tmax_work_item_dims:%d"
             "\tmax_work_item_sizes:{%d, %d, %d}"
-            "\tmax_work_group_size:%d",
+            "\tmax_work_group_size:%d"
+            "\tname:%s"
+            "\tdriver_version:%s",
             device_info.max_compute_unit,
             device_info.max_work_item_dims,
             device_info.max_work_item_sizes[0], device_info.max_work_item_sizes[1], device_info.max_work_item_sizes[2],
-            device_info.max_work_group_size);
+            device_info.max_work_group_size,
+            device_info.name,
+            device_info.driver_version);
     }
 
     _platform_id = platform_id;
@@ -136,6 +142,8 @@ CLDevice::query_device_info (cl_device_id device_id, CLDevieInfo &info)
     XCAM_CL_GET_DEVICE_INFO (CL_DEVICE_MAX_WORK_ITEM_DIMENSIONS, info.max_work_item_dims);
     XCAM_CL_GET_DEVICE_INFO (CL_DEVICE_MAX_WORK_ITEM_SIZES, info.max_work_item_sizes);
     XCAM_CL_GET_DEVICE_INFO (CL_DEVICE_MAX_WORK_GROUP_SIZE, info.max_work_group_size);
+    XCAM_CL_GET_DEVICE_INFO (CL_DEVICE_NAME, info.name);
+    XCAM_CL_GET_DEVICE_INFO (CL_DRIVER_VERSION, info.driver_version);
     return true;
 }
 
@@ -30,11 +30,15 @@ namespace XCam {
 
 class CLContext;
 
+#define XCAM_CL_DEVICE_INFO_STR_SIZE 256
+
 struct CLDevieInfo {
     uint32_t  max_compute_unit;
     uint32_t  max_work_item_dims;
     size_t    max_work_item_sizes [3];
     size_t    max_work_group_size;
+    char      name [XCAM_CL_DEVICE_INFO_STR_SIZE];
+    char      driver_version [XCAM_CL_DEVICE_INFO_STR_SIZE];
 
     CLDevieInfo ()
         : max_compute_unit (0)
@@ -42,6 +46,8 @@ struct CLDevieInfo {
         , max_work_group_size (0)
     {
         xcam_mem_clear (max_work_item_sizes);
+        xcam_mem_clear (name);
+        xcam_mem_clear (driver_version);
     }
 };
 
@@ -0,0 +1,102 @@
+/*
+ * cl_dvs_handler.cpp - CL digital video stabilization handler
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#include "cl_dvs_handler.h"
+
+namespace XCam {
+
+CLDvsImageHandler::CLDvsImageHandler ()
+    : CLImageHandler ("cl_handler_dvs")
+    , _dvs (new ProjectionDvs)
+{
+}
+
+bool
+CLDvsImageHandler::set_scaler_kernels (SmartPtr<CLScalerKernel> &y_kernel, SmartPtr<CLScalerKernel> &uv_kernel)
+{
+    SmartPtr<CLImageKernel> kernel;
+
+    _y_kernel = y_kernel;
+    _uv_kernel = uv_kernel;
+    kernel = y_kernel;
+    add_kernel (kernel);
+    kernel = uv_kernel;
+    add_kernel (kernel);
+    return true;
+}
+
+XCamReturn
+CLDvsImageHandler::prepare_output_buf (SmartPtr<DrmBoBuffer> &input, SmartPtr<DrmBoBuffer> &output)
+{
+    XCamReturn ret = CLImageHandler::prepare_output_buf (input, output);
+    XCAM_FAIL_RETURN (
+        WARNING,
+        ret == XCAM_RETURN_NO_ERROR,
+        ret,
+        "cl_handler_dvs prepare output buf failed");
+
+    XCam3AWindow crop;
+    xcam_mem_clear (crop);
+
+    uint8_t *mem = input->map ();
+    XCAM_FAIL_RETURN (
+        WARNING,
+        mem,
+        XCAM_RETURN_ERROR_MEM,
+        "cl_handler_dvs map input buffer failed");
+    ret = _dvs->process (input->get_video_info (), mem, crop);
+    input->unmap ();
+
+    // keep the frame unstabilized on failure, stream goes on
+    if (ret != XCAM_RETURN_NO_ERROR)
+        xcam_mem_clear (crop);
+
+    _y_kernel->set_crop_window (crop);
+    _uv_kernel->set_crop_window (crop);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+SmartPtr<CLImageHandler>
+create_cl_dvs_image_handler (SmartPtr<CLContext> &context)
+{
+    SmartPtr<CLDvsImageHandler> dvs_handler = new CLDvsImageHandler ();
+    SmartPtr<CLScalerKernel> kernels[2];
+    CLImageScalerMemoryLayout layouts[2] = {CL_IMAGE_SCALER_NV12_Y, CL_IMAGE_SCALER_NV12_UV};
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+
+    for (uint32_t i = 0; i < 2; ++i) {
+        kernels[i] = new CLScalerKernel (context, layouts[i]);
+        XCAM_CL_KERNEL_FUNC_SOURCE_BEGIN(kernel_image_scaler)
+#include "kernel_image_scaler.clx"
+        XCAM_CL_KERNEL_FUNC_END;
+        ret = kernels[i]->load_from_source (kernel_image_scaler_body, strlen (kernel_image_scaler_body));
+        XCAM_FAIL_RETURN (
+            WARNING,
+            ret == XCAM_RETURN_NO_ERROR,
+            NULL,
+            "CL image handler(%s) load source failed", kernels[i]->get_kernel_name());
+        XCAM_ASSERT (kernels[i]->is_valid ());
+    }
+    dvs_handler->set_scaler_kernels (kernels[0], kernels[1]);
+
+    return dvs_handler;
+}
+
+};
@@ -0,0 +1,65 @@
+/*
+ * cl_dvs_handler.h - CL digital video stabilization handler
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#ifndef XCAM_CL_DVS_HANDLER_H
+#define XCAM_CL_DVS_HANDLER_H
+
+#include "xcam_utils.h"
+#include "cl_image_handler.h"
+#include "cl_image_scaler.h"
+#include "projection_dvs.h"
+
+namespace XCam {
+
+/*
+ * CLDvsImageHandler
+ * ProjectionDvs runs on the mapped NV12 luma of each input, the crop window
+ * found is scaled back to full size by kernel_image_scaler on Y and UV.
+ */
+class CLDvsImageHandler
+    : public CLImageHandler
+{
+public:
+    explicit CLDvsImageHandler ();
+    bool set_scaler_kernels (SmartPtr<CLScalerKernel> &y_kernel, SmartPtr<CLScalerKernel> &uv_kernel);
+
+    SmartPtr<ProjectionDvs> &get_dvs () {
+        return _dvs;
+    }
+
+protected:
+    //derived from CLImageHandler
+    virtual XCamReturn prepare_output_buf (SmartPtr<DrmBoBuffer> &input, SmartPtr<DrmBoBuffer> &output);
+
+private:
+    XCAM_DEAD_COPY (CLDvsImageHandler);
+
+private:
+    SmartPtr<ProjectionDvs>    _dvs;
+    SmartPtr<CLScalerKernel>   _y_kernel;
+    SmartPtr<CLScalerKernel>   _uv_kernel;
+};
+
+SmartPtr<CLImageHandler>
+create_cl_dvs_image_handler (SmartPtr<CLContext> &context);
+
+};
+
+#endif //XCAM_CL_DVS_HANDLER_H
@@ -23,6 +23,8 @@
 
 #include "xcam_utils.h"
 #include "smartptr.h"
+#include "small_vector.h"
+#include "frame_arena.h"
 #include <list>
 #include <CL/cl.h>
 
@@ -30,9 +32,11 @@ namespace XCam {
 
 class CLEvent;
 
-typedef std::list<SmartPtr<CLEvent>> CLEventList;
+typedef SmallVector<SmartPtr<CLEvent>> CLEventList;
 
-class CLEvent {
+class CLEvent
+    : public ArenaObject
+{
 public:
     explicit CLEvent (cl_event event_id = NULL);
     ~CLEvent ();
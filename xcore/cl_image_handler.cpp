@@ -19,10 +19,13 @@
  */
 
 #include "cl_image_handler.h"
+#include "cl_kernel_variant.h"
 #include "drm_display.h"
 #include "cl_device.h"
 #include "cl_image_bo_buffer.h"
 #include "swapped_buffer.h"
+#include "perf_counters.h"
+#include "xcam_probes.h"
 
 namespace XCam {
 
@@ -146,6 +149,8 @@ CLImageHandler::CLImageHandler (const char *name)
     , _buf_swap_flags ((uint32_t)(SwappedBuffer::OrderY0Y1) | (uint32_t)(SwappedBuffer::OrderUV0UV1))
     , _buf_swap_init_order (SwappedBuffer::OrderY0Y1)
     , _result_timestamp (XCam::InvalidTimestamp)
+    , _cost_sample_interval (0)
+    , _cost_frame_count (0)
 {
     XCAM_ASSERT (name);
     if (name)
@@ -187,6 +192,25 @@ CLImageHandler::add_kernel (SmartPtr<CLImageKernel> &kernel)
     return true;
 }
 
+bool
+CLImageHandler::add_kernel_variants (SmartPtr<CLKernelVariantSelector> &variants)
+{
+    XCAM_ASSERT (variants.ptr ());
+    XCAM_FAIL_RETURN (
+        WARNING,
+        !_variant_selector.ptr (),
+        false,
+        "CLImageHandler(%s) kernel variants already set", XCAM_STR (_name));
+
+    CLKernelVariantSelector::VariantList &list = variants->get_variants ();
+    for (CLKernelVariantSelector::VariantList::iterator i = list.begin (); i != list.end (); ++i) {
+        SmartPtr<CLImageKernel> kernel = *i;
+        add_kernel (kernel);
+    }
+    _variant_selector = variants;
+    return true;
+}
+
 bool
 CLImageHandler::set_kernels_enable (bool enable)
 {
@@ -268,10 +292,22 @@ CLImageHandler::prepare_output_buf (SmartPtr<DrmBoBuffer> &input, SmartPtr<DrmBo
     SmartPtr<BufferProxy> new_buf;
     XCamReturn ret = XCAM_RETURN_NO_ERROR;
 
+    const VideoBufferInfo &input_info = input->get_video_info ();
+    if (_buf_pool.ptr () &&
+            (input_info.format != _buf_pool_input.format ||
+             input_info.width != _buf_pool_input.width ||
+             input_info.height != _buf_pool_input.height)) {
+        XCAM_LOG_INFO (
+            "CLImageHandler(%s) input changed to %dx%d, rebuild buffer pool",
+            XCAM_STR (_name), input_info.width, input_info.height);
+        _buf_pool->stop ();
+        _buf_pool.release ();
+    }
+
     if (!_buf_pool.ptr ()) {
         VideoBufferInfo output_video_info;
 
-        ret = prepare_buffer_pool_video_info (input->get_video_info (), output_video_info);
+        ret = prepare_buffer_pool_video_info (input_info, output_video_info);
         XCAM_FAIL_RETURN(
             WARNING,
             ret == XCAM_RETURN_NO_ERROR,
@@ -284,6 +320,7 @@ CLImageHandler::prepare_output_buf (SmartPtr<DrmBoBuffer> &input, SmartPtr<DrmBo
             ret == XCAM_RETURN_NO_ERROR,
             ret,
             "CLImageHandler(%s) ensure drm buffer pool failed", XCAM_STR (_name));
+        _buf_pool_input = input_info;
     }
 
     new_buf = _buf_pool->get_buffer (_buf_pool);
@@ -301,6 +338,18 @@ CLImageHandler::prepare_output_buf (SmartPtr<DrmBoBuffer> &input, SmartPtr<DrmBo
     return XCAM_RETURN_NO_ERROR;
 }
 
+void
+CLImageHandler::emit_start ()
+{
+    for (KernelList::iterator i_kernel = _kernels.begin ();
+            i_kernel != _kernels.end ();  ++i_kernel) {
+        (*i_kernel)->pre_start ();
+    }
+
+    if (_buf_pool.ptr ())
+        _buf_pool->resume ();
+}
+
 void
 CLImageHandler::emit_stop ()
 {
@@ -329,7 +378,20 @@ CLImageHandler::execute (SmartPtr<DrmBoBuffer> &input, SmartPtr<DrmBoBuffer> &ou
         return XCAM_RETURN_NO_ERROR;
     }
 
+    // host side only: argument setup and enqueue, not the kernels
+    PerfStage perf_stage ("handler", XCAM_STR (_name));
+    HandlerProbe probe (XCAM_STR (_name), input->get_timestamp ());
     XCAM_OBJ_PROFILING_START;
+    struct timeval execute_start;
+    gettimeofday (&execute_start, NULL);
+
+    // work of earlier handlers must not count, drain the queue first
+    bool cost_sample = _cost_sample_interval && (++_cost_frame_count % _cost_sample_interval == 0);
+    struct timeval cost_start;
+    if (cost_sample) {
+        CLDevice::instance()->get_context ()->finish ();
+        gettimeofday (&cost_start, NULL);
+    }
 
     XCAM_FAIL_RETURN (
         WARNING,
@@ -339,6 +401,22 @@ CLImageHandler::execute (SmartPtr<DrmBoBuffer> &input, SmartPtr<DrmBoBuffer> &ou
 
     XCAM_ASSERT (output.ptr ());
 
+    bool benchmark_variant = false;
+    struct timeval variant_start;
+    if (_variant_selector.ptr ()) {
+        XCAM_FAIL_RETURN (
+            WARNING,
+            (ret = _variant_selector->select (
+                       input->get_video_info (), output->get_video_info (), benchmark_variant)) == XCAM_RETURN_NO_ERROR,
+            ret,
+            "cl_image_handler(%s) select kernel variant failed", XCAM_STR (_name));
+        if (benchmark_variant) {
+            // earlier handlers' queued work must not count for this variant
+            CLDevice::instance()->get_context ()->finish ();
+            gettimeofday (&variant_start, NULL);
+        }
+    }
+
     for (KernelList::iterator i_kernel = _kernels.begin ();
             i_kernel != _kernels.end (); ++i_kernel) {
         SmartPtr<CLImageKernel> &kernel = *i_kernel;
@@ -361,7 +439,7 @@ CLImageHandler::execute (SmartPtr<DrmBoBuffer> &input, SmartPtr<DrmBoBuffer> &ou
 
         XCAM_FAIL_RETURN (
             WARNING,
-            (ret = kernel->execute ()) == XCAM_RETURN_NO_ERROR,
+            (ret = kernel->launch ()) == XCAM_RETURN_NO_ERROR,
             ret,
             "cl_image_handler(%s) execute kernel(%s) failed",
             XCAM_STR (_name), kernel->get_kernel_name ());
@@ -372,6 +450,20 @@ CLImageHandler::execute (SmartPtr<DrmBoBuffer> &input, SmartPtr<DrmBoBuffer> &ou
     CLDevice::instance()->get_context ()->finish ();
 #endif
 
+    if (cost_sample) {
+        CLDevice::instance()->get_context ()->finish ();
+        _cost_duration.add (cost_start);
+    }
+
+    if (benchmark_variant) {
+        struct timeval variant_end;
+        CLDevice::instance()->get_context ()->finish ();
+        gettimeofday (&variant_end, NULL);
+        _variant_selector->report_duration (
+            (variant_end.tv_sec - variant_start.tv_sec) * 1000.0 +
+            (variant_end.tv_usec - variant_start.tv_usec) / 1000.0);
+    }
+
     // for post_execute
     for (KernelList::iterator i_kernel = _kernels.begin ();
             i_kernel != _kernels.end (); ++i_kernel) {
@@ -390,10 +482,34 @@ CLImageHandler::execute (SmartPtr<DrmBoBuffer> &input, SmartPtr<DrmBoBuffer> &ou
     }
 
     XCAM_OBJ_PROFILING_END (XCAM_STR (_name), 30);
+    _execute_duration.add (execute_start);
 
     return ret;
 }
 
+void
+CLImageHandler::introspect (IntrospectionWriter &writer)
+{
+    writer.add ("name", XCAM_STR (_name));
+    writer.add ("enabled", is_kernels_enabled ());
+    writer.begin_object ("execute");
+    _execute_duration.introspect (writer);
+    writer.end_object ();
+    if (_cost_duration.get_count ()) {
+        writer.begin_object ("cost");
+        _cost_duration.introspect (writer);
+        writer.end_object ();
+    }
+
+    SmartPtr<BufferPool> pool = _buf_pool;
+    if (pool.ptr ()) {
+        writer.begin_object ("pool");
+        writer.add ("allocated", pool->get_allocated_count ());
+        writer.add ("free", pool->get_free_count ());
+        writer.end_object ();
+    }
+}
+
 void
 CLImageHandler::set_3a_result (SmartPtr<X3aResult> &result)
 {
@@ -26,11 +26,14 @@
 #include "drm_bo_buffer.h"
 #include "cl_memory.h"
 #include "x3a_result.h"
+#include "introspection.h"
 
 namespace XCam {
 
 #define XCAM_DEFAULT_IMAGE_DIM 2
 
+class CLKernelVariantSelector;
+
 struct CLWorkSize
 {
     uint32_t dim;
@@ -62,7 +65,12 @@ public:
     }
 
     XCamReturn pre_execute (SmartPtr<DrmBoBuffer> &input, SmartPtr<DrmBoBuffer> &output);
+    // enqueues what pre_execute prepared, batched kernels hand it over instead
+    virtual XCamReturn launch () {
+        return execute ();
+    }
     virtual XCamReturn post_execute (SmartPtr<DrmBoBuffer> &output);
+    virtual void pre_start () {}
     virtual void pre_stop () {}
 
 protected:
@@ -85,7 +93,7 @@ private:
 class CLImageHandler
 {
 public:
-    typedef std::list<SmartPtr<CLImageKernel>> KernelList;
+    typedef SmallVector<SmartPtr<CLImageKernel>> KernelList;
     enum BufferPoolType {
         CLBoPoolType  = 0x0001,
         DrmBoPoolType = 0x0002,
@@ -118,12 +126,27 @@ public:
         uint32_t init_order = (uint32_t)(SwappedBuffer::OrderY0Y1));
 
     bool add_kernel (SmartPtr<CLImageKernel> &kernel);
+    // add all variants as kernels, only the selected one is enabled per frame
+    bool add_kernel_variants (SmartPtr<CLKernelVariantSelector> &variants);
     bool set_kernels_enable (bool enable);
     bool is_kernels_enabled () const;
 
     XCamReturn execute (SmartPtr<DrmBoBuffer> &input, SmartPtr<DrmBoBuffer> &output);
+    // every n-th execute runs alone on the device and is timed until the
+    // kernels finished, 0 never; it stalls the queue so keep n large
+    void set_cost_sample_interval (uint32_t interval) {
+        _cost_sample_interval = interval;
+    }
+    const DurationStats &get_cost_duration () const {
+        return _cost_duration;
+    }
+    // stop parks kernels and pool, start re-arms them
+    virtual void emit_start ();
     virtual void emit_stop ();
 
+    // execute time is host side, kernels are only enqueued
+    virtual void introspect (IntrospectionWriter &writer);
+
 protected:
     virtual XCamReturn prepare_buffer_pool_video_info (
         const VideoBufferInfo &input,
@@ -142,13 +165,19 @@ private:
 private:
     char                      *_name;
     KernelList                 _kernels;
+    SmartPtr<CLKernelVariantSelector> _variant_selector;
     SmartPtr<BufferPool>       _buf_pool;
+    VideoBufferInfo            _buf_pool_input;
     BufferPoolType             _buf_pool_type;
     uint32_t                   _buf_pool_size;
     uint32_t                   _buf_swap_flags;
     uint32_t                   _buf_swap_init_order;
     X3aResultList              _3a_results;
     int64_t                    _result_timestamp;
+    DurationStats              _execute_duration;
+    uint32_t                   _cost_sample_interval;
+    uint32_t                   _cost_frame_count;
+    DurationStats              _cost_duration;
 
     XCAM_OBJ_PROFILING_DEFINES;
 };
@@ -24,6 +24,10 @@
 #include "drm_display.h"
 #include "cl_demo_handler.h"
 #include "xcam_thread.h"
+#include "frame_arena.h"
+#include "startup_tracer.h"
+#include "xcam_probes.h"
+#include "cl_profile_selector.h"
 
 namespace XCam {
 
@@ -52,6 +56,20 @@ bool CLHandlerThread::loop ()
     return true;
 }
 
+class DrmInitTask
+    : public StartupTask
+{
+public:
+    DrmInitTask ()
+        : StartupTask ("drm_init")
+    {}
+
+protected:
+    virtual XCamReturn run () {
+        return DrmDisplay::instance ().ptr () ? XCAM_RETURN_NO_ERROR : XCAM_RETURN_ERROR_MEM;
+    }
+};
+
 class CLBufferNotifyThread
     : public Thread
 {
@@ -80,9 +98,7 @@ CLImageProcessor::CLImageProcessor (const char* name)
     : ImageProcessor (name ? name : "CLImageProcessor")
     , _seq_num (0)
 {
-    _context = CLDevice::instance ()->get_context ();
-    XCAM_ASSERT (_context.ptr());
-
+    // cl device is probed on prepare, not for processors never started
     _handler_thread = new CLHandlerThread (this);
     XCAM_ASSERT (_handler_thread.ptr ());
 
@@ -106,6 +122,12 @@ CLImageProcessor::add_handler (SmartPtr<CLImageHandler> &handler)
     return true;
 }
 
+void
+CLImageProcessor::set_profile_selector (const SmartPtr<CLProfileSelector> &selector)
+{
+    _profile_selector = selector;
+}
+
 CLImageProcessor::ImageHandlerList::iterator
 CLImageProcessor::handlers_begin ()
 {
@@ -118,10 +140,34 @@ CLImageProcessor::handlers_end ()
     return _handlers.end ();
 }
 
+void
+CLImageProcessor::introspect (IntrospectionWriter &writer)
+{
+    ImageProcessor::introspect (writer);
+    writer.add ("process_queue", _process_buffer_queue.size ());
+    writer.add ("done_queue", _done_buffer_queue.size ());
+
+    // handlers are only added in create_handlers before start
+    writer.begin_array ("handlers");
+    for (ImageHandlerList::iterator i_handler = _handlers.begin ();
+            i_handler != _handlers.end (); ++i_handler) {
+        writer.begin_object ();
+        (*i_handler)->introspect (writer);
+        writer.end_object ();
+    }
+    writer.end_array ();
+
+    if (_profile_selector.ptr ()) {
+        writer.begin_object ("profile_selector");
+        _profile_selector->introspect (writer);
+        writer.end_object ();
+    }
+}
+
 SmartPtr<CLContext>
 CLImageProcessor::get_cl_context ()
 {
-    return _context;
+    return CLDevice::instance ()->get_context ();
 }
 
 bool
@@ -149,7 +195,6 @@ XCamReturn
 CLImageProcessor::process_buffer (SmartPtr<VideoBuffer> &input, SmartPtr<VideoBuffer> &output)
 {
     SmartPtr<DrmBoBuffer> drm_bo_in;
-    XCamReturn ret = XCAM_RETURN_NO_ERROR;
     SmartPtr<DrmDisplay> display = DrmDisplay::instance ();
 
     drm_bo_in = display->convert_to_drm_bo_buf (display, input);
@@ -164,17 +209,17 @@ CLImageProcessor::process_buffer (SmartPtr<VideoBuffer> &input, SmartPtr<VideoBu
 
     STREAM_LOCK;
 
-    if (_handlers.empty()) {
-        ret = create_handlers ();
-    }
-
+    // handlers are created in prepare, before start
     XCAM_FAIL_RETURN (
         WARNING,
-        !_handlers.empty () && ret == XCAM_RETURN_NO_ERROR,
+        !_handlers.empty (),
         XCAM_RETURN_ERROR_CL,
-        "CL image processor create handlers failed");
+        "CL image processor has no handler");
 
     SmartPtr<PriorityBuffer> p_buf = new PriorityBuffer;
+    XCAM_FAIL_RETURN (
+        WARNING, p_buf.ptr (), XCAM_RETURN_ERROR_MEM,
+        "CL image processor allocating priority buffer failed");
     p_buf->set_seq_num (_seq_num++);
     p_buf->data = drm_bo_in;
     p_buf->handler = *(_handlers.begin ());
@@ -209,7 +254,9 @@ CLImageProcessor::process_cl_buffer_queue ()
         XCAM_LOG_DEBUG ("cl buffer queue stopped");
         return XCAM_RETURN_ERROR_MEM;
     }
+    XCAM_PROBE3 (pqueue_pop, p_buf->seq_num, p_buf->rank, p_buf->data->get_timestamp ());
 
+    FrameArenaScope arena_scope;
     SmartPtr<DrmBoBuffer> data = p_buf->data;
     SmartPtr<CLImageHandler> handler = p_buf->handler;
     SmartPtr <DrmBoBuffer> out_data;
@@ -221,12 +268,13 @@ CLImageProcessor::process_cl_buffer_queue ()
     {
         STREAM_LOCK;
         ret = handler->execute (data, out_data);
-        XCAM_FAIL_RETURN (
-            WARNING,
-            (ret == XCAM_RETURN_NO_ERROR || ret == XCAM_RETURN_BYPASS),
-            ret,
-            "CLImageProcessor execute image handler failed");
+        if (ret != XCAM_RETURN_NO_ERROR && ret != XCAM_RETURN_BYPASS) {
+            XCAM_LOG_WARNING ("CLImageProcessor execute image handler failed");
+            notify_process_buffer_failed (data);
+            return ret;
+        }
         XCAM_ASSERT (out_data.ptr ());
+        // the handler keeps the frame and hands it out with a later one
         if (ret == XCAM_RETURN_BYPASS)
             return ret;
 
@@ -254,6 +302,11 @@ CLImageProcessor::process_cl_buffer_queue ()
         CLDevice::instance()->get_context ()->finish ();
         XCAM_OBJ_PROFILING_END (get_name (), 30);
 
+        if (_profile_selector.ptr ()) {
+            STREAM_LOCK;
+            _profile_selector->frame_done (this, out_data->get_video_info ());
+        }
+
         // buffer done, push back
         _done_buffer_queue.push (out_data);
         return XCAM_RETURN_NO_ERROR;
@@ -262,13 +315,39 @@ CLImageProcessor::process_cl_buffer_queue ()
     p_buf->data = out_data;
     p_buf->down_rank ();
 
+    if (!_process_buffer_queue.push_priority_buf (p_buf)) {
+        XCAM_LOG_WARNING ("CLImageProcessor push priority buffer failed");
+        notify_process_buffer_failed (out_data);
+        return XCAM_RETURN_ERROR_UNKNOWN;
+    }
+
+    return ret;
+}
+
+XCamReturn
+CLImageProcessor::emit_prepare ()
+{
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+
+    // drm probing overlaps cl device init and kernel builds
+    SmartPtr<StartupTask> drm_task = new DrmInitTask;
+    drm_task->launch ();
+
+    {
+        STREAM_LOCK;
+        StartupPhase phase ("cl_handlers", get_name ());
+        if (_handlers.empty ())
+            ret = create_handlers ();
+    }
+
+    drm_task->wait ();
     XCAM_FAIL_RETURN (
         WARNING,
-        _process_buffer_queue.push_priority_buf (p_buf),
-        XCAM_RETURN_ERROR_UNKNOWN,
-        "CLImageProcessor push priority buffer failed");
+        !_handlers.empty () && ret == XCAM_RETURN_NO_ERROR,
+        XCAM_RETURN_ERROR_CL,
+        "CLImageProcessor(%s) create handlers failed", XCAM_STR (get_name ()));
 
-    return ret;
+    return XCAM_RETURN_NO_ERROR;
 }
 
 XCamReturn
@@ -277,6 +356,15 @@ CLImageProcessor::emit_start ()
     _done_buffer_queue.resume_pop ();
     _process_buffer_queue.resume_pop ();
 
+    // handlers and kernels are kept from the last run, only re-armed
+    for (ImageHandlerList::iterator i_handler = _handlers.begin ();
+            i_handler != _handlers.end ();  ++i_handler) {
+        (*i_handler)->emit_start ();
+    }
+
+    if (_profile_selector.ptr ())
+        _profile_selector->attach (this);
+
     if (!_done_buf_thread->start ())
         return XCAM_RETURN_ERROR_THREAD;
 
@@ -302,13 +390,17 @@ CLImageProcessor::emit_stop ()
     _done_buf_thread->stop ();
     _process_buffer_queue.clear ();
     _done_buffer_queue.clear ();
+
+    if (_profile_selector.ptr ())
+        _profile_selector->detach (this);
 }
 
 XCamReturn
 CLImageProcessor::create_handlers ()
 {
+    SmartPtr<CLContext> context = get_cl_context ();
     SmartPtr<CLImageHandler> demo_handler;
-    demo_handler = create_cl_demo_image_handler (_context);
+    demo_handler = create_cl_demo_image_handler (context);
     XCAM_FAIL_RETURN (
         WARNING,
         demo_handler.ptr (),
@@ -32,12 +32,13 @@ class CLImageHandler;
 class CLContext;
 class CLHandlerThread;
 class CLBufferNotifyThread;
+class CLProfileSelector;
 
 class CLImageProcessor
     : public ImageProcessor
 {
 public:
-    typedef std::list<SmartPtr<CLImageHandler>>  ImageHandlerList;
+    typedef SmallVector<SmartPtr<CLImageHandler>, 16>  ImageHandlerList;
     friend class CLHandlerThread;
     friend class CLBufferNotifyThread;
 
@@ -48,6 +49,11 @@ public:
     bool add_handler (SmartPtr<CLImageHandler> &handler);
     ImageHandlerList::iterator handlers_begin ();
     ImageHandlerList::iterator handlers_end ();
+    // before start, may be shared by processors feeding each other
+    void set_profile_selector (const SmartPtr<CLProfileSelector> &selector);
+
+    //derived from ImageProcessor
+    virtual void introspect (IntrospectionWriter &writer);
 
 protected:
 
@@ -56,6 +62,7 @@ protected:
     virtual XCamReturn apply_3a_results (X3aResultList &results);
     virtual XCamReturn apply_3a_result (SmartPtr<X3aResult> &result);
     virtual XCamReturn process_buffer (SmartPtr<VideoBuffer> &input, SmartPtr<VideoBuffer> &output);
+    virtual XCamReturn emit_prepare ();
     virtual XCamReturn emit_start ();
     virtual void emit_stop ();
 
@@ -76,13 +83,13 @@ protected:
     Mutex                          _stream_mutex;
 
 private:
-    SmartPtr<CLContext>            _context;
     ImageHandlerList               _handlers;
     SmartPtr<CLHandlerThread>      _handler_thread;
     PriorityBufferQueue            _process_buffer_queue;
     SmartPtr<CLBufferNotifyThread> _done_buf_thread;
     SafeList<DrmBoBuffer>          _done_buffer_queue;
     uint32_t                       _seq_num;
+    SmartPtr<CLProfileSelector>    _profile_selector;
     XCAM_OBJ_PROFILING_DEFINES;
 };
 
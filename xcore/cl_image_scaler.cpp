@@ -33,6 +33,9 @@ CLScalerKernel::CLScalerKernel (
     , _output_width (0)
     , _output_height (0)
 {
+    xcam_mem_clear (_crop_window);
+    _crop[0] = _crop[1] = 0.0f;
+    _crop[2] = _crop[3] = 1.0f;
 }
 
 SmartPtr<DrmBoBuffer>
@@ -125,6 +128,16 @@ CLScalerKernel::prepare_arguments (
         _image_in = new CLVaImage (context, input_buf, input_imageDesc, input_info.offsets[0]);
     }
 
+    if (_crop_window.x_end > _crop_window.x_start && _crop_window.y_end > _crop_window.y_start) {
+        _crop[0] = (float)_crop_window.x_start / input_info.width;
+        _crop[1] = (float)_crop_window.y_start / input_info.height;
+        _crop[2] = (float)(_crop_window.x_end - _crop_window.x_start) / input_info.width;
+        _crop[3] = (float)(_crop_window.y_end - _crop_window.y_start) / input_info.height;
+    } else {
+        _crop[0] = _crop[1] = 0.0f;
+        _crop[2] = _crop[3] = 1.0f;
+    }
+
     //set args;
     args[0].arg_adress = &_image_in->get_mem_id ();
     args[0].arg_size = sizeof (cl_mem);
@@ -134,7 +147,11 @@ CLScalerKernel::prepare_arguments (
     args[2].arg_size = sizeof (_output_width);
     args[3].arg_adress = &_output_height;
     args[3].arg_size = sizeof (_output_height);
-    arg_count = 4;
+    for (uint32_t i = 0; i < 4; ++i) {
+        args[4 + i].arg_adress = &_crop[i];
+        args[4 + i].arg_size = sizeof (float);
+    }
+    arg_count = 8;
 
     work_size.dim = XCAM_DEFAULT_IMAGE_DIM;
     work_size.global[0] = XCAM_ALIGN_UP (_output_width, XCAM_CL_IMAGE_SCALER_KERNEL_LOCAL_WORK_SIZE0);
@@ -188,6 +205,13 @@ CLImageScalerKernel::post_execute (SmartPtr<DrmBoBuffer> &output)
     return ret;
 }
 
+void
+CLImageScalerKernel::pre_start ()
+{
+    if (_scaler.ptr ())
+        _scaler.ptr ()->pre_start ();
+}
+
 void
 CLImageScalerKernel::pre_stop ()
 {
@@ -201,6 +225,13 @@ CLImageScaler::CLImageScaler ()
 {
 }
 
+void
+CLImageScaler::pre_start ()
+{
+    if (_scaler_buf_pool.ptr ())
+        _scaler_buf_pool->resume ();
+}
+
 void
 CLImageScaler::pre_stop ()
 {
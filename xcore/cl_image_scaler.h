@@ -25,6 +25,7 @@
 #include "cl_image_handler.h"
 #include "cl_memory.h"
 #include "stats_callback_interface.h"
+#include <base/xcam_3a_types.h>
 
 namespace XCam {
 
@@ -53,6 +54,10 @@ public:
     uint32_t get_pixel_format () const {
         return _pixel_format;
     };
+    // area of input to scale, in input pixels; empty window for whole input
+    void set_crop_window (const XCam3AWindow &window) {
+        _crop_window = window;
+    }
 
 protected:
     virtual XCamReturn prepare_arguments (
@@ -74,6 +79,8 @@ protected:
     CLImageScalerMemoryLayout _mem_layout;
     uint32_t _output_width;
     uint32_t _output_height;
+    XCam3AWindow _crop_window;
+    float _crop[4];
 };
 
 class CLImageScalerKernel
@@ -85,6 +92,7 @@ public:
 
 protected:
     virtual XCamReturn post_execute (SmartPtr<DrmBoBuffer> &output);
+    virtual void pre_start ();
     virtual void pre_stop ();
 
     virtual SmartPtr<DrmBoBuffer> get_output_parameter (
@@ -115,6 +123,7 @@ public:
         return _scaler_buf;
     };
 
+    void pre_start ();
     void pre_stop ();
 
 protected:
@@ -0,0 +1,367 @@
+/*
+ * cl_kernel_variant.cpp - CL kernel variants selected by benchmark
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#include "cl_kernel_variant.h"
+#include "cl_device.h"
+#include <sys/stat.h>
+#include <unistd.h>
+#include <errno.h>
+
+namespace XCam {
+
+CLVariantImageKernel::CLVariantImageKernel (
+    SmartPtr<CLContext> &context, const char *name, const char *variant_name)
+    : CLImageKernel (context, name)
+    , _variant_name (NULL)
+{
+    XCAM_ASSERT (variant_name);
+    if (variant_name)
+        _variant_name = strndup (variant_name, XCAM_MAX_STR_SIZE);
+}
+
+CLVariantImageKernel::~CLVariantImageKernel ()
+{
+    if (_variant_name)
+        xcam_free (_variant_name);
+}
+
+bool
+CLVariantImageKernel::is_applicable (const VideoBufferInfo &input, const VideoBufferInfo &output)
+{
+    XCAM_UNUSED (input);
+    XCAM_UNUSED (output);
+    return true;
+}
+
+SmartPtr<CLKernelVariantCache> CLKernelVariantCache::_instance;
+Mutex CLKernelVariantCache::_instance_mutex;
+
+SmartPtr<CLKernelVariantCache>
+CLKernelVariantCache::instance ()
+{
+    SmartLock locker (_instance_mutex);
+    if (_instance.ptr ())
+        return _instance;
+
+    _instance = new CLKernelVariantCache ();
+    return _instance;
+}
+
+CLKernelVariantCache::CLKernelVariantCache ()
+    : _loaded (false)
+{
+    const char *path = getenv (XCAM_CL_VARIANT_CACHE_ENV);
+    _path = (path && path[0]) ? std::string (path) : default_path ();
+    if (_path.empty ())
+        XCAM_LOG_INFO ("cl kernel variant cache has no user cache dir, winners are not persisted");
+}
+
+std::string
+CLKernelVariantCache::default_path ()
+{
+    std::string dir;
+    const char *env = getenv ("XDG_CACHE_HOME");
+
+    if (env && env[0] == '/')
+        dir = env;
+    else if ((env = getenv ("HOME")) && env[0] == '/')
+        dir = std::string (env) + "/.cache";
+    else
+        return std::string ();
+
+    // private to the user, a shared dir would let others plant the winners
+    mkdir (dir.c_str (), 0700);
+    dir += "/" XCAM_CL_VARIANT_CACHE_DIR;
+    if (mkdir (dir.c_str (), 0700) < 0 && errno != EEXIST) {
+        XCAM_LOG_WARNING ("cl kernel variant cache dir(%s) create failed, %s", dir.c_str (), strerror (errno));
+        return std::string ();
+    }
+    return dir + "/" XCAM_CL_VARIANT_CACHE_FILE;
+}
+
+bool
+CLKernelVariantCache::load ()
+{
+    char line[XCAM_MAX_STR_SIZE];
+    FILE *fp = NULL;
+
+    _loaded = true;
+    if (_path.empty ())
+        return false;
+
+    fp = fopen (_path.c_str (), "r");
+    if (!fp) {
+        XCAM_LOG_DEBUG ("cl kernel variant cache(%s) not found", _path.c_str ());
+        return false;
+    }
+
+    while (fgets (line, sizeof (line), fp)) {
+        char *sep = strchr (line, '\t');
+        if (!sep)
+            continue;
+        *sep = '\0';
+        char *variant = sep + 1;
+        variant[strcspn (variant, "\r\n")] = '\0';
+        if (!line[0] || !variant[0])
+            continue;
+        _winners[line] = variant;
+    }
+    fclose (fp);
+
+    XCAM_LOG_DEBUG ("cl kernel variant cache(%s) loaded %d entries", _path.c_str (), (int)_winners.size ());
+    return true;
+}
+
+bool
+CLKernelVariantCache::save ()
+{
+    if (_path.empty ())
+        return false;
+
+    // unique name next to the cache, so concurrent writers never share it
+    std::string tmp_path = _path + ".XXXXXX";
+    std::vector<char> tmp_name (tmp_path.begin (), tmp_path.end ());
+    tmp_name.push_back ('\0');
+
+    int fd = mkstemp (&tmp_name[0]);
+    XCAM_FAIL_RETURN (
+        WARNING,
+        fd >= 0,
+        false,
+        "cl kernel variant cache(%s) create temp file failed, %s", _path.c_str (), strerror (errno));
+
+    FILE *fp = fdopen (fd, "w");
+    if (!fp) {
+        XCAM_LOG_WARNING ("cl kernel variant cache(%s) open temp file failed", &tmp_name[0]);
+        close (fd);
+        unlink (&tmp_name[0]);
+        return false;
+    }
+
+    for (std::map<std::string, std::string>::iterator i = _winners.begin (); i != _winners.end (); ++i)
+        fprintf (fp, "%s\t%s\n", i->first.c_str (), i->second.c_str ());
+    bool written = (fflush (fp) == 0);
+    written = (fclose (fp) == 0) && written;
+
+    // replace in one step, other processes never read a partial file
+    if (!written || rename (&tmp_name[0], _path.c_str ()) != 0) {
+        XCAM_LOG_WARNING ("cl kernel variant cache(%s) update failed", _path.c_str ());
+        unlink (&tmp_name[0]);
+        return false;
+    }
+    return true;
+}
+
+bool
+CLKernelVariantCache::lookup (const std::string &key, std::string &variant)
+{
+    SmartLock locker (_mutex);
+    if (!_loaded)
+        load ();
+
+    std::map<std::string, std::string>::iterator i = _winners.find (key);
+    if (i == _winners.end ())
+        return false;
+    variant = i->second;
+    return true;
+}
+
+bool
+CLKernelVariantCache::store (const std::string &key, const std::string &variant)
+{
+    SmartLock locker (_mutex);
+    if (!_loaded)
+        load ();
+
+    _winners[key] = variant;
+    return save ();
+}
+
+CLKernelVariantSelector::CLKernelVariantSelector (const char *name)
+    : _name (NULL)
+    , _winner (-1)
+    , _candidate (0)
+    , _candidate_runs (0)
+{
+    XCAM_ASSERT (name);
+    if (name)
+        _name = strndup (name, XCAM_MAX_STR_SIZE);
+}
+
+CLKernelVariantSelector::~CLKernelVariantSelector ()
+{
+    if (_name)
+        xcam_free (_name);
+}
+
+bool
+CLKernelVariantSelector::add_variant (SmartPtr<CLVariantImageKernel> &kernel)
+{
+    XCAM_ASSERT (kernel.ptr () && kernel->is_valid ());
+    _variants.push_back (kernel);
+    _applicable.push_back (true);
+    _sum_ms.push_back (0.0);
+    _key.clear ();
+    return true;
+}
+
+void
+CLKernelVariantSelector::enable_only (uint32_t index)
+{
+    for (uint32_t i = 0; i < _variants.size (); ++i)
+        _variants[i]->set_enable (i == index);
+}
+
+bool
+CLKernelVariantSelector::next_candidate (uint32_t from)
+{
+    for (uint32_t i = from; i < _variants.size (); ++i) {
+        if (_applicable[i]) {
+            _candidate = i;
+            _candidate_runs = 0;
+            return true;
+        }
+    }
+    return false;
+}
+
+void
+CLKernelVariantSelector::reset (
+    const std::string &key, const VideoBufferInfo &input, const VideoBufferInfo &output)
+{
+    std::string cached;
+    bool has_cached = CLKernelVariantCache::instance ()->lookup (key, cached);
+
+    _key = key;
+    _winner = -1;
+    for (uint32_t i = 0; i < _variants.size (); ++i) {
+        _applicable[i] = _variants[i]->is_applicable (input, output);
+        _sum_ms[i] = 0.0;
+        if (has_cached && _applicable[i] && cached == _variants[i]->get_variant_name ())
+            _winner = i;
+    }
+
+    if (_winner >= 0) {
+        XCAM_LOG_DEBUG (
+            "cl kernel variants(%s) use cached variant(%s)",
+            XCAM_STR (_name), _variants[_winner]->get_variant_name ());
+        return;
+    }
+
+    if (!next_candidate (0))
+        return;
+
+    // only one choice, no need to benchmark
+    uint32_t first = _candidate;
+    if (!next_candidate (first + 1)) {
+        _winner = first;
+        return;
+    }
+    next_candidate (first);
+    XCAM_LOG_INFO ("cl kernel variants(%s) start benchmark, key:%s", XCAM_STR (_name), key.c_str ());
+}
+
+XCamReturn
+CLKernelVariantSelector::select (
+    const VideoBufferInfo &input, const VideoBufferInfo &output, bool &benchmarking)
+{
+    const CLDevieInfo &dev_info = CLDevice::instance ()->get_device_info ();
+    char resolution[64];
+    std::string key;
+
+    XCAM_FAIL_RETURN (
+        WARNING,
+        !_variants.empty (),
+        XCAM_RETURN_ERROR_PARAM,
+        "cl kernel variants(%s) empty", XCAM_STR (_name));
+
+    key = dev_info.name;
+    key += "|";
+    key += dev_info.driver_version;
+    key += "|";
+    key += XCAM_STR (_name);
+    key += "|";
+    key += xcam_fourcc_to_string (input.format);
+    snprintf (resolution, sizeof (resolution), " %dx%d|", input.width, input.height);
+    key += resolution;
+    key += xcam_fourcc_to_string (output.format);
+    snprintf (resolution, sizeof (resolution), " %dx%d", output.width, output.height);
+    key += resolution;
+
+    if (key != _key)
+        reset (key, input, output);
+
+    if (_winner >= 0) {
+        enable_only (_winner);
+        benchmarking = false;
+        return XCAM_RETURN_NO_ERROR;
+    }
+
+    XCAM_FAIL_RETURN (
+        WARNING,
+        _candidate < _variants.size () && _applicable[_candidate],
+        XCAM_RETURN_ERROR_PARAM,
+        "cl kernel variants(%s) no variant applicable, key:%s", XCAM_STR (_name), _key.c_str ());
+
+    enable_only (_candidate);
+    benchmarking = true;
+    return XCAM_RETURN_NO_ERROR;
+}
+
+void
+CLKernelVariantSelector::report_duration (double duration_ms)
+{
+    if (_winner >= 0 || _candidate >= _variants.size ())
+        return;
+
+    if (_candidate_runs >= XCAM_CL_VARIANT_WARMUP_RUNS)
+        _sum_ms[_candidate] += duration_ms;
+    ++_candidate_runs;
+
+    if (_candidate_runs < XCAM_CL_VARIANT_WARMUP_RUNS + XCAM_CL_VARIANT_BENCH_RUNS)
+        return;
+
+    XCAM_LOG_INFO (
+        "cl kernel variants(%s) variant(%s) average %.3fms",
+        XCAM_STR (_name), _variants[_candidate]->get_variant_name (),
+        _sum_ms[_candidate] / XCAM_CL_VARIANT_BENCH_RUNS);
+
+    if (!next_candidate (_candidate + 1))
+        finish_benchmark ();
+}
+
+void
+CLKernelVariantSelector::finish_benchmark ()
+{
+    for (uint32_t i = 0; i < _variants.size (); ++i) {
+        if (!_applicable[i])
+            continue;
+        if (_winner < 0 || _sum_ms[i] < _sum_ms[_winner])
+            _winner = i;
+    }
+    XCAM_ASSERT (_winner >= 0);
+
+    XCAM_LOG_INFO (
+        "cl kernel variants(%s) selected variant(%s)",
+        XCAM_STR (_name), _variants[_winner]->get_variant_name ());
+    CLKernelVariantCache::instance ()->store (_key, _variants[_winner]->get_variant_name ());
+}
+
+};
@@ -0,0 +1,149 @@
+/*
+ * cl_kernel_variant.h - CL kernel variants selected by benchmark
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#ifndef XCAM_CL_KERNEL_VARIANT_H
+#define XCAM_CL_KERNEL_VARIANT_H
+
+#include "xcam_utils.h"
+#include "xcam_mutex.h"
+#include "cl_image_handler.h"
+#include <map>
+#include <string>
+#include <vector>
+
+// file to persist the winners, overridden by env XCAM_CL_VARIANT_CACHE;
+// default is per user, under $XDG_CACHE_HOME or else $HOME/.cache
+#define XCAM_CL_VARIANT_CACHE_ENV "XCAM_CL_VARIANT_CACHE"
+#define XCAM_CL_VARIANT_CACHE_DIR "libxcam"
+#define XCAM_CL_VARIANT_CACHE_FILE "cl_variants.conf"
+
+// frames of each variant, warm-up frames are not measured
+#define XCAM_CL_VARIANT_WARMUP_RUNS 1
+#define XCAM_CL_VARIANT_BENCH_RUNS 4
+
+namespace XCam {
+
+/*
+ * one implementation of a cl kernel, e.g. image2d_t vs buffer object,
+ * vector width or work-group shape. All variants of a kernel must produce
+ * the same output, each one binds its own arguments in prepare_arguments.
+ */
+class CLVariantImageKernel
+    : public CLImageKernel
+{
+public:
+    explicit CLVariantImageKernel (
+        SmartPtr<CLContext> &context, const char *name, const char *variant_name);
+    virtual ~CLVariantImageKernel ();
+
+    const char *get_variant_name () const {
+        return _variant_name;
+    }
+
+    // some variants only work with certain buffer layouts
+    virtual bool is_applicable (const VideoBufferInfo &input, const VideoBufferInfo &output);
+
+private:
+    XCAM_DEAD_COPY (CLVariantImageKernel);
+
+private:
+    char                *_variant_name;
+};
+
+/*
+ * winners of finished benchmarks, one line per key
+ * "device|driver|kernel|in_format wxh|out_format wxh<TAB>variant"
+ */
+class CLKernelVariantCache
+{
+public:
+    static SmartPtr<CLKernelVariantCache> instance ();
+
+    bool lookup (const std::string &key, std::string &variant);
+    bool store (const std::string &key, const std::string &variant);
+
+private:
+    CLKernelVariantCache ();
+    static std::string default_path ();
+    bool load ();
+    bool save ();
+
+    XCAM_DEAD_COPY (CLKernelVariantCache);
+
+private:
+    static SmartPtr<CLKernelVariantCache>  _instance;
+    static Mutex                           _instance_mutex;
+
+    std::map<std::string, std::string>     _winners;
+    std::string                            _path;
+    bool                                   _loaded;
+    Mutex                                  _mutex;
+};
+
+/*
+ * CLKernelVariantSelector
+ * on first use per device/resolution, each variant runs
+ * XCAM_CL_VARIANT_WARMUP_RUNS + XCAM_CL_VARIANT_BENCH_RUNS frames in turn,
+ * the fastest one is persisted and used afterwards.
+ * Only the selected variant is enabled, so CLImageHandler runs it as usual.
+ */
+class CLKernelVariantSelector
+{
+public:
+    typedef std::vector<SmartPtr<CLVariantImageKernel> > VariantList;
+
+public:
+    explicit CLKernelVariantSelector (const char *name);
+    ~CLKernelVariantSelector ();
+
+    const char *get_name () const {
+        return _name;
+    }
+    bool add_variant (SmartPtr<CLVariantImageKernel> &kernel);
+    VariantList &get_variants () {
+        return _variants;
+    }
+
+    // enable the variant for this frame, benchmarking is true if the caller need time it
+    XCamReturn select (const VideoBufferInfo &input, const VideoBufferInfo &output, bool &benchmarking);
+    void report_duration (double duration_ms);
+
+private:
+    void reset (const std::string &key, const VideoBufferInfo &input, const VideoBufferInfo &output);
+    bool next_candidate (uint32_t from);
+    void enable_only (uint32_t index);
+    void finish_benchmark ();
+
+    XCAM_DEAD_COPY (CLKernelVariantSelector);
+
+private:
+    char                     *_name;
+    VariantList               _variants;
+    std::vector<bool>         _applicable;
+    std::vector<double>       _sum_ms;
+    std::string               _key;
+    int32_t                   _winner;
+    uint32_t                  _candidate;
+    uint32_t                  _candidate_runs;
+};
+
+};
+
+#endif //XCAM_CL_KERNEL_VARIANT_H
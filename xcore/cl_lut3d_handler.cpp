@@ -0,0 +1,211 @@
+/*
+ * cl_lut3d_handler.cpp - CL 3D look up table color handler
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#include "xcam_utils.h"
+#include "cl_lut3d_handler.h"
+
+namespace XCam {
+
+CLLut3dImageKernel::CLLut3dImageKernel (SmartPtr<CLContext> &context, SmartPtr<ColorLut3d> &lut)
+    : CLImageKernel (context, "kernel_lut3d")
+    , _lut (lut)
+    , _interp (Lut3dTrilinear)
+    , _lut_version (0)
+    , _lut_size (0)
+    , _plannar_offset (0)
+    , _tetrahedral (0)
+{
+}
+
+XCamReturn
+CLLut3dImageKernel::prepare_arguments (
+    SmartPtr<DrmBoBuffer> &input, SmartPtr<DrmBoBuffer> &output,
+    CLArgument args[], uint32_t &arg_count,
+    CLWorkSize &work_size)
+{
+    SmartPtr<CLContext> context = get_context ();
+    const VideoBufferInfo & in_video_info = input->get_video_info ();
+    const VideoBufferInfo & out_video_info = output->get_video_info ();
+
+    XCAM_FAIL_RETURN (
+        WARNING,
+        in_video_info.format == XCAM_PIX_FMT_RGB48_planar && out_video_info.format == V4L2_PIX_FMT_NV12,
+        XCAM_RETURN_ERROR_PARAM,
+        "cl image kernel(%s) only support RGB48 planar input and NV12 output", get_kernel_name ());
+
+    // table only uploaded again after 3a results or settings changed
+    SmartPtr<ColorLut3dTable> table = _lut->get_table ();
+    if (!_lut_buffer.ptr () || table->version != _lut_version) {
+        _lut_size = table->size;
+        _lut_buffer = new CLBuffer (
+            context, sizeof (float) * table->entries.size (),
+            CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, (void *)&table->entries[0]);
+        _lut_version = table->version;
+    }
+    _tetrahedral = (_interp == Lut3dTetrahedral ? 1 : 0);
+
+    // same layout as the yuv pipe, 8 pixels each texel
+    CLImageDesc in_image_info;
+    in_image_info.format.image_channel_order = CL_RGBA;
+    in_image_info.format.image_channel_data_type = CL_UNSIGNED_INT32;
+    in_image_info.width = in_video_info.aligned_width / 8;
+    in_image_info.height = in_video_info.aligned_height * 3;
+    in_image_info.row_pitch = in_video_info.strides[0];
+
+    CLImageDesc out_image_info;
+    out_image_info.format.image_channel_order = CL_RGBA;
+    out_image_info.format.image_channel_data_type = CL_UNSIGNED_INT16;
+    out_image_info.width = out_video_info.width / 8;
+    out_image_info.height = out_video_info.aligned_height;
+    out_image_info.row_pitch = out_video_info.strides[0];
+
+    _image_in = new CLVaImage (context, input, in_image_info);
+    _image_out = new CLVaImage (context, output, out_image_info, out_video_info.offsets[0]);
+
+    out_image_info.height = out_video_info.aligned_height / 2;
+    out_image_info.row_pitch = out_video_info.strides[1];
+    _image_uv = new CLVaImage (context, output, out_image_info, out_video_info.offsets[1]);
+    _plannar_offset = in_video_info.aligned_height;
+
+    XCAM_ASSERT (_image_in->is_valid () && _image_out->is_valid () && _image_uv->is_valid ());
+    XCAM_FAIL_RETURN (
+        WARNING,
+        _image_in->is_valid () && _image_out->is_valid () && _image_uv->is_valid () && _lut_buffer->is_valid (),
+        XCAM_RETURN_ERROR_MEM,
+        "cl image kernel(%s) in/out memory not available", get_kernel_name ());
+
+    //set args;
+    args[0].arg_adress = &_image_in->get_mem_id ();
+    args[0].arg_size = sizeof (cl_mem);
+    args[1].arg_adress = &_image_out->get_mem_id ();
+    args[1].arg_size = sizeof (cl_mem);
+    args[2].arg_adress = &_image_uv->get_mem_id ();
+    args[2].arg_size = sizeof (cl_mem);
+    args[3].arg_adress = &_plannar_offset;
+    args[3].arg_size = sizeof (_plannar_offset);
+    args[4].arg_adress = &_lut_buffer->get_mem_id ();
+    args[4].arg_size = sizeof (cl_mem);
+    args[5].arg_adress = &_lut_size;
+    args[5].arg_size = sizeof (_lut_size);
+    args[6].arg_adress = &_tetrahedral;
+    args[6].arg_size = sizeof (_tetrahedral);
+    arg_count = 7;
+
+    // 8x2 pixels each work item, the driver picks the group size
+    work_size.dim = XCAM_DEFAULT_IMAGE_DIM;
+    work_size.global[0] = out_video_info.width / 8;
+    work_size.global[1] = out_video_info.aligned_height / 2;
+    work_size.local[0] = 0;
+    work_size.local[1] = 0;
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+CLLut3dImageKernel::post_execute (SmartPtr<DrmBoBuffer> &output)
+{
+    // keep _lut_buffer, reused until the table changes
+    _image_uv.release ();
+
+    return CLImageKernel::post_execute (output);
+}
+
+CLLut3dImageHandler::CLLut3dImageHandler (const char *name, SmartPtr<ColorLut3d> &lut)
+    : CLImageHandler (name)
+    , _lut (lut)
+{
+}
+
+bool
+CLLut3dImageHandler::set_lut3d_kernel (SmartPtr<CLLut3dImageKernel> &kernel)
+{
+    SmartPtr<CLImageKernel> image_kernel = kernel;
+    add_kernel (image_kernel);
+    _lut3d_kernel = kernel;
+    return true;
+}
+
+void
+CLLut3dImageHandler::set_interpolation (Lut3dInterpolation interp)
+{
+    XCAM_ASSERT (_lut3d_kernel.ptr ());
+    _lut3d_kernel->set_interpolation (interp);
+}
+
+XCamReturn
+CLLut3dImageHandler::apply_3a_result (SmartPtr<X3aResult> &result)
+{
+    return _lut->apply_3a_result (result);
+}
+
+XCamReturn
+CLLut3dImageHandler::prepare_buffer_pool_video_info (
+    const VideoBufferInfo &input,
+    VideoBufferInfo &output)
+{
+    bool format_inited = output.init (V4L2_PIX_FMT_NV12, input.width, input.height);
+
+    XCAM_FAIL_RETURN (
+        WARNING,
+        format_inited,
+        XCAM_RETURN_ERROR_PARAM,
+        "CL image handler(%s) ouput format(%s) unsupported",
+        get_name (), xcam_fourcc_to_string (V4L2_PIX_FMT_NV12));
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+SmartPtr<CLImageHandler>
+create_cl_lut3d_image_handler (SmartPtr<CLContext> &context, uint32_t lut_size, Lut3dInterpolation interp)
+{
+    SmartPtr<CLLut3dImageHandler> lut3d_handler;
+    SmartPtr<CLLut3dImageKernel> lut3d_kernel;
+    SmartPtr<ColorLut3d> lut = new ColorLut3d;
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+
+    XCAM_FAIL_RETURN (
+        WARNING,
+        lut->set_size (lut_size),
+        NULL,
+        "CL lut3d handler create failed, lut size:%d", lut_size);
+    // kernel writes nv12 only
+    lut->enable_csc (true);
+
+    lut3d_kernel = new CLLut3dImageKernel (context, lut);
+    {
+        XCAM_CL_KERNEL_FUNC_SOURCE_BEGIN(kernel_lut3d)
+#include "kernel_lut3d.clx"
+        XCAM_CL_KERNEL_FUNC_END;
+        ret = lut3d_kernel->load_from_source (kernel_lut3d_body, strlen (kernel_lut3d_body));
+        XCAM_FAIL_RETURN (
+            WARNING,
+            ret == XCAM_RETURN_NO_ERROR,
+            NULL,
+            "CL image handler(%s) load source failed", lut3d_kernel->get_kernel_name());
+    }
+    XCAM_ASSERT (lut3d_kernel->is_valid ());
+    lut3d_kernel->set_interpolation (interp);
+    lut3d_handler = new CLLut3dImageHandler ("cl_handler_lut3d", lut);
+    lut3d_handler->set_lut3d_kernel (lut3d_kernel);
+
+    return lut3d_handler;
+}
+
+};
@@ -0,0 +1,94 @@
+/*
+ * cl_lut3d_handler.h - CL 3D look up table color handler
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#ifndef XCAM_CL_LUT3D_HANLDER_H
+#define XCAM_CL_LUT3D_HANLDER_H
+
+#include "xcam_utils.h"
+#include "cl_image_handler.h"
+#include "color_lut3d.h"
+
+namespace XCam {
+
+class CLLut3dImageKernel
+    : public CLImageKernel
+{
+public:
+    // lut can be shared with SoftLut3dImageHandler, baked once for both
+    explicit CLLut3dImageKernel (SmartPtr<CLContext> &context, SmartPtr<ColorLut3d> &lut);
+    void set_interpolation (Lut3dInterpolation interp) {
+        _interp = interp;
+    }
+
+protected:
+    virtual XCamReturn prepare_arguments (
+        SmartPtr<DrmBoBuffer> &input, SmartPtr<DrmBoBuffer> &output,
+        CLArgument args[], uint32_t &arg_count,
+        CLWorkSize &work_size);
+    virtual XCamReturn post_execute (SmartPtr<DrmBoBuffer> &output);
+
+private:
+    XCAM_DEAD_COPY (CLLut3dImageKernel);
+
+    SmartPtr<ColorLut3d>  _lut;
+    Lut3dInterpolation    _interp;
+    uint32_t              _lut_version;
+    uint32_t              _lut_size;
+    uint32_t              _plannar_offset;
+    uint32_t              _tetrahedral;
+    SmartPtr<CLBuffer>    _lut_buffer;
+    SmartPtr<CLImage>     _image_uv;
+};
+
+class CLLut3dImageHandler
+    : public CLImageHandler
+{
+public:
+    explicit CLLut3dImageHandler (const char *name, SmartPtr<ColorLut3d> &lut);
+    SmartPtr<ColorLut3d> &get_color_lut () {
+        return _lut;
+    }
+    bool set_lut3d_kernel (SmartPtr<CLLut3dImageKernel> &kernel);
+    void set_interpolation (Lut3dInterpolation interp);
+
+    // RGB2YUV_MATRIX, MACC, Y_GAMMA and G_GAMMA
+    XCamReturn apply_3a_result (SmartPtr<X3aResult> &result);
+
+protected:
+    virtual XCamReturn prepare_buffer_pool_video_info (
+        const VideoBufferInfo &input,
+        VideoBufferInfo &output);
+
+private:
+    XCAM_DEAD_COPY (CLLut3dImageHandler);
+
+    SmartPtr<ColorLut3d>          _lut;
+    SmartPtr<CLLut3dImageKernel>  _lut3d_kernel;
+};
+
+SmartPtr<CLImageHandler>
+create_cl_lut3d_image_handler (
+    SmartPtr<CLContext> &context,
+    uint32_t lut_size = XCAM_LUT3D_SIZE_SMALL,
+    Lut3dInterpolation interp = Lut3dTrilinear);
+
+};
+
+#endif //XCAM_CL_LUT3D_HANLDER_H
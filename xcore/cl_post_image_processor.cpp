@@ -25,6 +25,7 @@
 #include "cl_tnr_handler.h"
 #include "cl_retinex_handler.h"
 #include "cl_csc_handler.h"
+#include "cl_dvs_handler.h"
 
 #define XCAM_CL_POST_IMAGE_DEFAULT_POOL_SIZE 6
 #define XCAM_CL_POST_IMAGE_MAX_POOL_SIZE 12
@@ -37,6 +38,7 @@ CLPostImageProcessor::CLPostImageProcessor ()
     , _out_sample_type (OutSampleYuv)
     , _tnr_mode (TnrYuv)
     , _enable_retinex (false)
+    , _enable_dvs (false)
 {
     XCAM_LOG_DEBUG ("CLPostImageProcessor constructed");
 }
@@ -194,6 +196,19 @@ CLPostImageProcessor::create_handlers ()
         }
     }
 
+    /* digital video stabilization */
+    image_handler = create_cl_dvs_image_handler (context);
+    _dvs = image_handler.dynamic_cast_ptr<CLDvsImageHandler> ();
+    XCAM_FAIL_RETURN (
+        WARNING,
+        _dvs.ptr (),
+        XCAM_RETURN_ERROR_CL,
+        "CLPostImageProcessor create dvs handler failed");
+    _dvs->set_kernels_enable (_enable_dvs);
+    image_handler->set_pool_type (CLImageHandler::DrmBoPoolType);
+    image_handler->set_pool_size (XCAM_CL_POST_IMAGE_DEFAULT_POOL_SIZE);
+    add_handler (image_handler);
+
     /* csc (nv12torgba) */
     image_handler = create_cl_csc_image_handler (context, CL_CSC_TYPE_NV12TORGBA);
     _csc = image_handler.dynamic_cast_ptr<CLCscImageHandler> ();
@@ -231,4 +246,20 @@ CLPostImageProcessor::set_retinex (bool enable)
     return true;
 }
 
+bool
+CLPostImageProcessor::set_dvs (bool enable)
+{
+    _enable_dvs = enable;
+
+    STREAM_LOCK;
+
+    if (_dvs.ptr ()) {
+        if (enable && !_dvs->is_kernels_enabled ())
+            _dvs->get_dvs ()->reset ();
+        _dvs->set_kernels_enable (enable);
+    }
+
+    return true;
+}
+
 };
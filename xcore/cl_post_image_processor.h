@@ -31,6 +31,7 @@ namespace XCam {
 class CLTnrImageHandler;
 class CLRetinexImageHandler;
 class CLCscImageHandler;
+class CLDvsImageHandler;
 
 class CLPostImageProcessor
     : public CLImageProcessor
@@ -55,6 +56,7 @@ public:
 
     virtual bool set_tnr (CLTnrMode mode);
     virtual bool set_retinex (bool enable);
+    virtual bool set_dvs (bool enable);
 
 protected:
     virtual bool can_process_result (SmartPtr<X3aResult> &result);
@@ -72,10 +74,12 @@ private:
 
     SmartPtr<CLTnrImageHandler>            _tnr;
     SmartPtr<CLRetinexImageHandler>        _retinex;
+    SmartPtr<CLDvsImageHandler>            _dvs;
     SmartPtr<CLCscImageHandler>            _csc;
 
     CLTnrMode                              _tnr_mode;
     bool                                   _enable_retinex;
+    bool                                   _enable_dvs;
 };
 
 };
@@ -0,0 +1,381 @@
+/*
+ * cl_profile_selector.cpp - choose optional cl handlers for a target frame rate
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#include "cl_profile_selector.h"
+#include "cl_image_processor.h"
+#include "cl_image_handler.h"
+#include <math.h>
+#include <algorithm>
+
+namespace XCam {
+
+static const char *profile_state_names[] = {
+    "warmup",
+    "profiling",
+    "running",
+};
+
+CLProfileSelector::CLProfileSelector (double target_fps)
+    : _target_fps (target_fps > 0.0 ? target_fps : 30.0)
+    , _budget_ratio (XCAM_CL_PROFILE_DEFAULT_BUDGET_RATIO)
+    , _clock_processor (NULL)
+    , _state (StateWarmup)
+    , _frames (0)
+    , _width (0)
+    , _height (0)
+    , _expected_ms (0.0)
+    , _selections (0)
+{
+}
+
+CLProfileSelector::~CLProfileSelector ()
+{
+}
+
+bool
+CLProfileSelector::rank_less (const Stage *a, const Stage *b)
+{
+    return a->rank < b->rank;
+}
+
+bool
+CLProfileSelector::set_target_fps (double fps)
+{
+    XCAM_FAIL_RETURN (
+        WARNING, fps > 0.0, false,
+        "cl profile selector target fps(%.2f) invalid", fps);
+
+    SmartLock locker (_mutex);
+    _target_fps = fps;
+    if (_state == StateRunning)
+        select_stages ();
+    return true;
+}
+
+bool
+CLProfileSelector::set_budget_ratio (double ratio)
+{
+    XCAM_FAIL_RETURN (
+        WARNING, ratio > 0.0 && ratio <= 1.0, false,
+        "cl profile selector budget ratio(%.2f) out of (0, 1]", ratio);
+
+    SmartLock locker (_mutex);
+    _budget_ratio = ratio;
+    if (_state == StateRunning)
+        select_stages ();
+    return true;
+}
+
+bool
+CLProfileSelector::set_quality_ranking (const std::vector<std::string> &names)
+{
+    SmartLock locker (_mutex);
+    XCAM_FAIL_RETURN (
+        WARNING, _stages.empty (), false,
+        "cl profile selector ranking must be set before processors start");
+
+    _ranking = names;
+    return true;
+}
+
+void
+CLProfileSelector::attach (CLImageProcessor *processor)
+{
+    SmartLock locker (_mutex);
+    StageList previous;
+    StageList::iterator i_stage = _stages.begin ();
+    while (i_stage != _stages.end ()) {
+        if (i_stage->processor == processor) {
+            previous.push_back (*i_stage);
+            i_stage = _stages.erase (i_stage);
+        } else {
+            ++i_stage;
+        }
+    }
+
+    for (CLImageProcessor::ImageHandlerList::iterator i_handler = processor->handlers_begin ();
+            i_handler != processor->handlers_end (); ++i_handler) {
+        Stage stage;
+        stage.processor = processor;
+        stage.handler = *i_handler;
+        stage.name = XCAM_STR ((*i_handler)->get_name ());
+        // attached again without detach, the handler state may be ours
+        stage.configured = (*i_handler)->is_kernels_enabled ();
+        for (StageList::iterator i_prev = previous.begin (); i_prev != previous.end (); ++i_prev) {
+            if (i_prev->handler.ptr () == i_handler->ptr ()) {
+                stage.configured = i_prev->configured;
+                break;
+            }
+        }
+        stage.rank = -1;
+        for (uint32_t i = 0; i < _ranking.size (); ++i) {
+            if (_ranking[i] == stage.name) {
+                stage.rank = i;
+                break;
+            }
+        }
+        stage.cost_ms = 0.0;
+        stage.enable = stage.configured;
+        stage.sample_interval = 0;
+        stage.last_count = 0;
+        stage.last_sum_ms = 0.0;
+        _stages.push_back (stage);
+    }
+
+    if (!_clock_processor)
+        _clock_processor = processor;
+
+    // a new set of handlers invalidates the cost model
+    restart_profiling ();
+    apply_stages (processor);
+}
+
+void
+CLProfileSelector::detach (CLImageProcessor *processor)
+{
+    SmartLock locker (_mutex);
+    StageList::iterator i_stage = _stages.begin ();
+    while (i_stage != _stages.end ()) {
+        if (i_stage->processor == processor) {
+            SmartPtr<CLImageHandler> &handler = i_stage->handler;
+            handler->set_cost_sample_interval (0);
+            if (i_stage->rank >= 0 && handler->is_kernels_enabled () != i_stage->configured)
+                handler->set_kernels_enable (i_stage->configured);
+            i_stage = _stages.erase (i_stage);
+        } else {
+            ++i_stage;
+        }
+    }
+
+    if (_clock_processor == processor) {
+        _clock_processor = _stages.empty () ? NULL : _stages.front ().processor;
+        restart_profiling ();
+    }
+}
+
+void
+CLProfileSelector::restart_profiling ()
+{
+    for (StageList::iterator i_stage = _stages.begin (); i_stage != _stages.end (); ++i_stage) {
+        i_stage->cost_ms = 0.0;
+        i_stage->enable = i_stage->configured;
+        i_stage->sample_interval = 0;
+    }
+    _state = StateWarmup;
+    _frames = 0;
+}
+
+void
+CLProfileSelector::set_sample_interval (uint32_t interval)
+{
+    for (StageList::iterator i_stage = _stages.begin (); i_stage != _stages.end (); ++i_stage)
+        i_stage->sample_interval = interval;
+}
+
+void
+CLProfileSelector::snapshot_costs ()
+{
+    for (StageList::iterator i_stage = _stages.begin (); i_stage != _stages.end (); ++i_stage) {
+        const DurationStats &cost = i_stage->handler->get_cost_duration ();
+        i_stage->last_count = cost.get_count ();
+        i_stage->last_sum_ms = cost.get_sum_ms ();
+    }
+}
+
+void
+CLProfileSelector::finish_profiling ()
+{
+    for (StageList::iterator i_stage = _stages.begin (); i_stage != _stages.end (); ++i_stage) {
+        const DurationStats &cost = i_stage->handler->get_cost_duration ();
+        uint64_t count = cost.get_count () - i_stage->last_count;
+
+        // handlers disabled by configuration are never run nor selected,
+        // their cost stays unknown
+        i_stage->cost_ms = count ? (cost.get_sum_ms () - i_stage->last_sum_ms) / count : 0.0;
+        XCAM_LOG_DEBUG (
+            "cl profile %s at %dx%d: %.3fms", i_stage->name.c_str (), _width, _height, i_stage->cost_ms);
+    }
+
+    snapshot_costs ();
+    set_sample_interval (XCAM_CL_PROFILE_SAMPLE_INTERVAL);
+    select_stages ();
+    _state = StateRunning;
+}
+
+void
+CLProfileSelector::check_drift ()
+{
+    double model_ms = 0.0, measured_ms = 0.0;
+    bool drift = false;
+
+    for (StageList::iterator i_stage = _stages.begin (); i_stage != _stages.end (); ++i_stage) {
+        const DurationStats &cost = i_stage->handler->get_cost_duration ();
+        uint64_t count = cost.get_count () - i_stage->last_count;
+        if (!count)
+            continue;
+
+        double window_ms = (cost.get_sum_ms () - i_stage->last_sum_ms) / count;
+        if (fabs (window_ms - i_stage->cost_ms) > i_stage->cost_ms * XCAM_CL_PROFILE_DRIFT_RATIO) {
+            XCAM_LOG_INFO (
+                "cl profile %s cost drifted %.3fms -> %.3fms",
+                i_stage->name.c_str (), i_stage->cost_ms, window_ms);
+            drift = true;
+        }
+        model_ms += i_stage->cost_ms;
+        measured_ms += window_ms;
+        i_stage->cost_ms = window_ms;
+    }
+    snapshot_costs ();
+
+    if (!drift)
+        return;
+
+    // disabled handlers can't be measured, assume they moved like the rest
+    if (model_ms > 0.0 && measured_ms > 0.0) {
+        double scale = measured_ms / model_ms;
+        for (StageList::iterator i_stage = _stages.begin (); i_stage != _stages.end (); ++i_stage) {
+            if (i_stage->rank >= 0 && !i_stage->enable)
+                i_stage->cost_ms *= scale;
+        }
+    }
+    select_stages ();
+}
+
+void
+CLProfileSelector::select_stages ()
+{
+    std::vector<Stage *> ranked;
+    double budget_ms = get_budget_ms ();
+    double used_ms = 0.0;
+
+    for (StageList::iterator i_stage = _stages.begin (); i_stage != _stages.end (); ++i_stage) {
+        if (i_stage->rank >= 0 && i_stage->configured)
+            ranked.push_back (&(*i_stage));
+        else if (i_stage->handler->is_kernels_enabled ())
+            used_ms += i_stage->cost_ms;
+    }
+
+    if (used_ms > budget_ms) {
+        XCAM_LOG_WARNING (
+            "cl profile required handlers take %.2fms, over budget %.2fms of %.1ffps",
+            used_ms, budget_ms, _target_fps);
+    }
+
+    std::stable_sort (ranked.begin (), ranked.end (), rank_less);
+    for (uint32_t i = 0; i < ranked.size (); ++i) {
+        Stage &stage = *ranked[i];
+        bool enable = (used_ms + stage.cost_ms <= budget_ms);
+        if (enable)
+            used_ms += stage.cost_ms;
+
+        if (enable != stage.enable || !_selections) {
+            XCAM_LOG_INFO (
+                "cl profile %s %s, cost %.2fms",
+                stage.name.c_str (), enable ? "enabled" : "disabled", stage.cost_ms);
+        }
+        stage.enable = enable;
+    }
+
+    _expected_ms = used_ms;
+    ++_selections;
+    XCAM_LOG_INFO (
+        "cl profile at %dx%d: %.2fms of %.2fms budget for %.1ffps",
+        _width, _height, used_ms, budget_ms, _target_fps);
+}
+
+void
+CLProfileSelector::apply_stages (CLImageProcessor *processor)
+{
+    for (StageList::iterator i_stage = _stages.begin (); i_stage != _stages.end (); ++i_stage) {
+        if (i_stage->processor != processor)
+            continue;
+
+        SmartPtr<CLImageHandler> &handler = i_stage->handler;
+        if (i_stage->rank >= 0 && handler->is_kernels_enabled () != i_stage->enable)
+            handler->set_kernels_enable (i_stage->enable);
+        handler->set_cost_sample_interval (i_stage->sample_interval);
+    }
+}
+
+void
+CLProfileSelector::frame_done (CLImageProcessor *processor, const VideoBufferInfo &info)
+{
+    SmartLock locker (_mutex);
+
+    if (processor == _clock_processor) {
+        if (info.width != _width || info.height != _height) {
+            _width = info.width;
+            _height = info.height;
+            restart_profiling ();
+        }
+
+        ++_frames;
+        switch (_state) {
+        case StateWarmup:
+            if (_frames >= XCAM_CL_PROFILE_WARMUP_FRAMES) {
+                snapshot_costs ();
+                set_sample_interval (1);
+                _state = StateProfiling;
+                _frames = 0;
+            }
+            break;
+        case StateProfiling:
+            if (_frames >= XCAM_CL_PROFILE_MEASURE_FRAMES) {
+                finish_profiling ();
+                _frames = 0;
+            }
+            break;
+        case StateRunning:
+            if (_frames >= XCAM_CL_PROFILE_EVAL_FRAMES) {
+                check_drift ();
+                _frames = 0;
+            }
+            break;
+        }
+    }
+
+    apply_stages (processor);
+}
+
+void
+CLProfileSelector::introspect (IntrospectionWriter &writer)
+{
+    SmartLock locker (_mutex);
+
+    writer.add ("target_fps", _target_fps);
+    writer.add ("budget_ms", get_budget_ms ());
+    writer.add ("state", profile_state_names[_state]);
+    writer.add ("width", _width);
+    writer.add ("height", _height);
+    writer.add ("expected_ms", _expected_ms);
+    writer.add ("selections", _selections);
+    writer.begin_array ("stages");
+    for (StageList::iterator i_stage = _stages.begin (); i_stage != _stages.end (); ++i_stage) {
+        writer.begin_object ();
+        writer.add ("name", i_stage->name.c_str ());
+        writer.add ("rank", i_stage->rank);
+        writer.add ("cost_ms", i_stage->cost_ms);
+        writer.add ("enabled", i_stage->handler->is_kernels_enabled ());
+        writer.end_object ();
+    }
+    writer.end_array ();
+}
+
+};
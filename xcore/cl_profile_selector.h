@@ -0,0 +1,143 @@
+/*
+ * cl_profile_selector.h - choose optional cl handlers for a target frame rate
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#ifndef XCAM_CL_PROFILE_SELECTOR_H
+#define XCAM_CL_PROFILE_SELECTOR_H
+
+#include "xcam_utils.h"
+#include "xcam_mutex.h"
+#include "introspection.h"
+#include "video_buffer.h"
+#include <string>
+#include <vector>
+
+// frames run untimed first, then frames timed per handler while profiling
+#define XCAM_CL_PROFILE_WARMUP_FRAMES 4
+#define XCAM_CL_PROFILE_MEASURE_FRAMES 16
+// afterwards each enabled handler is timed on one frame out of these
+#define XCAM_CL_PROFILE_SAMPLE_INTERVAL 30
+// frames between two checks of the measured costs
+#define XCAM_CL_PROFILE_EVAL_FRAMES 300
+// relative change of a stage cost taken as drift
+#define XCAM_CL_PROFILE_DRIFT_RATIO 0.2
+// share of the frame period the enabled handlers may take
+#define XCAM_CL_PROFILE_DEFAULT_BUDGET_RATIO 0.85
+
+namespace XCam {
+
+class CLImageProcessor;
+class CLImageHandler;
+
+/*
+ * CLProfileSelector
+ * keeps the optional cl handlers within the frame budget of a target
+ * frame rate. On the first frames at a resolution every handler of
+ * the attached processors is timed with the queue drained around it,
+ * the means form the cost model. Handlers named in the quality
+ * ranking are enabled greedily, best first, while the sum of costs of
+ * all enabled handlers fits 1/fps * budget ratio; handlers not ranked
+ * are left as configured and ranked ones disabled by configuration
+ * stay off, the state at attach is restored on detach. Later enabled
+ * handlers are sampled now and then, a cost off its model by more
+ * than XCAM_CL_PROFILE_DRIFT_RATIO updates the model, scales the
+ * costs of disabled handlers by the drift of the measured ones and
+ * selects again.
+ *
+ * Frames of the first attached processor clock the selector. Handlers
+ * change state between frames on their own processor thread, ranked
+ * handlers must cope with being switched while streaming.
+ */
+class CLProfileSelector
+    : public Introspectable
+{
+    struct Stage {
+        CLImageProcessor          *processor;
+        SmartPtr<CLImageHandler>   handler;
+        std::string                name;
+        int32_t                    rank;       // -1 if not ranked
+        double                     cost_ms;
+        bool                       enable;     // wanted, ranked handlers only
+        bool                       configured; // enabled when attached
+        uint32_t                   sample_interval;
+        uint64_t                   last_count; // cost duration at last check
+        double                     last_sum_ms;
+    };
+    typedef std::vector<Stage> StageList;
+
+    enum State {
+        StateWarmup = 0,
+        StateProfiling,
+        StateRunning,
+    };
+
+public:
+    explicit CLProfileSelector (double target_fps);
+    virtual ~CLProfileSelector ();
+
+    bool set_target_fps (double fps);
+    double get_target_fps () const {
+        return _target_fps;
+    }
+    bool set_budget_ratio (double ratio);
+    // handler names, highest quality first
+    bool set_quality_ranking (const std::vector<std::string> &names);
+
+    // called by CLImageProcessor on start and stop
+    void attach (CLImageProcessor *processor);
+    void detach (CLImageProcessor *processor);
+    // on the processor thread with its stream lock held, after a frame finished
+    void frame_done (CLImageProcessor *processor, const VideoBufferInfo &info);
+
+    //derived from Introspectable
+    virtual void introspect (IntrospectionWriter &writer);
+
+private:
+    static bool rank_less (const Stage *a, const Stage *b);
+    void restart_profiling ();
+    void set_sample_interval (uint32_t interval);
+    void snapshot_costs ();
+    void finish_profiling ();
+    void check_drift ();
+    void select_stages ();
+    void apply_stages (CLImageProcessor *processor);
+    double get_budget_ms () const {
+        return 1000.0 / _target_fps * _budget_ratio;
+    }
+
+    XCAM_DEAD_COPY (CLProfileSelector);
+
+private:
+    double                     _target_fps;
+    double                     _budget_ratio;
+    std::vector<std::string>   _ranking;
+    CLImageProcessor          *_clock_processor;
+    StageList                  _stages;
+    State                      _state;
+    uint64_t                   _frames;      // clock frames in current state
+    uint32_t                   _width;
+    uint32_t                   _height;
+    double                     _expected_ms; // cost of the enabled handlers
+    uint32_t                   _selections;
+    Mutex                      _mutex;
+};
+
+};
+
+#endif //XCAM_CL_PROFILE_SELECTOR_H
@@ -44,6 +44,13 @@ CLRetinexScalerImageKernel::get_output_parameter (
     return _retinex->get_scaler_buf1 ();
 }
 
+void
+CLRetinexScalerImageKernel::pre_start ()
+{
+    if (_retinex.ptr ())
+        _retinex->pre_start ();
+}
+
 void
 CLRetinexScalerImageKernel::pre_stop ()
 {
@@ -207,6 +214,13 @@ CLRetinexImageHandler::CLRetinexImageHandler (const char *name)
 {
 }
 
+void
+CLRetinexImageHandler::pre_start ()
+{
+    if (_scaler_buf_pool.ptr ())
+        _scaler_buf_pool->resume ();
+}
+
 void
 CLRetinexImageHandler::pre_stop ()
 {
@@ -51,6 +51,7 @@ class CLRetinexScalerImageKernel
 public:
     explicit CLRetinexScalerImageKernel (
         SmartPtr<CLContext> &context, CLImageScalerMemoryLayout mem_layout, SmartPtr<CLRetinexImageHandler> &retinex);
+    virtual void pre_start ();
     virtual void pre_stop ();
 
 protected:
@@ -127,6 +128,7 @@ public:
         return _gaussian_buf[index];
     };
 
+    void pre_start ();
     void pre_stop ();
 
 protected:
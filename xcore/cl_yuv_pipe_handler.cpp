@@ -21,8 +21,6 @@
 #include "xcam_utils.h"
 #include "cl_yuv_pipe_handler.h"
 
-#define USE_BUFFER_OBJECT 0
-
 float default_matrix[XCAM_COLOR_MATRIX_SIZE] = {0.299, 0.587, 0.114, -0.14713, -0.28886, 0.436, 0.615, -0.51499, -0.10001};
 float default_macc[XCAM_CHROMA_AXIS_SIZE*XCAM_CHROMA_MATRIX_SIZE] = {
     1.000000, 0.000000, 0.000000, 1.000000, 1.000000, 0.000000, 0.000000, 1.000000,
@@ -37,18 +35,40 @@ float default_macc[XCAM_CHROMA_AXIS_SIZE*XCAM_CHROMA_MATRIX_SIZE] = {
 
 namespace XCam {
 
-CLYuvPipeImageKernel::CLYuvPipeImageKernel (SmartPtr<CLContext> &context)
-    : CLImageKernel (context, "kernel_yuv_pipe")
+CLYuvPipeImageKernel::CLYuvPipeImageKernel (
+    SmartPtr<CLContext> &context, const char *variant_name,
+    bool use_buffer_object, uint32_t local_x, uint32_t local_y)
+    : CLVariantImageKernel (context, "kernel_yuv_pipe", variant_name)
+    , _use_buffer_object (use_buffer_object)
+    , _local_x (local_x)
+    , _local_y (local_y)
     , _vertical_offset (0)
     , _gain_yuv (1.0)
     , _thr_y (0.05)
     , _thr_uv (0.05)
     , _enable_tnr_yuv (0)
+    , _enable_tnr_yuv_state (0)
 {
     memcpy(_macc_table, default_macc, sizeof(float)*XCAM_CHROMA_AXIS_SIZE * XCAM_CHROMA_MATRIX_SIZE);
     memcpy(_rgbtoyuv_matrix, default_matrix, sizeof(float)*XCAM_COLOR_MATRIX_SIZE);
 }
 
+bool
+CLYuvPipeImageKernel::is_applicable (const VideoBufferInfo &input, const VideoBufferInfo &output)
+{
+    // 8 pixels per work item, 2 lines per work item
+    if ((output.width / 8) % _local_x || (output.aligned_height / 2) % _local_y)
+        return false;
+
+    if (!_use_buffer_object)
+        return true;
+
+    // buffer object indexes planes by width, no padding allowed
+    return (input.strides[0] == input.width * 2 &&
+            output.strides[0] == output.width &&
+            output.offsets[1] == output.width * output.aligned_height);
+}
+
 bool
 CLYuvPipeImageKernel::set_macc (const XCam3aResultMaccMatrix &macc)
 {
@@ -94,31 +114,31 @@ CLYuvPipeImageKernel::prepare_arguments (
     const VideoBufferInfo & video_info_in = input->get_video_info ();
     const VideoBufferInfo & video_info_out = output->get_video_info ();
 
-#if !USE_BUFFER_OBJECT
-    CLImageDesc in_image_info;
-    in_image_info.format.image_channel_order = CL_RGBA;
-    in_image_info.format.image_channel_data_type = CL_UNSIGNED_INT32;
-    in_image_info.width = video_info_in.aligned_width / 8;
-    in_image_info.height = video_info_in.aligned_height * 3;
-    in_image_info.row_pitch = video_info_in.strides[0];
-
-    CLImageDesc out_image_info;
-    out_image_info.format.image_channel_order = CL_RGBA;
-    out_image_info.format.image_channel_data_type = CL_UNSIGNED_INT16;
-    out_image_info.width = video_info_out.width / 8;
-    out_image_info.height = video_info_out.aligned_height;
-    out_image_info.row_pitch = video_info_out.strides[0];
-
-    _buffer_in = new CLVaImage (context, input, in_image_info);
-    _buffer_out = new CLVaImage (context, output, out_image_info, video_info_out.offsets[0]);
-
-    out_image_info.height = video_info_out.aligned_height / 2;
-    out_image_info.row_pitch = video_info_out.strides[1];
-    _buffer_out_UV = new CLVaImage (context, output, out_image_info, video_info_out.offsets[1]);
-#else
-    _buffer_in = new CLVaBuffer (context, input);
-    _buffer_out = new CLVaBuffer (context, output);
-#endif
+    if (!_use_buffer_object) {
+        CLImageDesc in_image_info;
+        in_image_info.format.image_channel_order = CL_RGBA;
+        in_image_info.format.image_channel_data_type = CL_UNSIGNED_INT32;
+        in_image_info.width = video_info_in.aligned_width / 8;
+        in_image_info.height = video_info_in.aligned_height * 3;
+        in_image_info.row_pitch = video_info_in.strides[0];
+
+        CLImageDesc out_image_info;
+        out_image_info.format.image_channel_order = CL_RGBA;
+        out_image_info.format.image_channel_data_type = CL_UNSIGNED_INT16;
+        out_image_info.width = video_info_out.width / 8;
+        out_image_info.height = video_info_out.aligned_height;
+        out_image_info.row_pitch = video_info_out.strides[0];
+
+        _buffer_in = new CLVaImage (context, input, in_image_info);
+        _buffer_out = new CLVaImage (context, output, out_image_info, video_info_out.offsets[0]);
+
+        out_image_info.height = video_info_out.aligned_height / 2;
+        out_image_info.row_pitch = video_info_out.strides[1];
+        _buffer_out_UV = new CLVaImage (context, output, out_image_info, video_info_out.offsets[1]);
+    } else {
+        _buffer_in = new CLVaBuffer (context, input);
+        _buffer_out = new CLVaBuffer (context, output);
+    }
     _matrix_buffer = new CLBuffer (
         context, sizeof(float)*XCAM_COLOR_MATRIX_SIZE,
         CL_MEM_READ_WRITE | CL_MEM_USE_HOST_PTR , &_rgbtoyuv_matrix);
@@ -129,16 +149,13 @@ CLYuvPipeImageKernel::prepare_arguments (
     _plannar_offset = video_info_in.aligned_height;
     _vertical_offset = video_info_out.aligned_height;
 
+    // no reference on first frame
     if (!_buffer_out_prev.ptr ()) {
         _buffer_out_prev = _buffer_out;
         _buffer_out_prev_UV = _buffer_out_UV;
+        _enable_tnr_yuv_state = 0;
+    } else
         _enable_tnr_yuv_state = _enable_tnr_yuv;
-        _enable_tnr_yuv = 0;
-    }
-    else {
-        if (_enable_tnr_yuv == 0)
-            _enable_tnr_yuv = _enable_tnr_yuv_state;
-    }
     XCAM_ASSERT (_buffer_in->is_valid () && _buffer_out->is_valid ());
     XCAM_FAIL_RETURN (
         WARNING,
@@ -152,25 +169,25 @@ CLYuvPipeImageKernel::prepare_arguments (
     args[arg_count].arg_size = sizeof (cl_mem);
     ++arg_count;
 
-#if !USE_BUFFER_OBJECT
-    args[arg_count].arg_adress = &_buffer_out_UV->get_mem_id ();
-    args[arg_count].arg_size = sizeof (cl_mem);
-    ++arg_count;
-#endif
+    if (!_use_buffer_object) {
+        args[arg_count].arg_adress = &_buffer_out_UV->get_mem_id ();
+        args[arg_count].arg_size = sizeof (cl_mem);
+        ++arg_count;
+    }
 
     args[arg_count].arg_adress = &_buffer_out_prev->get_mem_id ();
     args[arg_count].arg_size = sizeof (cl_mem);
     ++arg_count;
 
-#if !USE_BUFFER_OBJECT
-    args[arg_count].arg_adress = &_buffer_out_prev_UV->get_mem_id ();
-    args[arg_count].arg_size = sizeof (cl_mem);
-    ++arg_count;
-#else
-    args[arg_count].arg_adress = &_vertical_offset;
-    args[arg_count].arg_size = sizeof (_vertical_offset);
-    ++arg_count;
-#endif
+    if (!_use_buffer_object) {
+        args[arg_count].arg_adress = &_buffer_out_prev_UV->get_mem_id ();
+        args[arg_count].arg_size = sizeof (cl_mem);
+        ++arg_count;
+    } else {
+        args[arg_count].arg_adress = &_vertical_offset;
+        args[arg_count].arg_size = sizeof (_vertical_offset);
+        ++arg_count;
+    }
 
     args[arg_count].arg_adress = &_plannar_offset;
     args[arg_count].arg_size = sizeof (_plannar_offset);
@@ -196,8 +213,8 @@ CLYuvPipeImageKernel::prepare_arguments (
     args[arg_count].arg_size = sizeof (_thr_uv);
     ++arg_count;
 
-    args[arg_count].arg_adress = &_enable_tnr_yuv;
-    args[arg_count].arg_size = sizeof (_enable_tnr_yuv);
+    args[arg_count].arg_adress = &_enable_tnr_yuv_state;
+    args[arg_count].arg_size = sizeof (_enable_tnr_yuv_state);
     ++arg_count;
 
     args[arg_count].arg_adress = &_buffer_in->get_mem_id ();
@@ -207,8 +224,8 @@ CLYuvPipeImageKernel::prepare_arguments (
     work_size.dim = XCAM_DEFAULT_IMAGE_DIM;
     work_size.global[0] = video_info_out.width / 8 ;
     work_size.global[1] = video_info_out.aligned_height / 2 ;
-    work_size.local[0] = 8;
-    work_size.local[1] = 4;
+    work_size.local[0] = _local_x;
+    work_size.local[1] = _local_y;
 
     return XCAM_RETURN_NO_ERROR;
 }
@@ -218,6 +235,13 @@ CLYuvPipeImageKernel::post_execute (SmartPtr<DrmBoBuffer> &output)
 {
     XCAM_UNUSED (output);
 
+    // not selected this frame, restart tnr when selected again
+    if (!is_enabled ()) {
+        _buffer_out_prev.release ();
+        _buffer_out_prev_UV.release ();
+        return XCAM_RETURN_NO_ERROR;
+    }
+
     if (_buffer_out->is_valid ()) {
         _buffer_out_prev = _buffer_out;
         _buffer_out_prev_UV = _buffer_out_UV;
@@ -240,13 +264,19 @@ CLYuvPipeImageHandler::CLYuvPipeImageHandler (const char *name)
 bool
 CLYuvPipeImageHandler::set_macc_table (const XCam3aResultMaccMatrix &macc)
 {
-    return _yuv_pipe_kernel->set_macc (macc);
+    for (std::list<SmartPtr<CLYuvPipeImageKernel> >::iterator i = _yuv_pipe_kernels.begin ();
+            i != _yuv_pipe_kernels.end (); ++i)
+        (*i)->set_macc (macc);
+    return true;
 }
 
 bool
 CLYuvPipeImageHandler::set_rgbtoyuv_matrix (const XCam3aResultColorMatrix &matrix)
 {
-    return _yuv_pipe_kernel->set_matrix (matrix);
+    for (std::list<SmartPtr<CLYuvPipeImageKernel> >::iterator i = _yuv_pipe_kernels.begin ();
+            i != _yuv_pipe_kernels.end (); ++i)
+        (*i)->set_matrix (matrix);
+    return true;
 }
 
 XCamReturn
@@ -267,57 +297,99 @@ CLYuvPipeImageHandler::prepare_buffer_pool_video_info (
 }
 
 bool
-CLYuvPipeImageHandler::set_yuv_pipe_kernel(SmartPtr<CLYuvPipeImageKernel> &kernel)
+CLYuvPipeImageHandler::set_yuv_pipe_kernels (SmartPtr<CLKernelVariantSelector> &variants)
 {
-    SmartPtr<CLImageKernel> image_kernel = kernel;
-    add_kernel (image_kernel);
-    _yuv_pipe_kernel = kernel;
-    return true;
+    CLKernelVariantSelector::VariantList &list = variants->get_variants ();
+    for (CLKernelVariantSelector::VariantList::iterator i = list.begin (); i != list.end (); ++i) {
+        SmartPtr<CLYuvPipeImageKernel> kernel = (*i).dynamic_cast_ptr<CLYuvPipeImageKernel> ();
+        XCAM_FAIL_RETURN (
+            WARNING,
+            kernel.ptr (),
+            false,
+            "CL image handler(%s) variant(%s) is not a yuv pipe kernel",
+            get_name (), (*i)->get_variant_name ());
+        _yuv_pipe_kernels.push_back (kernel);
+    }
+    return add_kernel_variants (variants);
 }
 
 bool
 CLYuvPipeImageHandler::set_tnr_yuv_config (const XCam3aResultTemporalNoiseReduction& config)
 {
-    if (!_yuv_pipe_kernel->is_valid ()) {
-        XCAM_LOG_ERROR ("set config error, invalid YUV-Pipe kernel !");
+    for (std::list<SmartPtr<CLYuvPipeImageKernel> >::iterator i = _yuv_pipe_kernels.begin ();
+            i != _yuv_pipe_kernels.end (); ++i) {
+        if (!(*i)->is_valid ()) {
+            XCAM_LOG_ERROR ("set config error, invalid YUV-Pipe kernel !");
+        }
+        (*i)->set_tnr_yuv_config (config);
     }
 
-    _yuv_pipe_kernel->set_tnr_yuv_config (config);
-
     return true;
 }
 
 bool
 CLYuvPipeImageHandler::set_tnr_enable (bool enable_tnr_yuv)
 {
-    return _yuv_pipe_kernel->set_tnr_enable (enable_tnr_yuv);
+    for (std::list<SmartPtr<CLYuvPipeImageKernel> >::iterator i = _yuv_pipe_kernels.begin ();
+            i != _yuv_pipe_kernels.end (); ++i)
+        (*i)->set_tnr_enable (enable_tnr_yuv);
+    return true;
 }
 
+static const struct {
+    const char *name;
+    bool        use_buffer_object;
+    uint32_t    local_x;
+    uint32_t    local_y;
+} yuv_pipe_variants[] = {
+    {"image_8x4", false, 8, 4},
+    {"image_16x2", false, 16, 2},
+    {"buffer_8x4", true, 8, 4},
+};
+
 SmartPtr<CLImageHandler>
 create_cl_yuv_pipe_image_handler (SmartPtr<CLContext> &context)
 {
     SmartPtr<CLYuvPipeImageHandler> yuv_pipe_handler;
-    SmartPtr<CLYuvPipeImageKernel> yuv_pipe_kernel;
+    SmartPtr<CLKernelVariantSelector> variants = new CLKernelVariantSelector ("kernel_yuv_pipe");
     XCamReturn ret = XCAM_RETURN_NO_ERROR;
 
-    yuv_pipe_kernel = new CLYuvPipeImageKernel (context);
-    {
-        XCAM_CL_KERNEL_FUNC_SOURCE_BEGIN(kernel_yuv_pipe)
+    XCAM_CL_KERNEL_FUNC_SOURCE_BEGIN(kernel_yuv_pipe)
 #include "kernel_yuv_pipe.clx"
-        XCAM_CL_KERNEL_FUNC_END;
+    XCAM_CL_KERNEL_FUNC_END;
+
+    for (uint32_t i = 0; i < sizeof (yuv_pipe_variants) / sizeof (yuv_pipe_variants[0]); ++i) {
+        SmartPtr<CLVariantImageKernel> yuv_pipe_kernel =
+            new CLYuvPipeImageKernel (
+            context, yuv_pipe_variants[i].name, yuv_pipe_variants[i].use_buffer_object,
+            yuv_pipe_variants[i].local_x, yuv_pipe_variants[i].local_y);
+
         ret = yuv_pipe_kernel->load_from_source (
                   kernel_yuv_pipe_body, strlen (kernel_yuv_pipe_body),
                   NULL, NULL,
-                  USE_BUFFER_OBJECT ? "-DUSE_BUFFER_OBJECT=1" : "-DUSE_BUFFER_OBJECT=0");
-        XCAM_FAIL_RETURN (
-            WARNING,
-            ret == XCAM_RETURN_NO_ERROR,
-            NULL,
-            "CL image handler(%s) load source failed", yuv_pipe_kernel->get_kernel_name());
+                  yuv_pipe_variants[i].use_buffer_object ? "-DUSE_BUFFER_OBJECT=1" : "-DUSE_BUFFER_OBJECT=0");
+        if (ret != XCAM_RETURN_NO_ERROR) {
+            XCAM_LOG_WARNING (
+                "CL image handler(%s) variant(%s) load source failed, skipped",
+                yuv_pipe_kernel->get_kernel_name(), yuv_pipe_variants[i].name);
+            continue;
+        }
+        XCAM_ASSERT (yuv_pipe_kernel->is_valid ());
+        variants->add_variant (yuv_pipe_kernel);
     }
-    XCAM_ASSERT (yuv_pipe_kernel->is_valid ());
+
+    XCAM_FAIL_RETURN (
+        WARNING,
+        !variants->get_variants ().empty (),
+        NULL,
+        "CL image handler(kernel_yuv_pipe) no variant loaded");
+
     yuv_pipe_handler = new CLYuvPipeImageHandler ("cl_handler_pipe_yuv");
-    yuv_pipe_handler->set_yuv_pipe_kernel (yuv_pipe_kernel);
+    XCAM_FAIL_RETURN (
+        WARNING,
+        yuv_pipe_handler->set_yuv_pipe_kernels (variants),
+        NULL,
+        "CL image handler(%s) set kernel variants failed", yuv_pipe_handler->get_name ());
 
     return yuv_pipe_handler;
 }
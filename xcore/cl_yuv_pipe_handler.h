@@ -24,16 +24,24 @@
 
 #include "xcam_utils.h"
 #include "cl_image_handler.h"
+#include "cl_kernel_variant.h"
 #include "base/xcam_3a_result.h"
 
 namespace XCam {
 
 class CLYuvPipeImageKernel
-    : public CLImageKernel
+    : public CLVariantImageKernel
 {
 
 public:
-    explicit CLYuvPipeImageKernel (SmartPtr<CLContext> &context);
+    explicit CLYuvPipeImageKernel (
+        SmartPtr<CLContext> &context, const char *variant_name,
+        bool use_buffer_object, uint32_t local_x, uint32_t local_y);
+    bool use_buffer_object () const {
+        return _use_buffer_object;
+    }
+    virtual bool is_applicable (const VideoBufferInfo &input, const VideoBufferInfo &output);
+
     bool set_macc (const XCam3aResultMaccMatrix &macc);
     bool set_matrix (const XCam3aResultColorMatrix &matrix);
     bool set_tnr_yuv_config (const XCam3aResultTemporalNoiseReduction& config);
@@ -48,6 +56,9 @@ protected:
 
 private:
     XCAM_DEAD_COPY (CLYuvPipeImageKernel);
+    bool                _use_buffer_object;
+    uint32_t            _local_x;
+    uint32_t            _local_y;
     SmartPtr<CLBuffer>  _matrix_buffer;
     SmartPtr<CLBuffer>  _macc_table_buffer;
     float               _macc_table[XCAM_CHROMA_AXIS_SIZE * XCAM_CHROMA_MATRIX_SIZE];
@@ -73,7 +84,7 @@ class CLYuvPipeImageHandler
 {
 public:
     explicit CLYuvPipeImageHandler (const char *name);
-    bool set_yuv_pipe_kernel(SmartPtr<CLYuvPipeImageKernel> &kernel);
+    bool set_yuv_pipe_kernels (SmartPtr<CLKernelVariantSelector> &variants);
     bool set_macc_table (const XCam3aResultMaccMatrix &macc);
     bool set_rgbtoyuv_matrix (const XCam3aResultColorMatrix &matrix);
     bool set_tnr_yuv_config (const XCam3aResultTemporalNoiseReduction& config);
@@ -86,7 +97,7 @@ protected:
 
 private:
     XCAM_DEAD_COPY (CLYuvPipeImageHandler);
-    SmartPtr<CLYuvPipeImageKernel> _yuv_pipe_kernel;
+    std::list<SmartPtr<CLYuvPipeImageKernel> > _yuv_pipe_kernels;
     uint32_t  _output_format;
 };
 
@@ -0,0 +1,341 @@
+/*
+ * color_lut3d.cpp - 3D look up table baked from the color chain
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#include "color_lut3d.h"
+#include <math.h>
+#include <algorithm>
+
+namespace XCam {
+
+static const float default_rgbtoyuv_matrix[XCAM_COLOR_MATRIX_SIZE] = {
+    0.299f, 0.587f, 0.114f,
+    -0.14713f, -0.28886f, 0.436f,
+    0.615f, -0.51499f, -0.10001f
+};
+
+static const float identity_matrix[XCAM_COLOR_MATRIX_SIZE] = {
+    1.0f, 0.0f, 0.0f,
+    0.0f, 1.0f, 0.0f,
+    0.0f, 0.0f, 1.0f
+};
+
+// same sectors as get_sector_id of kernel_macc
+static uint32_t
+macc_sector_id (float u, float v)
+{
+    u = fabsf (u) > 0.00001f ? u : 0.00001f;
+    float tg = v / u;
+    uint32_t se = tg > 1 ? (tg > 2 ? 3 : 2) : (tg > 0.5 ? 1 : 0);
+    uint32_t so = tg > -1 ? (tg > -0.5 ? 3 : 2) : (tg > -2 ? 1 : 0);
+    return tg > 0 ? (u > 0 ? se : (se + 8)) : (u > 0 ? (so + 12) : (so + 4));
+}
+
+static inline void
+matrix_multiply (const float *m, const float in[3], float out[3])
+{
+    out[0] = m[0] * in[0] + m[1] * in[1] + m[2] * in[2];
+    out[1] = m[3] * in[0] + m[4] * in[1] + m[5] * in[2];
+    out[2] = m[6] * in[0] + m[7] * in[1] + m[8] * in[2];
+}
+
+ColorLut3d::ColorLut3d (uint32_t size)
+    : _size (XCAM_LUT3D_SIZE_SMALL)
+    , _dirty (true)
+    , _version (0)
+    , _enable_color_matrix (true)
+    , _enable_macc (true)
+    , _enable_gamma (true)
+    , _enable_csc (true)
+{
+    memcpy (_color_matrix, identity_matrix, sizeof (_color_matrix));
+    for (uint32_t i = 0; i < XCAM_CHROMA_AXIS_SIZE; ++i) {
+        _macc_table[i * XCAM_CHROMA_MATRIX_SIZE] = 1.0f;
+        _macc_table[i * XCAM_CHROMA_MATRIX_SIZE + 1] = 0.0f;
+        _macc_table[i * XCAM_CHROMA_MATRIX_SIZE + 2] = 0.0f;
+        _macc_table[i * XCAM_CHROMA_MATRIX_SIZE + 3] = 1.0f;
+    }
+    for (uint32_t i = 0; i < XCAM_GAMMA_TABLE_SIZE; ++i)
+        _gamma_table[i] = (float)i / (XCAM_GAMMA_TABLE_SIZE - 1);
+    memcpy (_rgbtoyuv_matrix, default_rgbtoyuv_matrix, sizeof (_rgbtoyuv_matrix));
+
+    set_size (size);
+}
+
+bool
+ColorLut3d::set_size (uint32_t size)
+{
+    XCAM_FAIL_RETURN (
+        WARNING,
+        size >= XCAM_LUT3D_MIN_SIZE && size <= XCAM_LUT3D_MAX_SIZE,
+        false,
+        "lut3d size:%d out of range [%d, %d]", size, XCAM_LUT3D_MIN_SIZE, XCAM_LUT3D_MAX_SIZE);
+
+    SmartLock locker (_mutex);
+    _size = size;
+    mark_dirty ();
+    return true;
+}
+
+bool
+ColorLut3d::set_color_matrix (const XCam3aResultColorMatrix &matrix)
+{
+    SmartLock locker (_mutex);
+    for (uint32_t i = 0; i < XCAM_COLOR_MATRIX_SIZE; ++i)
+        _color_matrix[i] = (float)matrix.matrix[i];
+    mark_dirty ();
+    return true;
+}
+
+bool
+ColorLut3d::set_macc_table (const XCam3aResultMaccMatrix &macc)
+{
+    SmartLock locker (_mutex);
+    for (uint32_t i = 0; i < XCAM_CHROMA_AXIS_SIZE * XCAM_CHROMA_MATRIX_SIZE; ++i)
+        _macc_table[i] = (float)macc.table[i];
+    mark_dirty ();
+    return true;
+}
+
+bool
+ColorLut3d::set_gamma_table (const XCam3aResultGammaTable &gamma)
+{
+    SmartLock locker (_mutex);
+    // same scale as bayer basic pipe
+    for (uint32_t i = 0; i < XCAM_GAMMA_TABLE_SIZE; ++i)
+        _gamma_table[i] = (float)gamma.table[i] / 256.0f;
+    mark_dirty ();
+    return true;
+}
+
+bool
+ColorLut3d::set_rgbtoyuv_matrix (const XCam3aResultColorMatrix &matrix)
+{
+    SmartLock locker (_mutex);
+    for (uint32_t i = 0; i < XCAM_COLOR_MATRIX_SIZE; ++i)
+        _rgbtoyuv_matrix[i] = (float)matrix.matrix[i];
+    mark_dirty ();
+    return true;
+}
+
+void
+ColorLut3d::enable_color_matrix (bool enable)
+{
+    SmartLock locker (_mutex);
+    _enable_color_matrix = enable;
+    mark_dirty ();
+}
+
+void
+ColorLut3d::enable_macc (bool enable)
+{
+    SmartLock locker (_mutex);
+    _enable_macc = enable;
+    mark_dirty ();
+}
+
+void
+ColorLut3d::enable_gamma (bool enable)
+{
+    SmartLock locker (_mutex);
+    _enable_gamma = enable;
+    mark_dirty ();
+}
+
+void
+ColorLut3d::enable_csc (bool enable)
+{
+    SmartLock locker (_mutex);
+    _enable_csc = enable;
+    mark_dirty ();
+}
+
+XCamReturn
+ColorLut3d::apply_3a_result (SmartPtr<X3aResult> &result)
+{
+    XCAM_ASSERT (result.ptr ());
+
+    switch (result->get_type ()) {
+    case XCAM_3A_RESULT_RGB2YUV_MATRIX: {
+        SmartPtr<X3aColorMatrixResult> csc_res = result.dynamic_cast_ptr<X3aColorMatrixResult> ();
+        XCAM_ASSERT (csc_res.ptr ());
+        set_rgbtoyuv_matrix (csc_res->get_standard_result ());
+        break;
+    }
+    case XCAM_3A_RESULT_MACC: {
+        SmartPtr<X3aMaccMatrixResult> macc_res = result.dynamic_cast_ptr<X3aMaccMatrixResult> ();
+        XCAM_ASSERT (macc_res.ptr ());
+        set_macc_table (macc_res->get_standard_result ());
+        break;
+    }
+    case XCAM_3A_RESULT_G_GAMMA:
+    case XCAM_3A_RESULT_Y_GAMMA: {
+        SmartPtr<X3aGammaTableResult> gamma_res = result.dynamic_cast_ptr<X3aGammaTableResult> ();
+        XCAM_ASSERT (gamma_res.ptr ());
+        set_gamma_table (gamma_res->get_standard_result ());
+        break;
+    }
+    default:
+        return XCAM_RETURN_BYPASS;
+    }
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+void
+ColorLut3d::apply_chain (const float in[3], float out[3]) const
+{
+    float rgb[3] = {in[0], in[1], in[2]};
+
+    if (_enable_color_matrix) {
+        float tmp[3];
+        matrix_multiply (_color_matrix, rgb, tmp);
+        memcpy (rgb, tmp, sizeof (rgb));
+    }
+
+    if (_enable_macc) {
+        // same yuv space as kernel_macc
+        float y = 0.3f * rgb[0] + 0.59f * rgb[1] + 0.11f * rgb[2];
+        float u = 0.493f * (rgb[2] - y);
+        float v = 0.877f * (rgb[0] - y);
+        const float *macc = _macc_table + XCAM_CHROMA_MATRIX_SIZE * macc_sector_id (u, v);
+        float uo = u * macc[0] + v * macc[1];
+        float vo = u * macc[2] + v * macc[3];
+        rgb[0] = y + 1.14f * vo;
+        rgb[1] = y - 0.39f * uo - 0.58f * vo;
+        rgb[2] = y + 2.03f * uo;
+    }
+
+    if (_enable_gamma) {
+        // linear between table entries instead of nearest entry
+        for (uint32_t i = 0; i < 3; ++i) {
+            float pos = XCAM_MIN (XCAM_MAX (rgb[i], 0.0f), 1.0f) * (XCAM_GAMMA_TABLE_SIZE - 1);
+            uint32_t index = XCAM_MIN ((uint32_t)pos, (uint32_t)XCAM_GAMMA_TABLE_SIZE - 2);
+            float frac = pos - index;
+            rgb[i] = _gamma_table[index] + (_gamma_table[index + 1] - _gamma_table[index]) * frac;
+        }
+    }
+
+    if (_enable_csc) {
+        matrix_multiply (_rgbtoyuv_matrix, rgb, out);
+        out[1] += 0.5f;
+        out[2] += 0.5f;
+    } else
+        memcpy (out, rgb, sizeof (rgb));
+}
+
+void
+ColorLut3d::bake ()
+{
+    const float scale = 1.0f / (_size - 1);
+    float in[3], out[3];
+
+    // a new table each time, the old one may still be in use
+    SmartPtr<ColorLut3dTable> table = new ColorLut3dTable;
+    table->entries.resize (_size * _size * _size * XCAM_LUT3D_ENTRY_SIZE);
+    float *entry = &table->entries[0];
+    for (uint32_t b = 0; b < _size; ++b) {
+        in[2] = b * scale;
+        for (uint32_t g = 0; g < _size; ++g) {
+            in[1] = g * scale;
+            for (uint32_t r = 0; r < _size; ++r) {
+                in[0] = r * scale;
+                apply_chain (in, out);
+                entry[0] = out[0];
+                entry[1] = out[1];
+                entry[2] = out[2];
+                entry[3] = 0.0f;
+                entry += XCAM_LUT3D_ENTRY_SIZE;
+            }
+        }
+    }
+
+    _dirty = false;
+    ++_version;
+    table->size = _size;
+    table->version = _version;
+    _table = table;
+    XCAM_LOG_DEBUG ("lut3d baked, size:%d version:%d", _size, _version);
+}
+
+SmartPtr<ColorLut3dTable>
+ColorLut3d::get_table ()
+{
+    SmartLock locker (_mutex);
+    if (_dirty)
+        bake ();
+    return _table;
+}
+
+void
+ColorLut3d::lookup (
+    const float *table, uint32_t size, Lut3dInterpolation interp,
+    const float in[3], float out[3])
+{
+    const uint32_t stride[3] = {
+        XCAM_LUT3D_ENTRY_SIZE,
+        XCAM_LUT3D_ENTRY_SIZE * size,
+        XCAM_LUT3D_ENTRY_SIZE * size * size
+    };
+    uint32_t offset = 0;
+    float f[3];
+
+    for (uint32_t i = 0; i < 3; ++i) {
+        float pos = XCAM_MIN (XCAM_MAX (in[i], 0.0f), 1.0f) * (size - 1);
+        uint32_t index = XCAM_MIN ((uint32_t)pos, size - 2);
+        f[i] = pos - index;
+        offset += index * stride[i];
+    }
+    const float *c000 = table + offset;
+
+    if (interp == Lut3dTrilinear) {
+        for (uint32_t ch = 0; ch < 3; ++ch) {
+            float c00 = c000[ch] + (c000[stride[0] + ch] - c000[ch]) * f[0];
+            float c10 = c000[stride[1] + ch] + (c000[stride[1] + stride[0] + ch] - c000[stride[1] + ch]) * f[0];
+            float c01 = c000[stride[2] + ch] + (c000[stride[2] + stride[0] + ch] - c000[stride[2] + ch]) * f[0];
+            float c11 = c000[stride[2] + stride[1] + ch] +
+                        (c000[stride[2] + stride[1] + stride[0] + ch] - c000[stride[2] + stride[1] + ch]) * f[0];
+            float c0 = c00 + (c10 - c00) * f[1];
+            float c1 = c01 + (c11 - c01) * f[1];
+            out[ch] = c0 + (c1 - c0) * f[2];
+        }
+        return;
+    }
+
+    // walk from c000 to c111 along the axes in order of decreasing fraction
+    uint32_t order[3] = {0, 1, 2};
+    if (f[order[0]] < f[order[1]])
+        std::swap (order[0], order[1]);
+    if (f[order[1]] < f[order[2]])
+        std::swap (order[1], order[2]);
+    if (f[order[0]] < f[order[1]])
+        std::swap (order[0], order[1]);
+
+    const float *c1 = c000 + stride[order[0]];
+    const float *c2 = c1 + stride[order[1]];
+    const float *c3 = c2 + stride[order[2]];
+    float w0 = 1.0f - f[order[0]];
+    float w1 = f[order[0]] - f[order[1]];
+    float w2 = f[order[1]] - f[order[2]];
+    float w3 = f[order[2]];
+    for (uint32_t ch = 0; ch < 3; ++ch)
+        out[ch] = c000[ch] * w0 + c1[ch] * w1 + c2[ch] * w2 + c3[ch] * w3;
+}
+
+};
@@ -0,0 +1,131 @@
+/*
+ * color_lut3d.h - 3D look up table baked from the color chain
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#ifndef XCAM_COLOR_LUT3D_H
+#define XCAM_COLOR_LUT3D_H
+
+#include "xcam_utils.h"
+#include "xcam_mutex.h"
+#include "x3a_result.h"
+#include <vector>
+
+#define XCAM_LUT3D_SIZE_SMALL 17
+#define XCAM_LUT3D_SIZE_LARGE 33
+#define XCAM_LUT3D_MIN_SIZE 2
+#define XCAM_LUT3D_MAX_SIZE 65
+// floats of each entry, 3 channels padded to 4 for vector loads
+#define XCAM_LUT3D_ENTRY_SIZE 4
+
+namespace XCam {
+
+enum Lut3dInterpolation {
+    Lut3dTrilinear = 0,   // 8 taps
+    Lut3dTetrahedral,     // 4 taps, neutral axis exact
+};
+
+/*
+ * one baked table, never changed once handed out, so readers keep using
+ * it while a newer version is baked
+ */
+struct ColorLut3dTable {
+    std::vector<float>   entries;
+    uint32_t             size;
+    uint32_t             version;
+
+    ColorLut3dTable ()
+        : size (0)
+        , version (0)
+    {}
+};
+
+/*
+ * ColorLut3d
+ * bakes color matrix -> macc -> gamma -> output csc (rgb -> yuv) into
+ * size^3 entries over normalized rgb [0, 1]. Every setter marks the table
+ * dirty, get_table() re-bakes only after a change.
+ * entry (r, g, b) starts at ((b * size + g) * size + r) * XCAM_LUT3D_ENTRY_SIZE,
+ * yuv entries keep 0.5 offset on u/v, entries are not clamped.
+ */
+class ColorLut3d
+{
+public:
+    explicit ColorLut3d (uint32_t size = XCAM_LUT3D_SIZE_SMALL);
+
+    bool set_size (uint32_t size);
+    uint32_t get_size () const {
+        return _size;
+    }
+
+    // rgb to rgb color correction
+    bool set_color_matrix (const XCam3aResultColorMatrix &matrix);
+    bool set_macc_table (const XCam3aResultMaccMatrix &macc);
+    bool set_gamma_table (const XCam3aResultGammaTable &gamma);
+    bool set_rgbtoyuv_matrix (const XCam3aResultColorMatrix &matrix);
+
+    void enable_color_matrix (bool enable);
+    void enable_macc (bool enable);
+    void enable_gamma (bool enable);
+    // output rgb when csc disabled
+    void enable_csc (bool enable);
+    bool is_csc_enabled () const {
+        return _enable_csc;
+    }
+
+    // RGB2YUV_MATRIX, MACC, Y_GAMMA and G_GAMMA, otherwise XCAM_RETURN_BYPASS
+    XCamReturn apply_3a_result (SmartPtr<X3aResult> &result);
+
+    // bake if dirty, version increases on every bake
+    SmartPtr<ColorLut3dTable> get_table ();
+
+    // whole chain on one color, no table
+    void apply_chain (const float in[3], float out[3]) const;
+    // interpolate one color from a baked table
+    static void lookup (
+        const float *table, uint32_t size, Lut3dInterpolation interp,
+        const float in[3], float out[3]);
+
+private:
+    void bake ();
+    void mark_dirty () {
+        _dirty = true;
+    }
+
+    XCAM_DEAD_COPY (ColorLut3d);
+
+private:
+    Mutex                  _mutex;
+    uint32_t               _size;
+    bool                   _dirty;
+    uint32_t               _version;
+    SmartPtr<ColorLut3dTable> _table;
+
+    float                  _color_matrix[XCAM_COLOR_MATRIX_SIZE];
+    float                  _macc_table[XCAM_CHROMA_AXIS_SIZE * XCAM_CHROMA_MATRIX_SIZE];
+    float                  _gamma_table[XCAM_GAMMA_TABLE_SIZE];
+    float                  _rgbtoyuv_matrix[XCAM_COLOR_MATRIX_SIZE];
+    bool                   _enable_color_matrix;
+    bool                   _enable_macc;
+    bool                   _enable_gamma;
+    bool                   _enable_csc;
+};
+
+};
+
+#endif //XCAM_COLOR_LUT3D_H
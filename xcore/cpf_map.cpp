@@ -0,0 +1,201 @@
+/*
+ * cpf_map.cpp - memory mapped CPF tuning file, shared in process
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#include "cpf_map.h"
+#include <sys/mman.h>
+#include <sys/statvfs.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+namespace XCam {
+
+CpfMap::MapCache CpfMap::_cache;
+Mutex CpfMap::_cache_mutex;
+
+SmartPtr<CpfMap>
+CpfMap::open (const char *path)
+{
+    struct stat st;
+
+    XCAM_FAIL_RETURN (ERROR, path, NULL, "cpf map open without path");
+    XCAM_FAIL_RETURN (
+        ERROR, stat (path, &st) == 0, NULL,
+        "cpf(%s) stat failed, %s", path, strerror (errno));
+
+    SmartLock locker (_cache_mutex);
+    MapCache::iterator i_map = _cache.find (path);
+    if (i_map != _cache.end ()) {
+        if (i_map->second->is_current (st))
+            return i_map->second;
+        XCAM_LOG_INFO ("cpf(%s) changed on disk, map it again", path);
+        _cache.erase (i_map);
+    }
+
+    SmartPtr<CpfMap> map = new CpfMap (path);
+    if (!map->map_file () || !map->index_records ())
+        return NULL;
+
+    _cache[path] = map;
+    return map;
+}
+
+void
+CpfMap::clear_cache ()
+{
+    SmartLock locker (_cache_mutex);
+    _cache.clear ();
+}
+
+CpfMap::CpfMap (const char *path)
+    : _path (path)
+    , _data (NULL)
+    , _size (0)
+    , _mapped (false)
+    , _dev (0)
+    , _ino (0)
+    , _mtime (0)
+    , _mtime_nsec (0)
+{
+}
+
+CpfMap::~CpfMap ()
+{
+    if (_data && _mapped)
+        munmap (_data, _size);
+    else if (_data)
+        xcam_free (_data);
+}
+
+bool
+CpfMap::is_current (const struct stat &st) const
+{
+    return st.st_dev == _dev && st.st_ino == _ino && (uint64_t)st.st_size == _size &&
+           st.st_mtim.tv_sec == _mtime && st.st_mtim.tv_nsec == _mtime_nsec;
+}
+
+bool
+CpfMap::map_file ()
+{
+    struct stat st;
+    struct statvfs vfs;
+    int fd = ::open (_path.c_str (), O_RDONLY | O_CLOEXEC);
+    XCAM_FAIL_RETURN (
+        ERROR, fd >= 0, false,
+        "cpf(%s) open failed, %s", _path.c_str (), strerror (errno));
+
+    if (fstat (fd, &st) < 0 || st.st_size < (off_t)sizeof (tbd_header_t) || st.st_size > (off_t)0xFFFFFFFF) {
+        XCAM_LOG_ERROR ("cpf(%s) size invalid", _path.c_str ());
+        close (fd);
+        return false;
+    }
+
+    _size = st.st_size;
+    if (fstatvfs (fd, &vfs) == 0 && (vfs.f_flag & ST_RDONLY)) {
+        void *data = mmap (NULL, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close (fd);
+        XCAM_FAIL_RETURN (
+            ERROR, data != MAP_FAILED, false,
+            "cpf(%s) mmap failed, %s", _path.c_str (), strerror (errno));
+        _data = (uint8_t *)data;
+        _mapped = true;
+    } else {
+        bool ret = read_file (fd);
+        close (fd);
+        if (!ret)
+            return false;
+    }
+
+    _dev = st.st_dev;
+    _ino = st.st_ino;
+    _mtime = st.st_mtim.tv_sec;
+    _mtime_nsec = st.st_mtim.tv_nsec;
+    return true;
+}
+
+// writable filesystem, keep a private copy
+bool
+CpfMap::read_file (int fd)
+{
+    uint32_t offset = 0;
+
+    _data = (uint8_t *) xcam_malloc (_size);
+    XCAM_FAIL_RETURN (ERROR, _data, false, "cpf(%s) allocating %d bytes failed", _path.c_str (), _size);
+
+    while (offset < _size) {
+        ssize_t len = pread (fd, _data + offset, _size - offset, offset);
+        if (len < 0 && errno == EINTR)
+            continue;
+        if (len <= 0) {
+            XCAM_LOG_ERROR (
+                "cpf(%s) read failed at %d of %d bytes, %s",
+                _path.c_str (), offset, _size, len < 0 ? strerror (errno) : "truncated");
+            return false;
+        }
+        offset += len;
+    }
+    return true;
+}
+
+bool
+CpfMap::index_records ()
+{
+    // checksum over the whole file, once per mapping
+    XCAM_FAIL_RETURN (
+        ERROR, tbd_validate (_data, _size, tbd_tag_cpff) == tbd_err_none, false,
+        "cpf(%s) validate failed", _path.c_str ());
+
+    const tbd_header_t *header = (const tbd_header_t *)_data;
+    const uint8_t *pos = (const uint8_t *)(header + 1);
+    const uint8_t *end = _data + header->size;
+
+    // sizes are checked by tbd_validate
+    while (pos < end) {
+        const tbd_record_header_t *record_header = (const tbd_record_header_t *)pos;
+        Record record;
+        record.class_id = record_header->class_id;
+        record.format_id = record_header->format_id;
+        record.data = (const uint8_t *)(record_header + 1);
+        record.size = record_header->size - sizeof (tbd_record_header_t);
+        _records.push_back (record);
+        pos += record_header->size;
+    }
+
+    XCAM_LOG_DEBUG (
+        "cpf(%s) %s, %d bytes, %d records",
+        _path.c_str (), _mapped ? "mapped" : "copied", _size, (uint32_t)_records.size ());
+    return true;
+}
+
+bool
+CpfMap::get_record (tbd_class_t record_class, const uint8_t *&data, uint32_t &size) const
+{
+    for (std::vector<Record>::const_iterator i_record = _records.begin ();
+            i_record != _records.end (); ++i_record) {
+        if (record_class == tbd_class_any || record_class == i_record->class_id) {
+            data = i_record->data;
+            size = i_record->size;
+            return true;
+        }
+    }
+    return false;
+}
+
+};
@@ -0,0 +1,101 @@
+/*
+ * cpf_map.h - memory mapped CPF tuning file, shared in process
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#ifndef XCAM_CPF_MAP_H
+#define XCAM_CPF_MAP_H
+
+#include "xcam_utils.h"
+#include "smartptr.h"
+#include "xcam_mutex.h"
+#include "libtbd.h"
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace XCam {
+
+/*
+ * CpfMap
+ * a CPF file mapped read only, validated and its tbd records indexed
+ * once. Only files on a read-only filesystem are mapped, others are
+ * copied to memory: a tuning file rewritten in place would change or,
+ * if truncated, SIGBUS a live mapping. Replace tuning files by rename
+ * so the new inode is picked up by the next open. open returns the
+ * map already held in process for the same path as long as the file
+ * on disk is unchanged (device, inode, size, mtime), so analyzers
+ * re-initialized or running side by side share one copy of the tuning
+ * data. Record data points into the mapped or copied file and stays
+ * valid while a reference to the map is held.
+ */
+class CpfMap
+{
+    struct Record {
+        uint16_t        class_id;
+        uint8_t         format_id;
+        const uint8_t  *data;
+        uint32_t        size;
+    };
+    typedef std::map<std::string, SmartPtr<CpfMap> > MapCache;
+
+public:
+    static SmartPtr<CpfMap> open (const char *path);
+    // drops cached maps, held references keep theirs alive
+    static void clear_cache ();
+
+    ~CpfMap ();
+
+    // first record of class, like tbd_get_record with tbd_format_any
+    bool get_record (tbd_class_t record_class, const uint8_t *&data, uint32_t &size) const;
+    const char *get_path () const {
+        return _path.c_str ();
+    }
+    uint32_t get_size () const {
+        return _size;
+    }
+
+private:
+    CpfMap (const char *path);
+    bool map_file ();
+    bool read_file (int fd);
+    bool index_records ();
+    bool is_current (const struct stat &st) const;
+
+    XCAM_DEAD_COPY (CpfMap);
+
+private:
+    static MapCache              _cache;
+    static Mutex                 _cache_mutex;
+
+    std::string                  _path;
+    uint8_t                     *_data;
+    uint32_t                     _size;
+    bool                         _mapped;
+    dev_t                        _dev;
+    ino_t                        _ino;
+    time_t                       _mtime;
+    long                         _mtime_nsec;
+    std::vector<Record>          _records;
+};
+
+};
+
+#endif //XCAM_CPF_MAP_H
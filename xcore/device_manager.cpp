@@ -25,6 +25,9 @@
 #include "x3a_analyzer_manager.h"
 #include "isp_image_processor.h"
 #include "isp_controller.h"
+#include "startup_tracer.h"
+#include "perf_counters.h"
+#include "xcam_probes.h"
 #if HAVE_IA_AIQ
 #include "x3a_analyzer_aiq.h"
 #endif
@@ -38,6 +41,57 @@
 
 namespace XCam {
 
+// analyzers stay initialized across stop/start, only new geometry re-inits
+static bool
+analyzer_configured (XAnalyzer *analyzer, uint32_t width, uint32_t height, double framerate)
+{
+    return analyzer->get_width () == width &&
+           analyzer->get_height () == height &&
+           analyzer->get_framerate () == framerate;
+}
+
+// (re)init of an analyzer for a new geometry, cpf parsing and handler loading
+class AnalyzerInitTask
+    : public StartupTask
+{
+public:
+    AnalyzerInitTask (
+        const char *name, XAnalyzer *analyzer, bool need_handlers,
+        uint32_t width, uint32_t height, double framerate)
+        : StartupTask (name)
+        , _analyzer (analyzer)
+        , _need_handlers (need_handlers)
+        , _width (width)
+        , _height (height)
+        , _framerate (framerate)
+    {}
+
+protected:
+    virtual XCamReturn run ();
+
+private:
+    XAnalyzer    *_analyzer;
+    bool          _need_handlers;
+    uint32_t      _width;
+    uint32_t      _height;
+    double        _framerate;
+};
+
+XCamReturn
+AnalyzerInitTask::run ()
+{
+    if (_analyzer->get_width ())
+        _analyzer->deinit ();
+
+    if (_analyzer->prepare_handlers () != XCAM_RETURN_NO_ERROR) {
+        XCAM_LOG_INFO ("prepare analyzer(%s) handlers failed", XCAM_STR (_analyzer->get_name ()));
+        if (_need_handlers)
+            return XCAM_RETURN_ERROR_PARAM;
+    }
+
+    return _analyzer->init (_width, _height, _framerate);
+}
+
 class MessageThread
     : public Thread
 {
@@ -88,6 +142,8 @@ DeviceManager::DeviceManager()
 
 DeviceManager::~DeviceManager()
 {
+    IntrospectionServer::instance ()->unregister_component (this);
+    release_pipeline ();
     XCAM_LOG_DEBUG ("~DeviceManager destruction");
 }
 
@@ -164,7 +220,11 @@ DeviceManager::set_poll_thread (SmartPtr<PollThread> thread)
     if (is_running ())
         return false;
 
-    XCAM_ASSERT (thread.ptr () && !_poll_thread.ptr ());
+    // a parked poll thread is already stopped, start wires up the new one
+    XCAM_ASSERT (thread.ptr ());
+    if (_poll_thread.ptr () && _poll_thread.ptr () != thread.ptr ()) {
+        XCAM_LOG_DEBUG ("device manager replaced parked poll thread");
+    }
     _poll_thread = thread;
     return true;
 }
@@ -173,6 +233,10 @@ XCamReturn
 DeviceManager::start ()
 {
     XCamReturn ret = XCAM_RETURN_NO_ERROR;
+    struct timeval start_time;
+    bool cold_start = false;
+
+    gettimeofday (&start_time, NULL);
 
     // start device
     XCAM_ASSERT (_device->is_opened());
@@ -206,42 +270,57 @@ DeviceManager::start ()
                 XCAM_FAILED_STOP (ret = XCAM_RETURN_ERROR_PARAM, "create analyzer failed");
             }
         }
-        if (_3a_analyzer->prepare_handlers () != XCAM_RETURN_NO_ERROR) {
-            XCAM_FAILED_STOP (ret = XCAM_RETURN_ERROR_PARAM, "prepare analyzer handler failed");
-        }
         _3a_analyzer->set_results_callback (this);
 
         _device->get_size (width, height);
         _device->get_framerate (fps_n, fps_d);
         if (fps_d)
             framerate = (double)fps_n / (double)fps_d;
-        XCAM_FAILED_STOP (
-            ret = _3a_analyzer->init (width, height, framerate),
-            "initialize analyzer failed");
 
-        XCAM_FAILED_STOP (ret = _3a_analyzer->start (), "start analyzer failed");
-
-        if (_smart_analyzer.ptr()) {
-            if (_smart_analyzer->prepare_handlers () != XCAM_RETURN_NO_ERROR) {
-                XCAM_LOG_INFO ("prepare smart analyzer handler failed");
-            }
-            //_smart_analyzer->set_results_callback (this);
-            if (_smart_analyzer->init (width, height, framerate) != XCAM_RETURN_NO_ERROR) {
-                XCAM_LOG_INFO ("initialize smart analyzer failed");
-            }
-            if (_smart_analyzer->start () != XCAM_RETURN_NO_ERROR) {
-                XCAM_LOG_INFO ("start smart analyzer failed");
-            }
+        // one-time inits are independent: analyzers init on helper threads
+        // while processors probe cl/drm and build kernels on theirs
+        SmartPtr<StartupTask> analyzer_task, smart_task;
+        if (!analyzer_configured (_3a_analyzer.ptr (), width, height, framerate)) {
+            analyzer_task = new AnalyzerInitTask (
+                "3a_analyzer_init", _3a_analyzer.ptr (), true, width, height, framerate);
+            analyzer_task->launch ();
+            cold_start = true;
+        }
+        if (_smart_analyzer.ptr() &&
+                !analyzer_configured (_smart_analyzer.ptr (), width, height, framerate)) {
+            smart_task = new AnalyzerInitTask (
+                "smart_analyzer_init", _smart_analyzer.ptr (), false, width, height, framerate);
+            smart_task->launch ();
+            cold_start = true;
         }
 
-        // Initialize and start image processors
         if (!_3a_process_center->has_processors()) {
             // default processor
             SmartPtr<ImageProcessor> default_processor = new IspImageProcessor (_isp_controller);
             XCAM_ASSERT (default_processor.ptr ());
             _3a_process_center->insert_processor (default_processor);
         }
+        XCamReturn prepare_ret = _3a_process_center->prepare ();
+
+        // join all before any failure stops the manager
+        if (smart_task.ptr () && smart_task->wait () != XCAM_RETURN_NO_ERROR) {
+            XCAM_LOG_INFO ("initialize smart analyzer failed");
+        }
+        if (analyzer_task.ptr ()) {
+            XCAM_FAILED_STOP (ret = analyzer_task->wait (), "initialize analyzer failed");
+        }
+        XCAM_FAILED_STOP (ret = prepare_ret, "prepare image processors failed");
+
+        XCAM_FAILED_STOP (ret = _3a_analyzer->start (), "start analyzer failed");
+
+        if (_smart_analyzer.ptr()) {
+            //_smart_analyzer->set_results_callback (this);
+            if (_smart_analyzer->start () != XCAM_RETURN_NO_ERROR) {
+                XCAM_LOG_INFO ("start smart analyzer failed");
+            }
+        }
 
+        // start image processors
         _3a_process_center->set_image_callback(this);
         XCAM_FAILED_STOP (ret = _3a_process_center->start (), "3A process center start failed");
 
@@ -260,26 +339,44 @@ DeviceManager::start ()
 
     _is_running = true;
 
-    XCAM_LOG_DEBUG ("Device manager started");
+    {
+        // introspection is optional, never fails the stream
+        SmartPtr<IntrospectionServer> server = IntrospectionServer::instance ();
+        const char *socket_path = getenv (XCAM_INTROSPECTION_SOCKET_ENV);
+        if (socket_path && !server->is_running ())
+            server->start_server (socket_path);
+        server->register_component ("device_manager", this);
+    }
+
+    _start_duration.add (start_time);
+    XCAM_LOG_INFO ("Device manager started in %.1fms", _start_duration.get_last_ms ());
+    if (cold_start) {
+        SmartPtr<StartupTracer> tracer = StartupTracer::instance ();
+        tracer->add_phase ("device_manager_start", start_time);
+        tracer->report ();
+    }
     return XCAM_RETURN_NO_ERROR;
 }
 
 XCamReturn
 DeviceManager::stop ()
 {
+    struct timeval stop_time;
+
+    gettimeofday (&stop_time, NULL);
+
+    // waits for a snapshot in progress
+    IntrospectionServer::instance ()->unregister_component (this);
     _is_running = false;
 
     if (_poll_thread.ptr())
         _poll_thread->stop ();
 
-    if (_3a_analyzer.ptr()) {
+    // analyzers keep their init and handlers for next start
+    if (_3a_analyzer.ptr())
         _3a_analyzer->stop ();
-        _3a_analyzer->deinit ();
-    }
-    if (_smart_analyzer.ptr()) {
+    if (_smart_analyzer.ptr())
         _smart_analyzer->stop ();
-        _smart_analyzer->deinit ();
-    }
 
     if (_3a_process_center.ptr())
         _3a_process_center->stop ();
@@ -289,13 +386,97 @@ DeviceManager::stop ()
 
     _device->stop ();
 
-    _isp_controller.release ();
+    _stop_duration.add (stop_time);
+    XCAM_LOG_INFO ("Device manager stopped in %.1fms", _stop_duration.get_last_ms ());
+    if (PerfCounters::is_enabled ())
+        PerfCounters::instance ()->report ();
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+DeviceManager::release_pipeline ()
+{
+    XCAM_FAIL_RETURN (
+        WARNING, !_is_running, XCAM_RETURN_ERROR_PARAM,
+        "device manager can't release pipeline while running");
+
+    if (_3a_analyzer.ptr()) {
+        if (_3a_analyzer->get_width ())
+            _3a_analyzer->deinit ();
+        _3a_analyzer.release ();
+    }
+    if (_smart_analyzer.ptr()) {
+        if (_smart_analyzer->get_width ())
+            _smart_analyzer->deinit ();
+        _smart_analyzer.release ();
+    }
+
+    if (_3a_process_center.ptr())
+        _3a_process_center->clear_processors ();
+
     _poll_thread.release ();
+    _isp_controller.release ();
+    _subdevice.release ();
+    _device.release ();
 
-    XCAM_LOG_DEBUG ("Device manager stopped");
+    XCAM_LOG_DEBUG ("Device manager pipeline released");
     return XCAM_RETURN_NO_ERROR;
 }
 
+void
+DeviceManager::introspect (IntrospectionWriter &writer)
+{
+    writer.add ("running", _is_running);
+    writer.add ("has_3a", _has_3a);
+    writer.add ("message_queue", _msg_queue.size ());
+
+    writer.begin_object ("start");
+    _start_duration.introspect (writer);
+    writer.end_object ();
+    writer.begin_object ("stop");
+    _stop_duration.introspect (writer);
+    writer.end_object ();
+    writer.begin_object ("startup");
+    StartupTracer::instance ()->introspect (writer);
+    writer.end_object ();
+
+    if (_device.ptr ()) {
+        uint32_t width = 0, height = 0, fps_n = 0, fps_d = 0;
+        _device->get_size (width, height);
+        _device->get_framerate (fps_n, fps_d);
+        writer.begin_object ("capture");
+        writer.add ("width", width);
+        writer.add ("height", height);
+        writer.add ("framerate", fps_d ? (double)fps_n / fps_d : 0.0);
+        writer.end_object ();
+    }
+
+    if (_poll_thread.ptr ()) {
+        writer.begin_object ("poll");
+        _poll_thread->introspect (writer);
+        writer.end_object ();
+    }
+
+    if (_3a_analyzer.ptr ()) {
+        writer.begin_object ("analyzer");
+        _3a_analyzer->introspect (writer);
+        writer.end_object ();
+    }
+    if (_smart_analyzer.ptr ()) {
+        writer.begin_object ("smart_analyzer");
+        _smart_analyzer->introspect (writer);
+        writer.end_object ();
+    }
+    if (_3a_process_center.ptr ())
+        _3a_process_center->introspect (writer);
+
+    if (PerfCounters::is_enabled ()) {
+        writer.begin_object ("perf");
+        PerfCounters::instance ()->introspect (writer);
+        writer.end_object ();
+    }
+}
+
 XCamReturn
 DeviceManager::x3a_stats_ready (const SmartPtr<X3aStats> &stats)
 {
@@ -303,6 +484,7 @@ DeviceManager::x3a_stats_ready (const SmartPtr<X3aStats> &stats)
     X3aResultList results;
     XCAM_ASSERT (_3a_analyzer.ptr());
 
+    XCAM_PROBE1 (stats_posted, stats->get_timestamp ());
     ret = _3a_analyzer->push_3a_stats (stats);
     XCAM_FAIL_RETURN (ERROR,
                       ret == XCAM_RETURN_NO_ERROR,
@@ -315,8 +497,9 @@ DeviceManager::x3a_stats_ready (const SmartPtr<X3aStats> &stats)
 XCamReturn
 DeviceManager::dvs_stats_ready ()
 {
-    XCAM_ASSERT (false);
-    // TODO
+    // isp dvs statistics not used, CLPostImageProcessor::set_dvs
+    // stabilizes on projections of output frames
+    XCAM_LOG_DEBUG ("dvs stats ready, ignored");
     return XCAM_RETURN_NO_ERROR;
 }
 
@@ -376,6 +559,7 @@ void
 DeviceManager::process_buffer_done (ImageProcessor *processor, const SmartPtr<VideoBuffer> &buf)
 {
     ImageProcessCallback::process_buffer_done (processor, buf);
+    XCAM_PROBE2 (output_delivered, XCAM_STR (processor->get_name ()), buf->get_timestamp ());
     handle_buffer (buf);
 }
 
@@ -395,6 +579,10 @@ void
 DeviceManager::post_message (XCamMessageType type, int64_t timestamp, const char *msg)
 {
     SmartPtr<XCamMessage> new_msg = new XCamMessage (type, timestamp, msg);
+    if (!new_msg.ptr ()) {
+        XCAM_LOG_ERROR ("device manager allocating message(%d) failed", type);
+        return;
+    }
     _msg_queue.push (new_msg);
 }
 
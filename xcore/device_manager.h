@@ -32,6 +32,8 @@
 #include "x3a_statistics_queue.h"
 #include "poll_thread.h"
 #include "stats_callback_interface.h"
+#include "introspection.h"
+#include "frame_arena.h"
 
 namespace XCam {
 
@@ -44,7 +46,9 @@ enum XCamMessageType {
     XCAM_MESSAGE_3A_RESULTS_ERROR,
 };
 
-struct XCamMessage {
+struct XCamMessage
+    : public ArenaObject
+{
     int64_t          timestamp;
     XCamMessageType  msg_id;
     char            *msg;
@@ -65,6 +69,7 @@ class DeviceManager
     , public StatsCallback
     , public AnalyzerCallback
     , public ImageProcessCallback
+    , public Introspectable
 {
     friend class MessageThread;
 
@@ -97,8 +102,17 @@ public:
         return _has_3a;
     }
 
+    // stop parks devices buffers, threads, analyzers and processors,
+    // start only rebuilds what depends on a changed format.
+    // while parked only set_poll_thread may replace a component, the other
+    // set_* assert unless release_pipeline was called first
     XCamReturn start ();
     XCamReturn stop ();
+    // drop all parked state, set_* and add_image_processor again before start
+    XCamReturn release_pipeline ();
+
+    //derived from Introspectable
+    virtual void introspect (IntrospectionWriter &writer);
 
 protected:
     virtual void handle_message (const SmartPtr<XCamMessage> &msg) = 0;
@@ -143,6 +157,8 @@ protected:
     SmartPtr<MessageThread>          _msg_thread;
 
     bool                             _is_running;
+    DurationStats                    _start_duration;
+    DurationStats                    _stop_duration;
 
     /* smart analysis */
     SmartPtr<SmartAnalyzer>         _smart_analyzer;
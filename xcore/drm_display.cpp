@@ -22,6 +22,7 @@
 #include "drm_display.h"
 #include "drm_v4l2_buffer.h"
 #include "drm_bo_buffer.h"
+#include "startup_tracer.h"
 #include <drm_fourcc.h>
 
 #define DEFAULT_DRM_DEVICE "i915"
@@ -41,6 +42,7 @@ DrmDisplay::instance()
     SmartLock lock(_mutex);
     if (_instance.ptr())
         return _instance;
+    StartupPhase phase ("drm_display");
     _instance = new DrmDisplay;
     return _instance;
 }
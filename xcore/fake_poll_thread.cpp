@@ -20,6 +20,7 @@
 
 #include "fake_poll_thread.h"
 #include "drm_bo_buffer.h"
+#include "perf_counters.h"
 
 #define DEFAULT_FPT_BUF_COUNT 4
 
@@ -53,13 +54,28 @@ FakePollThread::start()
         XCAM_RETURN_ERROR_FILE,
         "FakePollThread failed due to raw path NULL");
 
-    _raw = fopen (_raw_path, "rb");
+    // restart continues reading where the last run stopped
+    if (!_raw)
+        _raw = fopen (_raw_path, "rb");
     XCAM_FAIL_RETURN(
         ERROR,
         _raw,
         XCAM_RETURN_ERROR_FILE,
         "FakePollThread failed to open file:%s", XCAM_STR (_raw_path));
 
+    if (_buf_pool.ptr ()) {
+        struct v4l2_format format;
+        const VideoBufferInfo &info = _buf_pool->get_video_info ();
+        if (_capture_dev.ptr () &&
+                _capture_dev->get_format (format) == XCAM_RETURN_NO_ERROR &&
+                format.fmt.pix.pixelformat == info.format &&
+                format.fmt.pix.width == info.width &&
+                format.fmt.pix.height == info.height)
+            _buf_pool->resume ();
+        else
+            _buf_pool.release ();
+    }
+
     return PollThread::start ();
 }
 
@@ -73,6 +89,22 @@ FakePollThread::stop ()
     return XCAM_RETURN_NO_ERROR;
 }
 
+void
+FakePollThread::introspect (IntrospectionWriter &writer)
+{
+    PollThread::introspect (writer);
+
+#if HAVE_LIBDRM
+    SmartPtr<DrmBoBufferPool> pool = _buf_pool;
+    if (pool.ptr ()) {
+        writer.begin_object ("buffer_pool");
+        writer.add ("allocated", pool->get_allocated_count ());
+        writer.add ("free", pool->get_free_count ());
+        writer.end_object ();
+    }
+#endif
+}
+
 XCamReturn
 FakePollThread::read_buf (SmartPtr<DrmBoBuffer> &buf)
 {
@@ -80,6 +112,7 @@ FakePollThread::read_buf (SmartPtr<DrmBoBuffer> &buf)
     const VideoBufferInfo info = buf->get_video_info ();
     VideoBufferPlanarInfo planar;
     XCamReturn ret = XCAM_RETURN_NO_ERROR;
+    PerfStage perf_stage ("copy", "raw_read");
 
     for (uint32_t index = 0; index < info.components; index++) {
         info.get_planar_info(planar, index);
@@ -38,6 +38,9 @@ public:
     virtual XCamReturn start();
     virtual XCamReturn stop ();
 
+    //derived from PollThread
+    virtual void introspect (IntrospectionWriter &writer);
+
 protected:
     virtual XCamReturn poll_buffer_loop ();
 
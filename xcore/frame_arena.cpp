@@ -0,0 +1,183 @@
+/*
+ * frame_arena.cpp - per-frame arena for transient pipeline objects
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#include "frame_arena.h"
+#include "xcam_mutex.h"
+#include <vector>
+
+// keeps the object behind it 16 bytes aligned
+#define XCAM_ARENA_HEADER_SIZE 16
+#define XCAM_ARENA_ALIGN(size) (((size) + 15) & ~((size_t)15))
+
+namespace XCam {
+
+struct ArenaHeader {
+    FrameArena   *arena;  // NULL, allocated from heap
+};
+
+static __thread FrameArena *current_arena = NULL;
+
+class FrameArenaPool
+{
+public:
+    FrameArenaPool () : created (0) {}
+    ~FrameArenaPool () {
+        for (uint32_t i = 0; i < free_list.size (); ++i)
+            delete free_list[i];
+    }
+
+    Mutex                       mutex;
+    std::vector<FrameArena *>   free_list;
+    uint32_t                    created;
+};
+
+static FrameArenaPool              arena_pool;
+static std::atomic<uint64_t>       arena_alloc_count (0);
+static std::atomic<uint64_t>       heap_alloc_count (0);
+
+RefCount *
+arena_object_ref_count (ArenaObject *obj)
+{
+    return &obj->_arena_ref;
+}
+
+FrameArena::FrameArena ()
+    : _memory (NULL)
+    , _offset (0)
+    , _ref_count (0)
+{
+    _memory = (uint8_t *) xcam_malloc (XCAM_FRAME_ARENA_SIZE);
+    XCAM_ASSERT (_memory);
+}
+
+FrameArena::~FrameArena ()
+{
+    xcam_free (_memory);
+}
+
+FrameArena *
+FrameArena::acquire ()
+{
+    FrameArena *arena = NULL;
+    {
+        SmartLock locker (arena_pool.mutex);
+        if (!arena_pool.free_list.empty ()) {
+            arena = arena_pool.free_list.back ();
+            arena_pool.free_list.pop_back ();
+        } else
+            ++arena_pool.created;
+    }
+
+    if (!arena)
+        arena = new FrameArena;
+    arena->_offset = 0;
+    arena->_ref_count = 1;
+    return arena;
+}
+
+void *
+FrameArena::bump (size_t size)
+{
+    if (!_memory)
+        return NULL;
+
+    size_t offset = _offset.fetch_add (size);
+    if (offset + size > XCAM_FRAME_ARENA_SIZE)
+        return NULL;
+
+    ++_ref_count;
+    return _memory + offset;
+}
+
+void
+FrameArena::unref ()
+{
+    if (--_ref_count)
+        return;
+
+    // last object of a finished frame, any thread
+    SmartLock locker (arena_pool.mutex);
+    arena_pool.free_list.push_back (this);
+}
+
+// NULL when the heap fallback fails too, never throws
+void *
+FrameArena::allocate (size_t size)
+{
+    size_t total = XCAM_ARENA_ALIGN (size) + XCAM_ARENA_HEADER_SIZE;
+    FrameArena *arena = current_arena;
+    uint8_t *mem = NULL;
+
+    if (arena && (mem = (uint8_t *) arena->bump (total)) != NULL) {
+        ++arena_alloc_count;
+    } else {
+        arena = NULL;
+        mem = (uint8_t *) xcam_malloc (total);
+        if (!mem) {
+            XCAM_LOG_ERROR ("frame arena: heap allocation of %d bytes failed", (int)total);
+            return NULL;
+        }
+        ++heap_alloc_count;
+    }
+
+    ((ArenaHeader *) mem)->arena = arena;
+    return mem + XCAM_ARENA_HEADER_SIZE;
+}
+
+void
+FrameArena::free (void *ptr)
+{
+    if (!ptr)
+        return;
+
+    uint8_t *mem = (uint8_t *) ptr - XCAM_ARENA_HEADER_SIZE;
+    FrameArena *arena = ((ArenaHeader *) mem)->arena;
+    if (arena)
+        arena->unref ();
+    else
+        xcam_free (mem);
+}
+
+void
+FrameArena::get_stats (FrameArenaStats &stats)
+{
+    stats.arena_allocs = arena_alloc_count;
+    stats.heap_allocs = heap_alloc_count;
+
+    SmartLock locker (arena_pool.mutex);
+    stats.arenas_created = arena_pool.created;
+    stats.arenas_free = arena_pool.free_list.size ();
+}
+
+FrameArenaScope::FrameArenaScope ()
+    : _arena (FrameArena::acquire ())
+    , _previous (current_arena)
+{
+    current_arena = _arena;
+}
+
+FrameArenaScope::~FrameArenaScope ()
+{
+    XCAM_ASSERT (current_arena == _arena);
+    current_arena = _previous;
+    _arena->unref ();
+}
+
+};
@@ -0,0 +1,127 @@
+/*
+ * frame_arena.h - per-frame arena for transient pipeline objects
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#ifndef XCAM_FRAME_ARENA_H
+#define XCAM_FRAME_ARENA_H
+
+#include "xcam_utils.h"
+#include "smartptr.h"
+#include <atomic>
+
+#define XCAM_FRAME_ARENA_SIZE (64 * 1024)
+
+namespace XCam {
+
+struct FrameArenaStats {
+    uint64_t   arena_allocs;    // objects placed in an arena
+    uint64_t   heap_allocs;     // no arena in scope, or arena full
+    uint32_t   arenas_created;
+    uint32_t   arenas_free;
+};
+
+/*
+ * FrameArena, bump allocator shared by objects created while one frame is
+ * handled. Allocation is an atomic add; frees only count down. The arena
+ * goes back to the pool when its FrameArenaScope ended and every object
+ * in it died, on whichever thread drops the last one.
+ */
+class FrameArena
+{
+public:
+    static void *allocate (size_t size);
+    static void free (void *ptr);
+    static void get_stats (FrameArenaStats &stats);
+
+private:
+    friend class FrameArenaScope;
+    friend class FrameArenaPool;
+
+    explicit FrameArena ();
+    ~FrameArena ();
+
+    static FrameArena *acquire ();
+    void *bump (size_t size);
+    void unref ();
+
+    XCAM_DEAD_COPY (FrameArena);
+
+private:
+    uint8_t                  *_memory;
+    std::atomic<size_t>       _offset;
+    std::atomic<uint32_t>     _ref_count;
+};
+
+/*
+ * FrameArenaScope, ArenaObjects created on this thread while in scope go
+ * to one arena; put around the per-frame body of a thread loop
+ */
+class FrameArenaScope
+{
+public:
+    explicit FrameArenaScope ();
+    ~FrameArenaScope ();
+
+private:
+    XCAM_DEAD_COPY (FrameArenaScope);
+
+private:
+    FrameArena     *_arena;
+    FrameArena     *_previous;
+};
+
+/*
+ * ArenaObject, base of per-frame bookkeeping objects
+ * new/delete go through the current frame arena, heap outside a scope or
+ * when the arena is full; new returns NULL if that fails, check it.
+ * SmartPtr uses the embedded ref count instead of allocating one.
+ * Derived objects must not outlive a few frames or they pin their arena.
+ */
+class ArenaObject
+{
+    friend RefCount *arena_object_ref_count (ArenaObject *obj);
+
+public:
+    // non-throwing, so a NULL result skips the constructor
+    static void *operator new (size_t size) throw () {
+        return FrameArena::allocate (size);
+    }
+    static void operator delete (void *ptr) throw () {
+        FrameArena::free (ptr);
+    }
+
+protected:
+    ArenaObject ()
+        : _arena_ref (true)
+    {}
+    // a copy is a new object, never shares the count
+    ArenaObject (const ArenaObject &)
+        : _arena_ref (true)
+    {}
+    ArenaObject &operator = (const ArenaObject &) {
+        return *this;
+    }
+
+private:
+    RefCount         _arena_ref;
+};
+
+};
+
+#endif //XCAM_FRAME_ARENA_H
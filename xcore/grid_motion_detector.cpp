@@ -0,0 +1,235 @@
+/*
+ * grid_motion_detector.cpp - motion detection on 3a statistics grids
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#include "grid_motion_detector.h"
+#include "perf_counters.h"
+#include <math.h>
+#include <algorithm>
+
+// background of moving grids follows this much slower, stopped objects fade in
+#define MOTION_BACKGROUND_SLOW_FACTOR 0.1f
+// grids darker than this are left out of the global gain
+#define MOTION_GAIN_MIN_LUMA 8.0f
+
+namespace XCam {
+
+GridMotionDetector::GridMotionDetector ()
+    : _threshold (4.0f)
+    , _background_rate (0.05f)
+    , _noise_floor (1.5f)
+    , _min_grids (2)
+    , _hold_frames (15)
+    , _grid_width (0)
+    , _grid_height (0)
+    , _frames (0)
+    , _active (false)
+    , _quiet_frames (0)
+{
+}
+
+bool
+GridMotionDetector::set_threshold (float threshold)
+{
+    XCAM_FAIL_RETURN (WARNING, threshold > 0.0f, false, "motion threshold:%f invalid", threshold);
+
+    SmartLock locker (_mutex);
+    _threshold = threshold;
+    return true;
+}
+
+bool
+GridMotionDetector::set_background_rate (float rate)
+{
+    XCAM_FAIL_RETURN (WARNING, rate > 0.0f && rate <= 1.0f, false, "motion background rate:%f invalid", rate);
+
+    SmartLock locker (_mutex);
+    _background_rate = rate;
+    return true;
+}
+
+bool
+GridMotionDetector::set_noise_floor (float floor)
+{
+    XCAM_FAIL_RETURN (WARNING, floor >= 0.0f, false, "motion noise floor:%f invalid", floor);
+
+    SmartLock locker (_mutex);
+    _noise_floor = floor;
+    return true;
+}
+
+bool
+GridMotionDetector::set_event_params (uint32_t min_grids, uint32_t hold_frames)
+{
+    XCAM_FAIL_RETURN (WARNING, min_grids > 0, false, "motion event min grids can't be 0");
+
+    SmartLock locker (_mutex);
+    _min_grids = min_grids;
+    _hold_frames = hold_frames;
+    return true;
+}
+
+void
+GridMotionDetector::reset ()
+{
+    SmartLock locker (_mutex);
+    _frames = 0;
+    _active = false;
+    _quiet_frames = 0;
+}
+
+float
+GridMotionDetector::estimate_global_gain (const std::vector<float> &luma) const
+{
+    std::vector<float> ratios;
+    ratios.reserve (luma.size ());
+    for (uint32_t i = 0; i < luma.size (); ++i) {
+        if (_background[i] >= MOTION_GAIN_MIN_LUMA && luma[i] >= MOTION_GAIN_MIN_LUMA)
+            ratios.push_back (luma[i] / _background[i]);
+    }
+    if (ratios.empty ())
+        return 1.0f;
+
+    // median, moving objects hardly shift it
+    std::vector<float>::iterator middle = ratios.begin () + ratios.size () / 2;
+    std::nth_element (ratios.begin (), middle, ratios.end ());
+    return XCAM_MIN (XCAM_MAX (*middle, 0.25f), 4.0f);
+}
+
+XCamMotionEvent
+GridMotionDetector::update_event (uint32_t motion_grids)
+{
+    if (motion_grids >= _min_grids) {
+        _quiet_frames = 0;
+        if (_active)
+            return XCAM_MOTION_EVENT_ACTIVE;
+        _active = true;
+        XCAM_LOG_INFO ("motion started, %d grids", motion_grids);
+        return XCAM_MOTION_EVENT_START;
+    }
+
+    if (!_active)
+        return XCAM_MOTION_EVENT_NONE;
+    if (++_quiet_frames < _hold_frames)
+        return XCAM_MOTION_EVENT_ACTIVE;
+
+    _active = false;
+    _quiet_frames = 0;
+    XCAM_LOG_INFO ("motion stopped");
+    return XCAM_MOTION_EVENT_STOP;
+}
+
+SmartPtr<X3aMotionResult>
+GridMotionDetector::detect (const XCam3AStats *stats)
+{
+    XCAM_ASSERT (stats);
+    const XCam3AStatsInfo &info = stats->info;
+    uint32_t count = info.width * info.height;
+    uint32_t bit_depth = (info.bit_depth ? info.bit_depth : 8);
+    float to_8bit = 255.0f / ((1 << bit_depth) - 1);
+    std::vector<float> luma (count);
+    PerfStage perf_stage ("stats", "grid_motion");
+
+    XCAM_FAIL_RETURN (
+        WARNING,
+        count && info.aligned_width >= info.width,
+        NULL,
+        "motion detect on invalid grids(%dx%d)", info.width, info.height);
+
+    SmartLock locker (_mutex);
+    if (info.width != _grid_width || info.height != _grid_height) {
+        _grid_width = info.width;
+        _grid_height = info.height;
+        _background.resize (count);
+        _variance.resize (count);
+        _frames = 0;
+        _active = false;
+        _quiet_frames = 0;
+    }
+
+    for (uint32_t y = 0; y < info.height; ++y)
+        for (uint32_t x = 0; x < info.width; ++x)
+            luma[y * info.width + x] = stats->stats[y * info.aligned_width + x].avg_y * to_8bit;
+
+    // running mean and variance while learning
+    if (_frames < XCAM_MOTION_WARMUP_FRAMES) {
+        float rate = 1.0f / (_frames + 1);
+        for (uint32_t i = 0; i < count; ++i) {
+            float diff = (_frames ? luma[i] - _background[i] : 0.0f);
+            _background[i] += diff * rate;
+            _variance[i] = (_frames ? _variance[i] + (diff * diff - _variance[i]) * rate : 0.0f);
+        }
+        ++_frames;
+        return NULL;
+    }
+
+    SmartPtr<X3aMotionResult> result = new X3aMotionResult (info.width, info.height);
+    XCamMotionResult &motion = result->get_standard_result ();
+    std::vector<float> diff (count), limit (count);
+    float inv_gain = 1.0f / estimate_global_gain (luma);
+    float floor2 = _noise_floor * _noise_floor;
+
+    for (uint32_t i = 0; i < count; ++i) {
+        luma[i] *= inv_gain;
+        diff[i] = fabsf (luma[i] - _background[i]);
+        limit[i] = _threshold * sqrtf (_variance[i] + floor2);
+        motion.mask[i] = (diff[i] > limit[i] ? 1 : 0);
+    }
+
+    // drop isolated grids unless strong, then fill levels
+    uint32_t motion_grids = 0;
+    for (int32_t y = 0; y < (int32_t)info.height; ++y) {
+        for (int32_t x = 0; x < (int32_t)info.width; ++x) {
+            uint32_t i = y * info.width + x;
+            if (!motion.mask[i])
+                continue;
+
+            bool neighbor = false;
+            for (int32_t ny = XCAM_MAX (y - 1, 0); ny <= XCAM_MIN (y + 1, (int32_t)info.height - 1) && !neighbor; ++ny)
+                for (int32_t nx = XCAM_MAX (x - 1, 0); nx <= XCAM_MIN (x + 1, (int32_t)info.width - 1); ++nx) {
+                    if ((nx != x || ny != y) && motion.mask[ny * info.width + nx]) {
+                        neighbor = true;
+                        break;
+                    }
+                }
+            if (!neighbor && diff[i] < limit[i] * 2.0f) {
+                motion.mask[i] = 0;
+                continue;
+            }
+            ++motion_grids;
+        }
+    }
+
+    for (uint32_t i = 0; i < count; ++i) {
+        float rate = _background_rate;
+        if (motion.mask[i]) {
+            motion.mask[i] = (uint8_t)XCAM_MIN (diff[i] / limit[i] * 128.0f, 255.0f);
+            rate *= MOTION_BACKGROUND_SLOW_FACTOR;
+        } else
+            _variance[i] += (diff[i] * diff[i] - _variance[i]) * rate;
+        _background[i] += (luma[i] - _background[i]) * rate;
+    }
+
+    motion.grid_pixel_size = info.grid_pixel_size;
+    motion.motion_grids = motion_grids;
+    motion.event = update_event (motion_grids);
+    return result;
+}
+
+};
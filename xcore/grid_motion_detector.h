@@ -0,0 +1,85 @@
+/*
+ * grid_motion_detector.h - motion detection on 3a statistics grids
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#ifndef XCAM_GRID_MOTION_DETECTOR_H
+#define XCAM_GRID_MOTION_DETECTOR_H
+
+#include "xcam_utils.h"
+#include "xcam_mutex.h"
+#include "x3a_result.h"
+#include <base/xcam_3a_stats.h>
+#include <vector>
+
+#define XCAM_MOTION_WARMUP_FRAMES 8
+
+namespace XCam {
+
+/*
+ * GridMotionDetector
+ * temporal difference of avg_y on every grid against an adaptive background,
+ * no pixel access. Global brightness changes (AE) are removed by the median
+ * ratio of frame to background. A grid moves when its difference exceeds
+ * threshold * sqrt(temporal variance + noise_floor^2), isolated weak grids
+ * are dropped. Luma is normalized to 8 bits before all of these.
+ */
+class GridMotionDetector
+{
+public:
+    explicit GridMotionDetector ();
+
+    // in sigma of grid noise, default 4.0
+    bool set_threshold (float threshold);
+    // background blending of still grids each frame, default 0.05
+    bool set_background_rate (float rate);
+    // noise floor in 8 bit luma, default 1.5
+    bool set_noise_floor (float floor);
+    // moving grids to start an event and quiet frames to stop it, default 2, 15
+    bool set_event_params (uint32_t min_grids, uint32_t hold_frames);
+    void reset ();
+
+    // NULL while learning background
+    SmartPtr<X3aMotionResult> detect (const XCam3AStats *stats);
+
+private:
+    float estimate_global_gain (const std::vector<float> &luma) const;
+    XCamMotionEvent update_event (uint32_t motion_grids);
+
+    XCAM_DEAD_COPY (GridMotionDetector);
+
+private:
+    Mutex                  _mutex;
+    float                  _threshold;
+    float                  _background_rate;
+    float                  _noise_floor;
+    uint32_t               _min_grids;
+    uint32_t               _hold_frames;
+
+    uint32_t               _grid_width;
+    uint32_t               _grid_height;
+    uint32_t               _frames;
+    std::vector<float>     _background;
+    std::vector<float>     _variance;
+    bool                   _active;
+    uint32_t               _quiet_frames;
+};
+
+};
+
+#endif //XCAM_GRID_MOTION_DETECTOR_H
@@ -23,6 +23,7 @@
 #include "x3a_analyzer_aiq.h"
 #include "x3a_statistics_queue.h"
 #include "aiq3a_utils.h"
+#include "perf_counters.h"
 #include <math.h>
 
 namespace XCam {
@@ -123,7 +124,10 @@ HybridAnalyzer::convert_to_isp_stats (SmartPtr<X3aStats>& stats)
 
     struct atomisp_3a_statistics *to = isp_stats->get_isp_stats ();
     XCam3AStats *from = stats->get_stats ();
-    translate_3a_stats (from, to);
+    {
+        PerfStage perf_stage ("stats", "translate_isp");
+        translate_3a_stats (from, to);
+    }
     isp_stats->set_timestamp (stats->get_timestamp ());
     return isp_stats;
 }
@@ -20,6 +20,8 @@
 
 #include "image_processor.h"
 #include "xcam_thread.h"
+#include "frame_arena.h"
+#include "xcam_probes.h"
 
 namespace XCam {
 
@@ -48,6 +50,19 @@ ImageProcessCallback::process_buffer_failed (ImageProcessor *processor, const Sm
         XCAM_TIMESTAMP_ARGS (ts));
 }
 
+void
+ImageProcessCallback::process_buffer_dropped (ImageProcessor *processor, const SmartPtr<VideoBuffer> &buf)
+{
+    XCAM_ASSERT (buf.ptr() && processor);
+
+    int64_t ts = buf->get_timestamp();
+    XCAM_UNUSED (ts);
+    XCAM_LOG_DEBUG (
+        "processor(%s) dropped buffer(" XCAM_TIMESTAMP_FORMAT ")",
+        XCAM_STR(processor->get_name()),
+        XCAM_TIMESTAMP_ARGS (ts));
+}
+
 void
 ImageProcessCallback::process_image_result_done (ImageProcessor *processor, const SmartPtr<X3aResult> &result)
 {
@@ -103,6 +118,9 @@ public:
         return XCAM_RETURN_NO_ERROR;
     }
 
+    void triger_start () {
+        _queue.resume_pop ();
+    }
     void triger_stop () {
         _queue.pause_pop ();
     }
@@ -138,6 +156,9 @@ bool X3aResultsProcessThread::loop ()
 ImageProcessor::ImageProcessor (const char* name)
     : _name (NULL)
     , _callback (NULL)
+    , _input_type (InputPrevious)
+    , _input_processor (NULL)
+    , _prepared (false)
 {
     if (name)
         _name = strndup (name, XCAM_MAX_STR_SIZE);
@@ -155,15 +176,48 @@ ImageProcessor::~ImageProcessor ()
 bool
 ImageProcessor::set_callback (ImageProcessCallback *callback)
 {
-    XCAM_ASSERT (!_callback);
+    // set again by the process center on each start
+    XCAM_ASSERT (!_callback || _callback == callback);
     _callback = callback;
     return true;
 }
 
+bool
+ImageProcessor::set_input (InputType type, ImageProcessor *source)
+{
+    XCAM_FAIL_RETURN (
+        WARNING, (type == InputProcessor) == (source != NULL) && source != this, false,
+        "ImageProcessor(%s) input type(%d) mismatch with source", XCAM_STR (_name), type);
+
+    _input_type = type;
+    _input_processor = source;
+    return true;
+}
+
+XCamReturn
+ImageProcessor::prepare ()
+{
+    if (_prepared)
+        return XCAM_RETURN_NO_ERROR;
+
+    XCamReturn ret = emit_prepare ();
+    XCAM_FAIL_RETURN (
+        WARNING, ret == XCAM_RETURN_NO_ERROR, ret,
+        "ImageProcessor(%s) prepare failed", XCAM_STR (_name));
+    _prepared = true;
+    return XCAM_RETURN_NO_ERROR;
+}
+
 XCamReturn
 ImageProcessor::start()
 {
-    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+    XCamReturn ret = prepare ();
+    if (ret != XCAM_RETURN_NO_ERROR)
+        return ret;
+
+    // queues were paused by a previous stop
+    _video_buf_queue.resume_pop ();
+    _results_thread->triger_start ();
     if (!_results_thread->start ()) {
         return XCAM_RETURN_ERROR_THREAD;
     }
@@ -257,6 +311,9 @@ ImageProcessor::process_3a_results (X3aResultList &results)
         XCAM_LOG_WARNING ("processor(%s) apply results failed", XCAM_STR(get_name()));
         return ret;
     }
+    XCAM_PROBE3 (
+        results_applied, XCAM_STR (get_name ()),
+        valid_results.size (), valid_results.front ()->get_timestamp ());
 
     if (_callback) {
         for (X3aResultList::iterator i_res = valid_results.begin();
@@ -284,6 +341,7 @@ ImageProcessor::process_3a_result (SmartPtr<X3aResult> &result)
         XCAM_LOG_WARNING ("processor(%s) apply result failed", XCAM_STR(get_name()));
         return ret;
     }
+    XCAM_PROBE3 (results_applied, XCAM_STR (get_name ()), 1, result->get_timestamp ());
 
     if (_callback) {
         _callback->process_image_result_done (this, result);
@@ -299,7 +357,7 @@ ImageProcessor::filter_valid_results (X3aResultList &input, X3aResultList &valid
         SmartPtr<X3aResult> &res = *i_res;
         if (can_process_result(res)) {
             valid_results.push_back (res);
-            input.erase (i_res++);
+            i_res = input.erase (i_res);
         } else
             ++i_res;
     }
@@ -319,6 +377,13 @@ ImageProcessor::notify_process_buffer_failed (const SmartPtr<VideoBuffer> &buf)
         _callback->process_buffer_failed (this, buf);
 }
 
+void
+ImageProcessor::notify_process_buffer_dropped (const SmartPtr<VideoBuffer> &buf)
+{
+    if (_callback)
+        _callback->process_buffer_dropped (this, buf);
+}
+
 XCamReturn
 ImageProcessor::buffer_process_loop ()
 {
@@ -329,19 +394,41 @@ ImageProcessor::buffer_process_loop ()
     if (!buf.ptr())
         return XCAM_RETURN_ERROR_MEM;
 
+    FrameArenaScope arena_scope;
+    struct timeval start;
+    gettimeofday (&start, NULL);
     ret = this->process_buffer (buf, new_buf);
+    _process_duration.add (start);
     if (ret < XCAM_RETURN_NO_ERROR) {
+        // only this frame is lost, keep the thread for the next ones
         XCAM_LOG_DEBUG ("processing buffer failed");
         notify_process_buffer_failed (buf);
-        return ret;
+        return XCAM_RETURN_NO_ERROR;
     }
 
+    // no output: async processors notify later, others report drops themselves
     if (new_buf.ptr ())
         notify_process_buffer_done (new_buf);
 
     return XCAM_RETURN_NO_ERROR;
 }
 
+void
+ImageProcessor::introspect (IntrospectionWriter &writer)
+{
+    writer.add ("name", XCAM_STR (_name));
+    writer.add ("input_queue", _video_buf_queue.size ());
+    writer.begin_object ("process");
+    _process_duration.introspect (writer);
+    writer.end_object ();
+}
+
+XCamReturn
+ImageProcessor::emit_prepare ()
+{
+    return XCAM_RETURN_NO_ERROR;
+}
+
 XCamReturn
 ImageProcessor::emit_start ()
 {
@@ -26,6 +26,7 @@
 #include "x3a_result.h"
 #include "smartptr.h"
 #include "safe_list.h"
+#include "introspection.h"
 
 namespace XCam {
 
@@ -38,6 +39,8 @@ public:
     virtual ~ImageProcessCallback () {}
     virtual void process_buffer_done (ImageProcessor *processor, const SmartPtr<VideoBuffer> &buf);
     virtual void process_buffer_failed (ImageProcessor *processor, const SmartPtr<VideoBuffer> &buf);
+    // frame consumed without output and without error, e.g. a handler bypassed it
+    virtual void process_buffer_dropped (ImageProcessor *processor, const SmartPtr<VideoBuffer> &buf);
     virtual void process_image_result_done (ImageProcessor *processor, const SmartPtr<X3aResult> &result);
 
 private:
@@ -49,12 +52,21 @@ class X3aResultsProcessThread;
 
 /* base class, ImageProcessor */
 class ImageProcessor
+    : public Introspectable
 {
     friend class ImageProcessorThread;
     friend class X3aResultsProcessThread;
 
     typedef SafeList<VideoBuffer> VideoBufQueue;
 
+public:
+    // frame fed by X3aImageProcessCenter
+    enum InputType {
+        InputPrevious = 0,  // output of processor inserted before, default
+        InputCapture,       // capture frame, runs beside the other processors
+        InputProcessor,     // output of given processor, inserted before
+    };
+
 public:
     explicit ImageProcessor (const char* name);
     virtual ~ImageProcessor ();
@@ -64,6 +76,20 @@ public:
     }
 
     bool set_callback (ImageProcessCallback *callback);
+    // input buffer is shared with other processors of the same source, read only
+    bool set_input (InputType type, ImageProcessor *source = NULL);
+    InputType get_input_type () const {
+        return _input_type;
+    }
+    ImageProcessor *get_input_processor () const {
+        return _input_processor;
+    }
+    // one-time setup (device probing, kernel builds), done once;
+    // may run on a helper thread before start, else start does it
+    XCamReturn prepare ();
+    bool is_prepared () const {
+        return _prepared;
+    }
     XCamReturn start();
     XCamReturn stop ();
 
@@ -71,18 +97,23 @@ public:
     XCamReturn push_3a_results (X3aResultList &results);
     XCamReturn push_3a_result (SmartPtr<X3aResult> &result);
 
+    //derived from Introspectable
+    virtual void introspect (IntrospectionWriter &writer);
+
 protected:
     virtual bool can_process_result (SmartPtr<X3aResult> &result) = 0;
     virtual XCamReturn apply_3a_results (X3aResultList &results) = 0;
     virtual XCamReturn apply_3a_result (SmartPtr<X3aResult> &result) = 0;
     // buffer runs in another thread
     virtual XCamReturn process_buffer(SmartPtr<VideoBuffer> &input, SmartPtr<VideoBuffer> &output) = 0;
+    virtual XCamReturn emit_prepare ();
     virtual XCamReturn emit_start ();
     virtual void emit_stop ();
 
 
     void notify_process_buffer_done (const SmartPtr<VideoBuffer> &buf);
     void notify_process_buffer_failed (const SmartPtr<VideoBuffer> &buf);
+    void notify_process_buffer_dropped (const SmartPtr<VideoBuffer> &buf);
 
 private:
     void filter_valid_results (X3aResultList &input, X3aResultList &valid_results);
@@ -97,9 +128,13 @@ private:
 protected:
     char                               *_name;
     ImageProcessCallback               *_callback;
+    InputType                           _input_type;
+    ImageProcessor                     *_input_processor;
+    bool                                _prepared;
     SmartPtr<ImageProcessorThread>      _processor_thread;
     VideoBufQueue                       _video_buf_queue;
     SmartPtr<X3aResultsProcessThread>   _results_thread;
+    DurationStats                       _process_duration;
 };
 
 };
@@ -0,0 +1,475 @@
+/*
+ * introspection.cpp - runtime introspection of live pipeline state
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#include "introspection.h"
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <inttypes.h>
+
+#define XCAM_INTROSPECTION_MAX_REQUEST 128
+// a client not sending its request line in time is dropped
+#define XCAM_INTROSPECTION_CLIENT_TIMEOUT 200 // ms
+
+namespace XCam {
+
+IntrospectionWriter::IntrospectionWriter ()
+{
+    _text.reserve (4096);
+}
+
+void
+IntrospectionWriter::add_string (const char *str)
+{
+    _text += '"';
+    for (; str && *str; ++str) {
+        char c = *str;
+        if (c == '"' || c == '\\') {
+            _text += '\\';
+            _text += c;
+        } else if ((unsigned char)c < 0x20) {
+            char escaped[8];
+            snprintf (escaped, sizeof (escaped), "\\u%04x", (unsigned char)c);
+            _text += escaped;
+        } else
+            _text += c;
+    }
+    _text += '"';
+}
+
+void
+IntrospectionWriter::add_key (const char *key)
+{
+    if (_first_member.empty ())
+        return;
+
+    if (!_first_member.back ())
+        _text += ',';
+    _first_member.back () = false;
+
+    if (key) {
+        add_string (key);
+        _text += ':';
+    }
+}
+
+void
+IntrospectionWriter::begin_object (const char *key)
+{
+    add_key (key);
+    _text += '{';
+    _first_member.push_back (true);
+}
+
+void
+IntrospectionWriter::end_object ()
+{
+    XCAM_ASSERT (!_first_member.empty ());
+    _first_member.pop_back ();
+    _text += '}';
+}
+
+void
+IntrospectionWriter::begin_array (const char *key)
+{
+    add_key (key);
+    _text += '[';
+    _first_member.push_back (true);
+}
+
+void
+IntrospectionWriter::end_array ()
+{
+    XCAM_ASSERT (!_first_member.empty ());
+    _first_member.pop_back ();
+    _text += ']';
+}
+
+void
+IntrospectionWriter::add (const char *key, const char *value)
+{
+    add_key (key);
+    if (value)
+        add_string (value);
+    else
+        _text += "null";
+}
+
+void
+IntrospectionWriter::add (const char *key, bool value)
+{
+    add_key (key);
+    _text += (value ? "true" : "false");
+}
+
+void
+IntrospectionWriter::add (const char *key, int32_t value)
+{
+    add (key, (int64_t)value);
+}
+
+void
+IntrospectionWriter::add (const char *key, uint32_t value)
+{
+    add (key, (uint64_t)value);
+}
+
+void
+IntrospectionWriter::add (const char *key, int64_t value)
+{
+    char str[32];
+    snprintf (str, sizeof (str), "%" PRId64, value);
+    add_key (key);
+    _text += str;
+}
+
+void
+IntrospectionWriter::add (const char *key, uint64_t value)
+{
+    char str[32];
+    snprintf (str, sizeof (str), "%" PRIu64, value);
+    add_key (key);
+    _text += str;
+}
+
+void
+IntrospectionWriter::add (const char *key, double value)
+{
+    char str[32];
+    // json has no nan/inf
+    if (value != value || value > 1e300 || value < -1e300)
+        snprintf (str, sizeof (str), "null");
+    else
+        snprintf (str, sizeof (str), "%.4g", value);
+    add_key (key);
+    _text += str;
+}
+
+DurationStats::DurationStats ()
+    : _count (0)
+    , _sum_ms (0.0)
+    , _last_ms (0.0)
+    , _max_ms (0.0)
+{
+}
+
+void
+DurationStats::add (const struct timeval &start)
+{
+    struct timeval end;
+    gettimeofday (&end, NULL);
+
+    double ms = (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_usec - start.tv_usec) / 1000.0;
+    ++_count;
+    _sum_ms += ms;
+    _last_ms = ms;
+    if (ms > _max_ms)
+        _max_ms = ms;
+}
+
+void
+DurationStats::introspect (IntrospectionWriter &writer) const
+{
+    uint64_t count = _count;
+
+    writer.add ("count", count);
+    writer.add ("avg_ms", count ? _sum_ms / count : 0.0);
+    writer.add ("last_ms", _last_ms);
+    writer.add ("max_ms", _max_ms);
+}
+
+SmartPtr<IntrospectionServer> IntrospectionServer::_instance;
+Mutex IntrospectionServer::_instance_mutex;
+
+SmartPtr<IntrospectionServer>
+IntrospectionServer::instance ()
+{
+    SmartLock locker (_instance_mutex);
+    if (_instance.ptr ())
+        return _instance;
+
+    _instance = new IntrospectionServer ();
+    return _instance;
+}
+
+IntrospectionServer::IntrospectionServer ()
+    : Thread ("introspection")
+    , _listen_fd (-1)
+{
+    _wakeup_fds[0] = _wakeup_fds[1] = -1;
+}
+
+IntrospectionServer::~IntrospectionServer ()
+{
+    stop_server ();
+}
+
+bool
+IntrospectionServer::register_component (const char *name, Introspectable *component)
+{
+    XCAM_ASSERT (name && component);
+
+    SmartLock locker (_components_mutex);
+    for (ComponentList::iterator i = _components.begin (); i != _components.end (); ++i) {
+        XCAM_FAIL_RETURN (
+            WARNING, i->name != name && i->component != component, false,
+            "introspection component(%s) already registered", name);
+    }
+
+    Component entry;
+    entry.name = name;
+    entry.component = component;
+    _components.push_back (entry);
+    return true;
+}
+
+void
+IntrospectionServer::unregister_component (Introspectable *component)
+{
+    // a running snapshot holds the mutex, component is not used after return
+    SmartLock locker (_components_mutex);
+    for (ComponentList::iterator i = _components.begin (); i != _components.end (); ++i) {
+        if (i->component == component) {
+            _components.erase (i);
+            return;
+        }
+    }
+}
+
+void
+IntrospectionServer::snapshot (IntrospectionWriter &writer, const char *name)
+{
+    struct timeval now;
+    gettimeofday (&now, NULL);
+
+    SmartLock locker (_components_mutex);
+    writer.begin_object ();
+    writer.add ("timestamp_us", (int64_t)now.tv_sec * 1000000 + now.tv_usec);
+    writer.begin_object ("components");
+    for (ComponentList::iterator i = _components.begin (); i != _components.end (); ++i) {
+        if (name && i->name != name)
+            continue;
+        writer.begin_object (i->name.c_str ());
+        i->component->introspect (writer);
+        writer.end_object ();
+    }
+    writer.end_object ();
+    writer.end_object ();
+}
+
+std::string
+IntrospectionServer::handle_request (const char *request)
+{
+    IntrospectionWriter writer;
+    char command[XCAM_INTROSPECTION_MAX_REQUEST] = {0};
+    char name[XCAM_INTROSPECTION_MAX_REQUEST] = {0};
+
+    if (request)
+        sscanf (request, "%127s %127s", command, name);
+
+    if (!strcmp (command, "list")) {
+        SmartLock locker (_components_mutex);
+        writer.begin_object ();
+        writer.begin_array ("components");
+        for (ComponentList::iterator i = _components.begin (); i != _components.end (); ++i)
+            writer.add (NULL, i->name.c_str ());
+        writer.end_array ();
+        writer.end_object ();
+    } else if (!strcmp (command, "state") || !command[0]) {
+        snapshot (writer, name[0] ? name : NULL);
+    } else {
+        writer.begin_object ();
+        if (strcmp (command, "help"))
+            writer.add ("error", "unknown command");
+        writer.add ("usage", "list | state [component]");
+        writer.end_object ();
+    }
+
+    return writer.get_text () + "\n";
+}
+
+XCamReturn
+IntrospectionServer::start_server (const char *socket_path)
+{
+    struct sockaddr_un addr;
+    struct stat st;
+
+    XCAM_FAIL_RETURN (
+        ERROR, socket_path && strlen (socket_path) < sizeof (addr.sun_path),
+        XCAM_RETURN_ERROR_PARAM, "introspection socket path invalid");
+
+    SmartLock locker (_server_mutex);
+    XCAM_FAIL_RETURN (
+        WARNING, _listen_fd < 0, XCAM_RETURN_ERROR_PARAM,
+        "introspection server already listening on %s", _socket_path.c_str ());
+
+    // only replace a stale socket, never a regular file
+    if (lstat (socket_path, &st) == 0) {
+        XCAM_FAIL_RETURN (
+            ERROR, S_ISSOCK (st.st_mode), XCAM_RETURN_ERROR_PARAM,
+            "introspection path %s exists and is not a socket", socket_path);
+        unlink (socket_path);
+    }
+
+    xcam_mem_clear (addr);
+    addr.sun_family = AF_UNIX;
+    strncpy (addr.sun_path, socket_path, sizeof (addr.sun_path) - 1);
+
+    // bind creates the socket node with umask permissions, so narrow the
+    // umask first; a chmod afterwards leaves a window where others can connect
+    _listen_fd = socket (AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    mode_t old_mask = umask (S_IXUSR | S_IRWXG | S_IRWXO);
+    int bind_ret = (_listen_fd < 0) ? -1 :
+                   bind (_listen_fd, (struct sockaddr *)&addr, sizeof (addr));
+    int bind_errno = errno;
+    umask (old_mask);
+    errno = bind_errno;
+
+    if (_listen_fd < 0 || bind_ret < 0 ||
+            listen (_listen_fd, 4) < 0 ||
+            pipe2 (_wakeup_fds, O_CLOEXEC | O_NONBLOCK) < 0) {
+        XCAM_LOG_ERROR ("introspection socket %s failed: %s", socket_path, strerror (errno));
+        close_sockets ();
+        unlink (socket_path);
+        return XCAM_RETURN_ERROR_IOCTL;
+    }
+    _socket_path = socket_path;
+
+    if (!start ()) {
+        XCAM_LOG_ERROR ("introspection thread start failed");
+        close_sockets ();
+        unlink (socket_path);
+        _socket_path.clear ();
+        return XCAM_RETURN_ERROR_THREAD;
+    }
+
+    XCAM_LOG_INFO ("introspection server listening on %s", socket_path);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+void
+IntrospectionServer::stop_server ()
+{
+    SmartLock locker (_server_mutex);
+    if (_listen_fd < 0)
+        return;
+
+    emit_stop ();
+    char wakeup = 0;
+    while (write (_wakeup_fds[1], &wakeup, 1) < 0 && errno == EINTR);
+    stop ();
+
+    close_sockets ();
+    unlink (_socket_path.c_str ());
+    _socket_path.clear ();
+}
+
+void
+IntrospectionServer::close_sockets ()
+{
+    if (_listen_fd >= 0)
+        close (_listen_fd);
+    if (_wakeup_fds[0] >= 0)
+        close (_wakeup_fds[0]);
+    if (_wakeup_fds[1] >= 0)
+        close (_wakeup_fds[1]);
+    _listen_fd = -1;
+    _wakeup_fds[0] = _wakeup_fds[1] = -1;
+}
+
+bool
+IntrospectionServer::loop ()
+{
+    struct pollfd fds[2];
+    fds[0].fd = _listen_fd;
+    fds[0].events = POLLIN;
+    fds[1].fd = _wakeup_fds[0];
+    fds[1].events = POLLIN;
+
+    int ret = poll (fds, 2, -1);
+    if (ret < 0)
+        return (errno == EINTR);
+
+    if (fds[1].revents)
+        return false;
+
+    if (fds[0].revents & POLLIN) {
+        int client = accept4 (_listen_fd, NULL, NULL, SOCK_CLOEXEC);
+        if (client >= 0) {
+            serve_client (client);
+            close (client);
+        }
+    }
+    return true;
+}
+
+void
+IntrospectionServer::serve_client (int fd)
+{
+    char request[XCAM_INTROSPECTION_MAX_REQUEST];
+    uint32_t length = 0;
+    struct pollfd pfd;
+
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    while (length < sizeof (request) - 1) {
+        if (poll (&pfd, 1, XCAM_INTROSPECTION_CLIENT_TIMEOUT) <= 0)
+            break;
+        ssize_t size = read (fd, request + length, sizeof (request) - 1 - length);
+        if (size <= 0)
+            break;
+        length += size;
+        if (memchr (request, '\n', length))
+            break;
+    }
+    request[length] = '\0';
+
+    // the reply is complete and _components_mutex released before sending,
+    // so a slow client only stalls this thread, bounded by the send timeout
+    std::string reply = handle_request (request);
+    struct timeval timeout;
+    timeout.tv_sec = XCAM_INTROSPECTION_CLIENT_TIMEOUT / 1000;
+    timeout.tv_usec = (XCAM_INTROSPECTION_CLIENT_TIMEOUT % 1000) * 1000;
+    if (setsockopt (fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof (timeout)) < 0) {
+        XCAM_LOG_WARNING ("introspection client send timeout failed: %s", strerror (errno));
+        return;
+    }
+
+    const char *data = reply.c_str ();
+    size_t left = reply.size ();
+    while (left > 0) {
+        ssize_t size = send (fd, data, left, MSG_NOSIGNAL);
+        if (size < 0 && errno == EINTR)
+            continue;
+        if (size <= 0) {
+            XCAM_LOG_DEBUG ("introspection client dropped, %d bytes unsent", (int)left);
+            break;
+        }
+        data += size;
+        left -= size;
+    }
+}
+
+};
@@ -0,0 +1,172 @@
+/*
+ * introspection.h - runtime introspection of live pipeline state
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#ifndef XCAM_INTROSPECTION_H
+#define XCAM_INTROSPECTION_H
+
+#include "xcam_utils.h"
+#include "xcam_mutex.h"
+#include "xcam_thread.h"
+#include "smartptr.h"
+#include <sys/time.h>
+#include <list>
+#include <string>
+#include <vector>
+
+// socket path of introspection server started by DeviceManager, unset to disable
+#define XCAM_INTROSPECTION_SOCKET_ENV "XCAM_INTROSPECTION_SOCKET"
+
+namespace XCam {
+
+/*
+ * IntrospectionWriter, tiny json builder
+ * keys are needed inside objects and ignored inside arrays
+ */
+class IntrospectionWriter
+{
+public:
+    explicit IntrospectionWriter ();
+
+    void begin_object (const char *key = NULL);
+    void end_object ();
+    void begin_array (const char *key = NULL);
+    void end_array ();
+
+    void add (const char *key, const char *value);
+    void add (const char *key, bool value);
+    void add (const char *key, int32_t value);
+    void add (const char *key, uint32_t value);
+    void add (const char *key, int64_t value);
+    void add (const char *key, uint64_t value);
+    void add (const char *key, double value);
+
+    const std::string &get_text () const {
+        return _text;
+    }
+
+private:
+    void add_key (const char *key);
+    void add_string (const char *str);
+
+    XCAM_DEAD_COPY (IntrospectionWriter);
+
+private:
+    std::string           _text;
+    std::vector<bool>     _first_member;
+};
+
+// implemented by components registered to IntrospectionServer
+class Introspectable
+{
+public:
+    Introspectable () {}
+    virtual ~Introspectable () {}
+
+    // write members into the current object, called from introspection thread
+    // while the stream runs, take component locks only for short copies
+    virtual void introspect (IntrospectionWriter &writer) = 0;
+
+private:
+    XCAM_DEAD_COPY (Introspectable);
+};
+
+// duration of a repeated call, one writer; readers may see a torn update
+class DurationStats
+{
+public:
+    explicit DurationStats ();
+
+    void add (const struct timeval &start);
+    void introspect (IntrospectionWriter &writer) const;
+
+    double get_last_ms () const {
+        return _last_ms;
+    }
+    uint64_t get_count () const {
+        return _count;
+    }
+    double get_sum_ms () const {
+        return _sum_ms;
+    }
+
+private:
+    uint64_t   _count;
+    double     _sum_ms;
+    double     _last_ms;
+    double     _max_ms;
+};
+
+/*
+ * IntrospectionServer
+ * unix domain socket, one request line per connection, json reply:
+ *   "list"          registered component names
+ *   "state [name]"  snapshot of all components or the named one
+ * the thread sleeps in poll when nobody connects
+ */
+class IntrospectionServer
+    : public Thread
+{
+    struct Component {
+        std::string      name;
+        Introspectable  *component;
+    };
+    typedef std::list<Component> ComponentList;
+
+public:
+    static SmartPtr<IntrospectionServer> instance ();
+    ~IntrospectionServer ();
+
+    bool register_component (const char *name, Introspectable *component);
+    void unregister_component (Introspectable *component);
+
+    XCamReturn start_server (const char *socket_path);
+    void stop_server ();
+
+    // same reply as the socket, for in-process use
+    std::string handle_request (const char *request);
+
+protected:
+    explicit IntrospectionServer ();
+
+    //derived from Thread
+    virtual bool loop ();
+
+private:
+    void snapshot (IntrospectionWriter &writer, const char *name);
+    void serve_client (int fd);
+    void close_sockets ();
+
+    XCAM_DEAD_COPY (IntrospectionServer);
+
+private:
+    static SmartPtr<IntrospectionServer> _instance;
+    static Mutex                         _instance_mutex;
+
+    Mutex              _components_mutex;
+    ComponentList      _components;
+    Mutex              _server_mutex;
+    std::string        _socket_path;
+    int                _listen_fd;
+    int                _wakeup_fds[2];
+};
+
+};
+
+#endif //XCAM_INTROSPECTION_H
@@ -136,7 +136,7 @@ IspImageProcessor::merge_results (X3aResultList &results)
         SmartPtr<X3aResult> &x3a_result = *iter;
         if (_3a_config->attach (x3a_result, _translator.ptr())) {
             x3a_result->set_done (true);
-            results.erase (iter++);
+            iter = results.erase (iter);
         } else
             ++iter;
     }
@@ -159,7 +159,7 @@ IspImageProcessor::apply_exposure_result (X3aResultList &results)
             }
             if (res.ptr ())
                 res->set_done (true);
-            results.erase (iter++);
+            iter = results.erase (iter);
         } else if ((*iter)->get_type() == XCAM_3A_RESULT_EXPOSURE) {
             SmartPtr<X3aExposureResult> res = (*iter).dynamic_cast_ptr<X3aExposureResult> ();
             struct atomisp_exposure isp_exposure;
@@ -173,7 +173,7 @@ IspImageProcessor::apply_exposure_result (X3aResultList &results)
                 XCAM_LOG_WARNING ("set 3a exposure to sensor failed");
             }
             res->set_done (true);
-            results.erase (iter++);
+            iter = results.erase (iter);
         } else
             ++iter;
     }
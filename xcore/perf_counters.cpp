@@ -0,0 +1,320 @@
+/*
+ * perf_counters.cpp - hardware performance counters per pipeline stage
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#include "perf_counters.h"
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <vector>
+
+namespace XCam {
+
+static const struct {
+    uint64_t      config;
+    const char   *name;
+} perf_counter_types[PerfCounterTypeCount] = {
+    {PERF_COUNT_HW_CPU_CYCLES, "cycles"},
+    {PERF_COUNT_HW_INSTRUCTIONS, "instructions"},
+    {PERF_COUNT_HW_CACHE_MISSES, "llc_misses"},
+    {PERF_COUNT_HW_BRANCH_MISSES, "branch_misses"},
+};
+
+/*
+ * counters of one thread, the cycles event leads the group so all of
+ * them are read with one read(). Members the PMU refuses are left out
+ * and read as 0.
+ */
+class PerfThreadCounters
+{
+public:
+    explicit PerfThreadCounters ();
+    ~PerfThreadCounters ();
+
+    bool open ();
+    bool is_available () const {
+        return _fds[PerfCounterCycles] >= 0;
+    }
+    bool read (PerfCounterValues &values);
+
+private:
+    XCAM_DEAD_COPY (PerfThreadCounters);
+
+private:
+    int         _fds[PerfCounterTypeCount];
+    int32_t     _slots[PerfCounterTypeCount];  // position in group read, -1 if not opened
+    uint32_t    _opened;
+};
+
+static int
+perf_event_open (struct perf_event_attr &attr, int group_fd)
+{
+    // pid 0 and cpu -1, the calling thread on any cpu
+    return syscall (__NR_perf_event_open, &attr, 0, -1, group_fd, 0);
+}
+
+PerfThreadCounters::PerfThreadCounters ()
+    : _opened (0)
+{
+    for (uint32_t i = 0; i < PerfCounterTypeCount; ++i) {
+        _fds[i] = -1;
+        _slots[i] = -1;
+    }
+}
+
+PerfThreadCounters::~PerfThreadCounters ()
+{
+    for (uint32_t i = 0; i < PerfCounterTypeCount; ++i) {
+        if (_fds[i] >= 0)
+            close (_fds[i]);
+    }
+}
+
+bool
+PerfThreadCounters::open ()
+{
+    for (uint32_t i = 0; i < PerfCounterTypeCount; ++i) {
+        struct perf_event_attr attr;
+        xcam_mem_clear (attr);
+        attr.size = sizeof (attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = perf_counter_types[i].config;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format =
+            PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        _fds[i] = perf_event_open (attr, i == PerfCounterCycles ? -1 : _fds[PerfCounterCycles]);
+        if (_fds[i] < 0) {
+            XCAM_LOG_DEBUG (
+                "perf counter(%s) open failed, errno:%d", perf_counter_types[i].name, errno);
+            if (i == PerfCounterCycles)
+                return false;
+            continue;
+        }
+        _slots[i] = _opened++;
+    }
+    return true;
+}
+
+bool
+PerfThreadCounters::read (PerfCounterValues &values)
+{
+    // nr, time_enabled, time_running, then one value per member
+    uint64_t data[3 + PerfCounterTypeCount];
+
+    xcam_mem_clear (values);
+    if (!is_available ())
+        return false;
+
+    ssize_t size = ::read (_fds[PerfCounterCycles], data, sizeof (data));
+    XCAM_FAIL_RETURN (
+        WARNING, size >= (ssize_t)((3 + _opened) * sizeof (uint64_t)), false,
+        "perf counters read failed, errno:%d", errno);
+
+    // more events than PMU slots get multiplexed, scale to the full time
+    double scale = 1.0;
+    if (data[2] && data[2] < data[1])
+        scale = (double)data[1] / data[2];
+
+    for (uint32_t i = 0; i < PerfCounterTypeCount; ++i) {
+        if (_slots[i] >= 0)
+            values.values[i] = (uint64_t)(data[3 + _slots[i]] * scale);
+    }
+    return true;
+}
+
+SmartPtr<PerfCounters> PerfCounters::_instance;
+Mutex PerfCounters::_instance_mutex;
+bool PerfCounters::_enabled = (getenv (XCAM_PERF_COUNTERS_ENV) != NULL);
+
+SmartPtr<PerfCounters>
+PerfCounters::instance ()
+{
+    SmartLock locker (_instance_mutex);
+    if (_instance.ptr ())
+        return _instance;
+
+    _instance = new PerfCounters ();
+    return _instance;
+}
+
+PerfCounters::PerfCounters ()
+    : _key_created (false)
+    , _warned (false)
+{
+    _key_created = (pthread_key_create (&_thread_key, destroy_thread_counters) == 0);
+    if (!_key_created)
+        XCAM_LOG_WARNING ("perf counters can't create thread key");
+}
+
+PerfCounters::~PerfCounters ()
+{
+    // counters of live threads stay open until those threads exit
+    if (_key_created)
+        pthread_key_delete (_thread_key);
+}
+
+void
+PerfCounters::destroy_thread_counters (void *counters)
+{
+    delete (PerfThreadCounters *)counters;
+}
+
+PerfThreadCounters *
+PerfCounters::get_thread_counters ()
+{
+    if (!_key_created)
+        return NULL;
+
+    PerfThreadCounters *counters = (PerfThreadCounters *)pthread_getspecific (_thread_key);
+    if (counters)
+        return counters;
+
+    // a thread failing to open keeps its empty counters, no retry per frame
+    counters = new PerfThreadCounters ();
+    if (!counters->open ()) {
+        SmartLock locker (_stages_mutex);
+        if (!_warned) {
+            XCAM_LOG_WARNING (
+                "perf counters unavailable, check PMU access and /proc/sys/kernel/perf_event_paranoid");
+            _warned = true;
+        }
+    }
+    pthread_setspecific (_thread_key, counters);
+    return counters;
+}
+
+bool
+PerfCounters::read (PerfCounterValues &values)
+{
+    PerfThreadCounters *counters = get_thread_counters ();
+    if (!counters) {
+        xcam_mem_clear (values);
+        return false;
+    }
+    return counters->read (values);
+}
+
+void
+PerfCounters::add_sample (const char *stage, const PerfCounterValues &begin, const PerfCounterValues &end)
+{
+    SmartLock locker (_stages_mutex);
+    StageMap::iterator i = _stages.find (stage);
+    if (i == _stages.end ()) {
+        StageStats stats;
+        xcam_mem_clear (stats);
+        i = _stages.insert (std::make_pair (std::string (stage), stats)).first;
+    }
+
+    StageStats &stats = i->second;
+    ++stats.count;
+    for (uint32_t type = 0; type < PerfCounterTypeCount; ++type) {
+        if (end.values[type] > begin.values[type])
+            stats.sums[type] += end.values[type] - begin.values[type];
+    }
+}
+
+void
+PerfCounters::reset ()
+{
+    SmartLock locker (_stages_mutex);
+    _stages.clear ();
+}
+
+static double
+per_kilo (uint64_t events, uint64_t instructions)
+{
+    return instructions ? events * 1000.0 / instructions : 0.0;
+}
+
+void
+PerfCounters::report ()
+{
+    SmartLock locker (_stages_mutex);
+    for (StageMap::iterator i = _stages.begin (); i != _stages.end (); ++i) {
+        const StageStats &stats = i->second;
+        const uint64_t *sums = stats.sums;
+        if (!stats.count)
+            continue;
+
+        // low ipc with high llc mpki is memory bound, high ipc is compute bound
+        XCAM_LOG_INFO (
+            "perf stage %-32s calls:%-6" PRIu64 " cycles/call:%-10.0f ipc:%.2f llc_mpki:%.2f branch_mpki:%.2f",
+            i->first.c_str (), stats.count,
+            (double)sums[PerfCounterCycles] / stats.count,
+            sums[PerfCounterCycles] ? (double)sums[PerfCounterInstructions] / sums[PerfCounterCycles] : 0.0,
+            per_kilo (sums[PerfCounterLLCMisses], sums[PerfCounterInstructions]),
+            per_kilo (sums[PerfCounterBranchMisses], sums[PerfCounterInstructions]));
+    }
+}
+
+void
+PerfCounters::introspect (IntrospectionWriter &writer)
+{
+    std::vector<std::pair<std::string, StageStats> > stages;
+    {
+        SmartLock locker (_stages_mutex);
+        stages.assign (_stages.begin (), _stages.end ());
+    }
+
+    writer.add ("enabled", _enabled);
+    writer.begin_array ("stages");
+    for (uint32_t i = 0; i < stages.size (); ++i) {
+        const StageStats &stats = stages[i].second;
+        writer.begin_object ();
+        writer.add ("name", stages[i].first.c_str ());
+        writer.add ("count", stats.count);
+        for (uint32_t type = 0; type < PerfCounterTypeCount; ++type)
+            writer.add (perf_counter_types[type].name, stats.sums[type]);
+        writer.add (
+            "ipc", stats.sums[PerfCounterCycles] ?
+            (double)stats.sums[PerfCounterInstructions] / stats.sums[PerfCounterCycles] : 0.0);
+        writer.add ("llc_mpki", per_kilo (stats.sums[PerfCounterLLCMisses], stats.sums[PerfCounterInstructions]));
+        writer.add ("branch_mpki", per_kilo (stats.sums[PerfCounterBranchMisses], stats.sums[PerfCounterInstructions]));
+        writer.end_object ();
+    }
+    writer.end_array ();
+}
+
+void
+PerfStage::begin (const char *name, const char *detail)
+{
+    if (detail)
+        snprintf (_name, sizeof (_name), "%s.%s", name, detail);
+    else
+        snprintf (_name, sizeof (_name), "%s", name);
+
+    _started = PerfCounters::instance ()->read (_begin);
+}
+
+void
+PerfStage::end ()
+{
+    PerfCounterValues end_values;
+    SmartPtr<PerfCounters> counters = PerfCounters::instance ();
+
+    if (counters->read (end_values))
+        counters->add_sample (_name, _begin, end_values);
+}
+
+};
@@ -0,0 +1,139 @@
+/*
+ * perf_counters.h - hardware performance counters per pipeline stage
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#ifndef XCAM_PERF_COUNTERS_H
+#define XCAM_PERF_COUNTERS_H
+
+#include "xcam_utils.h"
+#include "xcam_mutex.h"
+#include "smartptr.h"
+#include "introspection.h"
+#include <pthread.h>
+#include <map>
+#include <string>
+
+// set to any value to count cycles/instructions/misses per stage
+#define XCAM_PERF_COUNTERS_ENV "XCAM_PERF_COUNTERS"
+
+#define XCAM_PERF_STAGE_NAME_SIZE 48
+
+namespace XCam {
+
+enum PerfCounterType {
+    PerfCounterCycles = 0,
+    PerfCounterInstructions,
+    PerfCounterLLCMisses,
+    PerfCounterBranchMisses,
+    PerfCounterTypeCount,
+};
+
+struct PerfCounterValues {
+    uint64_t    values[PerfCounterTypeCount];
+};
+
+class PerfThreadCounters;
+
+/*
+ * PerfCounters
+ * opens one perf_event group per thread on first use (cycles leading
+ * instructions, LLC misses and branch misses, user space only) and sums
+ * the deltas of PerfStage scopes by stage name. A thread where the group
+ * can't be opened (perf_event_paranoid, no PMU in a VM) is skipped.
+ * Counting is off unless XCAM_PERF_COUNTERS is set or set_enabled called.
+ */
+class PerfCounters
+    : public Introspectable
+{
+    struct StageStats {
+        uint64_t    count;
+        uint64_t    sums[PerfCounterTypeCount];
+    };
+    typedef std::map<std::string, StageStats> StageMap;
+
+public:
+    static SmartPtr<PerfCounters> instance ();
+    ~PerfCounters ();
+
+    static bool is_enabled () {
+        return _enabled;
+    }
+    static void set_enabled (bool enabled) {
+        _enabled = enabled;
+    }
+
+    // current counts of the calling thread, false if it has no counters
+    bool read (PerfCounterValues &values);
+    void add_sample (const char *stage, const PerfCounterValues &begin, const PerfCounterValues &end);
+
+    void reset ();
+    // logs one line per stage
+    void report ();
+
+    //derived from Introspectable
+    virtual void introspect (IntrospectionWriter &writer);
+
+private:
+    explicit PerfCounters ();
+    PerfThreadCounters *get_thread_counters ();
+    static void destroy_thread_counters (void *counters);
+
+    XCAM_DEAD_COPY (PerfCounters);
+
+private:
+    static SmartPtr<PerfCounters>   _instance;
+    static Mutex                    _instance_mutex;
+    static bool                     _enabled;
+
+    pthread_key_t                   _thread_key;
+    bool                            _key_created;
+    bool                            _warned;
+    StageMap                        _stages;
+    Mutex                           _stages_mutex;
+};
+
+// counts the enclosing scope on the calling thread when counting is enabled
+class PerfStage
+{
+public:
+    explicit PerfStage (const char *name, const char *detail = NULL) {
+        _started = false;
+        if (PerfCounters::is_enabled ())
+            begin (name, detail);
+    }
+    ~PerfStage () {
+        if (_started)
+            end ();
+    }
+
+private:
+    void begin (const char *name, const char *detail);
+    void end ();
+
+    XCAM_DEAD_COPY (PerfStage);
+
+private:
+    bool                 _started;
+    char                 _name[XCAM_PERF_STAGE_NAME_SIZE];
+    PerfCounterValues    _begin;
+};
+
+};
+
+#endif //XCAM_PERF_COUNTERS_H
@@ -101,7 +101,8 @@ PollThread::~PollThread ()
 bool
 PollThread::set_capture_device (SmartPtr<V4l2Device> &dev)
 {
-    XCAM_ASSERT (!_capture_dev.ptr());
+    // kept across stop/start, may be set again while stopped
+    XCAM_ASSERT (!_capture_loop->is_running ());
     _capture_dev = dev;
     return true;
 }
@@ -109,7 +110,7 @@ PollThread::set_capture_device (SmartPtr<V4l2Device> &dev)
 bool
 PollThread::set_event_device (SmartPtr<V4l2SubDevice> &dev)
 {
-    XCAM_ASSERT (!_event_dev.ptr());
+    XCAM_ASSERT (!_capture_loop->is_running ());
     _event_dev = dev;
     return true;
 }
@@ -117,7 +118,7 @@ PollThread::set_event_device (SmartPtr<V4l2SubDevice> &dev)
 bool
 PollThread::set_isp_controller (SmartPtr<IspController>  &isp)
 {
-    XCAM_ASSERT (!_isp_controller.ptr());
+    XCAM_ASSERT (!_capture_loop->is_running ());
     _isp_controller = isp;
     return true;
 }
@@ -125,7 +126,7 @@ PollThread::set_isp_controller (SmartPtr<IspController>  &isp)
 bool
 PollThread::set_poll_callback (PollCallback *callback)
 {
-    XCAM_ASSERT (!_poll_callback);
+    XCAM_ASSERT (!_capture_loop->is_running ());
     _poll_callback = callback;
     return true;
 }
@@ -133,7 +134,7 @@ PollThread::set_poll_callback (PollCallback *callback)
 bool
 PollThread::set_stats_callback (StatsCallback *callback)
 {
-    XCAM_ASSERT (!_stats_callback);
+    XCAM_ASSERT (!_capture_loop->is_running ());
     _stats_callback = callback;
     return true;
 }
@@ -141,7 +142,11 @@ PollThread::set_stats_callback (StatsCallback *callback)
 
 XCamReturn PollThread::start ()
 {
-    _3a_stats_pool = new X3aStatisticsQueue;
+    // stats pool is kept from last run, checked against isp grid on start
+    if (!_3a_stats_pool.ptr ())
+        _3a_stats_pool = new X3aStatisticsQueue;
+    else
+        _3a_stats_pool->resume ();
     if (_event_dev.ptr () && !_event_loop->start ()) {
         return XCAM_RETURN_ERROR_THREAD;
     }
@@ -165,6 +170,20 @@ XCamReturn PollThread::stop ()
     return XCAM_RETURN_NO_ERROR;
 }
 
+void
+PollThread::introspect (IntrospectionWriter &writer)
+{
+    writer.add ("running", _capture_loop->is_running ());
+
+    SmartPtr<X3aStatsPool> pool = _3a_stats_pool;
+    if (pool.ptr ()) {
+        writer.begin_object ("stats_pool");
+        writer.add ("allocated", pool->get_allocated_count ());
+        writer.add ("free", pool->get_free_count ());
+        writer.end_object ();
+    }
+}
+
 XCamReturn
 PollThread::init_3a_stats_pool ()
 {
@@ -181,7 +200,21 @@ PollThread::init_3a_stats_pool ()
         XCAM_LOG_WARNING ("get isp parameters width or height wrong");
         return XCAM_RETURN_ERROR_ISP;
     }
-    _3a_stats_pool.dynamic_cast_ptr<X3aStatisticsQueue>()->set_grid_info (parameters.info);
+
+    SmartPtr<X3aStatisticsQueue> stats_queue = _3a_stats_pool.dynamic_cast_ptr<X3aStatisticsQueue> ();
+    XCAM_ASSERT (stats_queue.ptr ());
+    if (stats_queue->get_allocated_count ()) {
+        const struct atomisp_grid_info &grid = stats_queue->get_grid_info ();
+        if (grid.width == parameters.info.width && grid.height == parameters.info.height &&
+                grid.bqs_per_grid_cell == parameters.info.bqs_per_grid_cell)
+            return XCAM_RETURN_NO_ERROR;
+
+        // grid changed, stats in flight keep the old pool alive
+        _3a_stats_pool->stop ();
+        stats_queue = new X3aStatisticsQueue;
+        _3a_stats_pool = stats_queue;
+    }
+    stats_queue->set_grid_info (parameters.info);
     if (!_3a_stats_pool->reserve (6)) {
         XCAM_LOG_WARNING ("init_3a_stats_pool failed to reserve stats buffer.");
         return XCAM_RETURN_ERROR_MEM;
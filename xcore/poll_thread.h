@@ -29,6 +29,7 @@
 #include "v4l2_device.h"
 #include "isp_controller.h"
 #include "stats_callback_interface.h"
+#include "introspection.h"
 
 namespace XCam {
 
@@ -54,10 +55,12 @@ class EventPollThread;
 class CapturePollThread;
 
 class PollThread
+    : public Introspectable
 {
     friend class EventPollThread;
     friend class CapturePollThread;
     friend class FakePollThread;
+    friend class SimSensorPollThread;
 public:
     explicit PollThread ();
     virtual ~PollThread ();
@@ -71,6 +74,9 @@ public:
     virtual XCamReturn start();
     virtual XCamReturn stop ();
 
+    //derived from Introspectable
+    virtual void introspect (IntrospectionWriter &writer);
+
 protected:
     XCamReturn poll_subdev_event_loop ();
     virtual XCamReturn poll_buffer_loop ();
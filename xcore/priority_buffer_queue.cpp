@@ -19,6 +19,7 @@
  */
 
 #include "priority_buffer_queue.h"
+#include "xcam_probes.h"
 
 #define XCAM_PRIORITY_BUFFER_FIXED_DELAY 8
 
@@ -53,6 +54,7 @@ PriorityBufferQueue::push_priority_buf (const SmartPtr<PriorityBuffer> &buf)
     }
 
     _obj_list.insert (iter, buf);
+    XCAM_PROBE3 (pqueue_push, buf->seq_num, buf->rank, buf->data->get_timestamp ());
     _new_obj_cond.signal ();
     return true;
 }
@@ -25,10 +25,12 @@
 #include "safe_list.h"
 #include "drm_bo_buffer.h"
 #include "cl_image_handler.h"
+#include "frame_arena.h"
 
 namespace XCam {
 
 struct PriorityBuffer
+    : public ArenaObject
 {
     SmartPtr<DrmBoBuffer>     data;
     SmartPtr<CLImageHandler>  handler;
@@ -0,0 +1,301 @@
+/*
+ * projection_dvs.cpp - digital video stabilization by luma projections
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#include "projection_dvs.h"
+#include <math.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// 255 * 256 still fits in 16 bits column accumulators
+#define DVS_COLUMN_BLOCK_ROWS 256
+// below this, profiles too flat to match
+#define DVS_MIN_MEAN_COST 1e-4f
+#define DVS_MIN_CORRELATION 0.15f
+#define DVS_HIGH_PASS_RADIUS 16
+
+namespace XCam {
+
+ProjectionDvs::ProjectionDvs ()
+    : _margin (0.05f)
+    , _smooth (0.1f)
+    , _width (0)
+    , _height (0)
+    , _has_reference (false)
+    , _offset_x (0.0f)
+    , _offset_y (0.0f)
+{
+    xcam_mem_clear (_motion);
+}
+
+bool
+ProjectionDvs::set_margin (float margin)
+{
+    XCAM_FAIL_RETURN (WARNING, margin >= 0.0f && margin < 0.25f, false, "dvs margin:%f invalid", margin);
+
+    SmartLock locker (_mutex);
+    _margin = margin;
+    return true;
+}
+
+bool
+ProjectionDvs::set_smooth (float smooth)
+{
+    XCAM_FAIL_RETURN (WARNING, smooth > 0.0f && smooth <= 1.0f, false, "dvs smooth:%f invalid", smooth);
+
+    SmartLock locker (_mutex);
+    _smooth = smooth;
+    return true;
+}
+
+void
+ProjectionDvs::reset ()
+{
+    SmartLock locker (_mutex);
+    _has_reference = false;
+    _offset_x = 0.0f;
+    _offset_y = 0.0f;
+    xcam_mem_clear (_motion);
+}
+
+void
+ProjectionDvs::calculate_projections (const uint8_t *luma, uint32_t width, uint32_t height, uint32_t stride)
+{
+    std::vector<uint16_t> block_sums (width);
+
+    memset (&_col_sums[0], 0, width * sizeof (uint32_t));
+    for (uint32_t block = 0; block < height; block += DVS_COLUMN_BLOCK_ROWS) {
+        uint32_t block_end = XCAM_MIN (block + DVS_COLUMN_BLOCK_ROWS, height);
+        memset (&block_sums[0], 0, width * sizeof (uint16_t));
+
+        for (uint32_t y = block; y < block_end; ++y) {
+            const uint8_t *line = luma + y * stride;
+            uint16_t *sums = &block_sums[0];
+            uint32_t x = 0;
+            uint32_t row_sum = 0;
+#if defined(__SSE2__)
+            __m128i zero = _mm_setzero_si128 ();
+            __m128i row_acc = _mm_setzero_si128 ();
+            for (; x + 16 <= width; x += 16) {
+                __m128i pixels = _mm_loadu_si128 ((const __m128i *)(line + x));
+                __m128i lo = _mm_unpacklo_epi8 (pixels, zero);
+                __m128i hi = _mm_unpackhi_epi8 (pixels, zero);
+                _mm_storeu_si128 ((__m128i *)(sums + x),
+                                  _mm_add_epi16 (_mm_loadu_si128 ((const __m128i *)(sums + x)), lo));
+                _mm_storeu_si128 ((__m128i *)(sums + x + 8),
+                                  _mm_add_epi16 (_mm_loadu_si128 ((const __m128i *)(sums + x + 8)), hi));
+                row_acc = _mm_add_epi64 (row_acc, _mm_sad_epu8 (pixels, zero));
+            }
+            row_sum = _mm_cvtsi128_si32 (row_acc) + _mm_cvtsi128_si32 (_mm_srli_si128 (row_acc, 8));
+#endif
+            for (; x < width; ++x) {
+                sums[x] += line[x];
+                row_sum += line[x];
+            }
+            _row_sums[y] = row_sum;
+        }
+
+        for (uint32_t x = 0; x < width; ++x)
+            _col_sums[x] += block_sums[x];
+    }
+}
+
+// profile divided by its mean, minus a box average of itself: lighting
+// gradients and vignetting are gone, only texture is matched
+static void
+normalize_profile (const std::vector<uint32_t> &sums, std::vector<float> &profile)
+{
+    int32_t count = sums.size ();
+    uint64_t total = 0;
+    for (int32_t i = 0; i < count; ++i)
+        total += sums[i];
+
+    float scale = (total ? (float)count / total : 0.0f);
+    int32_t radius = XCAM_MIN (DVS_HIGH_PASS_RADIUS, count / 2 - 1);
+    float box = 0.0f;
+    for (int32_t i = 0; i <= 2 * radius; ++i)
+        box += sums[i];
+
+    for (int32_t i = 0; i < count; ++i) {
+        int32_t center = XCAM_MIN (XCAM_MAX (i, radius), count - radius - 1);
+        if (center != XCAM_MIN (XCAM_MAX (i - 1, radius), count - radius - 1))
+            box += (float)sums[center + radius] - (float)sums[center - radius - 1];
+        profile[i] = (sums[i] - box / (2 * radius + 1)) * scale;
+    }
+}
+
+// mean absolute difference of current[i + shift] and reference[i] on the overlap
+static float
+profile_cost (const float *current, const float *reference, uint32_t count)
+{
+    uint32_t i = 0;
+    float sum = 0.0f;
+
+#if defined(__SSE2__)
+    __m128 abs_mask = _mm_castsi128_ps (_mm_set1_epi32 (0x7fffffff));
+    __m128 acc = _mm_setzero_ps ();
+    for (; i + 4 <= count; i += 4) {
+        __m128 diff = _mm_sub_ps (_mm_loadu_ps (current + i), _mm_loadu_ps (reference + i));
+        acc = _mm_add_ps (acc, _mm_and_ps (diff, abs_mask));
+    }
+    float lanes[4];
+    _mm_storeu_ps (lanes, acc);
+    sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+    for (; i < count; ++i)
+        sum += fabsf (current[i] - reference[i]);
+
+    return sum / count;
+}
+
+float
+ProjectionDvs::estimate_shift (
+    const std::vector<float> &current, const std::vector<float> &reference,
+    int32_t max_shift, float &corr)
+{
+    int32_t count = current.size ();
+    int32_t best = 0;
+    float best_cost = 0.0f;
+    float mean_cost = 0.0f;
+
+    corr = 0.0f;
+    max_shift = XCAM_MIN (max_shift, count / 4);
+    if (max_shift < 1)
+        return 0.0f;
+
+    _costs.resize (2 * max_shift + 1);
+    for (int32_t shift = -max_shift; shift <= max_shift; ++shift) {
+        int32_t start = XCAM_MAX (0, -shift);
+        int32_t end = XCAM_MIN (count, count - shift);
+        float cost = profile_cost (&current[start + shift], &reference[start], end - start);
+
+        _costs[shift + max_shift] = cost;
+        mean_cost += cost;
+        if (shift == -max_shift || cost < best_cost) {
+            best = shift;
+            best_cost = cost;
+        }
+    }
+    mean_cost /= _costs.size ();
+
+    if (mean_cost < DVS_MIN_MEAN_COST)
+        return 0.0f;
+    corr = 1.0f - best_cost / mean_cost;
+    // no clear minimum or at search border, do not trust
+    if (corr < DVS_MIN_CORRELATION || best == -max_shift || best == max_shift) {
+        corr = 0.0f;
+        return 0.0f;
+    }
+
+    float left = _costs[best + max_shift - 1];
+    float right = _costs[best + max_shift + 1];
+    float denom = left - 2.0f * best_cost + right;
+    float offset = (denom > 0.0f ? 0.5f * (left - right) / denom : 0.0f);
+
+    return best + XCAM_MIN (XCAM_MAX (offset, -0.5f), 0.5f);
+}
+
+// offset = camera path - smoothed path, low pass of path only costs a multiply
+float
+ProjectionDvs::filter_path (float shift, float &offset, float margin)
+{
+    offset += shift;
+
+    // follow faster near the margin so that pans don't stick at the border
+    float ratio = XCAM_MIN (fabsf (offset) / XCAM_MAX (margin, 1.0f), 1.0f);
+    float weight = _smooth + (1.0f - _smooth) * ratio * ratio * ratio;
+    offset -= offset * weight;
+    offset = XCAM_MIN (XCAM_MAX (offset, -margin), margin);
+    return offset;
+}
+
+XCamReturn
+ProjectionDvs::process (
+    const uint8_t *luma, uint32_t width, uint32_t height, uint32_t stride,
+    XCam3AWindow &crop)
+{
+    XCAM_FAIL_RETURN (
+        WARNING,
+        luma && width >= 16 && height >= 16 && stride >= width,
+        XCAM_RETURN_ERROR_PARAM,
+        "dvs process on invalid image(%dx%d, stride:%d)", width, height, stride);
+
+    SmartLock locker (_mutex);
+    if (width != _width || height != _height) {
+        _width = width;
+        _height = height;
+        _col_sums.resize (width);
+        _row_sums.resize (height);
+        _hor_current.resize (width);
+        _hor_reference.resize (width);
+        _ver_current.resize (height);
+        _ver_reference.resize (height);
+        _has_reference = false;
+        _offset_x = 0.0f;
+        _offset_y = 0.0f;
+    }
+
+    int32_t margin_x = (int32_t)(width * _margin) & ~1;
+    int32_t margin_y = (int32_t)(height * _margin) & ~1;
+
+    calculate_projections (luma, width, height, stride);
+    normalize_profile (_col_sums, _hor_current);
+    normalize_profile (_row_sums, _ver_current);
+
+    xcam_mem_clear (_motion);
+    if (_has_reference) {
+        _motion.hor_shift = estimate_shift (_hor_current, _hor_reference, margin_x, _motion.hor_corr);
+        _motion.ver_shift = estimate_shift (_ver_current, _ver_reference, margin_y, _motion.ver_corr);
+    }
+    _hor_current.swap (_hor_reference);
+    _ver_current.swap (_ver_reference);
+    _has_reference = true;
+
+    float offset_x = filter_path (_motion.hor_shift, _offset_x, margin_x);
+    float offset_y = filter_path (_motion.ver_shift, _offset_y, margin_y);
+
+    crop.x_start = margin_x + (int32_t)lrintf (offset_x);
+    crop.y_start = margin_y + (int32_t)lrintf (offset_y);
+    crop.x_end = crop.x_start + width - 2 * margin_x;
+    crop.y_end = crop.y_start + height - 2 * margin_y;
+    crop.weight = 1;
+
+    XCAM_LOG_DEBUG (
+        "dvs shift(%.2f, %.2f) corr(%.2f, %.2f) crop(%d, %d)",
+        _motion.hor_shift, _motion.ver_shift, _motion.hor_corr, _motion.ver_corr,
+        crop.x_start, crop.y_start);
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+ProjectionDvs::process (const VideoBufferInfo &info, const uint8_t *mem, XCam3AWindow &crop)
+{
+    XCAM_FAIL_RETURN (
+        WARNING,
+        info.format == V4L2_PIX_FMT_NV12 || info.format == V4L2_PIX_FMT_GREY,
+        XCAM_RETURN_ERROR_PARAM,
+        "dvs doesn't support format:%s", xcam_fourcc_to_string (info.format));
+
+    return process (mem + info.offsets[0], info.width, info.height, info.strides[0], crop);
+}
+
+};
@@ -0,0 +1,102 @@
+/*
+ * projection_dvs.h - digital video stabilization by luma projections
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#ifndef XCAM_PROJECTION_DVS_H
+#define XCAM_PROJECTION_DVS_H
+
+#include "xcam_utils.h"
+#include "xcam_mutex.h"
+#include "video_buffer.h"
+#include <base/xcam_3a_types.h>
+#include <vector>
+
+namespace XCam {
+
+typedef struct _DvsMotion {
+    float hor_shift;  /*!< content shift to previous frame in pixels, X */
+    float ver_shift;  /*!< content shift to previous frame in pixels, Y */
+    float hor_corr;   /*!< horizontal confidence in [0, 1], 0 means shift dropped */
+    float ver_corr;   /*!< vertical confidence in [0, 1], 0 means shift dropped */
+} DvsMotion;
+
+/*
+ * ProjectionDvs
+ * global translation from row/column sums of luma: profiles are divided by
+ * their mean (AE changes drop out), matched by sum of absolute differences
+ * over +-margin, refined to sub-pixel by a parabola. The camera path is
+ * smoothed by a first order filter, no frame delay; the filter speeds up as
+ * the correction gets near the margin so that pans are followed.
+ * Output is a crop window of (1 - 2 * margin) input size.
+ */
+class ProjectionDvs
+{
+public:
+    explicit ProjectionDvs ();
+
+    // each side, ratio of width/height, default 0.05
+    bool set_margin (float margin);
+    // path filter weight of new position, (0, 1], default 0.1
+    bool set_smooth (float smooth);
+    void reset ();
+
+    // luma: 8 bit plane, NV12 Y or gray
+    XCamReturn process (
+        const uint8_t *luma, uint32_t width, uint32_t height, uint32_t stride,
+        XCam3AWindow &crop);
+    XCamReturn process (const VideoBufferInfo &info, const uint8_t *mem, XCam3AWindow &crop);
+
+    const DvsMotion &get_last_motion () const {
+        return _motion;
+    }
+
+private:
+    void calculate_projections (const uint8_t *luma, uint32_t width, uint32_t height, uint32_t stride);
+    float estimate_shift (
+        const std::vector<float> &current, const std::vector<float> &reference,
+        int32_t max_shift, float &corr);
+    float filter_path (float shift, float &offset, float margin);
+
+    XCAM_DEAD_COPY (ProjectionDvs);
+
+private:
+    Mutex                  _mutex;
+    float                  _margin;
+    float                  _smooth;
+
+    uint32_t               _width;
+    uint32_t               _height;
+    bool                   _has_reference;
+    std::vector<uint32_t>  _col_sums;
+    std::vector<uint32_t>  _row_sums;
+    std::vector<float>     _hor_current;
+    std::vector<float>     _ver_current;
+    std::vector<float>     _hor_reference;
+    std::vector<float>     _ver_reference;
+    std::vector<float>     _costs;
+
+    DvsMotion              _motion;
+    // camera path minus smoothed path, the correction applied
+    float                  _offset_x;
+    float                  _offset_y;
+};
+
+};
+
+#endif //XCAM_PROJECTION_DVS_H
@@ -20,12 +20,67 @@
 
 #include "sensor_descriptor.h"
 #include <math.h>
+#include <string.h>
 
 namespace XCam {
 
+static bool
+time_to_integration_direct (
+    const struct atomisp_sensor_mode_data &data, int32_t exposure_time,
+    uint32_t &coarse_time, uint32_t &fine_time)
+{
+    uint32_t pixel_periods =  ((uint64_t)exposure_time) * data.vt_pix_clk_freq_mhz / XCAM_SECONDS_2_TIMESTAMP (1);
+
+    coarse_time = pixel_periods / data.line_length_pck;
+    fine_time = pixel_periods % data.line_length_pck;
+    return true;
+}
+
+static int32_t
+gain_to_code_direct (double gain)
+{
+    double db = log10 (gain) * 20;
+    if (db > XCAM_SENSOR_GAIN_MAX_DB)
+        db = XCAM_SENSOR_GAIN_MAX_DB;
+    return (uint32_t) (db * XCAM_SENSOR_GAIN_MAX_CODE / XCAM_SENSOR_GAIN_MAX_DB);
+}
+
+static double
+code_to_gain_direct (int32_t code)
+{
+    double db = code * (double) XCAM_SENSOR_GAIN_MAX_DB / XCAM_SENSOR_GAIN_MAX_CODE;
+    return pow (10.0, db / 20.0);
+}
+
+static inline uint64_t
+double_bits (double value)
+{
+    uint64_t bits;
+    memcpy (&bits, &value, sizeof (bits));
+    return bits;
+}
+
+static inline double
+bits_double (uint64_t bits)
+{
+    double value;
+    memcpy (&value, &bits, sizeof (value));
+    return value;
+}
+
+static inline uint32_t
+gain_bucket (double gain)
+{
+    // gain in [1.0, 256.0), exponent and top mantissa bits
+    return (double_bits (gain) - double_bits (1.0)) >> (52 - XCAM_SENSOR_GAIN_BUCKET_BITS);
+}
+
 SensorDescriptor::SensorDescriptor ()
+    : _lookup_enable (true)
+    , _lines_per_us (0.0)
 {
     xcam_mem_clear (_sensor_data);
+    build_gain_tables ();
 }
 
 SensorDescriptor::~SensorDescriptor ()
@@ -41,7 +96,75 @@ SensorDescriptor::is_ready ()
 void
 SensorDescriptor::set_sensor_data (struct atomisp_sensor_mode_data &data)
 {
+    bool timing_changed =
+        data.vt_pix_clk_freq_mhz != _sensor_data.vt_pix_clk_freq_mhz ||
+        data.line_length_pck != _sensor_data.line_length_pck ||
+        data.frame_length_lines != _sensor_data.frame_length_lines;
+
     _sensor_data = data;
+    if (timing_changed)
+        build_time_table ();
+}
+
+void
+SensorDescriptor::build_time_table ()
+{
+    _line_start_time.clear ();
+    _lines_per_us = 0.0;
+
+    uint64_t pixel_clock = _sensor_data.vt_pix_clk_freq_mhz;
+    uint64_t line_length = _sensor_data.line_length_pck;
+    if (!pixel_clock || !line_length || !_sensor_data.frame_length_lines)
+        return;
+
+    // pixel periods of every time in the table must fit in 32 bits
+    uint64_t lines = (uint64_t)_sensor_data.frame_length_lines * XCAM_SENSOR_TIME_TABLE_FRAMES;
+    lines = XCAM_MIN (lines, 0xFFFFFFFFULL / line_length);
+
+    // line c starts at the first time whose pixel periods reach c * line_length
+    _line_start_time.reserve (lines + 1);
+    for (uint64_t coarse = 0; coarse <= lines; ++coarse) {
+        uint64_t periods = coarse * line_length * XCAM_SECONDS_2_TIMESTAMP (1);
+        uint64_t time = (periods + pixel_clock - 1) / pixel_clock;
+        if (time > 0x7FFFFFFF)
+            break;
+        _line_start_time.push_back (time);
+    }
+    if (_line_start_time.size () < 2) {
+        _line_start_time.clear ();
+        return;
+    }
+
+    _lines_per_us = (double)pixel_clock / XCAM_SECONDS_2_TIMESTAMP (1) / line_length;
+    XCAM_LOG_DEBUG (
+        "sensor descriptor time table: %d lines up to %dus",
+        (uint32_t)_line_start_time.size () - 1, _line_start_time.back ());
+}
+
+void
+SensorDescriptor::build_gain_tables ()
+{
+    for (int32_t code = 0; code <= XCAM_SENSOR_GAIN_MAX_CODE; ++code)
+        _code_gain[code] = code_to_gain_direct (code);
+
+    // smallest double mapped to each code by the direct conversion
+    _gain_threshold[0] = 1.0;
+    for (int32_t code = 1; code <= XCAM_SENSOR_GAIN_MAX_CODE; ++code) {
+        double gain = _code_gain[code];
+        while (gain_to_code_direct (gain) >= code)
+            gain = nextafter (gain, 0.0);
+        while (gain_to_code_direct (gain) < code)
+            gain = nextafter (gain, HUGE_VAL);
+        _gain_threshold[code] = gain;
+    }
+
+    int32_t code = 0;
+    for (uint32_t bucket = 0; bucket < XCAM_SENSOR_GAIN_BUCKETS; ++bucket) {
+        double low = bits_double (double_bits (1.0) + ((uint64_t)bucket << (52 - XCAM_SENSOR_GAIN_BUCKET_BITS)));
+        while (code < XCAM_SENSOR_GAIN_MAX_CODE && low >= _gain_threshold[code + 1])
+            ++code;
+        _gain_bucket_code[bucket] = code;
+    }
 }
 
 bool
@@ -51,10 +174,20 @@ SensorDescriptor::exposure_time_to_integration (
     if (exposure_time < 0 || !is_ready ())
         return false;
 
-    uint32_t pixel_periods =  ((uint64_t)exposure_time) * _sensor_data.vt_pix_clk_freq_mhz / XCAM_SECONDS_2_TIMESTAMP (1);
+    if (!_lookup_enable || _line_start_time.empty () || exposure_time >= _line_start_time.back ())
+        return time_to_integration_direct (_sensor_data, exposure_time, coarse_time, fine_time);
+
+    // estimate is off by at most a line from rounding
+    uint32_t last = _line_start_time.size () - 1;
+    uint32_t coarse = XCAM_MIN ((uint32_t)(exposure_time * _lines_per_us), last - 1);
+    while (exposure_time < _line_start_time[coarse])
+        --coarse;
+    while (exposure_time >= _line_start_time[coarse + 1])
+        ++coarse;
 
-    coarse_time = pixel_periods / _sensor_data.line_length_pck;
-    fine_time = pixel_periods % _sensor_data.line_length_pck;
+    uint32_t pixel_periods = ((uint64_t)exposure_time) * _sensor_data.vt_pix_clk_freq_mhz / XCAM_SECONDS_2_TIMESTAMP (1);
+    coarse_time = coarse;
+    fine_time = pixel_periods - coarse * _sensor_data.line_length_pck;
     return true;
 }
 
@@ -76,11 +209,20 @@ SensorDescriptor::exposure_gain_to_code (
     int32_t &analog_code, int32_t &digital_code)
 {
     XCAM_ASSERT (digital_gain == 1.0);
-    double db = log10 (analog_gain * digital_gain) * 20;
-    if (db > 48)
-        db = 48;
-    analog_code =  (uint32_t) (db * 160.0 / 48);
+    double gain = analog_gain * digital_gain;
     digital_code = 0;
+
+    // below 1.0 and NaN take the direct path
+    if (!_lookup_enable || !(gain >= 1.0 && gain < 256.0)) {
+        analog_code = gain_to_code_direct (gain);
+        return true;
+    }
+
+    // a bucket spans less than one code step, at most one threshold to pass
+    int32_t code = _gain_bucket_code[gain_bucket (gain)];
+    while (code < XCAM_SENSOR_GAIN_MAX_CODE && gain >= _gain_threshold[code + 1])
+        ++code;
+    analog_code = code;
     return true;
 }
 
@@ -90,8 +232,10 @@ SensorDescriptor::exposure_code_to_gain (
     double &analog_gain, double &digital_gain)
 {
     XCAM_UNUSED (digital_code);
-    double db = analog_code * 48.0 / 160.0;
-    analog_gain = pow (10.0, db / 20.0);
+    if (_lookup_enable && analog_code >= 0 && analog_code <= XCAM_SENSOR_GAIN_MAX_CODE)
+        analog_gain = _code_gain[analog_code];
+    else
+        analog_gain = code_to_gain_direct (analog_code);
     digital_gain = 1.0;
 
     return true;
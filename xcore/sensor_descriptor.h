@@ -23,6 +23,16 @@
 
 #include "xcam_utils.h"
 #include <linux/atomisp.h>
+#include <vector>
+
+// exposure time covered by the coarse line table, in frames of the sensor mode
+#define XCAM_SENSOR_TIME_TABLE_FRAMES 4
+
+#define XCAM_SENSOR_GAIN_MAX_DB 48
+#define XCAM_SENSOR_GAIN_MAX_CODE 160
+// gains in [1.0, 256.0) are bucketed by exponent and top mantissa bits
+#define XCAM_SENSOR_GAIN_BUCKET_BITS 6
+#define XCAM_SENSOR_GAIN_BUCKETS (8 << XCAM_SENSOR_GAIN_BUCKET_BITS)
 
 namespace XCam {
 
@@ -34,6 +44,11 @@ public:
     void set_sensor_data (struct atomisp_sensor_mode_data &data);
     virtual bool is_ready ();
 
+    // tables are on by default, off computes every conversion directly
+    void set_lookup_enable (bool enable) {
+        _lookup_enable = enable;
+    }
+
     // Input: exposure_time
     // Output: coarse_time, fine_time
     virtual bool exposure_time_to_integration (
@@ -56,10 +71,21 @@ public:
         double &analog_gain, double &digital_gain);
 
 private:
+    void build_time_table ();
+    void build_gain_tables ();
+
     XCAM_DEAD_COPY (SensorDescriptor);
 
 private:
     struct atomisp_sensor_mode_data _sensor_data;
+    bool                            _lookup_enable;
+    // first exposure time reaching each coarse line, one past the last line
+    std::vector<int32_t>            _line_start_time;
+    double                          _lines_per_us;
+    double                          _code_gain[XCAM_SENSOR_GAIN_MAX_CODE + 1];
+    // first gain reaching each code
+    double                          _gain_threshold[XCAM_SENSOR_GAIN_MAX_CODE + 1];
+    uint8_t                         _gain_bucket_code[XCAM_SENSOR_GAIN_BUCKETS];
 };
 
 };
@@ -0,0 +1,958 @@
+/*
+ * sim_sensor.cpp - synthetic sensor simulator
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#include "sim_sensor.h"
+#include "v4l2_buffer_proxy.h"
+#include <math.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SIM_SENSOR_BQS_PER_GRID_CELL   16
+#define SIM_SENSOR_GRID_CELL_PIXELS    (SIM_SENSOR_BQS_PER_GRID_CELL * 2)
+// one bayer quad out of STEP x STEP is sampled for stats
+#define SIM_SENSOR_STATS_STEP          4
+#define SIM_SENSOR_NOISE_TABLE_SIZE    65536
+#define SIM_SENSOR_MAX_BUFFER_COUNT    32
+#define SIM_SENSOR_HBLANK              280
+#define SIM_SENSOR_VBLANK              45
+#define SIM_SENSOR_INTEGRATION_MARGIN  4
+#define SIM_SENSOR_OBJECT_REFLECTANCE  240
+#define SIM_SENSOR_MAX_POLL_WAIT       100000 // us
+
+namespace XCam {
+
+enum SimChannel {
+    SimChannelR = 0,
+    SimChannelG,
+    SimChannelB,
+};
+
+// channel response under a warm illuminant, leaves awb something to do
+static const double sim_channel_gains[3] = {0.80, 1.0, 0.65};
+
+static const uint32_t sim_formats[] = {
+    V4L2_PIX_FMT_NV12,
+    V4L2_PIX_FMT_YUYV,
+    V4L2_PIX_FMT_SGRBG10,
+    V4L2_PIX_FMT_SRGGB10,
+    V4L2_PIX_FMT_SBGGR10,
+    V4L2_PIX_FMT_SGBRG10,
+    V4L2_PIX_FMT_SGRBG12,
+    V4L2_PIX_FMT_SRGGB12,
+    V4L2_PIX_FMT_SBGGR12,
+    V4L2_PIX_FMT_SGBRG12,
+};
+
+class SimSensorBuffer
+    : public V4l2Buffer
+{
+public:
+    SimSensorBuffer (const struct v4l2_buffer &buf, const struct v4l2_format &format, uint8_t *mem)
+        : V4l2Buffer (buf, format)
+        , _mem (mem)
+    {}
+    ~SimSensorBuffer () {
+        xcam_free (_mem);
+    }
+
+private:
+    XCAM_DEAD_COPY (SimSensorBuffer);
+
+private:
+    uint8_t   *_mem;
+};
+
+static inline int64_t
+sim_get_time ()
+{
+    struct timespec now;
+    clock_gettime (CLOCK_MONOTONIC, &now);
+    return XCAM_TIMESPEC_2_USEC (now);
+}
+
+static inline int32_t
+sim_clamp (int32_t value, int32_t max)
+{
+    return value < 0 ? 0 : (value > max ? max : value);
+}
+
+static inline int32_t
+sim_wrap (int32_t value, int32_t size)
+{
+    value %= size;
+    return value < 0 ? value + size : value;
+}
+
+SimSensorConfig::SimSensorConfig ()
+    : width (1920)
+    , height (1080)
+    , format (V4L2_PIX_FMT_NV12)
+    , fps_n (30)
+    , fps_d (1)
+    , noise (2.0)
+    , pan_x (0.0)
+    , pan_y (0.0)
+    , object_size (128)
+    , object_speed (4.0)
+    , saturation_time (40000.0)
+    , exposure_delay (2)
+    , seed (1)
+{
+}
+
+SimSensorDevice::SimSensorDevice (const SimSensorConfig &config)
+    : V4l2Device ("/dev/null")
+    , _config (config)
+    , _streaming (false)
+    , _stats_sequence (0)
+    , _exposure_time (config.saturation_time / 4)
+    , _exposure_gain (1.0)
+    , _sequence (0)
+    , _dropped_count (0)
+    , _late_count (0)
+    , _width (config.width)
+    , _height (config.height)
+    , _grid_width (0)
+    , _grid_height (0)
+    , _bits (8)
+    , _lut_time (0.0)
+    , _lut_gain (0.0)
+    , _pan_x (0.0)
+    , _pan_y (0.0)
+    , _object_x (0.0)
+    , _object_y (0.0)
+    , _object_dx (0.0)
+    , _object_dy (0.0)
+    , _random (config.seed ? config.seed : 1)
+{
+    XCAM_ASSERT (config.fps_n && config.fps_d);
+    _sensor = new SensorDescriptor;
+    _timeperframe.numerator = config.fps_d;
+    _timeperframe.denominator = config.fps_n;
+    set_framerate (config.fps_n, config.fps_d);
+    xcam_mem_clear (_cfa);
+
+    XCAM_LOG_DEBUG ("SimSensorDevice constructed");
+}
+
+SimSensorDevice::~SimSensorDevice ()
+{
+    XCAM_LOG_DEBUG ("~SimSensorDevice destructed");
+}
+
+int64_t
+SimSensorDevice::get_frame_duration ()
+{
+    SmartLock locker (_lock);
+    return XCAM_SECONDS_2_TIMESTAMP ((int64_t)_timeperframe.numerator) / _timeperframe.denominator;
+}
+
+void
+SimSensorDevice::get_exposure (double &time, double &gain)
+{
+    SmartLock locker (_lock);
+    time = _exposure_time;
+    gain = _exposure_gain;
+}
+
+uint32_t
+SimSensorDevice::get_frame_count ()
+{
+    SmartLock locker (_lock);
+    return _sequence;
+}
+
+uint32_t
+SimSensorDevice::get_dropped_count ()
+{
+    SmartLock locker (_lock);
+    return _dropped_count;
+}
+
+uint32_t
+SimSensorDevice::get_late_count ()
+{
+    SmartLock locker (_lock);
+    return _late_count;
+}
+
+uint32_t
+SimSensorDevice::get_queued_count ()
+{
+    SmartLock locker (_lock);
+    return _free_bufs.size ();
+}
+
+int
+SimSensorDevice::io_control (int cmd, void *arg)
+{
+    SmartLock locker (_lock);
+
+    // ioctl numbers don't fit in int
+    switch ((uint32_t) cmd) {
+    case VIDIOC_S_INPUT:
+        return 0;
+
+    case VIDIOC_G_PARM: {
+        struct v4l2_streamparm *param = (struct v4l2_streamparm *)arg;
+        param->parm.capture.capability = V4L2_CAP_TIMEPERFRAME;
+        param->parm.capture.timeperframe = _timeperframe;
+        return 0;
+    }
+    case VIDIOC_S_PARM: {
+        // also called on open with only the capture mode set
+        const struct v4l2_fract &fract = ((struct v4l2_streamparm *)arg)->parm.capture.timeperframe;
+        if (fract.numerator && fract.denominator)
+            _timeperframe = fract;
+        return 0;
+    }
+    case VIDIOC_ENUM_FMT: {
+        struct v4l2_fmtdesc *desc = (struct v4l2_fmtdesc *)arg;
+        if (desc->index >= sizeof (sim_formats) / sizeof (sim_formats[0])) {
+            errno = EINVAL;
+            return -1;
+        }
+        desc->pixelformat = sim_formats[desc->index];
+        desc->flags = 0;
+        strncpy ((char *)desc->description, xcam_fourcc_to_string (desc->pixelformat),
+                 sizeof (desc->description) - 1);
+        return 0;
+    }
+    case VIDIOC_S_FMT:
+        return set_sim_format (*(struct v4l2_format *)arg);
+
+    case VIDIOC_G_FMT: {
+        struct v4l2_format *format = (struct v4l2_format *)arg;
+        format->fmt.pix.width = _width;
+        format->fmt.pix.height = _height;
+        format->fmt.pix.pixelformat = _format.fmt.pix.pixelformat ? _format.fmt.pix.pixelformat : _config.format;
+        return fill_format (*format) ? 0 : -1;
+    }
+    case VIDIOC_REQBUFS: {
+        struct v4l2_requestbuffers *request = (struct v4l2_requestbuffers *)arg;
+        if (request->count > SIM_SENSOR_MAX_BUFFER_COUNT)
+            request->count = SIM_SENSOR_MAX_BUFFER_COUNT;
+        _free_bufs.clear ();
+        _ready_bufs.clear ();
+        return 0;
+    }
+    case VIDIOC_QBUF: {
+        const struct v4l2_buffer *buf = (const struct v4l2_buffer *)arg;
+        if (buf->index >= _buf_pool.size ()) {
+            errno = EINVAL;
+            return -1;
+        }
+        _free_bufs.push_back (buf->index);
+        return 0;
+    }
+    case VIDIOC_DQBUF: {
+        struct v4l2_buffer *buf = (struct v4l2_buffer *)arg;
+        if (_ready_bufs.empty ()) {
+            errno = EAGAIN;
+            return -1;
+        }
+        *buf = _ready_bufs.front ();
+        _ready_bufs.pop_front ();
+        return 0;
+    }
+    case VIDIOC_STREAMON:
+        _streaming = true;
+        return 0;
+
+    case VIDIOC_STREAMOFF:
+        // like a driver, all queued and undequeued buffers are given back
+        _streaming = false;
+        _free_bufs.clear ();
+        _ready_bufs.clear ();
+        return 0;
+
+    case ATOMISP_IOC_G_SENSOR_MODE_DATA:
+        fill_sensor_mode_data (*(struct atomisp_sensor_mode_data *)arg);
+        return 0;
+
+    case ATOMISP_IOC_G_ISP_PARM:
+        fill_grid_info (((struct atomisp_parm *)arg)->info);
+        return 0;
+
+    case ATOMISP_IOC_G_3A_STAT:
+        return get_3a_stats (*(struct atomisp_3a_statistics *)arg);
+
+    case ATOMISP_IOC_S_EXPOSURE:
+        return set_exposure (*(const struct atomisp_exposure *)arg);
+
+    case ATOMISP_IOC_S_PARAMETERS:
+    case VIDIOC_S_CTRL:
+        // isp tuning and focus don't change the simulated scene
+        return 0;
+
+    default:
+        break;
+    }
+
+    XCAM_LOG_DEBUG ("SimSensorDevice ignored ioctl(0x%08x)", cmd);
+    errno = ENOTTY;
+    return -1;
+}
+
+XCamReturn
+SimSensorDevice::allocate_buffer (
+    SmartPtr<V4l2Buffer> &buf,
+    const struct v4l2_format &format,
+    const uint32_t index)
+{
+    struct v4l2_buffer v4l2_buf;
+    uint8_t *mem = (uint8_t *)xcam_malloc0 (format.fmt.pix.sizeimage);
+
+    XCAM_FAIL_RETURN (
+        WARNING, mem, XCAM_RETURN_ERROR_MEM,
+        "SimSensorDevice allocate buffer(%d) failed", index);
+
+    // frames are rendered by cpu, buffers are always memory mapped
+    xcam_mem_clear (v4l2_buf);
+    v4l2_buf.index = index;
+    v4l2_buf.type = _capture_buf_type;
+    v4l2_buf.memory = V4L2_MEMORY_MMAP;
+    v4l2_buf.length = format.fmt.pix.sizeimage;
+    v4l2_buf.m.userptr = (uintptr_t) mem;
+
+    buf = new SimSensorBuffer (v4l2_buf, format, mem);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+bool
+SimSensorDevice::fill_format (struct v4l2_format &format)
+{
+    struct v4l2_pix_format &pix = format.fmt.pix;
+
+    if (!pix.width || !pix.height || (pix.width % 2) || (pix.height % 2)) {
+        errno = EINVAL;
+        return false;
+    }
+
+    switch (pix.pixelformat) {
+    case V4L2_PIX_FMT_NV12:
+        // atomisp convention, bytesperline counts the uv plane
+        pix.bytesperline = pix.width * 3 / 2;
+        pix.sizeimage = pix.width * pix.height * 3 / 2;
+        break;
+    case V4L2_PIX_FMT_YUYV:
+    case V4L2_PIX_FMT_SGRBG10:
+    case V4L2_PIX_FMT_SRGGB10:
+    case V4L2_PIX_FMT_SBGGR10:
+    case V4L2_PIX_FMT_SGBRG10:
+    case V4L2_PIX_FMT_SGRBG12:
+    case V4L2_PIX_FMT_SRGGB12:
+    case V4L2_PIX_FMT_SBGGR12:
+    case V4L2_PIX_FMT_SGBRG12:
+        pix.bytesperline = pix.width * 2;
+        pix.sizeimage = pix.bytesperline * pix.height;
+        break;
+    default:
+        XCAM_LOG_WARNING (
+            "SimSensorDevice doesn't support format(%s)",
+            xcam_fourcc_to_string (pix.pixelformat));
+        errno = EINVAL;
+        return false;
+    }
+
+    format.type = _capture_buf_type;
+    pix.field = V4L2_FIELD_NONE;
+    return true;
+}
+
+int
+SimSensorDevice::set_sim_format (struct v4l2_format &format)
+{
+    const uint32_t pixelformat = format.fmt.pix.pixelformat;
+
+    if (!fill_format (format))
+        return -1;
+
+    _width = format.fmt.pix.width;
+    _height = format.fmt.pix.height;
+
+    switch (pixelformat) {
+    case V4L2_PIX_FMT_SGRBG10:
+    case V4L2_PIX_FMT_SRGGB10:
+    case V4L2_PIX_FMT_SBGGR10:
+    case V4L2_PIX_FMT_SGBRG10:
+        _bits = 10;
+        break;
+    case V4L2_PIX_FMT_SGRBG12:
+    case V4L2_PIX_FMT_SRGGB12:
+    case V4L2_PIX_FMT_SBGGR12:
+    case V4L2_PIX_FMT_SGBRG12:
+        _bits = 12;
+        break;
+    default:
+        _bits = 8;
+        break;
+    }
+
+    // yuv frames only use the green response, laid out as GRBG for stats
+    switch (pixelformat) {
+    case V4L2_PIX_FMT_SRGGB10:
+    case V4L2_PIX_FMT_SRGGB12:
+        _cfa[0][0] = SimChannelR;
+        _cfa[0][1] = SimChannelG;
+        _cfa[1][0] = SimChannelG;
+        _cfa[1][1] = SimChannelB;
+        break;
+    case V4L2_PIX_FMT_SBGGR10:
+    case V4L2_PIX_FMT_SBGGR12:
+        _cfa[0][0] = SimChannelB;
+        _cfa[0][1] = SimChannelG;
+        _cfa[1][0] = SimChannelG;
+        _cfa[1][1] = SimChannelR;
+        break;
+    case V4L2_PIX_FMT_SGBRG10:
+    case V4L2_PIX_FMT_SGBRG12:
+        _cfa[0][0] = SimChannelG;
+        _cfa[0][1] = SimChannelB;
+        _cfa[1][0] = SimChannelR;
+        _cfa[1][1] = SimChannelG;
+        break;
+    default:
+        _cfa[0][0] = SimChannelG;
+        _cfa[0][1] = SimChannelR;
+        _cfa[1][0] = SimChannelB;
+        _cfa[1][1] = SimChannelG;
+        break;
+    }
+
+    init_scene ();
+
+    XCAM_LOG_INFO (
+        "SimSensorDevice format(%s) %dx%d, stats grid %dx%d",
+        xcam_fourcc_to_string (pixelformat), _width, _height, _grid_width, _grid_height);
+    return 0;
+}
+
+void
+SimSensorDevice::fill_sensor_mode_data (struct atomisp_sensor_mode_data &data)
+{
+    const uint32_t line_length = _width + SIM_SENSOR_HBLANK;
+    const uint32_t frame_length = _height + SIM_SENSOR_VBLANK;
+
+    xcam_mem_clear (data);
+    data.coarse_integration_time_min = 1;
+    data.coarse_integration_time_max_margin = SIM_SENSOR_INTEGRATION_MARGIN;
+    data.fine_integration_time_min = 0;
+    data.fine_integration_time_max_margin = 0;
+    data.fine_integration_time_def = 0;
+    data.frame_length_lines = frame_length;
+    data.line_length_pck = line_length;
+    data.read_mode = 0;
+    // pixel clock derived from the blanking and the framerate
+    data.vt_pix_clk_freq_mhz =
+        (uint64_t)line_length * frame_length * _timeperframe.denominator / _timeperframe.numerator;
+    data.crop_horizontal_start = 0;
+    data.crop_vertical_start = 0;
+    data.crop_horizontal_end = _width;
+    data.crop_vertical_end = _height;
+    data.output_width = _width;
+    data.output_height = _height;
+    data.binning_factor_x = 1;
+    data.binning_factor_y = 1;
+}
+
+void
+SimSensorDevice::fill_grid_info (struct atomisp_grid_info &info)
+{
+    xcam_mem_clear (info);
+    info.enable = 1;
+    info.width = _grid_width;
+    info.height = _grid_height;
+    info.s3a_width = _grid_width;
+    info.s3a_height = _grid_height;
+    info.aligned_width = _grid_width;
+    info.aligned_height = _grid_height;
+    info.bqs_per_grid_cell = SIM_SENSOR_BQS_PER_GRID_CELL;
+    info.s3a_bqs_per_grid_cell = SIM_SENSOR_BQS_PER_GRID_CELL;
+    info.deci_factor_log2 = 4;
+    // sums are accumulated on 8 bits values whatever the sensor depth
+    info.elem_bit_depth = 8;
+    info.has_histogram = 0;
+}
+
+int
+SimSensorDevice::get_3a_stats (struct atomisp_3a_statistics &stats)
+{
+    const struct atomisp_grid_info &grid = stats.grid_info;
+
+    if (!stats.data || _stats.empty ()) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    const uint32_t width = XCAM_MIN (grid.width, _grid_width);
+    const uint32_t height = XCAM_MIN (grid.height, _grid_height);
+    const uint32_t stride = grid.aligned_width ? grid.aligned_width : grid.width;
+    for (uint32_t i = 0; i < height; ++i) {
+        memcpy (stats.data + i * stride, &_stats[i * _grid_width],
+                width * sizeof (struct atomisp_3a_output));
+    }
+    stats.exp_id = _stats_sequence;
+    return 0;
+}
+
+int
+SimSensorDevice::set_exposure (const struct atomisp_exposure &exposure)
+{
+    struct atomisp_sensor_mode_data mode_data;
+    int32_t time = 0, max_time = 0;
+    double analog_gain = 1.0, digital_gain = 1.0;
+    PendingExposure pending;
+
+    // mode data follows format and framerate, refreshed on each exposure
+    fill_sensor_mode_data (mode_data);
+    _sensor->set_sensor_data (mode_data);
+
+    if (!_sensor->exposure_integration_to_time (
+                exposure.integration_time[0], exposure.integration_time[1], time) ||
+            !_sensor->exposure_integration_to_time (
+                mode_data.frame_length_lines - SIM_SENSOR_INTEGRATION_MARGIN, 0, max_time) ||
+            !_sensor->exposure_code_to_gain (exposure.gain[0], exposure.gain[1], analog_gain, digital_gain)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    pending.sequence = _sequence + _config.exposure_delay;
+    pending.time = XCAM_MAX (XCAM_MIN (time, max_time), 1);
+    pending.gain = analog_gain * digital_gain;
+    _pending_exposures.push_back (pending);
+    return 0;
+}
+
+uint32_t
+SimSensorDevice::next_random ()
+{
+    // xorshift32
+    _random ^= _random << 13;
+    _random ^= _random >> 17;
+    _random ^= _random << 5;
+    return _random;
+}
+
+void
+SimSensorDevice::init_scene ()
+{
+    const uint32_t grid_cell = SIM_SENSOR_GRID_CELL_PIXELS;
+
+    // gradients with a 64 pixels checker, reflectance in [32, 255]
+    _scene.resize (_width * _height);
+    for (uint32_t y = 0; y < _height; ++y) {
+        uint8_t *line = &_scene[y * _width];
+        for (uint32_t x = 0; x < _width; ++x) {
+            line[x] = 32 + x * 128 / _width + y * 31 / _height +
+                      ((((x >> 6) ^ (y >> 6)) & 1) ? 64 : 0);
+        }
+    }
+    _row.resize (_width);
+
+    // gaussian read noise in output code values, box-muller
+    const double sigma = _config.noise * (1 << (_bits - 8));
+    _noise.resize (SIM_SENSOR_NOISE_TABLE_SIZE + _width);
+    for (uint32_t i = 0; i < _noise.size (); i += 2) {
+        double u1 = (next_random () + 1.0) / 4294967296.0;
+        double u2 = next_random () / 4294967296.0;
+        double r = sqrt (-2.0 * log (u1)) * sigma;
+        _noise[i] = (int16_t)lrint (r * cos (2 * M_PI * u2));
+        if (i + 1 < _noise.size ())
+            _noise[i + 1] = (int16_t)lrint (r * sin (2 * M_PI * u2));
+    }
+
+    for (uint32_t c = 0; c < 3; ++c)
+        _luts[c].resize (256);
+    _lut_time = 0.0;
+    _lut_gain = 0.0;
+
+    _grid_width = _width / grid_cell;
+    _grid_height = _height / grid_cell;
+    _stats.assign (_grid_width * _grid_height, atomisp_3a_output ());
+    _stats_scratch.assign (_grid_width * _grid_height, atomisp_3a_output ());
+
+    _pan_x = _pan_y = 0.0;
+    _object_x = (_width - XCAM_MIN (_config.object_size, _width)) / 2.0;
+    _object_y = (_height - XCAM_MIN (_config.object_size, _height)) / 2.0;
+    _object_dx = _config.object_speed;
+    _object_dy = _config.object_speed * 0.75;
+}
+
+void
+SimSensorDevice::update_luts (double time, double gain)
+{
+    const double max_code = (1 << _bits) - 1;
+    const double scale = time * gain / _config.saturation_time;
+
+    for (uint32_t c = 0; c < 3; ++c) {
+        for (uint32_t i = 0; i < 256; ++i) {
+            double value = i / 255.0 * scale * sim_channel_gains[c] * max_code;
+            _luts[c][i] = (uint16_t)(XCAM_MIN (value, max_code) + 0.5);
+        }
+    }
+    _lut_time = time;
+    _lut_gain = gain;
+}
+
+void
+SimSensorDevice::advance_motion ()
+{
+    const double object_size = XCAM_MIN (_config.object_size, XCAM_MIN (_width, _height));
+
+    _pan_x += _config.pan_x;
+    _pan_y += _config.pan_y;
+
+    _object_x += _object_dx;
+    _object_y += _object_dy;
+    if (_object_x < 0 || _object_x + object_size > _width) {
+        _object_dx = -_object_dx;
+        _object_x = XCAM_MAX (XCAM_MIN (_object_x, _width - object_size), 0.0);
+    }
+    if (_object_y < 0 || _object_y + object_size > _height) {
+        _object_dy = -_object_dy;
+        _object_y = XCAM_MAX (XCAM_MIN (_object_y, _height - object_size), 0.0);
+    }
+}
+
+void
+SimSensorDevice::render (uint8_t *dest)
+{
+    const uint32_t pixelformat = _format.fmt.pix.pixelformat;
+    const uint32_t bytes_per_line = _format.fmt.pix.bytesperline;
+    const int32_t max_code = (1 << _bits) - 1;
+    // keep even offsets so the bayer phase doesn't flip while panning
+    const uint32_t offset_x = sim_wrap ((int32_t)floor (_pan_x), _width) & ~1U;
+    const uint32_t offset_y = sim_wrap ((int32_t)floor (_pan_y), _height) & ~1U;
+    const uint32_t object_size = XCAM_MIN (_config.object_size, XCAM_MIN (_width, _height));
+    const uint32_t object_x = (uint32_t)_object_x;
+    const uint32_t object_y = (uint32_t)_object_y;
+    uint8_t *row = &_row[0];
+
+    for (uint32_t y = 0; y < _height; ++y) {
+        const uint8_t *scene_line = &_scene[((y + offset_y) % _height) * _width];
+        memcpy (row, scene_line + offset_x, _width - offset_x);
+        memcpy (row + _width - offset_x, scene_line, offset_x);
+        if (object_size && y >= object_y && y < object_y + object_size)
+            memset (row + object_x, SIM_SENSOR_OBJECT_REFLECTANCE, object_size);
+
+        const int16_t *noise = &_noise[next_random () % SIM_SENSOR_NOISE_TABLE_SIZE];
+
+        switch (pixelformat) {
+        case V4L2_PIX_FMT_NV12: {
+            const uint16_t *lut = &_luts[SimChannelG][0];
+            uint8_t *out = dest + y * _width;
+            for (uint32_t x = 0; x < _width; ++x)
+                out[x] = sim_clamp (lut[row[x]] + noise[x], max_code);
+            break;
+        }
+        case V4L2_PIX_FMT_YUYV: {
+            const uint16_t *lut = &_luts[SimChannelG][0];
+            uint8_t *out = dest + y * bytes_per_line;
+            for (uint32_t x = 0; x < _width; ++x) {
+                out[x * 2] = sim_clamp (lut[row[x]] + noise[x], max_code);
+                out[x * 2 + 1] = 128;
+            }
+            break;
+        }
+        default: {
+            const uint16_t *lut0 = &_luts[_cfa[y % 2][0]][0];
+            const uint16_t *lut1 = &_luts[_cfa[y % 2][1]][0];
+            uint16_t *out = (uint16_t *)(dest + y * bytes_per_line);
+            for (uint32_t x = 0; x < _width; x += 2) {
+                out[x] = sim_clamp (lut0[row[x]] + noise[x], max_code);
+                out[x + 1] = sim_clamp (lut1[row[x + 1]] + noise[x + 1], max_code);
+            }
+            break;
+        }
+        }
+    }
+
+    if (pixelformat == V4L2_PIX_FMT_NV12)
+        memset (dest + _width * _height, 128, _width * _height / 2);
+}
+
+uint32_t
+SimSensorDevice::read_pixel (const uint8_t *frame, uint32_t x, uint32_t y)
+{
+    switch (_format.fmt.pix.pixelformat) {
+    case V4L2_PIX_FMT_NV12:
+        return frame[y * _width + x];
+    case V4L2_PIX_FMT_YUYV:
+        return frame[y * _format.fmt.pix.bytesperline + x * 2];
+    default:
+        break;
+    }
+    return ((const uint16_t *)(frame + y * _format.fmt.pix.bytesperline))[x] >> (_bits - 8);
+}
+
+void
+SimSensorDevice::calculate_stats (const uint8_t *frame)
+{
+    const uint32_t grid_cell = SIM_SENSOR_GRID_CELL_PIXELS;
+    const uint32_t step = SIM_SENSOR_STATS_STEP;
+    const uint32_t samples = (SIM_SENSOR_BQS_PER_GRID_CELL / step) * (SIM_SENSOR_BQS_PER_GRID_CELL / step);
+    // sums are scaled up as if every bayer quad of the cell was counted
+    const uint32_t scale = SIM_SENSOR_BQS_PER_GRID_CELL * SIM_SENSOR_BQS_PER_GRID_CELL / samples;
+    uint32_t gr_x = 0, gr_y = 0;
+
+    // the green sharing its row with red, used for focus values
+    for (uint32_t i = 0; i < 2; ++i) {
+        for (uint32_t j = 0; j < 2; ++j) {
+            if (_cfa[i][j] == SimChannelG && (_cfa[i][0] == SimChannelR || _cfa[i][1] == SimChannelR)) {
+                gr_x = j;
+                gr_y = i;
+            }
+        }
+    }
+
+    for (uint32_t grid_y = 0; grid_y < _grid_height; ++grid_y) {
+        for (uint32_t grid_x = 0; grid_x < _grid_width; ++grid_x) {
+            uint32_t sum[4] = {0, 0, 0, 0}; // r, gr, gb, b
+            uint32_t hpf1 = 0, hpf2 = 0, valid = 0;
+
+            for (uint32_t qy = 0; qy < SIM_SENSOR_BQS_PER_GRID_CELL; qy += step) {
+                for (uint32_t qx = 0; qx < SIM_SENSOR_BQS_PER_GRID_CELL; qx += step) {
+                    const uint32_t x = grid_x * grid_cell + qx * 2;
+                    const uint32_t y = grid_y * grid_cell + qy * 2;
+                    uint32_t max_value = 0;
+
+                    for (uint32_t i = 0; i < 2; ++i) {
+                        for (uint32_t j = 0; j < 2; ++j) {
+                            uint32_t value = read_pixel (frame, x + j, y + i);
+                            uint32_t channel = _cfa[i][j];
+                            if (channel == SimChannelR)
+                                sum[0] += value;
+                            else if (channel == SimChannelB)
+                                sum[3] += value;
+                            else
+                                sum[i == gr_y ? 1 : 2] += value;
+                            max_value = XCAM_MAX (max_value, value);
+                        }
+                    }
+                    if (max_value < 255)
+                        ++valid;
+
+                    const int32_t green = read_pixel (frame, x + gr_x, y + gr_y);
+                    if (x + gr_x + 2 < _width)
+                        hpf1 += abs (green - (int32_t)read_pixel (frame, x + gr_x + 2, y + gr_y));
+                    if (y + gr_y + 2 < _height)
+                        hpf2 += abs (green - (int32_t)read_pixel (frame, x + gr_x, y + gr_y + 2));
+                }
+            }
+
+            struct atomisp_3a_output &out = _stats_scratch[grid_y * _grid_width + grid_x];
+            out.awb_r = sum[0] * scale;
+            out.awb_gr = sum[1] * scale;
+            out.awb_gb = sum[2] * scale;
+            out.awb_b = sum[3] * scale;
+            out.ae_y = (sum[0] + sum[1] + sum[2] + sum[3]) / 4 * scale;
+            out.awb_cnt = valid * scale;
+            out.af_hpf1 = hpf1 * scale;
+            out.af_hpf2 = hpf2 * scale;
+        }
+    }
+}
+
+XCamReturn
+SimSensorDevice::produce_frame (int64_t timestamp, uint32_t late_frames)
+{
+    uint32_t index = 0;
+    uint32_t sequence = 0;
+    double time = 0.0, gain = 0.0;
+    bool dropped = false;
+
+    {
+        SmartLock locker (_lock);
+        if (!_streaming)
+            return XCAM_RETURN_BYPASS;
+
+        _late_count += late_frames;
+        sequence = _sequence++;
+        while (!_pending_exposures.empty () && _pending_exposures.front ().sequence <= sequence) {
+            _exposure_time = _pending_exposures.front ().time;
+            _exposure_gain = _pending_exposures.front ().gain;
+            _pending_exposures.pop_front ();
+        }
+        time = _exposure_time;
+        gain = _exposure_gain;
+
+        if (_free_bufs.empty ()) {
+            ++_dropped_count;
+            dropped = true;
+        } else {
+            index = _free_bufs.front ();
+            _free_bufs.pop_front ();
+        }
+    }
+
+    // the scene keeps moving while no buffer is queued
+    advance_motion ();
+    if (dropped) {
+        XCAM_LOG_DEBUG ("SimSensorDevice dropped frame(%d), no buffer queued", sequence);
+        return XCAM_RETURN_BYPASS;
+    }
+
+    if (time != _lut_time || gain != _lut_gain)
+        update_luts (time, gain);
+
+    SmartPtr<V4l2Buffer> &buf = _buf_pool [index];
+    struct v4l2_buffer v4l2_buf = buf->get_buf ();
+    uint8_t *dest = (uint8_t *)(v4l2_buf.m.userptr);
+    render (dest);
+    calculate_stats (dest);
+
+    v4l2_buf.sequence = sequence;
+    v4l2_buf.bytesused = _format.fmt.pix.sizeimage;
+    v4l2_buf.timestamp.tv_sec = timestamp / XCAM_SECONDS_2_TIMESTAMP (1);
+    v4l2_buf.timestamp.tv_usec = timestamp % XCAM_SECONDS_2_TIMESTAMP (1);
+
+    SmartLock locker (_lock);
+    // stream stopped while rendering, buffer went back with the queue
+    if (!_streaming)
+        return XCAM_RETURN_BYPASS;
+    _stats.swap (_stats_scratch);
+    _stats_sequence = sequence;
+    _ready_bufs.push_back (v4l2_buf);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+SimSensorPollThread::SimSensorPollThread ()
+    : _next_frame_time (0)
+    , _stats_pool_ready (false)
+{
+}
+
+SimSensorPollThread::~SimSensorPollThread ()
+{
+}
+
+XCamReturn
+SimSensorPollThread::start ()
+{
+    _next_frame_time = 0;
+    _stats_pool_ready = false;
+    return PollThread::start ();
+}
+
+void
+SimSensorPollThread::introspect (IntrospectionWriter &writer)
+{
+    PollThread::introspect (writer);
+
+    SmartPtr<SimSensorDevice> sensor = _capture_dev.dynamic_cast_ptr<SimSensorDevice> ();
+    if (!sensor.ptr ())
+        return;
+
+    double time = 0.0, gain = 0.0;
+    sensor->get_exposure (time, gain);
+    writer.begin_object ("sim_sensor");
+    writer.add ("frames", sensor->get_frame_count ());
+    writer.add ("dropped", sensor->get_dropped_count ());
+    writer.add ("late", sensor->get_late_count ());
+    writer.add ("queued_buffers", sensor->get_queued_count ());
+    writer.add ("exposure_time_us", time);
+    writer.add ("gain", gain);
+    writer.end_object ();
+}
+
+XCamReturn
+SimSensorPollThread::poll_buffer_loop ()
+{
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+    SmartPtr<SimSensorDevice> sensor = _capture_dev.dynamic_cast_ptr<SimSensorDevice> ();
+
+    XCAM_FAIL_RETURN (
+        ERROR, sensor.ptr (), XCAM_RETURN_ERROR_PARAM,
+        "SimSensorPollThread needs a SimSensorDevice as capture device");
+
+    // no event device here, the stats pool is set up on the first frame
+    if (!_stats_pool_ready && _isp_controller.ptr ()) {
+        ret = init_3a_stats_pool ();
+        XCAM_FAIL_RETURN (
+            ERROR, ret == XCAM_RETURN_NO_ERROR, ret,
+            "SimSensorPollThread init 3a stats pool failed");
+        _stats_pool_ready = true;
+    }
+
+    const int64_t duration = sensor->get_frame_duration ();
+    int64_t now = sim_get_time ();
+    if (!_next_frame_time)
+        _next_frame_time = now;
+
+    // bounded waits keep stop () responsive at low framerates
+    if (now < _next_frame_time) {
+        int64_t wait = _next_frame_time - now;
+        ::usleep (XCAM_MIN (wait, SIM_SENSOR_MAX_POLL_WAIT));
+        if (wait > SIM_SENSOR_MAX_POLL_WAIT)
+            return XCAM_RETURN_ERROR_TIMEOUT;
+        now = sim_get_time ();
+    }
+
+    // too slow to keep up, the frames missed are lost like on a sensor
+    uint32_t late_frames = 0;
+    if (now - _next_frame_time >= duration) {
+        late_frames = (now - _next_frame_time) / duration;
+        _next_frame_time += late_frames * duration;
+    }
+    const int64_t timestamp = _next_frame_time;
+    _next_frame_time += duration;
+
+    ret = sensor->produce_frame (timestamp, late_frames);
+    if (ret == XCAM_RETURN_BYPASS)
+        return XCAM_RETURN_NO_ERROR;
+    XCAM_FAIL_RETURN (
+        WARNING, ret == XCAM_RETURN_NO_ERROR, ret,
+        "SimSensorPollThread produce frame failed");
+
+    SmartPtr<V4l2Buffer> buf;
+    ret = _capture_dev->dequeue_buffer (buf);
+    if (ret != XCAM_RETURN_NO_ERROR) {
+        XCAM_LOG_WARNING ("capture buffer failed");
+        return ret;
+    }
+    XCAM_ASSERT (buf.ptr());
+
+    const uint32_t sequence = buf->get_buf ().sequence;
+    SmartPtr<VideoBuffer> video_buf = new V4l2BufferProxy (buf, _capture_dev);
+    if (_poll_callback) {
+        ret = _poll_callback->poll_buffer_ready (video_buf);
+        if (ret != XCAM_RETURN_NO_ERROR)
+            return ret;
+    }
+
+    if (_stats_pool_ready) {
+        struct v4l2_event event;
+        xcam_mem_clear (event);
+        event.type = V4L2_EVENT_ATOMISP_3A_STATS_READY;
+        event.sequence = sequence;
+        event.timestamp.tv_sec = timestamp / XCAM_SECONDS_2_TIMESTAMP (1);
+        event.timestamp.tv_nsec = (timestamp % XCAM_SECONDS_2_TIMESTAMP (1)) * 1000;
+        if (handle_events (event) != XCAM_RETURN_NO_ERROR) {
+            XCAM_LOG_DEBUG ("SimSensorPollThread stats of frame(%d) not delivered", sequence);
+        }
+    }
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+};
@@ -0,0 +1,188 @@
+/*
+ * sim_sensor.h - synthetic sensor simulator
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#ifndef XCAM_SIM_SENSOR_H
+#define XCAM_SIM_SENSOR_H
+
+#include "xcam_utils.h"
+#include "xcam_mutex.h"
+#include "v4l2_device.h"
+#include "poll_thread.h"
+#include "sensor_descriptor.h"
+#include <linux/atomisp.h>
+#include <list>
+#include <vector>
+
+namespace XCam {
+
+struct SimSensorConfig {
+    uint32_t    width;
+    uint32_t    height;
+    uint32_t    format;          // NV12, YUYV or 10/12 bits bayer
+    uint32_t    fps_n;
+    uint32_t    fps_d;
+    double      noise;           // read noise stddev, in 8 bits code values
+    double      pan_x;           // global motion, pixels per frame
+    double      pan_y;
+    uint32_t    object_size;     // bouncing square, 0 to disable
+    double      object_speed;    // pixels per frame
+    double      saturation_time; // exposure(us) at gain 1.0 saturating white
+    uint32_t    exposure_delay;  // frames before a new exposure takes effect
+    uint32_t    seed;
+
+    SimSensorConfig ();
+};
+
+/*
+ * SimSensorDevice
+ * a capture device rendering a procedural scene instead of opening a
+ * driver. It answers the v4l2 and atomisp ioctls the pipeline issues, so
+ * IspController and PollThread work on it unchanged:
+ *   - S_FMT/G_FMT/ENUM_FMT, S_PARM/G_PARM, REQBUFS, QBUF/DQBUF, STREAMON/OFF
+ *   - G_SENSOR_MODE_DATA, G_ISP_PARM, G_3A_STAT, S_EXPOSURE
+ * Frames are rendered by SimSensorPollThread at the configured framerate.
+ */
+class SimSensorDevice
+    : public V4l2Device
+{
+    friend class SimSensorPollThread;
+
+    struct PendingExposure {
+        uint32_t  sequence;
+        double    time;        // us
+        double    gain;
+    };
+
+public:
+    explicit SimSensorDevice (const SimSensorConfig &config);
+    ~SimSensorDevice ();
+
+    const SimSensorConfig &get_config () const {
+        return _config;
+    }
+    int64_t get_frame_duration ();
+    void get_exposure (double &time, double &gain);
+
+    uint32_t get_frame_count ();
+    uint32_t get_dropped_count ();
+    uint32_t get_late_count ();
+    // buffers queued by the pipeline and not yet filled
+    uint32_t get_queued_count ();
+
+    virtual int io_control (int cmd, void *arg);
+
+protected:
+    virtual XCamReturn allocate_buffer (
+        SmartPtr<V4l2Buffer> &buf,
+        const struct v4l2_format &format,
+        const uint32_t index);
+
+private:
+    // called in SimSensorPollThread, BYPASS if no buffer queued
+    XCamReturn produce_frame (int64_t timestamp, uint32_t late_frames);
+
+    bool fill_format (struct v4l2_format &format);
+    int set_sim_format (struct v4l2_format &format);
+    void fill_sensor_mode_data (struct atomisp_sensor_mode_data &data);
+    void fill_grid_info (struct atomisp_grid_info &info);
+    int get_3a_stats (struct atomisp_3a_statistics &stats);
+    int set_exposure (const struct atomisp_exposure &exposure);
+
+    void init_scene ();
+    void update_luts (double time, double gain);
+    void advance_motion ();
+    void render (uint8_t *dest);
+    uint32_t read_pixel (const uint8_t *frame, uint32_t x, uint32_t y);
+    void calculate_stats (const uint8_t *frame);
+    uint32_t next_random ();
+
+    XCAM_DEAD_COPY (SimSensorDevice);
+
+private:
+    SimSensorConfig                     _config;
+    SmartPtr<SensorDescriptor>          _sensor;
+    Mutex                               _lock;
+
+    // driver side state, guarded by _lock
+    struct v4l2_fract                   _timeperframe;
+    bool                                _streaming;
+    std::list<uint32_t>                 _free_bufs;
+    std::list<struct v4l2_buffer>       _ready_bufs;
+    std::list<PendingExposure>          _pending_exposures;
+    std::vector<struct atomisp_3a_output> _stats;
+    uint32_t                            _stats_sequence;
+    double                              _exposure_time;
+    double                              _exposure_gain;
+    uint32_t                            _sequence;
+    uint32_t                            _dropped_count;
+    uint32_t                            _late_count;
+
+    // render state, only touched in the poll thread or while stopped
+    uint32_t                            _width;
+    uint32_t                            _height;
+    uint32_t                            _grid_width;
+    uint32_t                            _grid_height;
+    uint32_t                            _bits;
+    uint8_t                             _cfa[2][2];
+    std::vector<uint8_t>                _scene;
+    std::vector<uint8_t>                _row;
+    std::vector<int16_t>                _noise;
+    std::vector<uint16_t>               _luts[3];
+    std::vector<struct atomisp_3a_output> _stats_scratch;
+    double                              _lut_time;
+    double                              _lut_gain;
+    double                              _pan_x, _pan_y;
+    double                              _object_x, _object_y;
+    double                              _object_dx, _object_dy;
+    uint32_t                            _random;
+};
+
+/*
+ * SimSensorPollThread
+ * paces SimSensorDevice at its framerate, delivers every frame through
+ * the poll callback and follows it with a 3a stats event, the way the
+ * atomisp event device would.
+ */
+class SimSensorPollThread
+    : public PollThread
+{
+public:
+    explicit SimSensorPollThread ();
+    ~SimSensorPollThread ();
+
+    virtual XCamReturn start ();
+
+    //derived from PollThread
+    virtual void introspect (IntrospectionWriter &writer);
+
+protected:
+    virtual XCamReturn poll_buffer_loop ();
+
+private:
+    XCAM_DEAD_COPY (SimSensorPollThread);
+
+private:
+    int64_t         _next_frame_time;
+    bool            _stats_pool_ready;
+};
+
+};
+
+#endif //XCAM_SIM_SENSOR_H
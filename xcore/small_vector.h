@@ -0,0 +1,225 @@
+/*
+ * small_vector.h - vector with inline storage for short per-frame lists
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#ifndef XCAM_SMALL_VECTOR_H
+#define XCAM_SMALL_VECTOR_H
+
+#include "xcam_utils.h"
+#include <new>
+#include <type_traits>
+
+namespace XCam {
+
+/*
+ * SmallVector, drop-in for the std::list subset used on per-frame lists
+ * first InlineCount elements live inside the object, no allocation;
+ * beyond that storage moves to heap and doubles.
+ * Unlike std::list, erase/insert/push_back invalidate iterators:
+ * erase in loops must be written as "i = list.erase (i);".
+ */
+template <typename T, uint32_t InlineCount = 8>
+class SmallVector
+{
+public:
+    typedef T              value_type;
+    typedef T             *iterator;
+    typedef const T       *const_iterator;
+    typedef T             &reference;
+    typedef const T       &const_reference;
+    typedef size_t         size_type;
+
+public:
+    SmallVector ()
+        : _data (inline_data ())
+        , _size (0)
+        , _capacity (InlineCount)
+    {}
+    SmallVector (const SmallVector &other)
+        : _data (inline_data ())
+        , _size (0)
+        , _capacity (InlineCount)
+    {
+        insert (end (), other.begin (), other.end ());
+    }
+    ~SmallVector () {
+        clear ();
+        if (_data != inline_data ())
+            xcam_free (_data);
+    }
+
+    SmallVector &operator = (const SmallVector &other) {
+        if (this != &other) {
+            clear ();
+            insert (end (), other.begin (), other.end ());
+        }
+        return *this;
+    }
+
+    iterator begin () {
+        return _data;
+    }
+    iterator end () {
+        return _data + _size;
+    }
+    const_iterator begin () const {
+        return _data;
+    }
+    const_iterator end () const {
+        return _data + _size;
+    }
+
+    size_type size () const {
+        return _size;
+    }
+    bool empty () const {
+        return _size == 0;
+    }
+    bool is_inline () const {
+        return _data == inline_data ();
+    }
+
+    reference operator [] (size_type index) {
+        XCAM_ASSERT (index < _size);
+        return _data[index];
+    }
+    const_reference operator [] (size_type index) const {
+        XCAM_ASSERT (index < _size);
+        return _data[index];
+    }
+    reference front () {
+        XCAM_ASSERT (_size);
+        return _data[0];
+    }
+    reference back () {
+        XCAM_ASSERT (_size);
+        return _data[_size - 1];
+    }
+
+    void reserve (size_type count) {
+        if (count > _capacity)
+            grow (count);
+    }
+
+    void push_back (const T &value) {
+        if (_size == _capacity) {
+            // value may be an element of this vector
+            T copy (value);
+            grow (_size + 1);
+            new (_data + _size) T (copy);
+        } else
+            new (_data + _size) T (value);
+        ++_size;
+    }
+
+    void pop_back () {
+        XCAM_ASSERT (_size);
+        --_size;
+        _data[_size].~T ();
+    }
+
+    iterator erase (iterator pos) {
+        return erase (pos, pos + 1);
+    }
+
+    iterator erase (iterator first, iterator last) {
+        XCAM_ASSERT (first >= begin () && last <= end () && first <= last);
+        iterator dst = first;
+        for (iterator src = last; src != end (); ++src, ++dst)
+            *dst = *src;
+        for (iterator i = dst; i != end (); ++i)
+            i->~T ();
+        _size -= (last - first);
+        return first;
+    }
+
+    iterator insert (iterator pos, const T &value) {
+        size_type index = pos - begin ();
+        XCAM_ASSERT (index <= _size);
+        push_back (value);
+        rotate_tail (index, _size - 1);
+        return begin () + index;
+    }
+
+    template <typename InputIterator>
+    void insert (iterator pos, InputIterator first, InputIterator last) {
+        size_type index = pos - begin ();
+        size_type old_size = _size;
+        XCAM_ASSERT (index <= _size);
+        for (; first != last; ++first)
+            push_back (*first);
+        if (index != old_size)
+            rotate_tail (index, old_size);
+    }
+
+    template <typename InputIterator>
+    void assign (InputIterator first, InputIterator last) {
+        clear ();
+        insert (end (), first, last);
+    }
+
+    void clear () {
+        for (size_type i = 0; i < _size; ++i)
+            _data[i].~T ();
+        _size = 0;
+    }
+
+private:
+    T *inline_data () {
+        return reinterpret_cast<T *> (_storage);
+    }
+    const T *inline_data () const {
+        return reinterpret_cast<const T *> (_storage);
+    }
+
+    void grow (size_type min_capacity) {
+        size_type capacity = XCAM_MAX (_capacity * 2, min_capacity);
+        T *data = (T *) xcam_malloc (capacity * sizeof (T));
+        XCAM_ASSERT (data);
+        for (size_type i = 0; i < _size; ++i) {
+            new (data + i) T (_data[i]);
+            _data[i].~T ();
+        }
+        if (_data != inline_data ())
+            xcam_free (_data);
+        _data = data;
+        _capacity = capacity;
+    }
+
+    // move elements [middle, size) in front of [index, middle)
+    void rotate_tail (size_type index, size_type middle) {
+        for (; index < middle && middle < _size; ++index, ++middle) {
+            for (size_type i = middle; i > index; --i) {
+                T tmp (_data[i]);
+                _data[i] = _data[i - 1];
+                _data[i - 1] = tmp;
+            }
+        }
+    }
+
+private:
+    T                *_data;
+    size_type         _size;
+    size_type         _capacity;
+    typename std::aligned_storage<sizeof (T), std::alignment_of<T>::value>::type _storage[InlineCount];
+};
+
+};
+
+#endif //XCAM_SMALL_VECTOR_H
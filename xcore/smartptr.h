@@ -28,17 +28,38 @@ namespace XCam {
 
 class RefCount {
 public:
-    RefCount (): _ref_count(1) {}
+    RefCount (bool embedded = false): _ref_count(1), _embedded (embedded) {}
     void ref() {
         ++_ref_count;
     }
     uint32_t unref() {
         return --_ref_count;
     }
+    // part of the object, freed with it
+    bool is_embedded () const {
+        return _embedded;
+    }
 private:
     mutable std::atomic<uint32_t> _ref_count;
+    bool                          _embedded;
 };
 
+class ArenaObject;
+RefCount *arena_object_ref_count (ArenaObject *obj);
+
+// ArenaObject derived pointers pick the second one, see frame_arena.h
+inline RefCount *
+new_ref_count (void *)
+{
+    return new RefCount ();
+}
+
+inline RefCount *
+new_ref_count (ArenaObject *obj)
+{
+    return arena_object_ref_count (obj);
+}
+
 
 template <typename Obj>
 class SmartPtr {
@@ -47,12 +68,12 @@ private:
 public:
     SmartPtr (Obj *obj = NULL) : _ptr (obj), _ref(NULL) {
         if (_ptr)
-            _ref = new RefCount();
+            _ref = new_ref_count (obj);
     }
     template <typename ObjDerive>
     SmartPtr (ObjDerive *obj) : _ptr (obj), _ref(NULL) {
         if (_ptr)
-            _ref = new RefCount();
+            _ref = new_ref_count (obj);
     }
 
     // copy from pointer
@@ -108,7 +129,8 @@ public:
             return;
         XCAM_ASSERT (_ref);
         if (!_ref->unref()) {
-            delete _ref;
+            if (!_ref->is_embedded ())
+                delete _ref;
             delete _ptr;
         }
         _ptr = NULL;
@@ -128,17 +150,19 @@ public:
         return ret;
     }
 private:
-    void new_pointer (Obj *obj, RefCount *ref) {
+    template <typename ObjDerive>
+    void new_pointer (ObjDerive *obj, RefCount *ref) {
         if (!obj) {
             _ptr = NULL;
             _ref = NULL;
+            return;
         }
         _ptr = obj;
         if (ref) {
             _ref = ref;
             _ref->ref();
         } else
-            _ref = new RefCount();
+            _ref = new_ref_count (obj);
     }
 
 private:
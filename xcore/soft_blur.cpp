@@ -0,0 +1,468 @@
+/*
+ * soft_blur.cpp - soft(cpu) separable gaussian and box blur
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#include "soft_blur.h"
+#include <math.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// rows filtered before one transposed store
+#define SOFT_BLUR_BLOCK_ROWS 16
+
+namespace XCam {
+
+template <typename T> struct SoftPixelTraits;
+template <> struct SoftPixelTraits<uint8_t> {
+    static float max_value () {
+        return 255.0f;
+    }
+};
+template <> struct SoftPixelTraits<uint16_t> {
+    static float max_value () {
+        return 65535.0f;
+    }
+};
+
+template <typename T>
+inline static T
+float_to_pixel (float v)
+{
+    v = XCAM_MAX (v, 0.0f);
+    v = XCAM_MIN (v, SoftPixelTraits<T>::max_value ());
+    return (T)(v + 0.5f);
+}
+
+template <>
+inline float
+float_to_pixel<float> (float v)
+{
+    return v;
+}
+
+template <typename T>
+static void
+load_line (const T *src, float *dst, uint32_t n)
+{
+    for (uint32_t i = 0; i < n; ++i)
+        dst[i] = src[i];
+}
+
+#if defined(__SSE2__)
+template <>
+void
+load_line<uint8_t> (const uint8_t *src, float *dst, uint32_t n)
+{
+    const __m128i zero = _mm_setzero_si128 ();
+    uint32_t i = 0;
+
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128 ((const __m128i *)(src + i));
+        __m128i lo = _mm_unpacklo_epi8 (v, zero);
+        __m128i hi = _mm_unpackhi_epi8 (v, zero);
+        _mm_storeu_ps (dst + i, _mm_cvtepi32_ps (_mm_unpacklo_epi16 (lo, zero)));
+        _mm_storeu_ps (dst + i + 4, _mm_cvtepi32_ps (_mm_unpackhi_epi16 (lo, zero)));
+        _mm_storeu_ps (dst + i + 8, _mm_cvtepi32_ps (_mm_unpacklo_epi16 (hi, zero)));
+        _mm_storeu_ps (dst + i + 12, _mm_cvtepi32_ps (_mm_unpackhi_epi16 (hi, zero)));
+    }
+    for (; i < n; ++i)
+        dst[i] = src[i];
+}
+
+template <>
+void
+load_line<uint16_t> (const uint16_t *src, float *dst, uint32_t n)
+{
+    const __m128i zero = _mm_setzero_si128 ();
+    uint32_t i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+        __m128i v = _mm_loadu_si128 ((const __m128i *)(src + i));
+        _mm_storeu_ps (dst + i, _mm_cvtepi32_ps (_mm_unpacklo_epi16 (v, zero)));
+        _mm_storeu_ps (dst + i + 4, _mm_cvtepi32_ps (_mm_unpackhi_epi16 (v, zero)));
+    }
+    for (; i < n; ++i)
+        dst[i] = src[i];
+}
+
+// store 4 values of a transposed column, same rounding as float_to_pixel
+template <typename T>
+inline static void
+store_4 (T *dst, __m128 v);
+
+template <>
+inline void
+store_4<float> (float *dst, __m128 v)
+{
+    _mm_storeu_ps (dst, v);
+}
+
+template <>
+inline void
+store_4<uint8_t> (uint8_t *dst, __m128 v)
+{
+    v = _mm_min_ps (_mm_max_ps (v, _mm_setzero_ps ()), _mm_set1_ps (255.0f));
+    __m128i i32 = _mm_cvttps_epi32 (_mm_add_ps (v, _mm_set1_ps (0.5f)));
+    __m128i i16 = _mm_packs_epi32 (i32, i32);
+    int32_t packed = _mm_cvtsi128_si32 (_mm_packus_epi16 (i16, i16));
+    memcpy (dst, &packed, sizeof (packed));
+}
+
+template <>
+inline void
+store_4<uint16_t> (uint16_t *dst, __m128 v)
+{
+    v = _mm_min_ps (_mm_max_ps (v, _mm_setzero_ps ()), _mm_set1_ps (65535.0f));
+    __m128i i32 = _mm_cvttps_epi32 (_mm_add_ps (v, _mm_set1_ps (0.5f)));
+    // no unsigned 32 to 16 saturating pack in SSE2, bias into signed range
+    i32 = _mm_sub_epi32 (i32, _mm_set1_epi32 (32768));
+    __m128i i16 = _mm_xor_si128 (_mm_packs_epi32 (i32, i32), _mm_set1_epi16 ((int16_t)0x8000));
+    _mm_storel_epi64 ((__m128i *)dst, i16);
+}
+#endif
+
+/*
+ * rows[r * n + x] of block rows [y0, y0 + rows_count) go to
+ * dst row x, column y0 + r
+ */
+template <typename T>
+static void
+store_transposed (
+    const float *rows, uint32_t rows_count, uint32_t n,
+    uint8_t *dst, uint32_t dst_stride, uint32_t y0)
+{
+    uint32_t x = 0;
+
+#if defined(__SSE2__)
+    uint32_t tile_rows = rows_count / 4 * 4;
+    for (; x + 4 <= n; x += 4) {
+        for (uint32_t r = 0; r < tile_rows; r += 4) {
+            __m128 c0 = _mm_loadu_ps (rows + r * n + x);
+            __m128 c1 = _mm_loadu_ps (rows + (r + 1) * n + x);
+            __m128 c2 = _mm_loadu_ps (rows + (r + 2) * n + x);
+            __m128 c3 = _mm_loadu_ps (rows + (r + 3) * n + x);
+            _MM_TRANSPOSE4_PS (c0, c1, c2, c3);
+            store_4<T> ((T *)(dst + x * dst_stride) + y0 + r, c0);
+            store_4<T> ((T *)(dst + (x + 1) * dst_stride) + y0 + r, c1);
+            store_4<T> ((T *)(dst + (x + 2) * dst_stride) + y0 + r, c2);
+            store_4<T> ((T *)(dst + (x + 3) * dst_stride) + y0 + r, c3);
+        }
+        for (uint32_t r = tile_rows; r < rows_count; ++r) {
+            for (uint32_t k = 0; k < 4; ++k)
+                ((T *)(dst + (x + k) * dst_stride))[y0 + r] = float_to_pixel<T> (rows[r * n + x + k]);
+        }
+    }
+#endif
+
+    for (; x < n; ++x) {
+        T *dst_line = (T *)(dst + x * dst_stride) + y0;
+        for (uint32_t r = 0; r < rows_count; ++r)
+            dst_line[r] = float_to_pixel<T> (rows[r * n + x]);
+    }
+}
+
+/*
+ * filter rows [begin, end) of src along rows and write them
+ * as columns of dst
+ */
+template <typename TIn, typename TOut>
+class SoftBlurPassTask
+    : public SoftBandTask
+{
+public:
+    const SoftBlur  *blur;
+    const uint8_t   *src;
+    uint32_t         src_stride;
+    uint32_t         length;
+    uint8_t         *dst;
+    uint32_t         dst_stride;
+
+    virtual XCamReturn work (uint32_t begin, uint32_t end) {
+        uint32_t pad = blur->get_pad ();
+        std::vector<float> line (length + pad * 2);
+        std::vector<float> rows (length * SOFT_BLUR_BLOCK_ROWS);
+        float *line_start = &line[pad];
+
+        for (uint32_t y0 = begin; y0 < end; y0 += SOFT_BLUR_BLOCK_ROWS) {
+            uint32_t rows_count = XCAM_MIN (end - y0, (uint32_t)SOFT_BLUR_BLOCK_ROWS);
+
+            for (uint32_t r = 0; r < rows_count; ++r) {
+                load_line<TIn> ((const TIn *)(src + (y0 + r) * src_stride), line_start, length);
+                blur->filter_line (line_start, length, &rows[r * length]);
+            }
+            store_transposed<TOut> (&rows[0], rows_count, length, dst, dst_stride, y0);
+        }
+        return XCAM_RETURN_NO_ERROR;
+    }
+};
+
+template <typename TIn, typename TOut>
+static XCamReturn
+run_blur_pass (
+    SmartPtr<SoftWorkerPool> &workers, const SoftBlur *blur,
+    const uint8_t *src, uint32_t src_stride, uint32_t length, uint32_t rows,
+    uint8_t *dst, uint32_t dst_stride)
+{
+    SoftBlurPassTask<TIn, TOut> task;
+    task.blur = blur;
+    task.src = src;
+    task.src_stride = src_stride;
+    task.length = length;
+    task.dst = dst;
+    task.dst_stride = dst_stride;
+    return workers->run (task, rows, SOFT_BLUR_BLOCK_ROWS);
+}
+
+static void
+pad_line (float *line, uint32_t n, uint32_t pad)
+{
+    for (uint32_t i = 1; i <= pad; ++i) {
+        line[-(int32_t)i] = line[0];
+        line[n - 1 + i] = line[n - 1];
+    }
+}
+
+static void
+gauss_line (const float *line, uint32_t n, const float *kernel, uint32_t radius, float *out)
+{
+    uint32_t i = 0;
+
+#if defined(__SSE2__)
+    for (; i + 4 <= n; i += 4) {
+        __m128 acc = _mm_mul_ps (_mm_loadu_ps (line + i), _mm_set1_ps (kernel[0]));
+        for (uint32_t j = 1; j <= radius; ++j) {
+            __m128 pair = _mm_add_ps (_mm_loadu_ps (line + i - j), _mm_loadu_ps (line + i + j));
+            acc = _mm_add_ps (acc, _mm_mul_ps (pair, _mm_set1_ps (kernel[j])));
+        }
+        _mm_storeu_ps (out + i, acc);
+    }
+#endif
+
+    for (; i < n; ++i) {
+        float acc = line[i] * kernel[0];
+        for (uint32_t j = 1; j <= radius; ++j)
+            acc += (line[(int32_t)i - (int32_t)j] + line[i + j]) * kernel[j];
+        out[i] = acc;
+    }
+}
+
+static void
+box_line (const float *line, uint32_t n, uint32_t radius, float *out)
+{
+    // double sum, no drift along long lines
+    double sum = 0.0;
+    const double scale = 1.0 / (radius * 2 + 1);
+
+    for (int32_t j = -(int32_t)radius; j <= (int32_t)radius; ++j)
+        sum += line[j];
+    out[0] = sum * scale;
+    for (uint32_t i = 1; i < n; ++i) {
+        sum += line[i + radius] - line[(int32_t)i - (int32_t)radius - 1];
+        out[i] = sum * scale;
+    }
+}
+
+SoftBlur::SoftBlur (const char *name)
+    : _name (NULL)
+    , _method (SoftBlurGaussian)
+    , _pad (0)
+{
+    if (name)
+        _name = strndup (name, XCAM_MAX_STR_SIZE);
+    set_gaussian (1.0f);
+}
+
+SoftBlur::~SoftBlur ()
+{
+    if (_name)
+        xcam_free (_name);
+}
+
+bool
+SoftBlur::set_gaussian (float sigma, SoftBlurMethod method)
+{
+    XCAM_FAIL_RETURN (
+        WARNING,
+        sigma > 0.0f,
+        false,
+        "SoftBlur(%s) invalid sigma:%f", XCAM_STR (_name), sigma);
+
+    if (method == SoftBlurAuto)
+        method = (sigma <= XCAM_SOFT_BLUR_BOX_SIGMA ? SoftBlurGaussian : SoftBlurBoxCascade);
+
+    if (method == SoftBlurGaussian) {
+        uint32_t radius = XCAM_MAX ((uint32_t)ceilf (sigma * 3.0f), 1u);
+        XCAM_FAIL_RETURN (
+            WARNING,
+            radius <= XCAM_SOFT_BLUR_MAX_RADIUS,
+            false,
+            "SoftBlur(%s) sigma:%f too large for gaussian kernel", XCAM_STR (_name), sigma);
+
+        double sum = 0.0;
+        _kernel.resize (radius + 1);
+        for (uint32_t i = 0; i <= radius; ++i) {
+            _kernel[i] = expf (-(float)(i * i) / (2.0f * sigma * sigma));
+            sum += (i ? 2.0 : 1.0) * _kernel[i];
+        }
+        for (uint32_t i = 0; i <= radius; ++i)
+            _kernel[i] /= sum;
+
+        _box_radius.clear ();
+        _pad = radius;
+        _method = SoftBlurGaussian;
+        return true;
+    }
+
+    /*
+     * boxes of width wl or wu = wl + 2, m of them wl, so that the variance
+     * of the cascade, sum (w * w - 1) / 12, is the closest to sigma * sigma
+     */
+    const uint32_t passes = XCAM_SOFT_BLUR_BOX_PASSES;
+    float w_ideal = sqrtf (12.0f * sigma * sigma / passes + 1.0f);
+    int32_t wl = (int32_t)floorf (w_ideal);
+    if (wl % 2 == 0)
+        --wl;
+    int32_t m = (int32_t)roundf (
+                    (12.0f * sigma * sigma - passes * wl * wl - 4.0f * passes * wl - 3.0f * passes) / (-4.0f * wl - 4.0f));
+
+    _box_radius.resize (passes);
+    _pad = 0;
+    for (uint32_t i = 0; i < passes; ++i) {
+        _box_radius[i] = ((int32_t)i < m ? wl - 1 : wl + 1) / 2;
+        _pad = XCAM_MAX (_pad, _box_radius[i]);
+    }
+    XCAM_FAIL_RETURN (
+        WARNING,
+        _pad <= XCAM_SOFT_BLUR_MAX_RADIUS,
+        false,
+        "SoftBlur(%s) sigma:%f too large", XCAM_STR (_name), sigma);
+
+    _kernel.clear ();
+    _method = SoftBlurBoxCascade;
+    return true;
+}
+
+bool
+SoftBlur::set_box (uint32_t radius, uint32_t passes)
+{
+    XCAM_FAIL_RETURN (
+        WARNING,
+        radius && radius <= XCAM_SOFT_BLUR_MAX_RADIUS && passes,
+        false,
+        "SoftBlur(%s) invalid box radius:%d passes:%d", XCAM_STR (_name), radius, passes);
+
+    _box_radius.assign (passes, radius);
+    _kernel.clear ();
+    _pad = radius;
+    _method = SoftBlurBoxCascade;
+    return true;
+}
+
+void
+SoftBlur::filter_line (float *line, uint32_t n, float *out) const
+{
+    pad_line (line, n, _pad);
+
+    if (_method == SoftBlurGaussian) {
+        gauss_line (line, n, &_kernel[0], _kernel.size () - 1, out);
+        return;
+    }
+
+    for (uint32_t i = 0; i < _box_radius.size (); ++i) {
+        if (i) {
+            memcpy (line, out, n * sizeof (float));
+            pad_line (line, n, _pad);
+        }
+        box_line (line, n, _box_radius[i], out);
+    }
+}
+
+XCamReturn
+SoftBlur::blur (const SoftPlane &in, const SoftPlane &out)
+{
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+    uint8_t *transposed = NULL;
+    uint32_t transposed_stride = in.height * sizeof (float);
+
+    XCAM_FAIL_RETURN (
+        WARNING,
+        in.data && out.data && in.width && in.height &&
+        in.width == out.width && in.height == out.height,
+        XCAM_RETURN_ERROR_PARAM,
+        "SoftBlur(%s) invalid planes, in(%dx%d) out(%dx%d)",
+        XCAM_STR (_name), in.width, in.height, out.width, out.height);
+
+    if (!_workers.ptr ())
+        _workers = new SoftWorkerPool (_name);
+
+    _transposed.resize (in.width * in.height);
+    transposed = (uint8_t *)&_transposed[0];
+
+    // rows of in to rows of transposed
+    switch (in.type) {
+    case SoftPlaneU8:
+        ret = run_blur_pass<uint8_t, float> (
+                  _workers, this, in.data, in.stride, in.width, in.height, transposed, transposed_stride);
+        break;
+    case SoftPlaneU16:
+        ret = run_blur_pass<uint16_t, float> (
+                  _workers, this, in.data, in.stride, in.width, in.height, transposed, transposed_stride);
+        break;
+    case SoftPlaneF32:
+        ret = run_blur_pass<float, float> (
+                  _workers, this, in.data, in.stride, in.width, in.height, transposed, transposed_stride);
+        break;
+    default:
+        ret = XCAM_RETURN_ERROR_PARAM;
+    }
+    XCAM_FAIL_RETURN (
+        WARNING,
+        ret == XCAM_RETURN_NO_ERROR,
+        ret,
+        "SoftBlur(%s) horizontal pass failed, in type:%d", XCAM_STR (_name), in.type);
+
+    // columns of in to rows of out
+    switch (out.type) {
+    case SoftPlaneU8:
+        ret = run_blur_pass<float, uint8_t> (
+                  _workers, this, transposed, transposed_stride, in.height, in.width, out.data, out.stride);
+        break;
+    case SoftPlaneU16:
+        ret = run_blur_pass<float, uint16_t> (
+                  _workers, this, transposed, transposed_stride, in.height, in.width, out.data, out.stride);
+        break;
+    case SoftPlaneF32:
+        ret = run_blur_pass<float, float> (
+                  _workers, this, transposed, transposed_stride, in.height, in.width, out.data, out.stride);
+        break;
+    default:
+        ret = XCAM_RETURN_ERROR_PARAM;
+    }
+    XCAM_FAIL_RETURN (
+        WARNING,
+        ret == XCAM_RETURN_NO_ERROR,
+        ret,
+        "SoftBlur(%s) vertical pass failed, out type:%d", XCAM_STR (_name), out.type);
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+};
@@ -0,0 +1,123 @@
+/*
+ * soft_blur.h - soft(cpu) separable gaussian and box blur
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#ifndef XCAM_SOFT_BLUR_H
+#define XCAM_SOFT_BLUR_H
+
+#include "xcam_utils.h"
+#include "smartptr.h"
+#include "soft_worker_pool.h"
+#include <vector>
+
+// above this sigma, gaussian is approximated by box cascade
+#define XCAM_SOFT_BLUR_BOX_SIGMA 4.0f
+#define XCAM_SOFT_BLUR_BOX_PASSES 3
+#define XCAM_SOFT_BLUR_MAX_RADIUS 256
+
+namespace XCam {
+
+enum SoftPlaneType {
+    SoftPlaneU8 = 0,
+    SoftPlaneU16,
+    SoftPlaneF32,
+};
+
+/*
+ * one channel plane in host memory, stride in bytes
+ */
+struct SoftPlane {
+    SoftPlaneType  type;
+    uint8_t       *data;
+    uint32_t       width;
+    uint32_t       height;
+    uint32_t       stride;
+
+    SoftPlane ()
+        : type (SoftPlaneU8)
+        , data (NULL)
+        , width (0)
+        , height (0)
+        , stride (0)
+    {}
+    SoftPlane (SoftPlaneType t, uint8_t *d, uint32_t w, uint32_t h, uint32_t s)
+        : type (t)
+        , data (d)
+        , width (w)
+        , height (h)
+        , stride (s)
+    {}
+};
+
+enum SoftBlurMethod {
+    SoftBlurAuto = 0,
+    SoftBlurGaussian,    // separable gaussian kernel, radius = ceil (3 * sigma)
+    SoftBlurBoxCascade,  // running sum box passes, O(1) per pixel for any sigma
+};
+
+/*
+ * SoftBlur
+ * both passes filter along rows, the first one writes a transposed f32
+ * intermediate in 16-row blocks, the second one filters it and writes
+ * transposed back, so columns are never walked with a large stride.
+ * edges are clamped, in and out can be the same plane.
+ * not thread safe, one blur() at a time on each instance.
+ */
+class SoftBlur
+{
+public:
+    explicit SoftBlur (const char *name = "soft_blur");
+    ~SoftBlur ();
+
+    bool set_gaussian (float sigma, SoftBlurMethod method = SoftBlurAuto);
+    bool set_box (uint32_t radius, uint32_t passes = 1);
+    SoftBlurMethod get_method () const {
+        return _method;
+    }
+    // share worker threads with other soft modules, otherwise created on first blur
+    void set_workers (SmartPtr<SoftWorkerPool> &workers) {
+        _workers = workers;
+    }
+
+    // in and out must be the same size, types can differ
+    XCamReturn blur (const SoftPlane &in, const SoftPlane &out);
+
+    // filter one f32 line, line[-get_pad()] ... line[n - 1 + get_pad()] valid
+    // and overwritten by box cascade
+    void filter_line (float *line, uint32_t n, float *out) const;
+    uint32_t get_pad () const {
+        return _pad;
+    }
+
+private:
+    XCAM_DEAD_COPY (SoftBlur);
+
+private:
+    char                      *_name;
+    SoftBlurMethod             _method;
+    std::vector<float>         _kernel;      // half kernel, [0] is center
+    std::vector<uint32_t>      _box_radius;  // radius of each box pass
+    uint32_t                   _pad;
+    std::vector<float>         _transposed;
+    SmartPtr<SoftWorkerPool>   _workers;
+};
+
+};
+
+#endif //XCAM_SOFT_BLUR_H
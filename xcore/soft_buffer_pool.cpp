@@ -0,0 +1,89 @@
+/*
+ * soft_buffer_pool.cpp - host memory buffer pool for soft(cpu) handlers
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#include "soft_buffer_pool.h"
+
+namespace XCam {
+
+SoftBufferData::SoftBufferData (uint32_t size)
+    : _buf (NULL)
+    , _size (size)
+{
+    void *ptr = NULL;
+
+    XCAM_ASSERT (size);
+    if (posix_memalign (&ptr, XCAM_SOFT_BUFFER_ALIGNMENT, size) != 0) {
+        XCAM_LOG_ERROR ("SoftBufferData allocate %d bytes failed", size);
+        return;
+    }
+    _buf = (uint8_t *)ptr;
+}
+
+SoftBufferData::~SoftBufferData ()
+{
+    if (_buf)
+        free (_buf);
+}
+
+uint8_t *
+SoftBufferData::map ()
+{
+    return _buf;
+}
+
+bool
+SoftBufferData::unmap ()
+{
+    return true;
+}
+
+SoftBufferPool::SoftBufferPool ()
+{
+}
+
+bool
+SoftBufferPool::fixate_video_info (VideoBufferInfo &info)
+{
+    // align every line to XCAM_SOFT_BUFFER_ALIGNMENT bytes so that SIMD loops
+    // can process whole vectors on each line without peeling
+    uint32_t aligned_width = XCAM_MAX (info.aligned_width, XCAM_ALIGN_UP (info.width, XCAM_SOFT_BUFFER_ALIGNMENT));
+    uint32_t aligned_height = XCAM_MAX (info.aligned_height, XCAM_ALIGN_UP (info.height, 2));
+
+    if (aligned_width == info.aligned_width && aligned_height == info.aligned_height)
+        return true;
+
+    return info.init (info.format, info.width, info.height, aligned_width, aligned_height);
+}
+
+SmartPtr<BufferData>
+SoftBufferPool::allocate_data (const VideoBufferInfo &buffer_info)
+{
+    SmartPtr<SoftBufferData> data = new SoftBufferData (buffer_info.size);
+
+    XCAM_FAIL_RETURN (
+        ERROR,
+        data->is_valid (),
+        NULL,
+        "SoftBufferPool allocate data failed, size:%d", buffer_info.size);
+
+    return data;
+}
+
+};
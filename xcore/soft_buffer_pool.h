@@ -0,0 +1,72 @@
+/*
+ * soft_buffer_pool.h - host memory buffer pool for soft(cpu) handlers
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#ifndef XCAM_SOFT_BUFFER_POOL_H
+#define XCAM_SOFT_BUFFER_POOL_H
+
+#include "xcam_utils.h"
+#include "buffer_pool.h"
+
+namespace XCam {
+
+// every plane of soft buffer starts from this alignment, enough for SSE/AVX loads
+#define XCAM_SOFT_BUFFER_ALIGNMENT 32
+
+class SoftBufferData
+    : public BufferData
+{
+public:
+    explicit SoftBufferData (uint32_t size);
+    ~SoftBufferData ();
+
+    bool is_valid () const {
+        return _buf != NULL;
+    }
+
+    //derived from BufferData
+    virtual uint8_t *map ();
+    virtual bool unmap ();
+
+private:
+    XCAM_DEAD_COPY (SoftBufferData);
+
+private:
+    uint8_t          *_buf;
+    uint32_t          _size;
+};
+
+class SoftBufferPool
+    : public BufferPool
+{
+public:
+    explicit SoftBufferPool ();
+
+protected:
+    // derived from BufferPool
+    virtual bool fixate_video_info (VideoBufferInfo &info);
+    virtual SmartPtr<BufferData> allocate_data (const VideoBufferInfo &buffer_info);
+
+private:
+    XCAM_DEAD_COPY (SoftBufferPool);
+};
+
+};
+
+#endif //XCAM_SOFT_BUFFER_POOL_H
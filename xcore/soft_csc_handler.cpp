@@ -0,0 +1,256 @@
+/*
+ * soft_csc_handler.cpp - soft(cpu) color space conversion handler
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#include "soft_csc_handler.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace XCam {
+
+/*
+ * one line pair of packed 4:2:2 to 4:2:0
+ * Uyvy: luma on odd bytes (UYVY) or even bytes (YUYV)
+ * PlanarUV: separated U/V planes (I420) or interleaved UV plane (NV12)
+ */
+template <bool Uyvy, bool PlanarUV>
+static void
+convert_line_pair (
+    const uint8_t *in0, const uint8_t *in1,
+    uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v,
+    uint32_t width)
+{
+    const uint32_t y_idx = Uyvy ? 1 : 0;
+    const uint32_t c_idx = Uyvy ? 0 : 1;
+    uint32_t x = 0;
+
+#if defined(__SSE2__)
+    const __m128i low_mask = _mm_set1_epi16 (0x00ff);
+    const __m128i zero = _mm_setzero_si128 ();
+
+    // 16 pixels of two lines per loop
+    for (; x + 16 <= width; x += 16) {
+        __m128i a0 = _mm_loadu_si128 ((const __m128i *)(in0 + x * 2));
+        __m128i a1 = _mm_loadu_si128 ((const __m128i *)(in0 + x * 2 + 16));
+        __m128i b0 = _mm_loadu_si128 ((const __m128i *)(in1 + x * 2));
+        __m128i b1 = _mm_loadu_si128 ((const __m128i *)(in1 + x * 2 + 16));
+        __m128i ya, yb, ca, cb;
+
+        if (Uyvy) {
+            ya = _mm_packus_epi16 (_mm_srli_epi16 (a0, 8), _mm_srli_epi16 (a1, 8));
+            yb = _mm_packus_epi16 (_mm_srli_epi16 (b0, 8), _mm_srli_epi16 (b1, 8));
+            ca = _mm_packus_epi16 (_mm_and_si128 (a0, low_mask), _mm_and_si128 (a1, low_mask));
+            cb = _mm_packus_epi16 (_mm_and_si128 (b0, low_mask), _mm_and_si128 (b1, low_mask));
+        } else {
+            ya = _mm_packus_epi16 (_mm_and_si128 (a0, low_mask), _mm_and_si128 (a1, low_mask));
+            yb = _mm_packus_epi16 (_mm_and_si128 (b0, low_mask), _mm_and_si128 (b1, low_mask));
+            ca = _mm_packus_epi16 (_mm_srli_epi16 (a0, 8), _mm_srli_epi16 (a1, 8));
+            cb = _mm_packus_epi16 (_mm_srli_epi16 (b0, 8), _mm_srli_epi16 (b1, 8));
+        }
+        _mm_storeu_si128 ((__m128i *)(y0 + x), ya);
+        _mm_storeu_si128 ((__m128i *)(y1 + x), yb);
+
+        // U0 V0 U1 V1 ..., (a + b + 1) >> 1
+        __m128i uv = _mm_avg_epu8 (ca, cb);
+        if (PlanarUV) {
+            _mm_storel_epi64 ((__m128i *)(u + x / 2), _mm_packus_epi16 (_mm_and_si128 (uv, low_mask), zero));
+            _mm_storel_epi64 ((__m128i *)(v + x / 2), _mm_packus_epi16 (_mm_srli_epi16 (uv, 8), zero));
+        } else
+            _mm_storeu_si128 ((__m128i *)(u + x), uv);
+    }
+#endif
+
+    for (; x < width; x += 2) {
+        const uint8_t *p0 = in0 + x * 2;
+        const uint8_t *p1 = in1 + x * 2;
+
+        y0[x] = p0[y_idx];
+        y0[x + 1] = p0[y_idx + 2];
+        y1[x] = p1[y_idx];
+        y1[x + 1] = p1[y_idx + 2];
+
+        uint8_t cu = (p0[c_idx] + p1[c_idx] + 1) >> 1;
+        uint8_t cv = (p0[c_idx + 2] + p1[c_idx + 2] + 1) >> 1;
+        if (PlanarUV) {
+            u[x / 2] = cu;
+            v[x / 2] = cv;
+        } else {
+            u[x] = cu;
+            u[x + 1] = cv;
+        }
+    }
+}
+
+typedef void (*ConvertLinePairFunc) (
+    const uint8_t *in0, const uint8_t *in1,
+    uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v,
+    uint32_t width);
+
+// rows of the task are line pairs
+class PackedToPlanarTask
+    : public SoftBandTask
+{
+public:
+    ConvertLinePairFunc  convert;
+    const uint8_t       *in;
+    uint32_t             in_stride;
+    uint8_t             *y;
+    uint32_t             y_stride;
+    uint8_t             *u;
+    uint32_t             u_stride;
+    uint8_t             *v;
+    uint32_t             v_stride;
+    uint32_t             width;
+
+    virtual XCamReturn work (uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; ++i) {
+            const uint8_t *in0 = in + 2 * i * in_stride;
+            uint8_t *y0 = y + 2 * i * y_stride;
+            convert (
+                in0, in0 + in_stride, y0, y0 + y_stride,
+                u + i * u_stride, (v ? v + i * v_stride : NULL), width);
+        }
+        return XCAM_RETURN_NO_ERROR;
+    }
+};
+
+SoftCscImageHandler::SoftCscImageHandler (const char *name, uint32_t output_format)
+    : SoftImageHandler (name)
+    , _output_format (output_format)
+    , _thread_count (0)
+{
+}
+
+bool
+SoftCscImageHandler::set_output_format (uint32_t format)
+{
+    XCAM_FAIL_RETURN (
+        WARNING,
+        format == V4L2_PIX_FMT_NV12 || format == V4L2_PIX_FMT_YUV420,
+        false,
+        "SoftCscImageHandler(%s) unsupported output format(%s)",
+        XCAM_STR (get_name ()), xcam_fourcc_to_string (format));
+
+    _output_format = format;
+    return true;
+}
+
+bool
+SoftCscImageHandler::set_thread_count (uint32_t count)
+{
+    XCAM_FAIL_RETURN (
+        WARNING,
+        !_workers.ptr (),
+        false,
+        "SoftCscImageHandler(%s) set thread count after workers started", XCAM_STR (get_name ()));
+
+    _thread_count = count;
+    return true;
+}
+
+void
+SoftCscImageHandler::emit_stop ()
+{
+    if (_workers.ptr ())
+        _workers->stop ();
+    SoftImageHandler::emit_stop ();
+}
+
+XCamReturn
+SoftCscImageHandler::prepare_buffer_pool_video_info (
+    const VideoBufferInfo &input,
+    VideoBufferInfo &output)
+{
+    bool format_inited = output.init (_output_format, input.width, input.height);
+
+    XCAM_FAIL_RETURN (
+        WARNING,
+        format_inited,
+        XCAM_RETURN_ERROR_PARAM,
+        "SoftCscImageHandler(%s) ouput format(%s) unsupported",
+        XCAM_STR (get_name ()), xcam_fourcc_to_string (_output_format));
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+SoftCscImageHandler::process (
+    const VideoBufferInfo &in_info, uint8_t *in_mem,
+    const VideoBufferInfo &out_info, uint8_t *out_mem)
+{
+    PackedToPlanarTask task;
+    bool uyvy = (in_info.format == V4L2_PIX_FMT_UYVY);
+    bool planar_uv = (out_info.format == V4L2_PIX_FMT_YUV420);
+
+    XCAM_FAIL_RETURN (
+        WARNING,
+        in_info.format == V4L2_PIX_FMT_YUYV || in_info.format == V4L2_PIX_FMT_UYVY,
+        XCAM_RETURN_ERROR_PARAM,
+        "SoftCscImageHandler(%s) unsupported input format(%s)",
+        XCAM_STR (get_name ()), xcam_fourcc_to_string (in_info.format));
+    XCAM_FAIL_RETURN (
+        WARNING,
+        out_info.format == V4L2_PIX_FMT_NV12 || out_info.format == V4L2_PIX_FMT_YUV420,
+        XCAM_RETURN_ERROR_PARAM,
+        "SoftCscImageHandler(%s) unsupported output format(%s)",
+        XCAM_STR (get_name ()), xcam_fourcc_to_string (out_info.format));
+    XCAM_FAIL_RETURN (
+        WARNING,
+        in_info.width == out_info.width && in_info.height == out_info.height &&
+        !(in_info.width % 2) && !(in_info.height % 2),
+        XCAM_RETURN_ERROR_PARAM,
+        "SoftCscImageHandler(%s) size mismatch or odd, in(%dx%d) out(%dx%d)",
+        XCAM_STR (get_name ()), in_info.width, in_info.height, out_info.width, out_info.height);
+
+    if (uyvy)
+        task.convert = planar_uv ? convert_line_pair<true, true> : convert_line_pair<true, false>;
+    else
+        task.convert = planar_uv ? convert_line_pair<false, true> : convert_line_pair<false, false>;
+    task.in = in_mem + in_info.offsets[0];
+    task.in_stride = in_info.strides[0];
+    task.y = out_mem + out_info.offsets[0];
+    task.y_stride = out_info.strides[0];
+    task.u = out_mem + out_info.offsets[1];
+    task.u_stride = out_info.strides[1];
+    task.v = planar_uv ? out_mem + out_info.offsets[2] : NULL;
+    task.v_stride = planar_uv ? out_info.strides[2] : 0;
+    task.width = in_info.width;
+
+    if (!_workers.ptr ())
+        _workers = new SoftWorkerPool (get_name (), _thread_count);
+
+    return _workers->run (task, in_info.height / 2);
+}
+
+SmartPtr<SoftImageHandler>
+create_soft_csc_image_handler (uint32_t output_format)
+{
+    SmartPtr<SoftCscImageHandler> csc_handler = new SoftCscImageHandler ("soft_handler_csc", output_format);
+    XCAM_FAIL_RETURN (
+        WARNING,
+        csc_handler->set_output_format (output_format),
+        NULL,
+        "create soft csc handler failed");
+
+    return csc_handler;
+}
+
+};
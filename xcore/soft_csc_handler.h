@@ -0,0 +1,75 @@
+/*
+ * soft_csc_handler.h - soft(cpu) color space conversion handler
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#ifndef XCAM_SOFT_CSC_HANDLER_H
+#define XCAM_SOFT_CSC_HANDLER_H
+
+#include "xcam_utils.h"
+#include "soft_image_handler.h"
+#include "soft_worker_pool.h"
+
+namespace XCam {
+
+/*
+ * SoftCscImageHandler, packed 4:2:2 to planar 4:2:0
+ * input:  V4L2_PIX_FMT_YUYV or V4L2_PIX_FMT_UYVY
+ * output: V4L2_PIX_FMT_NV12 or V4L2_PIX_FMT_YUV420
+ * chroma of each line pair is averaged, rows are split into bands among worker threads
+ */
+class SoftCscImageHandler
+    : public SoftImageHandler
+{
+public:
+    explicit SoftCscImageHandler (const char *name, uint32_t output_format = V4L2_PIX_FMT_NV12);
+
+    bool set_output_format (uint32_t format);
+    uint32_t get_output_format () const {
+        return _output_format;
+    }
+    // 0 means number of online cpus
+    bool set_thread_count (uint32_t count);
+
+    //derived from SoftImageHandler
+    virtual void emit_stop ();
+
+protected:
+    //derived from SoftImageHandler
+    virtual XCamReturn prepare_buffer_pool_video_info (
+        const VideoBufferInfo &input,
+        VideoBufferInfo &output);
+    virtual XCamReturn process (
+        const VideoBufferInfo &in_info, uint8_t *in_mem,
+        const VideoBufferInfo &out_info, uint8_t *out_mem);
+
+private:
+    XCAM_DEAD_COPY (SoftCscImageHandler);
+
+private:
+    uint32_t                 _output_format;
+    uint32_t                 _thread_count;
+    SmartPtr<SoftWorkerPool> _workers;
+};
+
+SmartPtr<SoftImageHandler>
+create_soft_csc_image_handler (uint32_t output_format = V4L2_PIX_FMT_NV12);
+
+};
+
+#endif //XCAM_SOFT_CSC_HANDLER_H
@@ -0,0 +1,187 @@
+/*
+ * soft_fast_math.h - bounded error approximations for soft(cpu) handlers
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#ifndef XCAM_SOFT_FAST_MATH_H
+#define XCAM_SOFT_FAST_MATH_H
+
+#include "xcam_utils.h"
+#include <math.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/*
+ * Scalar and SSE2 versions run the same operations in the same order,
+ * results of both are bit exact.
+ * Inputs must be positive normal floats (log2, pow, cbrt) or
+ * in [-126, 127] (exp2), no check on nan, inf or denormal.
+ *
+ * error bounds against double precision libm, measured by test-soft-lab -c
+ *   fast_log2:  absolute 1.1e-6 on [2^-30, 2^30], mostly float rounding of exponent + series
+ *   fast_exp2:  relative 2.5e-7 on [-30, 30]
+ *   fast_pow:   relative 8.0e-7 for x in [2^-10, 1], y in {1/3, 0.45, 1/2.4, 2.2, 2.4}
+ *   fast_cbrt:  relative 2.5e-7 on [2^-30, 2^30]
+ */
+
+// log2(m), m in [sqrt(1/2), sqrt(2)) through t = (m - 1) / (m + 1), odd series up to t^7
+#define XCAM_FAST_LOG2_C1 2.8853900817779268f   // 2 / ln2
+#define XCAM_FAST_LOG2_C3 0.9617966939259756f   // 2 / (3 * ln2)
+#define XCAM_FAST_LOG2_C5 0.5770780163555854f   // 2 / (5 * ln2)
+#define XCAM_FAST_LOG2_C7 0.4121985831111324f   // 2 / (7 * ln2)
+// 2^f, f in [-0.5, 0.5], taylor series up to f^6
+#define XCAM_FAST_EXP2_C1 0.6931471805599453f
+#define XCAM_FAST_EXP2_C2 0.2402265069591007f
+#define XCAM_FAST_EXP2_C3 0.0555041086648216f
+#define XCAM_FAST_EXP2_C4 0.0096181291076285f
+#define XCAM_FAST_EXP2_C5 0.0013333558146428f
+#define XCAM_FAST_EXP2_C6 0.0001540353039338f
+// bits / 3 + magic, cube root seed within 3.2%
+#define XCAM_FAST_CBRT_MAGIC 709958130
+
+namespace XCam {
+
+inline float
+fast_bits_to_float (int32_t bits)
+{
+    float value;
+    memcpy (&value, &bits, sizeof (value));
+    return value;
+}
+
+inline int32_t
+fast_float_to_bits (float value)
+{
+    int32_t bits;
+    memcpy (&bits, &value, sizeof (bits));
+    return bits;
+}
+
+inline float
+fast_log2 (float x)
+{
+    int32_t bits = fast_float_to_bits (x);
+    int32_t e = (bits >> 23) - 127;
+    float m = fast_bits_to_float ((bits & 0x007fffff) | 0x3f800000);
+    if (m > 1.41421356f) {
+        m = m - m * 0.5f;
+        e = e + 1;
+    }
+    float t = (m - 1.0f) / (m + 1.0f);
+    float t2 = t * t;
+    float p = t * (XCAM_FAST_LOG2_C1 + t2 * (XCAM_FAST_LOG2_C3 + t2 * (XCAM_FAST_LOG2_C5 + t2 * XCAM_FAST_LOG2_C7)));
+    return (float)e + p;
+}
+
+inline float
+fast_exp2 (float x)
+{
+    x = XCAM_MIN (XCAM_MAX (x, -126.0f), 127.0f);
+    int32_t n = (int32_t)lrintf (x);
+    float f = x - (float)n;
+    float p = 1.0f + f * (XCAM_FAST_EXP2_C1 + f * (XCAM_FAST_EXP2_C2 + f * (XCAM_FAST_EXP2_C3 +
+                          f * (XCAM_FAST_EXP2_C4 + f * (XCAM_FAST_EXP2_C5 + f * XCAM_FAST_EXP2_C6)))));
+    return p * fast_bits_to_float ((n + 127) << 23);
+}
+
+inline float
+fast_pow (float x, float y)
+{
+    return fast_exp2 (y * fast_log2 (x));
+}
+
+// seed from exponent bits, then two halley steps y = y * (y^3 + 2x) / (2y^3 + x)
+inline float
+fast_cbrt (float x)
+{
+    int32_t bits = fast_float_to_bits (x);
+    float y = fast_bits_to_float ((int32_t)((float)bits * (1.0f / 3.0f)) + XCAM_FAST_CBRT_MAGIC);
+    float y3 = y * y * y;
+    y = y * (y3 + x + x) / (y3 + y3 + x);
+    y3 = y * y * y;
+    y = y * (y3 + x + x) / (y3 + y3 + x);
+    return y;
+}
+
+#if defined(__SSE2__)
+inline __m128
+fast_select_ps (__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps (_mm_and_ps (mask, a), _mm_andnot_ps (mask, b));
+}
+
+inline __m128
+fast_log2_ps (__m128 x)
+{
+    __m128i bits = _mm_castps_si128 (x);
+    __m128i e = _mm_sub_epi32 (_mm_srli_epi32 (bits, 23), _mm_set1_epi32 (127));
+    __m128 m = _mm_castsi128_ps (
+                   _mm_or_si128 (_mm_and_si128 (bits, _mm_set1_epi32 (0x007fffff)), _mm_set1_epi32 (0x3f800000)));
+    __m128 big = _mm_cmpgt_ps (m, _mm_set1_ps (1.41421356f));
+    m = _mm_sub_ps (m, _mm_and_ps (big, _mm_mul_ps (m, _mm_set1_ps (0.5f))));
+    e = _mm_sub_epi32 (e, _mm_castps_si128 (big));
+
+    __m128 one = _mm_set1_ps (1.0f);
+    __m128 t = _mm_div_ps (_mm_sub_ps (m, one), _mm_add_ps (m, one));
+    __m128 t2 = _mm_mul_ps (t, t);
+    __m128 p = _mm_add_ps (_mm_set1_ps (XCAM_FAST_LOG2_C5), _mm_mul_ps (t2, _mm_set1_ps (XCAM_FAST_LOG2_C7)));
+    p = _mm_add_ps (_mm_set1_ps (XCAM_FAST_LOG2_C3), _mm_mul_ps (t2, p));
+    p = _mm_add_ps (_mm_set1_ps (XCAM_FAST_LOG2_C1), _mm_mul_ps (t2, p));
+    return _mm_add_ps (_mm_cvtepi32_ps (e), _mm_mul_ps (t, p));
+}
+
+inline __m128
+fast_exp2_ps (__m128 x)
+{
+    x = _mm_min_ps (_mm_max_ps (x, _mm_set1_ps (-126.0f)), _mm_set1_ps (127.0f));
+    __m128i n = _mm_cvtps_epi32 (x);
+    __m128 f = _mm_sub_ps (x, _mm_cvtepi32_ps (n));
+    __m128 p = _mm_add_ps (_mm_set1_ps (XCAM_FAST_EXP2_C5), _mm_mul_ps (f, _mm_set1_ps (XCAM_FAST_EXP2_C6)));
+    p = _mm_add_ps (_mm_set1_ps (XCAM_FAST_EXP2_C4), _mm_mul_ps (f, p));
+    p = _mm_add_ps (_mm_set1_ps (XCAM_FAST_EXP2_C3), _mm_mul_ps (f, p));
+    p = _mm_add_ps (_mm_set1_ps (XCAM_FAST_EXP2_C2), _mm_mul_ps (f, p));
+    p = _mm_add_ps (_mm_set1_ps (XCAM_FAST_EXP2_C1), _mm_mul_ps (f, p));
+    p = _mm_add_ps (_mm_set1_ps (1.0f), _mm_mul_ps (f, p));
+    __m128i scale = _mm_slli_epi32 (_mm_add_epi32 (n, _mm_set1_epi32 (127)), 23);
+    return _mm_mul_ps (p, _mm_castsi128_ps (scale));
+}
+
+inline __m128
+fast_pow_ps (__m128 x, __m128 y)
+{
+    return fast_exp2_ps (_mm_mul_ps (y, fast_log2_ps (x)));
+}
+
+inline __m128
+fast_cbrt_ps (__m128 x)
+{
+    __m128i bits = _mm_cvttps_epi32 (_mm_mul_ps (_mm_cvtepi32_ps (_mm_castps_si128 (x)), _mm_set1_ps (1.0f / 3.0f)));
+    __m128 y = _mm_castsi128_ps (_mm_add_epi32 (bits, _mm_set1_epi32 (XCAM_FAST_CBRT_MAGIC)));
+    __m128 y3 = _mm_mul_ps (_mm_mul_ps (y, y), y);
+    y = _mm_div_ps (_mm_mul_ps (y, _mm_add_ps (_mm_add_ps (y3, x), x)), _mm_add_ps (_mm_add_ps (y3, y3), x));
+    y3 = _mm_mul_ps (_mm_mul_ps (y, y), y);
+    y = _mm_div_ps (_mm_mul_ps (y, _mm_add_ps (_mm_add_ps (y3, x), x)), _mm_add_ps (_mm_add_ps (y3, y3), x));
+    return y;
+}
+#endif
+
+};
+
+#endif //XCAM_SOFT_FAST_MATH_H
@@ -0,0 +1,202 @@
+/*
+ * soft_image_handler.cpp - soft(cpu) image handler
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#include "soft_image_handler.h"
+#include "soft_buffer_pool.h"
+#include "perf_counters.h"
+#include "xcam_probes.h"
+
+namespace XCam {
+
+#define XCAM_SOFT_IMAGE_HANDLER_DEFAULT_BUF_NUM 4
+
+SoftImageHandler::SoftImageHandler (const char *name)
+    : _name (NULL)
+    , _buf_pool_size (XCAM_SOFT_IMAGE_HANDLER_DEFAULT_BUF_NUM)
+    , _enable (true)
+{
+    XCAM_ASSERT (name);
+    if (name)
+        _name = strndup (name, XCAM_MAX_STR_SIZE);
+
+    XCAM_OBJ_PROFILING_INIT;
+}
+
+SoftImageHandler::~SoftImageHandler ()
+{
+    if (_name)
+        xcam_free (_name);
+}
+
+XCamReturn
+SoftImageHandler::apply_3a_result (SmartPtr<X3aResult> &result)
+{
+    XCAM_UNUSED (result);
+    return XCAM_RETURN_BYPASS;
+}
+
+XCamReturn
+SoftImageHandler::prepare_buffer_pool_video_info (
+    const VideoBufferInfo &input,
+    VideoBufferInfo &output)
+{
+    output = input;
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+SoftImageHandler::prepare_output_buf (SmartPtr<VideoBuffer> &input, SmartPtr<VideoBuffer> &output)
+{
+    SmartPtr<BufferProxy> new_buf;
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+
+    const VideoBufferInfo &input_info = input->get_video_info ();
+    if (_buf_pool.ptr () &&
+            (input_info.format != _buf_pool_input.format ||
+             input_info.width != _buf_pool_input.width ||
+             input_info.height != _buf_pool_input.height)) {
+        XCAM_LOG_INFO (
+            "SoftImageHandler(%s) input changed to %dx%d, rebuild buffer pool",
+            XCAM_STR (_name), input_info.width, input_info.height);
+        _buf_pool->stop ();
+        _buf_pool.release ();
+    }
+
+    if (!_buf_pool.ptr ()) {
+        VideoBufferInfo output_video_info;
+        SmartPtr<BufferPool> pool = new SoftBufferPool;
+
+        ret = prepare_buffer_pool_video_info (input_info, output_video_info);
+        XCAM_FAIL_RETURN (
+            WARNING,
+            ret == XCAM_RETURN_NO_ERROR,
+            ret,
+            "SoftImageHandler(%s) prepare output video info failed", XCAM_STR (_name));
+
+        XCAM_FAIL_RETURN (
+            WARNING,
+            pool->set_video_info (output_video_info) && pool->reserve (_buf_pool_size),
+            XCAM_RETURN_ERROR_MEM,
+            "SoftImageHandler(%s) failed to init buffer pool", XCAM_STR (_name));
+        _buf_pool = pool;
+        _buf_pool_input = input_info;
+    }
+
+    new_buf = _buf_pool->get_buffer (_buf_pool);
+    XCAM_FAIL_RETURN (
+        WARNING,
+        new_buf.ptr (),
+        XCAM_RETURN_ERROR_MEM,
+        "SoftImageHandler(%s) failed to get buffer from pool", XCAM_STR (_name));
+
+    new_buf->set_timestamp (input->get_timestamp ());
+    output = new_buf;
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+SoftImageHandler::post_process (SmartPtr<VideoBuffer> &output)
+{
+    XCAM_UNUSED (output);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+void
+SoftImageHandler::emit_start ()
+{
+    if (_buf_pool.ptr ())
+        _buf_pool->resume ();
+}
+
+void
+SoftImageHandler::emit_stop ()
+{
+    if (_buf_pool.ptr ())
+        _buf_pool->stop ();
+}
+
+XCamReturn
+SoftImageHandler::execute (SmartPtr<VideoBuffer> &input, SmartPtr<VideoBuffer> &output)
+{
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+    uint8_t *in_mem = NULL, *out_mem = NULL;
+
+    XCAM_ASSERT (input.ptr ());
+    if (!_enable) {
+        output = input;
+        return XCAM_RETURN_NO_ERROR;
+    }
+
+    PerfStage perf_stage ("handler", XCAM_STR (_name));
+    HandlerProbe probe (XCAM_STR (_name), input->get_timestamp ());
+    XCAM_OBJ_PROFILING_START;
+    struct timeval execute_start;
+    gettimeofday (&execute_start, NULL);
+
+    XCAM_FAIL_RETURN (
+        WARNING,
+        (ret = prepare_output_buf (input, output)) == XCAM_RETURN_NO_ERROR,
+        ret,
+        "SoftImageHandler(%s) prepare output buf failed", XCAM_STR (_name));
+    XCAM_ASSERT (output.ptr ());
+
+    in_mem = input->map ();
+    out_mem = output->map ();
+    if (in_mem && out_mem)
+        ret = process (input->get_video_info (), in_mem, output->get_video_info (), out_mem);
+    else
+        ret = XCAM_RETURN_ERROR_MEM;
+    if (in_mem)
+        input->unmap ();
+    if (out_mem)
+        output->unmap ();
+
+    XCAM_FAIL_RETURN (
+        WARNING,
+        ret == XCAM_RETURN_NO_ERROR,
+        ret,
+        "SoftImageHandler(%s) process failed", XCAM_STR (_name));
+
+    ret = post_process (output);
+
+    XCAM_OBJ_PROFILING_END (XCAM_STR (_name), 30);
+    _execute_duration.add (execute_start);
+    return ret;
+}
+
+void
+SoftImageHandler::introspect (IntrospectionWriter &writer)
+{
+    writer.add ("name", XCAM_STR (_name));
+    writer.add ("enabled", _enable);
+    writer.begin_object ("execute");
+    _execute_duration.introspect (writer);
+    writer.end_object ();
+
+    SmartPtr<BufferPool> pool = _buf_pool;
+    if (pool.ptr ()) {
+        writer.begin_object ("pool");
+        writer.add ("allocated", pool->get_allocated_count ());
+        writer.add ("free", pool->get_free_count ());
+        writer.end_object ();
+    }
+}
+
+};
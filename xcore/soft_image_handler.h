@@ -0,0 +1,94 @@
+/*
+ * soft_image_handler.h - soft(cpu) image handler
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#ifndef XCAM_SOFT_IMAGE_HANDLER_H
+#define XCAM_SOFT_IMAGE_HANDLER_H
+
+#include "xcam_utils.h"
+#include "buffer_pool.h"
+#include "x3a_result.h"
+#include "introspection.h"
+
+namespace XCam {
+
+/*
+ * SoftImageHandler, cpu counterpart of CLImageHandler
+ * works on any mappable VideoBuffer and allocates output from host memory
+ */
+class SoftImageHandler
+{
+public:
+    explicit SoftImageHandler (const char *name);
+    virtual ~SoftImageHandler ();
+    const char *get_name () const {
+        return _name;
+    }
+
+    void set_pool_size (uint32_t size) {
+        XCAM_ASSERT (size);
+        _buf_pool_size = size;
+    }
+    void set_enable (bool enable) {
+        _enable = enable;
+    }
+    bool is_enabled () const {
+        return _enable;
+    }
+
+    // return XCAM_RETURN_BYPASS if handler is not interested in this result
+    virtual XCamReturn apply_3a_result (SmartPtr<X3aResult> &result);
+
+    XCamReturn execute (SmartPtr<VideoBuffer> &input, SmartPtr<VideoBuffer> &output);
+    virtual void emit_start ();
+    virtual void emit_stop ();
+
+    virtual void introspect (IntrospectionWriter &writer);
+
+protected:
+    virtual XCamReturn prepare_buffer_pool_video_info (
+        const VideoBufferInfo &input,
+        VideoBufferInfo &output);
+    virtual XCamReturn prepare_output_buf (SmartPtr<VideoBuffer> &input, SmartPtr<VideoBuffer> &output);
+
+    // input and output are both mapped
+    virtual XCamReturn process (
+        const VideoBufferInfo &in_info, uint8_t *in_mem,
+        const VideoBufferInfo &out_info, uint8_t *out_mem) = 0;
+
+    // called after output buffer unmapped, for handlers keeping history frames
+    virtual XCamReturn post_process (SmartPtr<VideoBuffer> &output);
+
+private:
+    XCAM_DEAD_COPY (SoftImageHandler);
+
+private:
+    char                      *_name;
+    SmartPtr<BufferPool>       _buf_pool;
+    VideoBufferInfo            _buf_pool_input;
+    uint32_t                   _buf_pool_size;
+    bool                       _enable;
+    DurationStats              _execute_duration;
+
+    XCAM_OBJ_PROFILING_DEFINES;
+};
+
+};
+
+#endif //XCAM_SOFT_IMAGE_HANDLER_H
@@ -0,0 +1,168 @@
+/*
+ * soft_image_processor.cpp - soft(cpu) image processor
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#include "soft_image_processor.h"
+#include "soft_image_handler.h"
+
+namespace XCam {
+
+SoftImageProcessor::SoftImageProcessor (const char* name)
+    : ImageProcessor (name ? name : "SoftImageProcessor")
+{
+    XCAM_LOG_DEBUG ("SoftImageProcessor constructed");
+}
+
+SoftImageProcessor::~SoftImageProcessor ()
+{
+    XCAM_LOG_DEBUG ("SoftImageProcessor destructed");
+}
+
+bool
+SoftImageProcessor::add_handler (SmartPtr<SoftImageHandler> &handler)
+{
+    XCAM_ASSERT (handler.ptr ());
+    SmartLock locker (_handlers_mutex);
+    _handlers.push_back (handler);
+    return true;
+}
+
+void
+SoftImageProcessor::introspect (IntrospectionWriter &writer)
+{
+    ImageHandlerList handlers;
+    {
+        // don't wait for the frame in process
+        SmartLock locker (_handlers_mutex);
+        handlers = _handlers;
+    }
+
+    ImageProcessor::introspect (writer);
+    writer.begin_array ("handlers");
+    for (ImageHandlerList::iterator i_handler = handlers.begin ();
+            i_handler != handlers.end (); ++i_handler) {
+        writer.begin_object ();
+        (*i_handler)->introspect (writer);
+        writer.end_object ();
+    }
+    writer.end_array ();
+}
+
+bool
+SoftImageProcessor::can_process_result (SmartPtr<X3aResult> &result)
+{
+    if (result.ptr () == NULL)
+        return false;
+
+    // smart analysis and user defined results are not for image handlers
+    return result->get_type () < XCAM_3A_RESULT_FACE_DETECTION;
+}
+
+XCamReturn
+SoftImageProcessor::apply_3a_results (X3aResultList &results)
+{
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+
+    for (X3aResultList::iterator iter = results.begin (); iter != results.end (); ++iter)
+    {
+        SmartPtr<X3aResult> &result = *iter;
+        ret = apply_3a_result (result);
+        if (ret != XCAM_RETURN_NO_ERROR && ret != XCAM_RETURN_BYPASS)
+            break;
+    }
+    return ret;
+}
+
+XCamReturn
+SoftImageProcessor::apply_3a_result (SmartPtr<X3aResult> &result)
+{
+    XCamReturn ret = XCAM_RETURN_BYPASS;
+
+    if (result.ptr () == NULL)
+        return XCAM_RETURN_BYPASS;
+
+    SmartLock locker (_handlers_mutex);
+    for (ImageHandlerList::iterator i_handler = _handlers.begin ();
+            i_handler != _handlers.end (); ++i_handler) {
+        XCamReturn handler_ret = (*i_handler)->apply_3a_result (result);
+        if (handler_ret == XCAM_RETURN_NO_ERROR)
+            ret = XCAM_RETURN_NO_ERROR;
+        else if (handler_ret != XCAM_RETURN_BYPASS) {
+            XCAM_LOG_WARNING (
+                "SoftImageProcessor handler(%s) apply 3a result(type:%d) failed",
+                XCAM_STR ((*i_handler)->get_name ()), result->get_type ());
+            return handler_ret;
+        }
+    }
+
+    return ret;
+}
+
+XCamReturn
+SoftImageProcessor::process_buffer (SmartPtr<VideoBuffer> &input, SmartPtr<VideoBuffer> &output)
+{
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+    SmartPtr<VideoBuffer> in_buf = input;
+
+    SmartLock locker (_handlers_mutex);
+    for (ImageHandlerList::iterator i_handler = _handlers.begin ();
+            i_handler != _handlers.end (); ++i_handler) {
+        SmartPtr<VideoBuffer> out_buf;
+
+        ret = (*i_handler)->execute (in_buf, out_buf);
+        if (ret == XCAM_RETURN_BYPASS) {
+            // held back by the handler, tell the center not to wait for it
+            notify_process_buffer_dropped (input);
+            return ret;
+        }
+        XCAM_FAIL_RETURN (
+            WARNING,
+            ret == XCAM_RETURN_NO_ERROR,
+            ret,
+            "SoftImageProcessor handler(%s) execute failed",
+            XCAM_STR ((*i_handler)->get_name ()));
+        in_buf = out_buf;
+    }
+
+    output = in_buf;
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+SoftImageProcessor::emit_start ()
+{
+    SmartLock locker (_handlers_mutex);
+    for (ImageHandlerList::iterator i_handler = _handlers.begin ();
+            i_handler != _handlers.end (); ++i_handler) {
+        (*i_handler)->emit_start ();
+    }
+    return XCAM_RETURN_NO_ERROR;
+}
+
+void
+SoftImageProcessor::emit_stop ()
+{
+    SmartLock locker (_handlers_mutex);
+    for (ImageHandlerList::iterator i_handler = _handlers.begin ();
+            i_handler != _handlers.end (); ++i_handler) {
+        (*i_handler)->emit_stop ();
+    }
+}
+
+};
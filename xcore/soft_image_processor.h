@@ -0,0 +1,70 @@
+/*
+ * soft_image_processor.h - soft(cpu) image processor
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#ifndef XCAM_SOFT_IMAGE_PROCESSOR_H
+#define XCAM_SOFT_IMAGE_PROCESSOR_H
+
+#include "xcam_utils.h"
+#include "image_processor.h"
+#include "xcam_mutex.h"
+#include <list>
+
+namespace XCam {
+
+class SoftImageHandler;
+
+/*
+ * SoftImageProcessor, runs soft handlers in series on processor thread
+ * for host memory frames when no GPU is available
+ */
+class SoftImageProcessor
+    : public ImageProcessor
+{
+public:
+    typedef SmallVector<SmartPtr<SoftImageHandler>>  ImageHandlerList;
+
+public:
+    explicit SoftImageProcessor (const char* name = NULL);
+    virtual ~SoftImageProcessor ();
+
+    bool add_handler (SmartPtr<SoftImageHandler> &handler);
+
+    //derived from ImageProcessor
+    virtual void introspect (IntrospectionWriter &writer);
+
+protected:
+    //derive from ImageProcessor
+    virtual bool can_process_result (SmartPtr<X3aResult> &result);
+    virtual XCamReturn apply_3a_results (X3aResultList &results);
+    virtual XCamReturn apply_3a_result (SmartPtr<X3aResult> &result);
+    virtual XCamReturn process_buffer (SmartPtr<VideoBuffer> &input, SmartPtr<VideoBuffer> &output);
+    virtual XCamReturn emit_start ();
+    virtual void emit_stop ();
+
+private:
+    XCAM_DEAD_COPY (SoftImageProcessor);
+
+private:
+    Mutex                          _handlers_mutex;
+    ImageHandlerList               _handlers;
+};
+
+};
+#endif //XCAM_SOFT_IMAGE_PROCESSOR_H
@@ -0,0 +1,516 @@
+/*
+ * soft_lab_handler.cpp - soft(cpu) rgb to lab and lab hdr handler
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#include "soft_lab_handler.h"
+#include "soft_fast_math.h"
+#include <vector>
+
+#define LAB_THRESHOLD 0.008856f
+#define LAB_INV_THRESHOLD 0.008865f
+#define LAB_LINEAR_SLOPE 7.787f
+#define LAB_LINEAR_OFFSET (16.0f / 116.0f)
+#define LAB_L_LINEAR_SLOPE 903.3f
+
+namespace XCam {
+
+// rgb to xyz divided by D65 white, same as kernel_csc_rgbatolab
+static const float csc_rgb_to_xyz[9] = {
+    0.433910f, 0.376220f, 0.189860f,
+    0.212649f, 0.715169f, 0.072182f,
+    0.017756f, 0.109478f, 0.872915f
+};
+
+// same as kernel_hdr_lab, not white normalized
+static const float hdr_rgb_to_xyz[9] = {
+    0.412453f, 0.357580f, 0.180423f,
+    0.212671f, 0.715160f, 0.072169f,
+    0.019334f, 0.119193f, 0.950227f
+};
+
+static const float hdr_xyz_to_rgb[9] = {
+    3.240479f, -1.537150f, -0.498535f,
+    -0.969256f, 1.875992f, 0.041556f,
+    0.055648f, -0.204043f, 1.204043f
+};
+
+static const float hdr_lab_table[XCAM_SOFT_LAB_HDR_TABLE_SIZE] = {
+    4.3287616, 5.9319224, 7.1324205, 8.1288157, 8.9965763, 9.7739191, 10.483327, 11.139331,
+    11.751958, 12.328467, 12.874310, 13.393700, 13.889977, 14.365837, 14.823494, 15.264792,
+    15.691289, 16.104307, 16.504990, 16.894327, 17.273184, 17.642323, 18.002419, 18.354071,
+    18.697817, 19.034143, 19.363485, 19.686239, 20.002764, 20.313389, 20.618416, 20.918123,
+    21.212763, 21.502573, 21.787767, 22.068552, 22.345116, 22.617630, 22.886259, 23.151157,
+    23.412468, 23.670324, 23.924854, 24.176174, 24.424398, 24.669630, 24.911972, 25.151518,
+    25.388355, 25.622572, 25.854246, 26.083458, 26.310276, 26.534771, 26.757010, 26.977057,
+    27.194969, 27.410807, 27.624624, 27.836473, 28.046406, 28.254467, 28.254467, 28.254467,
+    28.254467, 28.254467, 28.254467, 28.254467, 28.254467, 28.254467, 28.377895, 28.567524,
+    28.755781, 28.942692, 29.128284, 29.312582, 29.495617, 29.677410, 29.857986, 30.037369,
+    30.215582, 30.392645, 30.568581, 30.743410, 30.917152, 31.089828, 31.261454, 31.432049,
+    31.601633, 31.770222, 31.937832, 32.104481, 32.270180, 32.434952, 32.598808, 32.761761,
+    32.923832, 33.085026, 33.245361, 33.404850, 33.563507, 33.721340, 33.878368, 34.034599,
+    34.190044, 34.344715, 34.498627, 34.651783, 34.804199, 34.955887, 35.106853, 35.257107,
+    35.406662, 35.555523, 35.703705, 35.851208, 35.998051, 36.144238, 36.289776, 36.434673,
+    36.578941, 36.722588, 36.865616, 37.008038, 37.008038, 37.008038, 37.008038, 37.008038,
+    37.008038, 37.008038, 37.008038, 37.008038, 37.008038, 37.008038, 37.008038, 37.008038,
+    37.013512, 37.148350, 37.282703, 37.416573, 37.549969, 37.682888, 37.815342, 37.947330,
+    38.078865, 38.209946, 38.340580, 38.470768, 38.600517, 38.729836, 38.858719, 38.987175,
+    39.115215, 39.242832, 39.370041, 39.496838, 39.623226, 39.749214, 39.874802, 40.0,
+    40.124805, 40.249222, 40.373260, 40.496914, 40.620193, 40.743095, 40.865631, 40.987804,
+    41.109608, 41.231056, 41.352146, 41.472885, 41.593269, 41.713306, 41.833000, 41.952354,
+    42.071369, 42.190048, 42.308392, 42.426407, 42.544094, 42.661457, 42.778500, 42.895222,
+    43.011627, 43.127716, 43.243496, 43.243496, 43.243496, 43.243496, 43.243496, 43.243496,
+    43.243496, 43.243496, 43.243496, 43.243496, 43.243496, 43.243496, 43.243496, 43.243496,
+    43.243496, 43.243496, 43.243496, 43.315910, 43.427536, 43.538902, 43.650013, 43.760872,
+    43.871479, 43.981831, 44.091938, 44.201797, 44.311413, 44.420780, 44.529911, 44.638798,
+    44.747448, 44.855862, 44.964039, 45.071983, 45.179695, 45.287178, 45.394428, 45.501453,
+    45.608253, 45.714825, 45.821178, 45.927307, 46.033215, 46.138905, 46.244377, 46.349632,
+    46.454674, 46.559505, 46.664120, 46.768528, 46.872723, 46.976711, 47.080494, 47.184067,
+    47.287441, 47.390610, 47.493576, 47.596344, 47.698910, 47.801281, 47.903454, 48.005428,
+    48.107212, 48.107212, 48.107212, 48.107212, 48.107212, 48.107212, 48.107212, 48.107212,
+    48.107212, 48.107212, 48.107212, 48.107212, 48.107212, 48.107212, 48.107212, 48.107212,
+    48.107212, 48.107212, 48.107212, 48.116840, 48.216503, 48.316002, 48.415333, 48.514507,
+    48.613514, 48.712364, 48.811050, 48.909580, 49.007950, 49.106163, 49.204220, 49.302116,
+    49.399860, 49.497452, 49.594887, 49.692173, 49.789303, 49.886284, 49.983109, 50.079788,
+    50.176319, 50.272701, 50.368935, 50.465023, 50.560966, 50.656761, 50.752411, 50.847919,
+    50.943279, 51.038502, 51.133583, 51.228519, 51.323318, 51.417973, 51.512493, 51.606873,
+    51.701115, 51.795219, 51.889191, 51.983021, 52.076717, 52.170280, 52.263706, 52.357002,
+    52.357002, 52.357002, 52.357002, 52.357002, 52.357002, 52.357002, 52.357002, 52.357002,
+    52.357002, 52.357002, 52.357002, 52.357002, 52.357002, 52.357002, 52.357002, 52.357002,
+    52.357002, 52.357002, 52.357002, 52.357002, 52.370274, 52.462727, 52.555069, 52.647293,
+    52.739407, 52.831406, 52.923294, 53.015072, 53.106739, 53.198296, 53.289738, 53.381077,
+    53.472301, 53.563419, 53.654430, 53.745327, 53.836124, 53.926811, 54.017391, 54.107864,
+    54.198231, 54.288494, 54.378651, 54.468708, 54.558655, 54.648502, 54.738243, 54.827885,
+    54.917419, 55.006851, 55.096188, 55.185417, 55.274551, 55.363579, 55.452511, 55.541340,
+    55.630070, 55.718704, 55.807240, 55.895676, 55.984013, 56.072254, 56.072254, 56.072254,
+    56.072254, 56.072254, 56.072254, 56.072254, 56.072254, 56.072254, 56.072254, 56.072254,
+    56.072254, 56.072254, 56.072254, 56.072254, 56.072254, 56.072254, 56.072254, 56.072254,
+    56.072254, 56.072254, 56.072254, 56.072254, 56.136337, 56.224670, 56.312920, 56.401089,
+    56.489174, 56.577179, 56.665100, 56.752941, 56.840698, 56.928371, 57.015968, 57.103481,
+    57.190918, 57.278271, 57.365547, 57.452744, 57.539856, 57.626896, 57.713852, 57.800732,
+    57.887531, 57.974255, 58.060902, 58.147465, 58.233959, 58.320370, 58.406708, 58.492970,
+    58.579155, 58.665260, 58.751289, 58.837250, 58.923130, 59.008938, 59.094666, 59.180325,
+    59.265907, 59.351414, 59.436852, 59.522209, 59.607498, 59.607498, 59.607498, 59.607498,
+    59.607498, 59.607498, 59.607498, 59.607498, 59.607498, 59.607498, 59.607498, 59.607498,
+    59.607498, 59.607498, 59.607498, 59.607498, 59.607498, 59.607498, 59.607498, 59.607498,
+    59.607498, 59.607498, 59.607498, 59.607498, 59.676125, 59.762394, 59.848598, 59.934742,
+    60.020828, 60.106846, 60.192806, 60.278702, 60.364540, 60.450314, 60.536030, 60.621685,
+    60.707275, 60.792812, 60.878284, 60.963699, 61.049049, 61.134342, 61.219578, 61.304752,
+    61.389870, 61.474926, 61.559925, 61.644867, 61.729748, 61.814568, 61.899334, 61.984039,
+    62.068687, 62.153282, 62.237812, 62.322292, 62.406708, 62.491070, 62.575375, 62.659622,
+    62.743816, 62.827950, 62.912029, 62.912029, 62.912029, 62.912029, 62.912029, 62.912029,
+    62.912029, 62.912029, 62.912029, 62.912029, 62.912029, 62.912029, 62.912029, 62.912029,
+    62.912029, 62.912029, 62.912029, 62.912029, 62.912029, 62.912029, 62.912029, 62.912029,
+    62.912029, 62.912029, 62.940441, 63.026379, 63.112267, 63.198112, 63.283909, 63.369659,
+    63.455360, 63.541019, 63.626637, 63.712200, 63.797718, 63.883190, 63.968624, 64.054001,
+    64.139343, 64.224632, 64.309875, 64.395081, 64.480240, 64.565346, 64.650414, 64.735435,
+    64.820412, 64.905342, 64.990234, 65.075073, 65.159874, 65.244629, 65.329346, 65.414009,
+    65.498634, 65.583214, 65.667747, 65.752243, 65.836693, 65.921097, 66.005463, 66.089783,
+    66.174057, 66.258286, 66.258286, 66.258286, 66.258286, 66.258286, 66.258286, 66.258286,
+    66.258286, 66.258286, 66.258286, 66.258286, 66.258286, 66.258286, 66.258286, 66.258286,
+    66.258286, 66.258286, 66.258286, 66.258286, 66.258286, 66.258286, 66.258286, 66.258286,
+    66.258286, 66.291786, 66.378784, 66.465752, 66.552689, 66.639587, 66.726456, 66.813293,
+    66.900085, 66.986855, 67.073586, 67.160286, 67.246948, 67.333572, 67.420174, 67.506737,
+    67.593269, 67.679764, 67.766228, 67.852654, 67.939056, 68.025421, 68.111755, 68.198051,
+    68.284325, 68.370560, 68.456757, 68.542923, 68.629059, 68.715164, 68.801239, 68.887276,
+    68.973282, 69.059258, 69.145203, 69.231110, 69.316986, 69.402832, 69.488655, 69.574432,
+    69.574432, 69.574432, 69.574432, 69.574432, 69.574432, 69.574432, 69.574432, 69.574432,
+    69.574432, 69.574432, 69.574432, 69.574432, 69.574432, 69.574432, 69.574432, 69.574432,
+    69.574432, 69.574432, 69.574432, 69.574432, 69.574432, 69.574432, 69.574432, 69.659309,
+    69.748878, 69.838425, 69.927956, 70.017456, 70.106934, 70.196388, 70.285820, 70.375237,
+    70.464622, 70.553986, 70.643333, 70.732658, 70.821953, 70.911224, 71.000481, 71.089706,
+    71.178917, 71.268105, 71.357262, 71.446404, 71.535530, 71.624619, 71.713692, 71.802750,
+    71.891777, 71.980789, 72.069771, 72.158737, 72.247673, 72.336594, 72.425499, 72.514374,
+    72.603226, 72.692062, 72.780876, 72.869659, 72.958427, 73.047173, 73.135902, 73.135902,
+    73.135902, 73.135902, 73.135902, 73.135902, 73.135902, 73.135902, 73.135902, 73.135902,
+    73.135902, 73.135902, 73.135902, 73.135902, 73.135902, 73.135902, 73.135902, 73.135902,
+    73.135902, 73.135902, 73.135902, 73.135902, 73.151604, 73.245392, 73.339172, 73.432938,
+    73.526695, 73.620430, 73.714165, 73.807884, 73.901588, 73.995285, 74.088966, 74.182640,
+    74.276299, 74.369942, 74.463577, 74.557198, 74.650818, 74.744415, 74.838005, 74.931580,
+    75.025139, 75.118698, 75.212242, 75.305771, 75.399284, 75.492798, 75.586296, 75.679771,
+    75.773247, 75.866707, 75.960159, 76.053596, 76.147018, 76.240433, 76.333839, 76.427231,
+    76.520615, 76.613983, 76.707336, 76.800690, 76.894020, 76.894020, 76.894020, 76.894020,
+    76.894020, 76.894020, 76.894020, 76.894020, 76.894020, 76.894020, 76.894020, 76.894020,
+    76.894020, 76.894020, 76.894020, 76.894020, 76.894020, 76.894020, 76.894020, 76.894020,
+    76.900002, 77.0, 77.100006, 77.200005, 77.300003, 77.400002, 77.500000, 77.600006,
+    77.700005, 77.800003, 77.900002, 78.0, 78.099998, 78.199997, 78.300003, 78.400002,
+    78.500000, 78.599998, 78.699997, 78.799995, 78.899994, 79.0, 79.099998, 79.199997,
+    79.299995, 79.400002, 79.500000, 79.599998, 79.699997, 79.799995, 79.900002, 80.0,
+    80.099998, 80.199997, 80.299995, 80.400002, 80.500000, 80.599998, 80.699997, 80.800003,
+    80.900002, 81.0, 81.099998, 81.199997, 81.199997, 81.199997, 81.199997, 81.199997,
+    81.199997, 81.199997, 81.199997, 81.199997, 81.199997, 81.199997, 81.199997, 81.199997,
+    81.199997, 81.199997, 81.199997, 81.199997, 81.199997, 81.299294, 81.408134, 81.516991,
+    81.625862, 81.734749, 81.843643, 81.952560, 82.061493, 82.170433, 82.279388, 82.388359,
+    82.497353, 82.606354, 82.715363, 82.824394, 82.933441, 83.042496, 83.151573, 83.260658,
+    83.369759, 83.478874, 83.588005, 83.697151, 83.806305, 83.915474, 84.024666, 84.133865,
+    84.243080, 84.352310, 84.461555, 84.570816, 84.680084, 84.789368, 84.898666, 85.007988,
+    85.117310, 85.226654, 85.336006, 85.445374, 85.554764, 85.664162, 85.773575, 85.882996,
+    85.992439, 86.101898, 86.211365, 86.320839, 86.430336, 86.539848, 86.649376, 86.758911,
+    86.868454, 86.978027, 87.087608, 87.197197, 87.306801, 87.416420, 87.526054, 87.635704,
+    87.745361, 87.855034, 87.964722, 88.074432, 88.184143, 88.293877, 88.403618, 88.513374,
+    88.623146, 88.732933, 88.842728, 88.952538, 89.062363, 89.172203, 89.282051, 89.391914,
+    89.501793, 89.611694, 89.721596, 89.831512, 89.941444, 90.051399, 90.161354, 90.271324,
+    90.381310, 90.491310, 90.601326, 90.711349, 90.821388, 90.931442, 91.041512, 91.151596,
+    91.261681, 91.371788, 91.481911, 91.592049, 91.702187, 91.812347, 91.922516, 92.032707,
+    92.142906, 92.253120, 92.363342, 92.473579, 92.583839, 92.694099, 92.804375, 92.914665,
+    93.024971, 93.135292, 93.245621, 93.355965, 93.466316, 93.576683, 93.687073, 93.797470,
+    93.907875, 94.018295, 94.128731, 94.239182, 94.349640, 94.460106, 94.570595, 94.681099,
+    94.791611, 94.902130, 95.012665, 95.123215, 95.233788, 95.344360, 95.454948, 95.565552,
+    95.676170, 95.786797, 95.897430, 96.008087, 96.118752, 96.229431, 96.340126, 96.450829,
+    96.561539, 96.672272, 96.783012, 96.893768, 97.004532, 97.115311, 97.226112, 97.336914,
+    97.447731, 97.558563, 97.669403, 97.780266, 97.891129, 98.002007, 98.112900, 98.223816,
+    98.334732, 98.445656, 98.556602, 98.667557, 98.778526, 98.889511, 99.000504, 99.111504,
+    99.222519, 99.333557, 99.444603, 99.555656, 99.666718, 99.777809, 99.888893, 100.0
+};
+
+const float *
+soft_hdr_lab_table ()
+{
+    return hdr_lab_table;
+}
+
+static inline float
+lab_f (float t)
+{
+    return t > LAB_THRESHOLD ? fast_cbrt (t) : LAB_LINEAR_SLOPE * t + LAB_LINEAR_OFFSET;
+}
+
+static inline float
+lab_f_inverse (float f)
+{
+    float t = f * f * f;
+    return t < LAB_INV_THRESHOLD ? (f - LAB_LINEAR_OFFSET) * (1.0f / LAB_LINEAR_SLOPE) : t;
+}
+
+static inline uint32_t
+hdr_table_index (float l)
+{
+    return XCAM_MIN ((uint32_t)(XCAM_MAX (l, 0.0f) * 10.0f), (uint32_t)XCAM_SOFT_LAB_HDR_TABLE_SIZE - 1);
+}
+
+#if defined(__SSE2__)
+static inline __m128
+lab_f_ps (__m128 t)
+{
+    __m128 linear = _mm_add_ps (_mm_mul_ps (t, _mm_set1_ps (LAB_LINEAR_SLOPE)), _mm_set1_ps (LAB_LINEAR_OFFSET));
+    return fast_select_ps (_mm_cmpgt_ps (t, _mm_set1_ps (LAB_THRESHOLD)), fast_cbrt_ps (t), linear);
+}
+
+static inline __m128
+lab_f_inverse_ps (__m128 f)
+{
+    __m128 t = _mm_mul_ps (_mm_mul_ps (f, f), f);
+    __m128 linear = _mm_mul_ps (_mm_sub_ps (f, _mm_set1_ps (LAB_LINEAR_OFFSET)), _mm_set1_ps (1.0f / LAB_LINEAR_SLOPE));
+    return fast_select_ps (_mm_cmplt_ps (t, _mm_set1_ps (LAB_INV_THRESHOLD)), linear, t);
+}
+
+static inline void
+matrix_multiply_ps (const float *m, __m128 r, __m128 g, __m128 b, __m128 out[3])
+{
+    for (uint32_t i = 0; i < 3; ++i)
+        out[i] = _mm_add_ps (
+                     _mm_add_ps (_mm_mul_ps (_mm_set1_ps (m[i * 3]), r), _mm_mul_ps (_mm_set1_ps (m[i * 3 + 1]), g)),
+                     _mm_mul_ps (_mm_set1_ps (m[i * 3 + 2]), b));
+}
+
+// L, fY, a, b of kernel_hdr_lab and kernel_csc_rgbatolab
+static inline void
+rgb_to_lab_ps (const float *m, __m128 r, __m128 g, __m128 b, __m128 &l, __m128 &fy, __m128 &a, __m128 &lab_b)
+{
+    __m128 xyz[3];
+    matrix_multiply_ps (m, r, g, b, xyz);
+    __m128 fx = lab_f_ps (xyz[0]);
+    __m128 fz = lab_f_ps (xyz[2]);
+    fy = lab_f_ps (xyz[1]);
+
+    __m128 l_cbrt = _mm_sub_ps (_mm_mul_ps (fy, _mm_set1_ps (116.0f)), _mm_set1_ps (16.0f));
+    __m128 l_linear = _mm_mul_ps (xyz[1], _mm_set1_ps (LAB_L_LINEAR_SLOPE));
+    l = fast_select_ps (_mm_cmpgt_ps (xyz[1], _mm_set1_ps (LAB_THRESHOLD)), l_cbrt, l_linear);
+    a = _mm_mul_ps (_mm_sub_ps (fx, fy), _mm_set1_ps (500.0f));
+    lab_b = _mm_mul_ps (_mm_sub_ps (fy, fz), _mm_set1_ps (200.0f));
+}
+#endif
+
+static inline void
+matrix_multiply (const float *m, float r, float g, float b, float out[3])
+{
+    for (uint32_t i = 0; i < 3; ++i)
+        out[i] = (m[i * 3] * r + m[i * 3 + 1] * g) + m[i * 3 + 2] * b;
+}
+
+static inline void
+rgb_to_lab (const float *m, float r, float g, float b, float &l, float &fy, float &a, float &lab_b)
+{
+    float xyz[3];
+    matrix_multiply (m, r, g, b, xyz);
+    float fx = lab_f (xyz[0]);
+    float fz = lab_f (xyz[2]);
+    fy = lab_f (xyz[1]);
+
+    l = xyz[1] > LAB_THRESHOLD ? fy * 116.0f - 16.0f : xyz[1] * LAB_L_LINEAR_SLOPE;
+    a = (fx - fy) * 500.0f;
+    lab_b = (fy - fz) * 200.0f;
+}
+
+void
+soft_rgb_to_lab (
+    const float *r, const float *g, const float *b,
+    float *l, float *a, float *lab_b, uint32_t width)
+{
+    uint32_t x = 0;
+    float fy;
+
+#if defined(__SSE2__)
+    for (; x + 4 <= width; x += 4) {
+        __m128 vl, vfy, va, vb;
+        rgb_to_lab_ps (
+            csc_rgb_to_xyz, _mm_loadu_ps (r + x), _mm_loadu_ps (g + x), _mm_loadu_ps (b + x),
+            vl, vfy, va, vb);
+        _mm_storeu_ps (l + x, vl);
+        _mm_storeu_ps (a + x, va);
+        _mm_storeu_ps (lab_b + x, vb);
+    }
+#endif
+
+    for (; x < width; ++x)
+        rgb_to_lab (csc_rgb_to_xyz, r[x], g[x], b[x], l[x], fy, a[x], lab_b[x]);
+}
+
+/*
+ * inverse of kernel_hdr_lab, Y = (L / 116)^3 with its cube root folded
+ * back to L / 116, fast_cbrt only on the linear segment
+ */
+void
+soft_hdr_lab (
+    const float *r, const float *g, const float *b,
+    float *out_r, float *out_g, float *out_b, uint32_t width)
+{
+    uint32_t x = 0;
+
+#if defined(__SSE2__)
+    for (; x + 4 <= width; x += 4) {
+        __m128 l, fy, a, lab_b, xyz[3], rgb[3];
+        rgb_to_lab_ps (
+            hdr_rgb_to_xyz, _mm_loadu_ps (r + x), _mm_loadu_ps (g + x), _mm_loadu_ps (b + x),
+            l, fy, a, lab_b);
+
+        float ls[4];
+        _mm_storeu_ps (ls, l);
+        l = _mm_setr_ps (
+                hdr_lab_table[hdr_table_index (ls[0])], hdr_lab_table[hdr_table_index (ls[1])],
+                hdr_lab_table[hdr_table_index (ls[2])], hdr_lab_table[hdr_table_index (ls[3])]);
+
+        __m128 l116 = _mm_mul_ps (l, _mm_set1_ps (1.0f / 116.0f));
+        __m128 y_cube = _mm_mul_ps (_mm_mul_ps (l116, l116), l116);
+        __m128 cube_mask = _mm_cmplt_ps (y_cube, _mm_set1_ps (LAB_THRESHOLD));
+        xyz[1] = y_cube;
+        fy = l116;
+        if (_mm_movemask_ps (cube_mask)) {
+            __m128 y_linear = _mm_mul_ps (l, _mm_set1_ps (1.0f / LAB_L_LINEAR_SLOPE));
+            xyz[1] = fast_select_ps (cube_mask, y_linear, y_cube);
+            fy = fast_select_ps (cube_mask, lab_f_ps (y_linear), l116);
+        }
+        xyz[0] = lab_f_inverse_ps (_mm_add_ps (_mm_mul_ps (a, _mm_set1_ps (1.0f / 500.0f)), fy));
+        xyz[2] = lab_f_inverse_ps (_mm_sub_ps (fy, _mm_mul_ps (lab_b, _mm_set1_ps (1.0f / 200.0f))));
+
+        matrix_multiply_ps (hdr_xyz_to_rgb, xyz[0], xyz[1], xyz[2], rgb);
+        _mm_storeu_ps (out_r + x, rgb[0]);
+        _mm_storeu_ps (out_g + x, rgb[1]);
+        _mm_storeu_ps (out_b + x, rgb[2]);
+    }
+#endif
+
+    for (; x < width; ++x) {
+        float l, fy, a, lab_b, xyz[3], rgb[3];
+        rgb_to_lab (hdr_rgb_to_xyz, r[x], g[x], b[x], l, fy, a, lab_b);
+
+        l = hdr_lab_table[hdr_table_index (l)];
+        float l116 = l * (1.0f / 116.0f);
+        xyz[1] = l116 * l116 * l116;
+        fy = l116;
+        if (xyz[1] < LAB_THRESHOLD) {
+            xyz[1] = l * (1.0f / LAB_L_LINEAR_SLOPE);
+            fy = lab_f (xyz[1]);
+        }
+        xyz[0] = lab_f_inverse (a * (1.0f / 500.0f) + fy);
+        xyz[2] = lab_f_inverse (fy - lab_b * (1.0f / 200.0f));
+
+        matrix_multiply (hdr_xyz_to_rgb, xyz[0], xyz[1], xyz[2], rgb);
+        out_r[x] = rgb[0];
+        out_g[x] = rgb[1];
+        out_b[x] = rgb[2];
+    }
+}
+
+template <typename T>
+static inline void
+load_line (const uint8_t *in, float *out, uint32_t width, float scale)
+{
+    const T *src = (const T *)in;
+    for (uint32_t x = 0; x < width; ++x)
+        out[x] = src[x] * scale;
+}
+
+template <typename T>
+static inline void
+store_line (const float *in, uint8_t *out, uint32_t width, float scale)
+{
+    T *dst = (T *)out;
+    for (uint32_t x = 0; x < width; ++x)
+        dst[x] = (T)(XCAM_MIN (XCAM_MAX (in[x], 0.0f), 1.0f) * scale + 0.5f);
+}
+
+static inline uint8_t
+clamp_lab_u8 (float value)
+{
+    return (uint8_t)(XCAM_MIN (XCAM_MAX (value, 0.0f), 255.0f) + 0.5f);
+}
+
+class LabTask
+    : public SoftBandTask
+{
+public:
+    SoftLabType     type;
+    bool            in_16bit;
+    const uint8_t  *in[3];
+    uint32_t        in_stride[3];
+    uint8_t        *out[3];
+    uint32_t        out_stride[3];
+    uint32_t        width;
+
+    virtual XCamReturn work (uint32_t begin, uint32_t end) {
+        std::vector<float> buf (width * 6);
+        float *rgb[3] = {&buf[0], &buf[width], &buf[width * 2]};
+        float *res[3] = {&buf[width * 3], &buf[width * 4], &buf[width * 5]};
+        float max_value = in_16bit ? 65535.0f : 255.0f;
+
+        for (uint32_t y = begin; y < end; ++y) {
+            for (uint32_t c = 0; c < 3; ++c) {
+                if (in_16bit)
+                    load_line<uint16_t> (in[c] + y * in_stride[c], rgb[c], width, 1.0f / max_value);
+                else
+                    load_line<uint8_t> (in[c] + y * in_stride[c], rgb[c], width, 1.0f / max_value);
+            }
+
+            if (type == SoftLabCsc) {
+                soft_rgb_to_lab (rgb[0], rgb[1], rgb[2], res[0], res[1], res[2], width);
+                uint8_t *dst = out[0] + y * out_stride[0];
+                for (uint32_t x = 0; x < width; ++x) {
+                    dst[x * 3] = clamp_lab_u8 (res[0][x] * (255.0f / 100.0f));
+                    dst[x * 3 + 1] = clamp_lab_u8 (res[1][x] + 128.0f);
+                    dst[x * 3 + 2] = clamp_lab_u8 (res[2][x] + 128.0f);
+                }
+                continue;
+            }
+
+            soft_hdr_lab (rgb[0], rgb[1], rgb[2], res[0], res[1], res[2], width);
+            for (uint32_t c = 0; c < 3; ++c) {
+                if (in_16bit)
+                    store_line<uint16_t> (res[c], out[c] + y * out_stride[c], width, max_value);
+                else
+                    store_line<uint8_t> (res[c], out[c] + y * out_stride[c], width, max_value);
+            }
+        }
+        return XCAM_RETURN_NO_ERROR;
+    }
+};
+
+SoftLabImageHandler::SoftLabImageHandler (const char *name, SoftLabType type)
+    : SoftImageHandler (name)
+    , _type (type)
+{
+}
+
+void
+SoftLabImageHandler::emit_stop ()
+{
+    if (_workers.ptr ())
+        _workers->stop ();
+    SoftImageHandler::emit_stop ();
+}
+
+XCamReturn
+SoftLabImageHandler::prepare_buffer_pool_video_info (
+    const VideoBufferInfo &input,
+    VideoBufferInfo &output)
+{
+    uint32_t format = (_type == SoftLabCsc ? XCAM_PIX_FMT_LAB : input.format);
+    bool format_inited = output.init (format, input.width, input.height);
+
+    XCAM_FAIL_RETURN (
+        WARNING,
+        format_inited,
+        XCAM_RETURN_ERROR_PARAM,
+        "SoftLabImageHandler(%s) ouput format(%s) unsupported",
+        XCAM_STR (get_name ()), xcam_fourcc_to_string (format));
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+SoftLabImageHandler::process (
+    const VideoBufferInfo &in_info, uint8_t *in_mem,
+    const VideoBufferInfo &out_info, uint8_t *out_mem)
+{
+    LabTask task;
+
+    XCAM_FAIL_RETURN (
+        WARNING,
+        in_info.format == XCAM_PIX_FMT_RGB48_planar || in_info.format == XCAM_PIX_FMT_RGB24_planar,
+        XCAM_RETURN_ERROR_PARAM,
+        "SoftLabImageHandler(%s) unsupported input format(%s)",
+        XCAM_STR (get_name ()), xcam_fourcc_to_string (in_info.format));
+    XCAM_FAIL_RETURN (
+        WARNING,
+        out_info.format == (_type == SoftLabCsc ? XCAM_PIX_FMT_LAB : in_info.format),
+        XCAM_RETURN_ERROR_PARAM,
+        "SoftLabImageHandler(%s) unsupported output format(%s)",
+        XCAM_STR (get_name ()), xcam_fourcc_to_string (out_info.format));
+    XCAM_FAIL_RETURN (
+        WARNING,
+        in_info.width == out_info.width && in_info.height == out_info.height,
+        XCAM_RETURN_ERROR_PARAM,
+        "SoftLabImageHandler(%s) size mismatch, in(%dx%d) out(%dx%d)",
+        XCAM_STR (get_name ()), in_info.width, in_info.height, out_info.width, out_info.height);
+
+    task.type = _type;
+    task.in_16bit = (in_info.format == XCAM_PIX_FMT_RGB48_planar);
+    for (uint32_t c = 0; c < 3; ++c) {
+        task.in[c] = in_mem + in_info.offsets[c];
+        task.in_stride[c] = in_info.strides[c];
+        task.out[c] = (c < out_info.components ? out_mem + out_info.offsets[c] : NULL);
+        task.out_stride[c] = (c < out_info.components ? out_info.strides[c] : 0);
+    }
+    task.width = in_info.width;
+
+    if (!_workers.ptr ())
+        _workers = new SoftWorkerPool (get_name ());
+
+    return _workers->run (task, in_info.height);
+}
+
+SmartPtr<SoftImageHandler>
+create_soft_lab_image_handler (SoftLabType type)
+{
+    SmartPtr<SoftLabImageHandler> lab_handler =
+        new SoftLabImageHandler ((type == SoftLabCsc ? "soft_handler_lab_csc" : "soft_handler_lab_hdr"), type);
+
+    return lab_handler;
+}
+
+};
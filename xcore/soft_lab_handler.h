@@ -0,0 +1,91 @@
+/*
+ * soft_lab_handler.h - soft(cpu) rgb to lab and lab hdr handler
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#ifndef XCAM_SOFT_LAB_HANDLER_H
+#define XCAM_SOFT_LAB_HANDLER_H
+
+#include "xcam_utils.h"
+#include "soft_image_handler.h"
+#include "soft_worker_pool.h"
+
+#define XCAM_SOFT_LAB_HDR_TABLE_SIZE 1000
+
+namespace XCam {
+
+enum SoftLabType {
+    SoftLabCsc = 0,  // rgb to 8 bit lab, same as kernel_csc_rgbatolab
+    SoftLabHdr,      // tone mapping on L, same as kernel_hdr_lab
+};
+
+/*
+ * line functions on normalized rgb [0, 1], cube roots from fast_cbrt
+ * soft_rgb_to_lab: D65 white normalized, L in [0, 100]
+ *                  max absolute error 1.6e-4 on L, a and b against libm
+ * soft_hdr_lab:    rgb -> xyz -> lab, L through hdr table, back to rgb
+ *                  max absolute error 2.4e-3, only where L lies within
+ *                  cbrt error of a table step, otherwise 2e-6
+ */
+void soft_rgb_to_lab (
+    const float *r, const float *g, const float *b,
+    float *l, float *a, float *lab_b, uint32_t width);
+void soft_hdr_lab (
+    const float *r, const float *g, const float *b,
+    float *out_r, float *out_g, float *out_b, uint32_t width);
+// tone table of soft_hdr_lab, indexed by L * 10
+const float *soft_hdr_lab_table ();
+
+/*
+ * SoftLabImageHandler
+ * input:  XCAM_PIX_FMT_RGB48_planar or XCAM_PIX_FMT_RGB24_planar
+ * output: SoftLabCsc, XCAM_PIX_FMT_LAB, packed 8 bit L * 255 / 100, a + 128, b + 128
+ *         SoftLabHdr, same format as input
+ */
+class SoftLabImageHandler
+    : public SoftImageHandler
+{
+public:
+    explicit SoftLabImageHandler (const char *name, SoftLabType type);
+
+    //derived from SoftImageHandler
+    virtual void emit_stop ();
+
+protected:
+    //derived from SoftImageHandler
+    virtual XCamReturn prepare_buffer_pool_video_info (
+        const VideoBufferInfo &input,
+        VideoBufferInfo &output);
+    virtual XCamReturn process (
+        const VideoBufferInfo &in_info, uint8_t *in_mem,
+        const VideoBufferInfo &out_info, uint8_t *out_mem);
+
+private:
+    XCAM_DEAD_COPY (SoftLabImageHandler);
+
+private:
+    SoftLabType                _type;
+    SmartPtr<SoftWorkerPool>   _workers;
+};
+
+SmartPtr<SoftImageHandler>
+create_soft_lab_image_handler (SoftLabType type);
+
+};
+
+#endif //XCAM_SOFT_LAB_HANDLER_H
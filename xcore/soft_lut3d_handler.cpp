@@ -0,0 +1,304 @@
+/*
+ * soft_lut3d_handler.cpp - soft(cpu) 3D look up table color handler
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#include "soft_lut3d_handler.h"
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace XCam {
+
+static inline uint8_t
+clamp_to_u8 (float value)
+{
+    return (uint8_t)(XCAM_MIN (XCAM_MAX (value, 0.0f), 1.0f) * 255.0f + 0.5f);
+}
+
+#if defined(__SSE2__)
+// same arithmetic and order as ColorLut3d::lookup, results are bit exact
+static inline void
+sample_lut3d (
+    const float *table, uint32_t size, Lut3dInterpolation interp,
+    const float in[3], float out[3])
+{
+    const uint32_t stride[3] = {
+        XCAM_LUT3D_ENTRY_SIZE,
+        XCAM_LUT3D_ENTRY_SIZE * size,
+        XCAM_LUT3D_ENTRY_SIZE * size * size
+    };
+    uint32_t offset = 0;
+    float f[3];
+
+    for (uint32_t i = 0; i < 3; ++i) {
+        float pos = XCAM_MIN (XCAM_MAX (in[i], 0.0f), 1.0f) * (size - 1);
+        uint32_t index = XCAM_MIN ((uint32_t)pos, size - 2);
+        f[i] = pos - index;
+        offset += index * stride[i];
+    }
+    const float *c000 = table + offset;
+    __m128 result;
+
+    if (interp == Lut3dTrilinear) {
+        __m128 fr = _mm_set1_ps (f[0]), fg = _mm_set1_ps (f[1]), fb = _mm_set1_ps (f[2]);
+        const float *p10 = c000 + stride[1];
+        const float *p01 = c000 + stride[2];
+        const float *p11 = p01 + stride[1];
+        __m128 a, b;
+
+        a = _mm_loadu_ps (c000);
+        b = _mm_loadu_ps (c000 + stride[0]);
+        __m128 c00 = _mm_add_ps (a, _mm_mul_ps (_mm_sub_ps (b, a), fr));
+        a = _mm_loadu_ps (p10);
+        b = _mm_loadu_ps (p10 + stride[0]);
+        __m128 c10 = _mm_add_ps (a, _mm_mul_ps (_mm_sub_ps (b, a), fr));
+        a = _mm_loadu_ps (p01);
+        b = _mm_loadu_ps (p01 + stride[0]);
+        __m128 c01 = _mm_add_ps (a, _mm_mul_ps (_mm_sub_ps (b, a), fr));
+        a = _mm_loadu_ps (p11);
+        b = _mm_loadu_ps (p11 + stride[0]);
+        __m128 c11 = _mm_add_ps (a, _mm_mul_ps (_mm_sub_ps (b, a), fr));
+
+        __m128 c0 = _mm_add_ps (c00, _mm_mul_ps (_mm_sub_ps (c10, c00), fg));
+        __m128 c1 = _mm_add_ps (c01, _mm_mul_ps (_mm_sub_ps (c11, c01), fg));
+        result = _mm_add_ps (c0, _mm_mul_ps (_mm_sub_ps (c1, c0), fb));
+    } else {
+        uint32_t order[3] = {0, 1, 2};
+        if (f[order[0]] < f[order[1]])
+            std::swap (order[0], order[1]);
+        if (f[order[1]] < f[order[2]])
+            std::swap (order[1], order[2]);
+        if (f[order[0]] < f[order[1]])
+            std::swap (order[0], order[1]);
+
+        const float *c1 = c000 + stride[order[0]];
+        const float *c2 = c1 + stride[order[1]];
+        const float *c3 = c2 + stride[order[2]];
+        result = _mm_mul_ps (_mm_loadu_ps (c000), _mm_set1_ps (1.0f - f[order[0]]));
+        result = _mm_add_ps (result, _mm_mul_ps (_mm_loadu_ps (c1), _mm_set1_ps (f[order[0]] - f[order[1]])));
+        result = _mm_add_ps (result, _mm_mul_ps (_mm_loadu_ps (c2), _mm_set1_ps (f[order[1]] - f[order[2]])));
+        result = _mm_add_ps (result, _mm_mul_ps (_mm_loadu_ps (c3), _mm_set1_ps (f[order[2]])));
+    }
+
+    float tmp[4];
+    _mm_storeu_ps (tmp, result);
+    out[0] = tmp[0];
+    out[1] = tmp[1];
+    out[2] = tmp[2];
+}
+#else
+static inline void
+sample_lut3d (
+    const float *table, uint32_t size, Lut3dInterpolation interp,
+    const float in[3], float out[3])
+{
+    ColorLut3d::lookup (table, size, interp, in, out);
+}
+#endif
+
+// rows of the task are line pairs
+class Lut3dTask
+    : public SoftBandTask
+{
+public:
+    const float         *table;
+    uint32_t             size;
+    Lut3dInterpolation   interp;
+    bool                 in_16bit;
+    float                in_scale;
+    const uint8_t       *in[3];
+    uint32_t             in_stride[3];
+    bool                 out_nv12;
+    uint8_t             *out[3];
+    uint32_t             out_stride[3];
+    uint32_t             width;
+
+    virtual XCamReturn work (uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; ++i) {
+            if (in_16bit)
+                convert_line_pair<uint16_t> (i * 2);
+            else
+                convert_line_pair<uint8_t> (i * 2);
+        }
+        return XCAM_RETURN_NO_ERROR;
+    }
+
+private:
+    template <typename T>
+    void convert_line_pair (uint32_t line) {
+        const T *src[2][3];
+        float color[3], result[2][2][3];
+
+        for (uint32_t c = 0; c < 3; ++c) {
+            src[0][c] = (const T *)(in[c] + line * in_stride[c]);
+            src[1][c] = (const T *)(in[c] + (line + 1) * in_stride[c]);
+        }
+
+        for (uint32_t x = 0; x < width; x += 2) {
+            for (uint32_t l = 0; l < 2; ++l)
+                for (uint32_t p = 0; p < 2; ++p) {
+                    color[0] = src[l][0][x + p] * in_scale;
+                    color[1] = src[l][1][x + p] * in_scale;
+                    color[2] = src[l][2][x + p] * in_scale;
+                    sample_lut3d (table, size, interp, color, result[l][p]);
+                }
+
+            if (out_nv12) {
+                uint8_t *y0 = out[0] + line * out_stride[0];
+                uint8_t *uv = out[1] + line / 2 * out_stride[1];
+                y0[x] = clamp_to_u8 (result[0][0][0]);
+                y0[x + 1] = clamp_to_u8 (result[0][1][0]);
+                y0[out_stride[0] + x] = clamp_to_u8 (result[1][0][0]);
+                y0[out_stride[0] + x + 1] = clamp_to_u8 (result[1][1][0]);
+                for (uint32_t c = 1; c < 3; ++c)
+                    uv[x + c - 1] = clamp_to_u8 (
+                                        (result[0][0][c] + result[0][1][c] + result[1][0][c] + result[1][1][c]) * 0.25f);
+            } else {
+                for (uint32_t c = 0; c < 3; ++c) {
+                    uint8_t *dst = out[c] + line * out_stride[c] + x;
+                    dst[0] = clamp_to_u8 (result[0][0][c]);
+                    dst[1] = clamp_to_u8 (result[0][1][c]);
+                    dst[out_stride[c]] = clamp_to_u8 (result[1][0][c]);
+                    dst[out_stride[c] + 1] = clamp_to_u8 (result[1][1][c]);
+                }
+            }
+        }
+    }
+};
+
+SoftLut3dImageHandler::SoftLut3dImageHandler (const char *name)
+    : SoftImageHandler (name)
+    , _interp (Lut3dTrilinear)
+    , _output_format (V4L2_PIX_FMT_NV12)
+{
+    _lut = new ColorLut3d;
+}
+
+bool
+SoftLut3dImageHandler::set_output_format (uint32_t format)
+{
+    XCAM_FAIL_RETURN (
+        WARNING,
+        format == V4L2_PIX_FMT_NV12 || format == XCAM_PIX_FMT_RGB24_planar,
+        false,
+        "SoftLut3dImageHandler(%s) unsupported output format(%s)",
+        XCAM_STR (get_name ()), xcam_fourcc_to_string (format));
+
+    _output_format = format;
+    _lut->enable_csc (format == V4L2_PIX_FMT_NV12);
+    return true;
+}
+
+XCamReturn
+SoftLut3dImageHandler::apply_3a_result (SmartPtr<X3aResult> &result)
+{
+    return _lut->apply_3a_result (result);
+}
+
+void
+SoftLut3dImageHandler::emit_stop ()
+{
+    if (_workers.ptr ())
+        _workers->stop ();
+    SoftImageHandler::emit_stop ();
+}
+
+XCamReturn
+SoftLut3dImageHandler::prepare_buffer_pool_video_info (
+    const VideoBufferInfo &input,
+    VideoBufferInfo &output)
+{
+    bool format_inited = output.init (_output_format, input.width, input.height);
+
+    XCAM_FAIL_RETURN (
+        WARNING,
+        format_inited,
+        XCAM_RETURN_ERROR_PARAM,
+        "SoftLut3dImageHandler(%s) ouput format(%s) unsupported",
+        XCAM_STR (get_name ()), xcam_fourcc_to_string (_output_format));
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+SoftLut3dImageHandler::process (
+    const VideoBufferInfo &in_info, uint8_t *in_mem,
+    const VideoBufferInfo &out_info, uint8_t *out_mem)
+{
+    Lut3dTask task;
+
+    XCAM_FAIL_RETURN (
+        WARNING,
+        in_info.format == XCAM_PIX_FMT_RGB48_planar || in_info.format == XCAM_PIX_FMT_RGB24_planar,
+        XCAM_RETURN_ERROR_PARAM,
+        "SoftLut3dImageHandler(%s) unsupported input format(%s)",
+        XCAM_STR (get_name ()), xcam_fourcc_to_string (in_info.format));
+    XCAM_FAIL_RETURN (
+        WARNING,
+        out_info.format == _output_format,
+        XCAM_RETURN_ERROR_PARAM,
+        "SoftLut3dImageHandler(%s) output format(%s) mismatch",
+        XCAM_STR (get_name ()), xcam_fourcc_to_string (out_info.format));
+    XCAM_FAIL_RETURN (
+        WARNING,
+        in_info.width == out_info.width && in_info.height == out_info.height &&
+        !(in_info.width % 2) && !(in_info.height % 2),
+        XCAM_RETURN_ERROR_PARAM,
+        "SoftLut3dImageHandler(%s) size mismatch or odd, in(%dx%d) out(%dx%d)",
+        XCAM_STR (get_name ()), in_info.width, in_info.height, out_info.width, out_info.height);
+
+    // re-baked only after 3a results or settings changed, held until the run returns
+    SmartPtr<ColorLut3dTable> table = _lut->get_table ();
+    task.table = &table->entries[0];
+    task.size = table->size;
+    task.interp = _interp;
+    task.in_16bit = (in_info.format == XCAM_PIX_FMT_RGB48_planar);
+    task.in_scale = task.in_16bit ? 1.0f / 65535.0f : 1.0f / 255.0f;
+    task.out_nv12 = (out_info.format == V4L2_PIX_FMT_NV12);
+    for (uint32_t c = 0; c < 3; ++c) {
+        task.in[c] = in_mem + in_info.offsets[c];
+        task.in_stride[c] = in_info.strides[c];
+        task.out[c] = (c < out_info.components ? out_mem + out_info.offsets[c] : NULL);
+        task.out_stride[c] = (c < out_info.components ? out_info.strides[c] : 0);
+    }
+    task.width = in_info.width;
+
+    if (!_workers.ptr ())
+        _workers = new SoftWorkerPool (get_name ());
+
+    return _workers->run (task, in_info.height / 2);
+}
+
+SmartPtr<SoftImageHandler>
+create_soft_lut3d_image_handler (uint32_t lut_size, Lut3dInterpolation interp)
+{
+    SmartPtr<SoftLut3dImageHandler> lut3d_handler = new SoftLut3dImageHandler ("soft_handler_lut3d");
+    XCAM_FAIL_RETURN (
+        WARNING,
+        lut3d_handler->get_color_lut ()->set_size (lut_size),
+        NULL,
+        "create soft lut3d handler failed");
+    lut3d_handler->set_interpolation (interp);
+
+    return lut3d_handler;
+}
+
+};
@@ -0,0 +1,82 @@
+/*
+ * soft_lut3d_handler.h - soft(cpu) 3D look up table color handler
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#ifndef XCAM_SOFT_LUT3D_HANDLER_H
+#define XCAM_SOFT_LUT3D_HANDLER_H
+
+#include "xcam_utils.h"
+#include "soft_image_handler.h"
+#include "soft_worker_pool.h"
+#include "color_lut3d.h"
+
+namespace XCam {
+
+/*
+ * SoftLut3dImageHandler, whole color chain in one lookup per pixel
+ * input:  XCAM_PIX_FMT_RGB48_planar or XCAM_PIX_FMT_RGB24_planar
+ * output: V4L2_PIX_FMT_NV12, chroma averaged on 2x2
+ *         XCAM_PIX_FMT_RGB24_planar, csc of the lut disabled
+ */
+class SoftLut3dImageHandler
+    : public SoftImageHandler
+{
+public:
+    explicit SoftLut3dImageHandler (const char *name);
+
+    // configure color matrix, enabled stages and size through it
+    SmartPtr<ColorLut3d> &get_color_lut () {
+        return _lut;
+    }
+    void set_interpolation (Lut3dInterpolation interp) {
+        _interp = interp;
+    }
+    bool set_output_format (uint32_t format);
+
+    //derived from SoftImageHandler
+    virtual XCamReturn apply_3a_result (SmartPtr<X3aResult> &result);
+    virtual void emit_stop ();
+
+protected:
+    //derived from SoftImageHandler
+    virtual XCamReturn prepare_buffer_pool_video_info (
+        const VideoBufferInfo &input,
+        VideoBufferInfo &output);
+    virtual XCamReturn process (
+        const VideoBufferInfo &in_info, uint8_t *in_mem,
+        const VideoBufferInfo &out_info, uint8_t *out_mem);
+
+private:
+    XCAM_DEAD_COPY (SoftLut3dImageHandler);
+
+private:
+    SmartPtr<ColorLut3d>       _lut;
+    Lut3dInterpolation         _interp;
+    uint32_t                   _output_format;
+    SmartPtr<SoftWorkerPool>   _workers;
+};
+
+SmartPtr<SoftImageHandler>
+create_soft_lut3d_image_handler (
+    uint32_t lut_size = XCAM_LUT3D_SIZE_SMALL,
+    Lut3dInterpolation interp = Lut3dTrilinear);
+
+};
+
+#endif //XCAM_SOFT_LUT3D_HANDLER_H
@@ -0,0 +1,210 @@
+/*
+ * soft_worker_pool.cpp - worker threads for soft(cpu) row band processing
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#include "soft_worker_pool.h"
+#include "xcam_thread.h"
+#include "perf_counters.h"
+#include <unistd.h>
+
+// bands per thread, more bands balance uneven cores better
+#define XCAM_SOFT_WORKER_BANDS_PER_THREAD 2
+
+namespace XCam {
+
+class SoftWorkerThread
+    : public Thread
+{
+public:
+    SoftWorkerThread (SoftWorkerPool *pool, const char *name)
+        : Thread (name)
+        , _pool (pool)
+    {}
+
+protected:
+    virtual bool loop () {
+        return _pool->work_one_band (true);
+    }
+
+private:
+    SoftWorkerPool   *_pool;
+};
+
+SoftWorkerPool::SoftWorkerPool (const char *name, uint32_t thread_count)
+    : _name (NULL)
+    , _thread_count (thread_count)
+    , _started (false)
+    , _stopping (false)
+    , _task (NULL)
+    , _rows (0)
+    , _band_rows (0)
+    , _band_count (0)
+    , _next_band (0)
+    , _done_bands (0)
+    , _result (XCAM_RETURN_NO_ERROR)
+{
+    if (name)
+        _name = strndup (name, XCAM_MAX_STR_SIZE);
+
+    if (!_thread_count) {
+        long cpus = sysconf (_SC_NPROCESSORS_ONLN);
+        // calling thread works as well
+        _thread_count = (cpus > 1 ? (uint32_t)(cpus - 1) : 0);
+    }
+    if (_thread_count > XCAM_SOFT_WORKER_MAX_THREADS)
+        _thread_count = XCAM_SOFT_WORKER_MAX_THREADS;
+}
+
+SoftWorkerPool::~SoftWorkerPool ()
+{
+    stop ();
+    if (_name)
+        xcam_free (_name);
+}
+
+bool
+SoftWorkerPool::start ()
+{
+    char thread_name[64];
+
+    if (_started)
+        return true;
+
+    for (uint32_t i = 0; i < _thread_count; ++i) {
+        snprintf (thread_name, sizeof (thread_name), "%s-%d", XCAM_STR (_name), i);
+        SmartPtr<SoftWorkerThread> thread = new SoftWorkerThread (this, thread_name);
+        if (!thread->start ()) {
+            XCAM_LOG_WARNING ("soft worker pool(%s) start thread %d failed", XCAM_STR (_name), i);
+            break;
+        }
+        _threads.push_back (thread);
+    }
+    _thread_count = _threads.size ();
+    _started = true;
+    return true;
+}
+
+void
+SoftWorkerPool::stop ()
+{
+    SmartLock run_locker (_run_mutex);
+    if (!_started)
+        return;
+
+    {
+        SmartLock locker (_mutex);
+        _stopping = true;
+        _job_cond.broadcast ();
+    }
+    for (uint32_t i = 0; i < _threads.size (); ++i)
+        _threads[i]->stop ();
+    _threads.clear ();
+
+    _stopping = false;
+    _started = false;
+}
+
+bool
+SoftWorkerPool::work_one_band (bool wait)
+{
+    SoftBandTask *task = NULL;
+    uint32_t begin = 0, end = 0;
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+
+    {
+        SmartLock locker (_mutex);
+        while (wait && !_stopping && (!_task || _next_band >= _band_count))
+            _job_cond.wait (_mutex);
+
+        if (_stopping || !_task || _next_band >= _band_count)
+            return false;
+
+        task = _task;
+        begin = _next_band * _band_rows;
+        end = XCAM_MIN (begin + _band_rows, _rows);
+        ++_next_band;
+    }
+
+    {
+        // all bands on all threads, the handler stage only sees its own thread
+        PerfStage perf_stage ("worker", _name);
+        ret = task->work (begin, end);
+    }
+
+    {
+        SmartLock locker (_mutex);
+        if (ret != XCAM_RETURN_NO_ERROR && _result == XCAM_RETURN_NO_ERROR)
+            _result = ret;
+        ++_done_bands;
+        if (_done_bands >= _band_count)
+            _done_cond.broadcast ();
+    }
+    return true;
+}
+
+XCamReturn
+SoftWorkerPool::run (SoftBandTask &task, uint32_t rows, uint32_t row_align)
+{
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+    SmartLock run_locker (_run_mutex);
+
+    if (!rows)
+        return XCAM_RETURN_NO_ERROR;
+    if (!row_align)
+        row_align = 1;
+
+    if (!_started)
+        start ();
+
+    uint32_t max_bands = (_thread_count + 1) * XCAM_SOFT_WORKER_BANDS_PER_THREAD;
+    uint32_t band_rows = XCAM_ALIGN_UP ((rows + max_bands - 1) / max_bands, row_align);
+
+    if (!_thread_count || band_rows >= rows) {
+        PerfStage perf_stage ("worker", _name);
+        return task.work (0, rows);
+    }
+
+    {
+        SmartLock locker (_mutex);
+        _task = &task;
+        _rows = rows;
+        _band_rows = band_rows;
+        _band_count = (rows + band_rows - 1) / band_rows;
+        _next_band = 0;
+        _done_bands = 0;
+        _result = XCAM_RETURN_NO_ERROR;
+        _job_cond.broadcast ();
+    }
+
+    while (work_one_band (false)) {
+        // calling thread keeps taking bands
+    }
+
+    {
+        SmartLock locker (_mutex);
+        while (_done_bands < _band_count)
+            _done_cond.wait (_mutex);
+        ret = _result;
+        _task = NULL;
+    }
+
+    return ret;
+}
+
+};
@@ -0,0 +1,96 @@
+/*
+ * soft_worker_pool.h - worker threads for soft(cpu) row band processing
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#ifndef XCAM_SOFT_WORKER_POOL_H
+#define XCAM_SOFT_WORKER_POOL_H
+
+#include "xcam_utils.h"
+#include "xcam_mutex.h"
+#include "smartptr.h"
+#include <vector>
+
+#define XCAM_SOFT_WORKER_MAX_THREADS 16
+
+namespace XCam {
+
+class SoftWorkerThread;
+
+/*
+ * a job split by rows, work() is called concurrently on different bands
+ */
+class SoftBandTask
+{
+public:
+    virtual ~SoftBandTask () {}
+    // process rows in [begin, end)
+    virtual XCamReturn work (uint32_t begin, uint32_t end) = 0;
+};
+
+/*
+ * SoftWorkerPool
+ * run() splits rows into bands, the calling thread works on bands too
+ * and returns after all bands are done. One job at a time.
+ */
+class SoftWorkerPool
+{
+    friend class SoftWorkerThread;
+
+public:
+    // thread_count 0 means number of online cpus
+    explicit SoftWorkerPool (const char *name, uint32_t thread_count = 0);
+    ~SoftWorkerPool ();
+
+    uint32_t get_thread_count () const {
+        return _thread_count;
+    }
+
+    // rows of each band except the last one are aligned to row_align, a power of 2
+    XCamReturn run (SoftBandTask &task, uint32_t rows, uint32_t row_align = 1);
+    void stop ();
+
+private:
+    bool start ();
+    bool work_one_band (bool wait);
+
+    XCAM_DEAD_COPY (SoftWorkerPool);
+
+private:
+    char                                   *_name;
+    uint32_t                                _thread_count;
+    std::vector<SmartPtr<SoftWorkerThread> > _threads;
+    bool                                    _started;
+    bool                                    _stopping;
+
+    Mutex                                   _run_mutex;
+    Mutex                                   _mutex;
+    Cond                                    _job_cond;
+    Cond                                    _done_cond;
+    SoftBandTask                           *_task;
+    uint32_t                                _rows;
+    uint32_t                                _band_rows;
+    uint32_t                                _band_count;
+    uint32_t                                _next_band;
+    uint32_t                                _done_bands;
+    XCamReturn                              _result;
+};
+
+};
+
+#endif //XCAM_SOFT_WORKER_POOL_H
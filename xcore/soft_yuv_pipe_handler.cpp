@@ -0,0 +1,513 @@
+/*
+ * soft_yuv_pipe_handler.cpp - soft(cpu) yuv pipe handler
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#include "soft_yuv_pipe_handler.h"
+#include <math.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// same range as kernel_yuv_pipe, but all values are kept in [0, 255] instead of [0, 1]
+#define SOFT_YUV_PIPE_UV_OFFSET 127.5f
+#define SOFT_YUV_PIPE_TNR_DIFF_MAX (0.8f * 255.0f)
+
+namespace XCam {
+
+static const float default_rgbtoyuv_matrix[XCAM_COLOR_MATRIX_SIZE] = {
+    0.299f, 0.587f, 0.114f, -0.14713f, -0.28886f, 0.436f, 0.615f, -0.51499f, -0.10001f
+};
+
+/*
+ * same sector definition as get_sector_id in kernel_yuv_pipe.cl,
+ * 16 sectors split by tan() of 0.5, 1, 2 in each quadrant
+ */
+static uint8_t
+macc_sector_id (float u, float v)
+{
+    u = fabs (u) > 0.00001f ? u : 0.00001f;
+    float tg = v / u;
+    uint8_t se = tg > 1.0f ? (tg > 2.0f ? 3 : 2) : (tg > 0.5f ? 1 : 0);
+    uint8_t so = tg > -1.0f ? (tg > -0.5f ? 3 : 2) : (tg > -2.0f ? 1 : 0);
+    return tg > 0 ? (u > 0 ? se : (se + 8)) : (u > 0 ? (so + 12) : (so + 4));
+}
+
+static inline int32_t
+macc_lut_index (float value)
+{
+    const int32_t half = 1 << (XCAM_SOFT_MACC_SECTOR_LUT_BITS - 1);
+    int32_t index = (int32_t)floorf (value) + half;
+    return XCAM_MIN (XCAM_MAX (index, 0), (half << 1) - 1);
+}
+
+// rounds to nearest even like _mm_cvtps_epi32, so tail and SSE2 columns match
+static inline uint8_t
+clamp_to_uint8 (float value)
+{
+    int32_t v = (int32_t)lrintf (value);
+    return (uint8_t)XCAM_MIN (XCAM_MAX (v, 0), 255);
+}
+
+/*
+ * tnr coefficient of kernel_yuv_pipe:
+ *   diff < thr ? gain : min ((diff * (1 - gain) + diff_max * gain - thr) / (diff_max - thr), 1)
+ * rewritten as slope * diff + bias to save the division
+ */
+struct TnrCoeff {
+    float gain;
+    float thr;
+    float slope;
+    float bias;
+
+    void init (float tnr_gain, float tnr_thr) {
+        gain = tnr_gain;
+        thr = tnr_thr;
+        slope = (1.0f - gain) / (SOFT_YUV_PIPE_TNR_DIFF_MAX - thr);
+        bias = (SOFT_YUV_PIPE_TNR_DIFF_MAX * gain - thr) / (SOFT_YUV_PIPE_TNR_DIFF_MAX - thr);
+    }
+    float get (float diff) const {
+        if (diff < thr)
+            return gain;
+        return XCAM_MIN (diff * slope + bias, 1.0f);
+    }
+};
+
+SoftYuvPipeImageHandler::SoftYuvPipeImageHandler (const char *name)
+    : SoftImageHandler (name)
+    , _gain_yuv (1.0f)
+    , _thr_y (0.05f)
+    , _thr_uv (0.05f)
+    , _enable_tnr_yuv (false)
+{
+    for (uint32_t i = 0; i < XCAM_CHROMA_AXIS_SIZE; ++i) {
+        _macc_table[i * XCAM_CHROMA_MATRIX_SIZE] = 1.0f;
+        _macc_table[i * XCAM_CHROMA_MATRIX_SIZE + 1] = 0.0f;
+        _macc_table[i * XCAM_CHROMA_MATRIX_SIZE + 2] = 0.0f;
+        _macc_table[i * XCAM_CHROMA_MATRIX_SIZE + 3] = 1.0f;
+    }
+    memcpy (_rgbtoyuv_matrix, default_rgbtoyuv_matrix, sizeof (_rgbtoyuv_matrix));
+    init_sector_lut ();
+}
+
+void
+SoftYuvPipeImageHandler::init_sector_lut ()
+{
+    const int32_t size = 1 << XCAM_SOFT_MACC_SECTOR_LUT_BITS;
+    const int32_t half = size / 2;
+
+    // sample sector at the center of each quantization cell
+    for (int32_t iu = 0; iu < size; ++iu)
+        for (int32_t iv = 0; iv < size; ++iv)
+            _sector_lut[(iu << XCAM_SOFT_MACC_SECTOR_LUT_BITS) | iv] =
+                macc_sector_id (iu - half + 0.5f, iv - half + 0.5f);
+}
+
+bool
+SoftYuvPipeImageHandler::set_macc_table (const XCam3aResultMaccMatrix &macc)
+{
+    for (int i = 0; i < XCAM_CHROMA_AXIS_SIZE * XCAM_CHROMA_MATRIX_SIZE; i++)
+        _macc_table[i] = (float)macc.table[i];
+    return true;
+}
+
+bool
+SoftYuvPipeImageHandler::set_rgbtoyuv_matrix (const XCam3aResultColorMatrix &matrix)
+{
+    for (int i = 0; i < XCAM_COLOR_MATRIX_SIZE; i++)
+        _rgbtoyuv_matrix[i] = (float)matrix.matrix[i];
+    return true;
+}
+
+bool
+SoftYuvPipeImageHandler::set_tnr_yuv_config (const XCam3aResultTemporalNoiseReduction &config)
+{
+    _gain_yuv = (float)config.gain;
+    _thr_y = (float)config.threshold[0];
+    _thr_uv = (float)config.threshold[1];
+    XCAM_LOG_DEBUG ("soft yuv pipe set TNR config: _gain(%f), _thr_y(%f), _thr_uv(%f)",
+                    _gain_yuv, _thr_y, _thr_uv);
+    return true;
+}
+
+bool
+SoftYuvPipeImageHandler::set_tnr_enable (bool enable_tnr_yuv)
+{
+    _enable_tnr_yuv = enable_tnr_yuv;
+    if (!_enable_tnr_yuv)
+        _prev_output.release ();
+    return true;
+}
+
+XCamReturn
+SoftYuvPipeImageHandler::apply_3a_result (SmartPtr<X3aResult> &result)
+{
+    XCAM_ASSERT (result.ptr ());
+
+    switch (result->get_type ()) {
+    case XCAM_3A_RESULT_RGB2YUV_MATRIX: {
+        SmartPtr<X3aColorMatrixResult> csc_res = result.dynamic_cast_ptr<X3aColorMatrixResult> ();
+        XCAM_ASSERT (csc_res.ptr ());
+        set_rgbtoyuv_matrix (csc_res->get_standard_result ());
+        break;
+    }
+    case XCAM_3A_RESULT_MACC: {
+        SmartPtr<X3aMaccMatrixResult> macc_res = result.dynamic_cast_ptr<X3aMaccMatrixResult> ();
+        XCAM_ASSERT (macc_res.ptr ());
+        set_macc_table (macc_res->get_standard_result ());
+        break;
+    }
+    case XCAM_3A_RESULT_TEMPORAL_NOISE_REDUCTION_YUV: {
+        SmartPtr<X3aTemporalNoiseReduction> tnr_res = result.dynamic_cast_ptr<X3aTemporalNoiseReduction> ();
+        XCAM_ASSERT (tnr_res.ptr ());
+        set_tnr_yuv_config (tnr_res->get_standard_result ());
+        break;
+    }
+    default:
+        return XCAM_RETURN_BYPASS;
+    }
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+void
+SoftYuvPipeImageHandler::emit_stop ()
+{
+    _prev_output.release ();
+    SoftImageHandler::emit_stop ();
+}
+
+XCamReturn
+SoftYuvPipeImageHandler::prepare_buffer_pool_video_info (
+    const VideoBufferInfo &input,
+    VideoBufferInfo &output)
+{
+    bool format_inited = output.init (V4L2_PIX_FMT_NV12, input.width, input.height);
+
+    XCAM_FAIL_RETURN (
+        WARNING,
+        format_inited,
+        XCAM_RETURN_ERROR_PARAM,
+        "soft image handler(%s) init NV12 output failed", XCAM_STR (get_name ()));
+    return XCAM_RETURN_NO_ERROR;
+}
+
+static inline const float *
+macc_lookup (const float *macc_table, const uint8_t *sector_lut, float u, float v)
+{
+    return macc_table + XCAM_CHROMA_MATRIX_SIZE *
+           sector_lut[(macc_lut_index (u) << XCAM_SOFT_MACC_SECTOR_LUT_BITS) | macc_lut_index (v)];
+}
+
+static void
+process_block (
+    float r[2][2], float g[2][2], float b[2][2],
+    uint8_t *y_out[2], uint8_t *uv_out,
+    const uint8_t *y_prev[2], const uint8_t *uv_prev,
+    const float *matrix, const float *macc_table, const uint8_t *sector_lut,
+    const TnrCoeff &coeff_y, const TnrCoeff &coeff_uv)
+{
+    float y[2][2], uv[2];
+
+    for (uint32_t j = 0; j < 2; ++j)
+        for (uint32_t i = 0; i < 2; ++i)
+            y[j][i] = matrix[0] * r[j][i] + matrix[1] * g[j][i] + matrix[2] * b[j][i];
+
+    // chroma from top-left pixel, same as kernel_yuv_pipe
+    float u = matrix[3] * r[0][0] + matrix[4] * g[0][0] + matrix[5] * b[0][0];
+    float v = matrix[6] * r[0][0] + matrix[7] * g[0][0] + matrix[8] * b[0][0];
+    const float *macc = macc_lookup (macc_table, sector_lut, u, v);
+    uv[0] = u * macc[0] + v * macc[1] + SOFT_YUV_PIPE_UV_OFFSET;
+    uv[1] = u * macc[2] + v * macc[3] + SOFT_YUV_PIPE_UV_OFFSET;
+
+    if (y_prev[0]) {
+        float diff = 0.0f;
+        for (uint32_t j = 0; j < 2; ++j)
+            for (uint32_t i = 0; i < 2; ++i)
+                diff += fabsf (y[j][i] - y_prev[j][i]);
+        float c = coeff_y.get (diff * 0.25f);
+        for (uint32_t j = 0; j < 2; ++j)
+            for (uint32_t i = 0; i < 2; ++i)
+                y[j][i] = y_prev[j][i] + (y[j][i] - y_prev[j][i]) * c;
+
+        for (uint32_t i = 0; i < 2; ++i)
+            uv[i] = uv_prev[i] + (uv[i] - uv_prev[i]) * coeff_uv.get (fabsf (uv[i] - uv_prev[i]));
+    }
+
+    for (uint32_t j = 0; j < 2; ++j)
+        for (uint32_t i = 0; i < 2; ++i)
+            y_out[j][i] = clamp_to_uint8 (y[j][i]);
+    uv_out[0] = clamp_to_uint8 (uv[0]);
+    uv_out[1] = clamp_to_uint8 (uv[1]);
+}
+
+#if defined(__SSE2__)
+static inline void
+load_8_pixels (const uint16_t *src, __m128 &lo, __m128 &hi)
+{
+    __m128i zero = _mm_setzero_si128 ();
+    __m128i v = _mm_loadu_si128 ((const __m128i *)src);
+    lo = _mm_cvtepi32_ps (_mm_unpacklo_epi16 (v, zero));
+    hi = _mm_cvtepi32_ps (_mm_unpackhi_epi16 (v, zero));
+}
+
+static inline void
+load_8_pixels (const uint8_t *src, __m128 &lo, __m128 &hi)
+{
+    __m128i zero = _mm_setzero_si128 ();
+    __m128i v = _mm_unpacklo_epi8 (_mm_loadl_epi64 ((const __m128i *)src), zero);
+    lo = _mm_cvtepi32_ps (_mm_unpacklo_epi16 (v, zero));
+    hi = _mm_cvtepi32_ps (_mm_unpackhi_epi16 (v, zero));
+}
+
+static inline void
+store_8_pixels (uint8_t *dst, __m128 lo, __m128 hi)
+{
+    __m128i v = _mm_packs_epi32 (_mm_cvtps_epi32 (lo), _mm_cvtps_epi32 (hi));
+    _mm_storel_epi64 ((__m128i *)dst, _mm_packus_epi16 (v, v));
+}
+
+static inline __m128
+abs_ps (__m128 v)
+{
+    return _mm_andnot_ps (_mm_set1_ps (-0.0f), v);
+}
+
+static inline __m128
+tnr_coeff_ps (__m128 diff, const TnrCoeff &coeff)
+{
+    __m128 linear = _mm_min_ps (
+                        _mm_add_ps (_mm_mul_ps (diff, _mm_set1_ps (coeff.slope)), _mm_set1_ps (coeff.bias)),
+                        _mm_set1_ps (1.0f));
+    __m128 below = _mm_cmplt_ps (diff, _mm_set1_ps (coeff.thr));
+    return _mm_or_ps (_mm_and_ps (below, _mm_set1_ps (coeff.gain)), _mm_andnot_ps (below, linear));
+}
+
+// prev + (cur - prev) * coeff
+static inline __m128
+tnr_blend_ps (__m128 cur, __m128 prev, __m128 coeff)
+{
+    return _mm_add_ps (prev, _mm_mul_ps (_mm_sub_ps (cur, prev), coeff));
+}
+
+static inline __m128
+matrix_row_ps (const float *row, __m128 r, __m128 g, __m128 b)
+{
+    return _mm_add_ps (
+               _mm_add_ps (_mm_mul_ps (_mm_set1_ps (row[0]), r), _mm_mul_ps (_mm_set1_ps (row[1]), g)),
+               _mm_mul_ps (_mm_set1_ps (row[2]), b));
+}
+#endif
+
+template <typename PixelT>
+void
+SoftYuvPipeImageHandler::process_lines (
+    const PixelT *r[2], const PixelT *g[2], const PixelT *b[2],
+    uint8_t *y_out[2], uint8_t *uv_out,
+    const uint8_t *y_prev[2], const uint8_t *uv_prev,
+    uint32_t width, float in_scale)
+{
+    float matrix[XCAM_COLOR_MATRIX_SIZE];
+    uint32_t x = 0;
+
+    // fold input normalization and the [0, 255] output range into matrix
+    for (uint32_t i = 0; i < XCAM_COLOR_MATRIX_SIZE; ++i)
+        matrix[i] = _rgbtoyuv_matrix[i] * in_scale;
+
+    TnrCoeff coeff_y, coeff_uv;
+    coeff_y.init (_gain_yuv, _thr_y * 255.0f);
+    coeff_uv.init (_gain_yuv, _thr_uv * 255.0f);
+
+#if defined(__SSE2__)
+    // 8 pixels x 2 lines each loop, 4 UV pairs
+    for (; x + 8 <= width; x += 8) {
+        __m128 y_lo[2], y_hi[2], u_lo, u_hi, v_lo, v_hi;
+        __m128 r_lo, r_hi, g_lo, g_hi, b_lo, b_hi;
+
+        // uv comes from the first line of the pair
+        load_8_pixels (r[0] + x, r_lo, r_hi);
+        load_8_pixels (g[0] + x, g_lo, g_hi);
+        load_8_pixels (b[0] + x, b_lo, b_hi);
+        y_lo[0] = matrix_row_ps (matrix, r_lo, g_lo, b_lo);
+        y_hi[0] = matrix_row_ps (matrix, r_hi, g_hi, b_hi);
+        u_lo = matrix_row_ps (matrix + 3, r_lo, g_lo, b_lo);
+        u_hi = matrix_row_ps (matrix + 3, r_hi, g_hi, b_hi);
+        v_lo = matrix_row_ps (matrix + 6, r_lo, g_lo, b_lo);
+        v_hi = matrix_row_ps (matrix + 6, r_hi, g_hi, b_hi);
+
+        load_8_pixels (r[1] + x, r_lo, r_hi);
+        load_8_pixels (g[1] + x, g_lo, g_hi);
+        load_8_pixels (b[1] + x, b_lo, b_hi);
+        y_lo[1] = matrix_row_ps (matrix, r_lo, g_lo, b_lo);
+        y_hi[1] = matrix_row_ps (matrix, r_hi, g_hi, b_hi);
+
+        if (y_prev[0]) {
+            __m128 p_lo[2], p_hi[2];
+            __m128 d_lo = _mm_setzero_ps (), d_hi = _mm_setzero_ps ();
+            for (uint32_t j = 0; j < 2; ++j) {
+                load_8_pixels (y_prev[j] + x, p_lo[j], p_hi[j]);
+                d_lo = _mm_add_ps (d_lo, abs_ps (_mm_sub_ps (y_lo[j], p_lo[j])));
+                d_hi = _mm_add_ps (d_hi, abs_ps (_mm_sub_ps (y_hi[j], p_hi[j])));
+            }
+            // mean absolute difference of each 2x2 block
+            __m128 diff = _mm_mul_ps (
+                              _mm_add_ps (
+                                  _mm_shuffle_ps (d_lo, d_hi, _MM_SHUFFLE (2, 0, 2, 0)),
+                                  _mm_shuffle_ps (d_lo, d_hi, _MM_SHUFFLE (3, 1, 3, 1))),
+                              _mm_set1_ps (0.25f));
+            __m128 coeff = tnr_coeff_ps (diff, coeff_y);
+            __m128 c_lo = _mm_unpacklo_ps (coeff, coeff);
+            __m128 c_hi = _mm_unpackhi_ps (coeff, coeff);
+            for (uint32_t j = 0; j < 2; ++j) {
+                y_lo[j] = tnr_blend_ps (y_lo[j], p_lo[j], c_lo);
+                y_hi[j] = tnr_blend_ps (y_hi[j], p_hi[j], c_hi);
+            }
+        }
+        store_8_pixels (y_out[0] + x, y_lo[0], y_hi[0]);
+        store_8_pixels (y_out[1] + x, y_lo[1], y_hi[1]);
+
+        // macc, sector lookup is a gather, done per sample
+        float u[4], v[4], uv[8];
+        _mm_storeu_ps (u, _mm_shuffle_ps (u_lo, u_hi, _MM_SHUFFLE (2, 0, 2, 0)));
+        _mm_storeu_ps (v, _mm_shuffle_ps (v_lo, v_hi, _MM_SHUFFLE (2, 0, 2, 0)));
+        for (uint32_t i = 0; i < 4; ++i) {
+            const float *macc = macc_lookup (_macc_table, _sector_lut, u[i], v[i]);
+            uv[i * 2] = u[i] * macc[0] + v[i] * macc[1] + SOFT_YUV_PIPE_UV_OFFSET;
+            uv[i * 2 + 1] = u[i] * macc[2] + v[i] * macc[3] + SOFT_YUV_PIPE_UV_OFFSET;
+        }
+
+        __m128 uv_lo = _mm_loadu_ps (uv);
+        __m128 uv_hi = _mm_loadu_ps (uv + 4);
+        if (uv_prev) {
+            __m128 p_lo, p_hi;
+            load_8_pixels (uv_prev + x, p_lo, p_hi);
+            uv_lo = tnr_blend_ps (uv_lo, p_lo, tnr_coeff_ps (abs_ps (_mm_sub_ps (uv_lo, p_lo)), coeff_uv));
+            uv_hi = tnr_blend_ps (uv_hi, p_hi, tnr_coeff_ps (abs_ps (_mm_sub_ps (uv_hi, p_hi)), coeff_uv));
+        }
+        store_8_pixels (uv_out + x, uv_lo, uv_hi);
+    }
+#endif
+
+    // remaining pixels, or whole line without SSE2
+    for (; x + 2 <= width; x += 2) {
+        float r_blk[2][2], g_blk[2][2], b_blk[2][2];
+        uint8_t *y_dst[2] = {y_out[0] + x, y_out[1] + x};
+        const uint8_t *y_ref[2] = {NULL, NULL};
+
+        for (uint32_t j = 0; j < 2; ++j) {
+            for (uint32_t i = 0; i < 2; ++i) {
+                r_blk[j][i] = r[j][x + i];
+                g_blk[j][i] = g[j][x + i];
+                b_blk[j][i] = b[j][x + i];
+            }
+            if (y_prev[j])
+                y_ref[j] = y_prev[j] + x;
+        }
+        process_block (
+            r_blk, g_blk, b_blk, y_dst, uv_out + x, y_ref, uv_prev ? uv_prev + x : NULL,
+            matrix, _macc_table, _sector_lut, coeff_y, coeff_uv);
+    }
+}
+
+XCamReturn
+SoftYuvPipeImageHandler::process (
+    const VideoBufferInfo &in_info, uint8_t *in_mem,
+    const VideoBufferInfo &out_info, uint8_t *out_mem)
+{
+    const uint8_t *prev_mem = NULL;
+    uint32_t width = XCAM_MIN (in_info.width, out_info.width);
+    uint32_t height = XCAM_MIN (in_info.height, out_info.height);
+
+    XCAM_FAIL_RETURN (
+        WARNING,
+        (in_info.format == XCAM_PIX_FMT_RGB48_planar || in_info.format == XCAM_PIX_FMT_RGB24_planar) &&
+        out_info.format == V4L2_PIX_FMT_NV12,
+        XCAM_RETURN_ERROR_PARAM,
+        "soft image handler(%s) unsupported format in:%s",
+        XCAM_STR (get_name ()), xcam_fourcc_to_string (in_info.format));
+    XCAM_FAIL_RETURN (
+        WARNING,
+        width % 2 == 0 && height % 2 == 0,
+        XCAM_RETURN_ERROR_PARAM,
+        "soft image handler(%s) needs even width/height, but got %dx%d",
+        XCAM_STR (get_name ()), width, height);
+
+    if (_enable_tnr_yuv && _prev_output.ptr ()) {
+        const VideoBufferInfo &prev_info = _prev_output->get_video_info ();
+        if (prev_info.width == out_info.width && prev_info.height == out_info.height &&
+                prev_info.strides[0] == out_info.strides[0] && prev_info.strides[1] == out_info.strides[1])
+            prev_mem = _prev_output->map ();
+    }
+
+    for (uint32_t line = 0; line < height; line += 2) {
+        uint8_t *y_out[2] = {
+            out_mem + out_info.offsets[0] + line * out_info.strides[0],
+            out_mem + out_info.offsets[0] + (line + 1) * out_info.strides[0]
+        };
+        uint8_t *uv_out = out_mem + out_info.offsets[1] + line / 2 * out_info.strides[1];
+        const uint8_t *y_prev[2] = {NULL, NULL};
+        const uint8_t *uv_prev = NULL;
+
+        if (prev_mem) {
+            y_prev[0] = prev_mem + out_info.offsets[0] + line * out_info.strides[0];
+            y_prev[1] = y_prev[0] + out_info.strides[0];
+            uv_prev = prev_mem + out_info.offsets[1] + line / 2 * out_info.strides[1];
+        }
+
+        if (in_info.format == XCAM_PIX_FMT_RGB48_planar) {
+            const uint16_t *rgb[3][2];
+            for (uint32_t c = 0; c < 3; ++c) {
+                rgb[c][0] = (const uint16_t *)(in_mem + in_info.offsets[c] + line * in_info.strides[c]);
+                rgb[c][1] = (const uint16_t *)(in_mem + in_info.offsets[c] + (line + 1) * in_info.strides[c]);
+            }
+            process_lines<uint16_t> (rgb[0], rgb[1], rgb[2], y_out, uv_out, y_prev, uv_prev, width, 255.0f / 65536.0f);
+        } else {
+            const uint8_t *rgb[3][2];
+            for (uint32_t c = 0; c < 3; ++c) {
+                rgb[c][0] = in_mem + in_info.offsets[c] + line * in_info.strides[c];
+                rgb[c][1] = in_mem + in_info.offsets[c] + (line + 1) * in_info.strides[c];
+            }
+            process_lines<uint8_t> (rgb[0], rgb[1], rgb[2], y_out, uv_out, y_prev, uv_prev, width, 1.0f);
+        }
+    }
+
+    if (prev_mem)
+        _prev_output->unmap ();
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+SoftYuvPipeImageHandler::post_process (SmartPtr<VideoBuffer> &output)
+{
+    if (_enable_tnr_yuv)
+        _prev_output = output;
+    return XCAM_RETURN_NO_ERROR;
+}
+
+SmartPtr<SoftImageHandler>
+create_soft_yuv_pipe_image_handler ()
+{
+    SmartPtr<SoftYuvPipeImageHandler> yuv_pipe_handler = new SoftYuvPipeImageHandler ("soft_handler_pipe_yuv");
+    // one more buffer is held as tnr reference
+    yuv_pipe_handler->set_pool_size (5);
+    return yuv_pipe_handler;
+}
+
+};
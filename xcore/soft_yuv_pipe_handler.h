@@ -0,0 +1,92 @@
+/*
+ * soft_yuv_pipe_handler.h - soft(cpu) yuv pipe handler
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#ifndef XCAM_SOFT_YUV_PIPE_HANDLER_H
+#define XCAM_SOFT_YUV_PIPE_HANDLER_H
+
+#include "xcam_utils.h"
+#include "soft_image_handler.h"
+#include "base/xcam_3a_result.h"
+
+namespace XCam {
+
+#define XCAM_SOFT_MACC_SECTOR_LUT_BITS 8
+#define XCAM_SOFT_MACC_SECTOR_LUT_SIZE (1 << (XCAM_SOFT_MACC_SECTOR_LUT_BITS * 2))
+
+/*
+ * SoftYuvPipeImageHandler, same stage as kernel_yuv_pipe on cpu
+ * input:  XCAM_PIX_FMT_RGB48_planar or XCAM_PIX_FMT_RGB24_planar
+ * output: V4L2_PIX_FMT_NV12
+ * rgb->yuv matrix, macc and yuv temporal noise reduction are fused into one pass
+ */
+class SoftYuvPipeImageHandler
+    : public SoftImageHandler
+{
+public:
+    explicit SoftYuvPipeImageHandler (const char *name);
+
+    bool set_macc_table (const XCam3aResultMaccMatrix &macc);
+    bool set_rgbtoyuv_matrix (const XCam3aResultColorMatrix &matrix);
+    bool set_tnr_yuv_config (const XCam3aResultTemporalNoiseReduction &config);
+    bool set_tnr_enable (bool enable_tnr_yuv);
+
+    //derived from SoftImageHandler
+    virtual XCamReturn apply_3a_result (SmartPtr<X3aResult> &result);
+    virtual void emit_stop ();
+
+protected:
+    //derived from SoftImageHandler
+    virtual XCamReturn prepare_buffer_pool_video_info (
+        const VideoBufferInfo &input,
+        VideoBufferInfo &output);
+    virtual XCamReturn process (
+        const VideoBufferInfo &in_info, uint8_t *in_mem,
+        const VideoBufferInfo &out_info, uint8_t *out_mem);
+    virtual XCamReturn post_process (SmartPtr<VideoBuffer> &output);
+
+private:
+    void init_sector_lut ();
+    template <typename PixelT>
+    void process_lines (
+        const PixelT *r[2], const PixelT *g[2], const PixelT *b[2],
+        uint8_t *y_out[2], uint8_t *uv_out,
+        const uint8_t *y_prev[2], const uint8_t *uv_prev,
+        uint32_t width, float in_scale);
+
+    XCAM_DEAD_COPY (SoftYuvPipeImageHandler);
+
+private:
+    float                  _macc_table[XCAM_CHROMA_AXIS_SIZE * XCAM_CHROMA_MATRIX_SIZE];
+    float                  _rgbtoyuv_matrix[XCAM_COLOR_MATRIX_SIZE];
+    // sector id of each quantized (u, v), replaces the per-pixel division of get_sector_id
+    uint8_t                _sector_lut[XCAM_SOFT_MACC_SECTOR_LUT_SIZE];
+    float                  _gain_yuv;
+    float                  _thr_y;
+    float                  _thr_uv;
+    bool                   _enable_tnr_yuv;
+    SmartPtr<VideoBuffer>  _prev_output;
+};
+
+SmartPtr<SoftImageHandler>
+create_soft_yuv_pipe_image_handler ();
+
+};
+
+#endif //XCAM_SOFT_YUV_PIPE_HANDLER_H
@@ -0,0 +1,169 @@
+/*
+ * startup_tracer.cpp - startup phase tracer and one-shot init tasks
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#include "startup_tracer.h"
+#include <pthread.h>
+
+namespace XCam {
+
+SmartPtr<StartupTracer> StartupTracer::_instance;
+Mutex StartupTracer::_instance_mutex;
+
+SmartPtr<StartupTracer>
+StartupTracer::instance ()
+{
+    SmartLock locker (_instance_mutex);
+    if (_instance.ptr ())
+        return _instance;
+
+    _instance = new StartupTracer ();
+    return _instance;
+}
+
+StartupTracer::StartupTracer ()
+    : _reported (0)
+{
+    gettimeofday (&_origin, NULL);
+    _phases.reserve (XCAM_STARTUP_MAX_PHASES);
+}
+
+double
+StartupTracer::to_ms (const struct timeval &time) const
+{
+    return (time.tv_sec - _origin.tv_sec) * 1000.0 + (time.tv_usec - _origin.tv_usec) / 1000.0;
+}
+
+void
+StartupTracer::add_phase (const char *name, const struct timeval &begin)
+{
+    StartupPhaseRecord record;
+    struct timeval end;
+
+    gettimeofday (&end, NULL);
+    xcam_mem_clear (record);
+    strncpy (record.name, name, sizeof (record.name) - 1);
+#ifdef __USE_GNU
+    pthread_getname_np (pthread_self (), record.thread, sizeof (record.thread));
+#endif
+    record.begin_ms = to_ms (begin);
+    record.duration_ms = to_ms (end) - record.begin_ms;
+
+    SmartLock locker (_mutex);
+    if (_phases.size () >= XCAM_STARTUP_MAX_PHASES)
+        return;
+    _phases.push_back (record);
+}
+
+void
+StartupTracer::report ()
+{
+    SmartLock locker (_mutex);
+    for (; _reported < _phases.size (); ++_reported) {
+        const StartupPhaseRecord &record = _phases[_reported];
+        XCAM_LOG_INFO (
+            "startup phase %-24s at %8.1fms took %7.1fms [%s]",
+            record.name, record.begin_ms, record.duration_ms, record.thread);
+    }
+}
+
+void
+StartupTracer::introspect (IntrospectionWriter &writer)
+{
+    std::vector<StartupPhaseRecord> phases;
+    {
+        SmartLock locker (_mutex);
+        phases = _phases;
+    }
+
+    writer.begin_array ("phases");
+    for (uint32_t i = 0; i < phases.size (); ++i) {
+        writer.begin_object ();
+        writer.add ("name", phases[i].name);
+        writer.add ("thread", phases[i].thread);
+        writer.add ("begin_ms", phases[i].begin_ms);
+        writer.add ("duration_ms", phases[i].duration_ms);
+        writer.end_object ();
+    }
+    writer.end_array ();
+}
+
+StartupPhase::StartupPhase (const char *name, const char *detail)
+{
+    if (detail)
+        snprintf (_name, sizeof (_name), "%s(%s)", name, detail);
+    else
+        snprintf (_name, sizeof (_name), "%s", name);
+
+    // the first phase creates the tracer, its origin
+    StartupTracer::instance ();
+    gettimeofday (&_begin, NULL);
+}
+
+StartupPhase::~StartupPhase ()
+{
+    StartupTracer::instance ()->add_phase (_name, _begin);
+}
+
+StartupTask::StartupTask (const char *name)
+    : Thread (name)
+    , _result (XCAM_RETURN_NO_ERROR)
+    , _done (false)
+{
+    snprintf (_phase_name, sizeof (_phase_name), "%s", XCAM_STR (name));
+}
+
+void
+StartupTask::launch ()
+{
+    if (start ())
+        return;
+
+    XCAM_LOG_WARNING ("startup task(%s) has no thread, run inline", _phase_name);
+    loop ();
+    stopped ();
+}
+
+bool
+StartupTask::loop ()
+{
+    StartupPhase phase (_phase_name);
+    _result = run ();
+    return false;
+}
+
+void
+StartupTask::stopped ()
+{
+    // last touch of the task from its thread
+    SmartLock locker (_done_mutex);
+    _done = true;
+    _done_cond.broadcast ();
+}
+
+XCamReturn
+StartupTask::wait ()
+{
+    SmartLock locker (_done_mutex);
+    while (!_done)
+        _done_cond.wait (_done_mutex);
+    return _result;
+}
+
+};
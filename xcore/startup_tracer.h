@@ -0,0 +1,126 @@
+/*
+ * startup_tracer.h - startup phase tracer and one-shot init tasks
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#ifndef XCAM_STARTUP_TRACER_H
+#define XCAM_STARTUP_TRACER_H
+
+#include "xcam_utils.h"
+#include "xcam_mutex.h"
+#include "xcam_thread.h"
+#include "smartptr.h"
+#include "introspection.h"
+#include <sys/time.h>
+#include <vector>
+
+#define XCAM_STARTUP_PHASE_NAME_SIZE 48
+#define XCAM_STARTUP_MAX_PHASES 64
+
+namespace XCam {
+
+struct StartupPhaseRecord {
+    char        name[XCAM_STARTUP_PHASE_NAME_SIZE];
+    char        thread[16];
+    double      begin_ms;     // since the tracer was created
+    double      duration_ms;
+};
+
+/*
+ * StartupTracer
+ * collects one-time init phases (device probing, dlopen, cpf, kernel
+ * builds) with the thread they ran on, so overlapping phases show up.
+ * report () logs the phases added since the last report.
+ */
+class StartupTracer
+    : public Introspectable
+{
+public:
+    static SmartPtr<StartupTracer> instance ();
+
+    void add_phase (const char *name, const struct timeval &begin);
+    void report ();
+
+    //derived from Introspectable
+    virtual void introspect (IntrospectionWriter &writer);
+
+private:
+    explicit StartupTracer ();
+    double to_ms (const struct timeval &time) const;
+
+    XCAM_DEAD_COPY (StartupTracer);
+
+private:
+    static SmartPtr<StartupTracer>   _instance;
+    static Mutex                     _instance_mutex;
+
+    struct timeval                   _origin;
+    std::vector<StartupPhaseRecord>  _phases;
+    uint32_t                         _reported;
+    Mutex                            _mutex;
+};
+
+// scope of one init phase, put where the one-time work is really done
+class StartupPhase
+{
+public:
+    explicit StartupPhase (const char *name, const char *detail = NULL);
+    ~StartupPhase ();
+
+private:
+    XCAM_DEAD_COPY (StartupPhase);
+
+private:
+    char             _name[XCAM_STARTUP_PHASE_NAME_SIZE];
+    struct timeval   _begin;
+};
+
+/*
+ * StartupTask, runs run () once on its own thread as a startup phase.
+ * launch () falls back to running inline if no thread can be created;
+ * wait () joins, the task may be released right after.
+ */
+class StartupTask
+    : public Thread
+{
+public:
+    explicit StartupTask (const char *name);
+
+    void launch ();
+    XCamReturn wait ();
+
+protected:
+    virtual XCamReturn run () = 0;
+
+private:
+    virtual bool loop ();
+    virtual void stopped ();
+
+    XCAM_DEAD_COPY (StartupTask);
+
+private:
+    char             _phase_name[XCAM_STARTUP_PHASE_NAME_SIZE];
+    XCamReturn       _result;
+    bool             _done;
+    Mutex            _done_mutex;
+    Cond             _done_cond;
+};
+
+};
+
+#endif //XCAM_STARTUP_TRACER_H
@@ -29,6 +29,7 @@
 #include <sys/mman.h>
 
 #include "v4l2_buffer_proxy.h"
+#include "xcam_probes.h"
 
 namespace XCam {
 
@@ -122,6 +123,8 @@ V4l2Device::set_mem_type (enum v4l2_memory type) {
         XCAM_LOG_WARNING ("device(%s) set mem type failed", XCAM_STR (_name));
         return false;
     }
+    if (type != _memory_type)
+        fini_buffer_pool ();
     _memory_type = type;
     return true;
 }
@@ -133,6 +136,8 @@ V4l2Device::set_buffer_count (uint32_t buf_count)
         XCAM_LOG_WARNING ("device(%s) set buffer count failed", XCAM_STR (_name));
         return false;
     }
+    if (buf_count != _buf_count)
+        fini_buffer_pool ();
     _buf_count = buf_count;
     return true;
 }
@@ -179,6 +184,7 @@ V4l2Device::close ()
 {
     if (!is_opened())
         return XCAM_RETURN_NO_ERROR;
+    fini_buffer_pool ();
     ::close (_fd);
     _fd = -1;
     return XCAM_RETURN_NO_ERROR;
@@ -228,6 +234,7 @@ V4l2Device::set_format (struct v4l2_format &format)
 
     struct v4l2_format tmp_format = format;
 
+    fini_buffer_pool ();
     ret = pre_set_format (format);
     if (ret != XCAM_RETURN_NO_ERROR) {
         XCAM_LOG_WARNING ("device(%s) pre_set_format failed", XCAM_STR (_name));
@@ -394,42 +401,57 @@ XCamReturn
 V4l2Device::start ()
 {
     XCamReturn ret = XCAM_RETURN_NO_ERROR;
-    // request buffer first
-    ret = request_buffer ();
-    XCAM_FAIL_RETURN (
-        ERROR, ret == XCAM_RETURN_NO_ERROR, ret,
-        "device(%s) start failed", XCAM_STR (_name));
-
-    //alloc buffers
-    ret = init_buffer_pool ();
-    XCAM_FAIL_RETURN (
-        ERROR, ret == XCAM_RETURN_NO_ERROR, ret,
-        "device(%s) start failed", XCAM_STR (_name));
-
-    //queue all buffers
-    for (uint32_t i = 0; i < _buf_count; ++i) {
-        SmartPtr<V4l2Buffer> &buf = _buf_pool [i];
-        XCAM_ASSERT (buf.ptr());
-        XCAM_ASSERT (buf->get_buf().index == i);
-        ret = queue_buffer (buf);
-        if (ret != XCAM_RETURN_NO_ERROR) {
+
+    // buffers parked by last stop are reused if format didn't change
+    if (_buf_pool.empty ()) {
+        // request buffer first
+        ret = request_buffer ();
+        XCAM_FAIL_RETURN (
+            ERROR, ret == XCAM_RETURN_NO_ERROR, ret,
+            "device(%s) start failed", XCAM_STR (_name));
+
+        //alloc buffers
+        ret = init_buffer_pool ();
+        XCAM_FAIL_RETURN (
+            ERROR, ret == XCAM_RETURN_NO_ERROR, ret,
+            "device(%s) start failed", XCAM_STR (_name));
+    }
+
+    {
+        // queue the buffers parked by stop, those still held downstream are
+        // queued by queue_buffer once they come back after stream on
+        SmartLock locker (_queue_mutex);
+        for (uint32_t i = 0; i < _buf_count; ++i) {
+            SmartPtr<V4l2Buffer> &buf = _buf_pool [i];
+            XCAM_ASSERT (buf.ptr());
+            XCAM_ASSERT (buf->get_buf().index == i);
+            if (_buf_outstanding[i])
+                continue;
+            ret = enqueue_buffer (buf);
+            if (ret != XCAM_RETURN_NO_ERROR) {
+                XCAM_LOG_ERROR (
+                    "device(%s) start failed on queue index:%d",
+                    XCAM_STR (_name), i);
+                break;
+            }
+        }
+
+        // stream on
+        if (ret == XCAM_RETURN_NO_ERROR &&
+                io_control (VIDIOC_STREAMON, &_capture_buf_type) < 0) {
             XCAM_LOG_ERROR (
-                "device(%s) start failed on queue index:%d",
-                XCAM_STR (_name), i);
-            stop ();
-            return ret;
+                "device(%s) start failed on VIDIOC_STREAMON",
+                XCAM_STR (_name));
+            ret = XCAM_RETURN_ERROR_IOCTL;
         }
+        if (ret == XCAM_RETURN_NO_ERROR)
+            _active = true;
     }
 
-    // stream on
-    if (io_control (VIDIOC_STREAMON, &_capture_buf_type) < 0) {
-        XCAM_LOG_ERROR (
-            "device(%s) start failed on VIDIOC_STREAMON",
-            XCAM_STR (_name));
+    if (ret != XCAM_RETURN_NO_ERROR) {
         stop ();
-        return XCAM_RETURN_ERROR_IOCTL;
+        return ret;
     }
-    _active = true;
     XCAM_LOG_INFO ("device(%s) started successfully", XCAM_STR (_name));
     return XCAM_RETURN_NO_ERROR;
 }
@@ -437,7 +459,8 @@ V4l2Device::start ()
 XCamReturn
 V4l2Device::stop ()
 {
-    // stream off
+    // stream off, the driver gives up every queued buffer
+    SmartLock locker (_queue_mutex);
     if (_active) {
         if (io_control (VIDIOC_STREAMOFF, &_capture_buf_type) < 0) {
             XCAM_LOG_WARNING ("device(%s) steamoff failed", XCAM_STR (_name));
@@ -445,8 +468,7 @@ V4l2Device::stop ()
         _active = false;
     }
 
-    fini_buffer_pool ();
-
+    // keep buffers for next start, released on format change or close
     XCAM_LOG_INFO ("device(%s) stopped", XCAM_STR (_name));
     return XCAM_RETURN_NO_ERROR;
 }
@@ -547,6 +569,7 @@ V4l2Device::init_buffer_pool ()
 
     _buf_pool.clear ();
     _buf_pool.reserve (_buf_count);
+    _buf_outstanding.clear ();
 
     for (; i < _buf_count; i++) {
         SmartPtr<V4l2Buffer> new_buf;
@@ -568,6 +591,7 @@ V4l2Device::init_buffer_pool ()
             XCAM_STR (_name), _buf_count, i);
         _buf_count = i;
     }
+    _buf_outstanding.assign (_buf_count, false);
 
     return XCAM_RETURN_NO_ERROR;
 }
@@ -575,7 +599,23 @@ V4l2Device::init_buffer_pool ()
 XCamReturn
 V4l2Device::fini_buffer_pool()
 {
+    struct v4l2_requestbuffers request_buf;
+
+    if (_buf_pool.empty () || is_activated ())
+        return XCAM_RETURN_NO_ERROR;
+
     _buf_pool.clear ();
+    _buf_outstanding.clear ();
+
+    // driver keeps buffers until count 0 is requested, S_FMT fails meanwhile
+    xcam_mem_clear (request_buf);
+    request_buf.type = _capture_buf_type;
+    request_buf.count = 0;
+    request_buf.memory = _memory_type;
+    if (io_control (VIDIOC_REQBUFS, &request_buf) < 0) {
+        XCAM_LOG_WARNING ("device(%s) release buffers failed", XCAM_STR (_name));
+        return XCAM_RETURN_ERROR_IOCTL;
+    }
     return XCAM_RETURN_NO_ERROR;
 }
 
@@ -601,17 +641,24 @@ V4l2Device::dequeue_buffer(SmartPtr<V4l2Buffer> &buf)
 
     XCAM_LOG_DEBUG ("device(%s) dequeue buffer index:%d", XCAM_STR (_name), v4l2_buf.index);
 
-    if (v4l2_buf.index > _buf_count) {
+    if (v4l2_buf.index >= _buf_count) {
         XCAM_LOG_ERROR (
             "device(%s) dequeue wrong buffer index:%d",
             XCAM_STR (_name), v4l2_buf.index);
         return XCAM_RETURN_ERROR_ISP;
     }
+    {
+        SmartLock locker (_queue_mutex);
+        _buf_outstanding[v4l2_buf.index] = true;
+    }
     buf = _buf_pool [v4l2_buf.index];
     buf->set_timestamp (v4l2_buf.timestamp);
     buf->set_timecode (v4l2_buf.timecode);
     buf->set_sequence (v4l2_buf.sequence);
     //buf.set_length (v4l2_buf.length); // not necessary to set length
+    XCAM_PROBE4 (
+        v4l2_dequeue, XCAM_STR (_name), v4l2_buf.index, v4l2_buf.sequence,
+        XCAM_TIMEVAL_2_USEC (v4l2_buf.timestamp));
     return XCAM_RETURN_NO_ERROR;
 }
 
@@ -619,6 +666,31 @@ XCamReturn
 V4l2Device::queue_buffer (SmartPtr<V4l2Buffer> &buf)
 {
     XCAM_ASSERT (buf.ptr());
+
+    SmartLock locker (_queue_mutex);
+    uint32_t index = buf->get_buf ().index;
+    // pool rebuilt by a format change, or already given back
+    if (index >= _buf_outstanding.size () || !_buf_outstanding[index] ||
+            _buf_pool[index].ptr () != buf.ptr ()) {
+        XCAM_LOG_DEBUG ("device(%s) drop stale buffer index:%d", XCAM_STR (_name), index);
+        return XCAM_RETURN_NO_ERROR;
+    }
+    _buf_outstanding[index] = false;
+
+    // returned after stop, parked until next start queues it
+    if (!is_activated ()) {
+        buf->reset ();
+        return XCAM_RETURN_NO_ERROR;
+    }
+
+    return enqueue_buffer (buf);
+}
+
+XCamReturn
+V4l2Device::enqueue_buffer (SmartPtr<V4l2Buffer> &buf)
+{
+    // sequence of the frame given back, reset clears it
+    XCAM_PROBE3 (v4l2_queue, XCAM_STR (_name), buf->get_buf ().index, buf->get_buf ().sequence);
     buf->reset ();
 
     struct v4l2_buffer v4l2_buf = buf->get_buf ();
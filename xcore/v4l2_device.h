@@ -23,6 +23,7 @@
 
 #include "xcam_utils.h"
 #include "smartptr.h"
+#include "xcam_mutex.h"
 #include <linux/videodev2.h>
 #include <list>
 #include <vector>
@@ -121,6 +122,7 @@ private:
     XCamReturn request_buffer ();
     XCamReturn init_buffer_pool ();
     XCamReturn fini_buffer_pool ();
+    XCamReturn enqueue_buffer (SmartPtr<V4l2Buffer> &buf);
 
     XCAM_DEAD_COPY (V4l2Device);
 
@@ -141,6 +143,9 @@ protected:
     // buffer pool
     BufferPool          _buf_pool;
     uint32_t            _buf_count;
+    // dequeued and not given back yet, start must not queue them
+    std::vector<bool>   _buf_outstanding;
+    Mutex               _queue_mutex;
 
     XCamReturn buffer_new();
     XCamReturn buffer_del();
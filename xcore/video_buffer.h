@@ -23,13 +23,14 @@
 
 #include "xcam_utils.h"
 #include "smartptr.h"
+#include "small_vector.h"
 #include "base/xcam_buffer.h"
 #include <list>
 
 namespace XCam {
 
 class VideoBuffer;
-typedef std::list<SmartPtr<VideoBuffer>>  VideoBufferList;
+typedef SmallVector<SmartPtr<VideoBuffer>>  VideoBufferList;
 
 struct VideoBufferPlanarInfo
         : XCamVideoBufferPlanarInfo
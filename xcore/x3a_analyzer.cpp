@@ -31,6 +31,8 @@ X3aAnalyzer::X3aAnalyzer (const char *name)
     , _awb_handler (NULL)
     , _af_handler (NULL)
     , _common_handler (NULL)
+    , _motion_detector (new GridMotionDetector)
+    , _motion_detection (false)
 {
 }
 
@@ -148,6 +150,15 @@ X3aAnalyzer::analyze_3a_statistics (SmartPtr<X3aStats> &stats)
         return ret;
     }
 
+    if (_motion_detection) {
+        XCam3AStats *grid_stats = stats->get_stats ();
+        SmartPtr<X3aMotionResult> motion;
+        if (grid_stats)
+            motion = _motion_detector->detect (grid_stats);
+        if (motion.ptr ())
+            results.push_back (motion);
+    }
+
     if (!results.empty ()) {
         set_results_timestamp(results, stats->get_timestamp ());
         notify_calculation_done (results);
@@ -306,6 +317,38 @@ X3aAnalyzer::set_dvs (bool enable)
     return _common_handler->set_dvs (enable);
 }
 
+bool
+X3aAnalyzer::set_motion_detection (bool enable)
+{
+    // detector created once, the stats thread never sees it swapped
+    if (enable && !_motion_detection)
+        _motion_detector->reset ();
+    _motion_detection = enable;
+    return true;
+}
+
+void
+X3aAnalyzer::introspect (IntrospectionWriter &writer)
+{
+    SmartPtr<AeHandler> ae_handler = _ae_handler;
+    SmartPtr<AwbHandler> awb_handler = _awb_handler;
+
+    XAnalyzer::introspect (writer);
+    if (ae_handler.ptr ()) {
+        writer.begin_object ("ae");
+        writer.add ("exposure_time_us", ae_handler->get_current_exposure_time ());
+        writer.add ("analog_gain", ae_handler->get_current_analog_gain ());
+        writer.add ("flicker_mode", (int32_t)ae_handler->get_flicker_mode ());
+        writer.end_object ();
+    }
+    if (awb_handler.ptr ()) {
+        writer.begin_object ("awb");
+        writer.add ("cct", awb_handler->get_current_estimate_cct ());
+        writer.end_object ();
+    }
+    writer.add ("motion_detection", _motion_detection);
+}
+
 bool
 X3aAnalyzer::set_gbce (bool enable)
 {
@@ -24,6 +24,7 @@
 #include "xcam_utils.h"
 #include "xcam_analyzer.h"
 #include "handler_interface.h"
+#include "grid_motion_detector.h"
 
 namespace XCam {
 
@@ -73,6 +74,9 @@ public:
     bool set_gbce (bool enable);
     bool set_night_mode (bool enable);
 
+    /* motion detection on 3a grids, X3aMotionResult merged into results */
+    bool set_motion_detection (bool enable);
+
     /* Picture quality */
     bool set_noise_reduction_level (double level);
     bool set_temporal_noise_reduction_level (double level);
@@ -103,6 +107,12 @@ public:
     SmartPtr<CommonHandler> get_common_handler () {
         return _common_handler;
     }
+    SmartPtr<GridMotionDetector> get_motion_detector () {
+        return _motion_detector;
+    }
+
+    //derived from XAnalyzer
+    virtual void introspect (IntrospectionWriter &writer);
 
 protected:
     /* virtual function list */
@@ -138,6 +148,8 @@ private:
     SmartPtr<AwbHandler>     _awb_handler;
     SmartPtr<AfHandler>      _af_handler;
     SmartPtr<CommonHandler>  _common_handler;
+    SmartPtr<GridMotionDetector> _motion_detector;
+    bool                     _motion_detection;
 };
 
 }
@@ -22,6 +22,8 @@
 #include "aiq_handler.h"
 #include "isp_controller.h"
 #include "xcam_cpf_reader.h"
+#include "cpf_map.h"
+#include "startup_tracer.h"
 #include "ia_types.h"
 
 namespace XCam {
@@ -36,6 +38,7 @@ private:
 
 private:
     XCamCpfBlob *_aiq_cpf;
+    SmartPtr<CpfMap> _cpf_map;
     char *_name;
 };
 
@@ -55,6 +58,19 @@ CpfReader::~CpfReader()
 
 bool CpfReader::read (ia_binary_data &binary)
 {
+    StartupPhase phase ("cpf_parse");
+    const uint8_t *data = NULL;
+    uint32_t size = 0;
+
+    // shared mapping first, a private read if the file can't be mapped
+    _cpf_map = CpfMap::open (_name);
+    if (_cpf_map.ptr () && _cpf_map->get_record (tbd_class_aiq, data, size) && size > 0) {
+        binary.data = (void *)data;
+        binary.size = size;
+        XCAM_LOG_INFO ("map cpf(%s) ok", XCAM_STR (_name));
+        return true;
+    }
+
     if (!xcam_cpf_read (_name, _aiq_cpf, NULL)) {
         XCAM_LOG_ERROR ("parse CPF(%s) failed", XCAM_STR (_name));
         return false;
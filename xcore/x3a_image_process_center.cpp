@@ -18,11 +18,34 @@
  * Author: Wind Yuan <feng.yuan@intel.com>
  */
 #include "x3a_image_process_center.h"
+#include "startup_tracer.h"
+#include <inttypes.h>
 
 namespace XCam {
 
+class ProcessorPrepareTask
+    : public StartupTask
+{
+public:
+    explicit ProcessorPrepareTask (const SmartPtr<ImageProcessor> &processor)
+        : StartupTask (processor->get_name ())
+        , _processor (processor)
+    {}
+
+protected:
+    virtual XCamReturn run () {
+        return _processor->prepare ();
+    }
+
+private:
+    SmartPtr<ImageProcessor>  _processor;
+};
+
 X3aImageProcessCenter::X3aImageProcessCenter()
     :   _callback (NULL)
+    ,   _output_node (0)
+    ,   _need_join (false)
+    ,   _delivering (false)
 {
     XCAM_LOG_DEBUG ("X3aImageProcessCenter construction");
 }
@@ -36,7 +59,7 @@ X3aImageProcessCenter::~X3aImageProcessCenter()
 bool
 X3aImageProcessCenter::set_image_callback (ImageProcessCallback *callback)
 {
-    XCAM_ASSERT (!_callback);
+    XCAM_ASSERT (!_callback || _callback == callback);
     _callback = callback;
     return true;
 }
@@ -55,6 +78,123 @@ X3aImageProcessCenter::has_processors ()
     return !_image_processors.empty();
 }
 
+void
+X3aImageProcessCenter::clear_processors ()
+{
+    _image_processors.clear ();
+}
+
+void
+X3aImageProcessCenter::introspect (IntrospectionWriter &writer)
+{
+    writer.begin_array ("processors");
+    for (ImageProcessorIter i = _image_processors.begin (); i != _image_processors.end (); ++i) {
+        writer.begin_object ();
+        (*i)->introspect (writer);
+        writer.end_object ();
+    }
+    writer.end_array ();
+
+    if (_need_join) {
+        SmartLock locker (_join_mutex);
+        writer.add ("pending_frames", (uint32_t)_pending_frames.size ());
+    }
+}
+
+int32_t
+X3aImageProcessCenter::find_node (ImageProcessor *processor) const
+{
+    for (uint32_t i = 0; i < _nodes.size (); ++i) {
+        if (_nodes[i].processor == processor)
+            return i;
+    }
+    return -1;
+}
+
+XCamReturn
+X3aImageProcessCenter::build_graph ()
+{
+    XCAM_FAIL_RETURN (
+        ERROR, _image_processors.size () <= 32, XCAM_RETURN_ERROR_PARAM,
+        "process center supports 32 processors at most");
+
+    _nodes.clear ();
+    _capture_consumers.clear ();
+    for (ImageProcessorIter i_pro = _image_processors.begin ();
+            i_pro != _image_processors.end (); ++i_pro) {
+        ImageProcessor *processor = i_pro->ptr ();
+        uint32_t index = _nodes.size ();
+        int32_t source = -1;
+
+        switch (processor->get_input_type ()) {
+        case ImageProcessor::InputPrevious:
+            source = (int32_t)index - 1;
+            break;
+        case ImageProcessor::InputProcessor:
+            source = find_node (processor->get_input_processor ());
+            XCAM_FAIL_RETURN (
+                ERROR, source >= 0, XCAM_RETURN_ERROR_PARAM,
+                "processor(%s) input processor not inserted before it", XCAM_STR (processor->get_name ()));
+            break;
+        case ImageProcessor::InputCapture:
+            break;
+        }
+
+        ProcessorNode node;
+        node.processor = processor;
+        node.leaf_mask = 0;
+        _nodes.push_back (node);
+        if (source >= 0)
+            _nodes[source].consumers.push_back (index);
+        else
+            _capture_consumers.push_back (index);
+    }
+
+    // consumers are always inserted later, leaves propagate backwards
+    uint32_t leaf_count = 0;
+    for (int32_t i = (int32_t)_nodes.size () - 1; i >= 0; --i) {
+        ProcessorNode &node = _nodes[i];
+        if (node.consumers.empty ()) {
+            node.leaf_mask = (1u << i);
+            ++leaf_count;
+        }
+        for (uint32_t c = 0; c < node.consumers.size (); ++c)
+            node.leaf_mask |= _nodes[node.consumers[c]].leaf_mask;
+    }
+    _output_node = _nodes.size () - 1;
+    _need_join = (leaf_count > 1);
+
+    XCAM_LOG_INFO (
+        "process center: %d processors, %d from capture, %d leaves",
+        (uint32_t)_nodes.size (), (uint32_t)_capture_consumers.size (), leaf_count);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+X3aImageProcessCenter::prepare ()
+{
+    std::vector<SmartPtr<StartupTask> > tasks;
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+
+    for (ImageProcessorList::iterator i_pro = _image_processors.begin ();
+            i_pro != _image_processors.end(); ++i_pro)
+    {
+        if ((*i_pro)->is_prepared ())
+            continue;
+        SmartPtr<StartupTask> task = new ProcessorPrepareTask (*i_pro);
+        task->launch ();
+        tasks.push_back (task);
+    }
+
+    for (uint32_t i = 0; i < tasks.size (); ++i) {
+        XCamReturn task_ret = tasks[i]->wait ();
+        if (task_ret != XCAM_RETURN_NO_ERROR)
+            ret = task_ret;
+    }
+
+    return ret;
+}
+
 XCamReturn
 X3aImageProcessCenter::start ()
 {
@@ -65,6 +205,9 @@ X3aImageProcessCenter::start ()
         return XCAM_RETURN_ERROR_PARAM;
     }
 
+    ret = build_graph ();
+    XCAM_FAIL_RETURN (ERROR, ret == XCAM_RETURN_NO_ERROR, ret, "process center build processor graph failed");
+
     for (ImageProcessorList::iterator i_pro = _image_processors.begin ();
             i_pro != _image_processors.end(); ++i_pro)
     {
@@ -100,25 +243,69 @@ X3aImageProcessCenter::stop ()
 
     XCAM_LOG_INFO ("3a process center stopped");
 
-    _image_processors.clear();
+    {
+        SmartLock locker (_join_mutex);
+        _pending_frames.clear ();
+        _ready_outputs.clear ();
+    }
+    _nodes.clear ();
+    _capture_consumers.clear ();
     return XCAM_RETURN_NO_ERROR;
 }
 
+void
+X3aImageProcessCenter::push_to_consumers (const std::vector<uint32_t> &consumers, const SmartPtr<VideoBuffer> &buf)
+{
+    for (uint32_t i = 0; i < consumers.size (); ++i) {
+        const ProcessorNode &node = _nodes[consumers[i]];
+        SmartPtr<VideoBuffer> cur_buf = buf;
+        if (node.processor->push_buffer (cur_buf) == XCAM_RETURN_NO_ERROR)
+            continue;
+
+        XCAM_LOG_ERROR ("processor(%s) failed in push_buffer", XCAM_STR (node.processor->get_name ()));
+        if (_need_join)
+            join_frame (buf, node.leaf_mask, false);
+    }
+}
+
 bool
 X3aImageProcessCenter::put_buffer (SmartPtr<VideoBuffer> &buf)
 {
-    XCAM_ASSERT (!_image_processors.empty());
-    if (_image_processors.empty())
+    XCAM_ASSERT (!_capture_consumers.empty());
+    if (_capture_consumers.empty())
         return false;
 
-    ImageProcessorList::iterator i_pro = _image_processors.begin ();
-    SmartPtr<ImageProcessor> &processor = *i_pro;
-    if (processor->push_buffer (buf) != XCAM_RETURN_NO_ERROR)
-        return false;
+    if (_need_join) {
+        {
+            SmartLock locker (_join_mutex);
+            collect_ready_frames (_pending_frames.size () >= XCAM_PROCESS_CENTER_MAX_PENDING);
+
+            PendingFrame frame;
+            struct timeval now;
+            gettimeofday (&now, NULL);
+            frame.timestamp = buf->get_timestamp ();
+            frame.queued_us = XCAM_TIMEVAL_2_USEC (now);
+            frame.waiting_mask = 0;
+            for (uint32_t i = 0; i < _capture_consumers.size (); ++i)
+                frame.waiting_mask |= _nodes[_capture_consumers[i]].leaf_mask;
+            _pending_frames.push_back (frame);
+        }
+        deliver_ready_frames ();
+    }
+
+    if (_capture_consumers.size () == 1) {
+        if (_nodes[_capture_consumers[0]].processor->push_buffer (buf) != XCAM_RETURN_NO_ERROR) {
+            if (_need_join)
+                join_frame (buf, _nodes[_capture_consumers[0]].leaf_mask, false);
+            return false;
+        }
+        return true;
+    }
+
+    push_to_consumers (_capture_consumers, buf);
     return true;
 }
 
-
 XCamReturn
 X3aImageProcessCenter::put_3a_results (X3aResultList &results)
 {
@@ -181,31 +368,108 @@ X3aImageProcessCenter::put_3a_result (SmartPtr<X3aResult> &result)
 }
 
 void
-X3aImageProcessCenter::process_buffer_done (ImageProcessor *processor, const SmartPtr<VideoBuffer> &buf)
+X3aImageProcessCenter::join_frame (const SmartPtr<VideoBuffer> &buf, uint32_t mask, bool is_output)
 {
-    ImageProcessorIter i_pro = _image_processors.begin();
-    for (; i_pro != _image_processors.end(); ++i_pro)
+    int64_t timestamp = buf->get_timestamp ();
+
     {
-        SmartPtr<ImageProcessor> &cur_pro = *i_pro;
-        XCAM_ASSERT (cur_pro.ptr());
-        if (cur_pro.ptr() == processor)
-            break;
+        SmartLock locker (_join_mutex);
+        PendingFrameList::iterator i_frame = _pending_frames.begin ();
+        for (; i_frame != _pending_frames.end (); ++i_frame) {
+            if (i_frame->timestamp == timestamp && (i_frame->waiting_mask & mask))
+                break;
+        }
+        if (i_frame == _pending_frames.end ()) {
+            XCAM_LOG_DEBUG ("process center: frame(ts:%" PRId64 ") finished after forced out", timestamp);
+            return;
+        }
+
+        i_frame->waiting_mask &= ~mask;
+        if (is_output)
+            i_frame->output = buf;
+        collect_ready_frames (false);
+    }
+    deliver_ready_frames ();
+}
+
+// _join_mutex held, moves finished frames in capture order to _ready_outputs
+void
+X3aImageProcessCenter::collect_ready_frames (bool force_oldest)
+{
+    struct timeval now;
+    gettimeofday (&now, NULL);
+    int64_t expire_us = XCAM_TIMEVAL_2_USEC (now) - XCAM_PROCESS_CENTER_JOIN_TIMEOUT * 1000LL;
+
+    while (!_pending_frames.empty ()) {
+        PendingFrame &frame = _pending_frames.front ();
+        if (frame.waiting_mask) {
+            bool expired = (frame.queued_us < expire_us);
+            if (!force_oldest && !expired)
+                break;
+            XCAM_LOG_WARNING (
+                "process center: frame(ts:%" PRId64 ") %s, branches(mask:0x%x) not done",
+                frame.timestamp, expired ? "timed out" : "forced out", frame.waiting_mask);
+            if (!expired)
+                force_oldest = false;
+        }
+
+        if (frame.output.ptr ())
+            _ready_outputs.push_back (frame.output);
+        _pending_frames.pop_front ();
+    }
+}
+
+// callback runs without _join_mutex; a single thread drains at a time so
+// frames collected by other branch threads still go out in capture order
+void
+X3aImageProcessCenter::deliver_ready_frames ()
+{
+    ImageProcessor *output_processor = _nodes[_output_node].processor;
+    ReadyBufferList ready;
+
+    {
+        SmartLock locker (_join_mutex);
+        if (_delivering || _ready_outputs.empty ())
+            return;
+        _delivering = true;
+        ready.swap (_ready_outputs);
+    }
+
+    while (!ready.empty ()) {
+        for (ReadyBufferList::iterator i = ready.begin (); i != ready.end (); ++i) {
+            if (_callback)
+                _callback->process_buffer_done (output_processor, *i);
+            else
+                ImageProcessCallback::process_buffer_done (output_processor, *i);
+        }
+        ready.clear ();
+
+        SmartLock locker (_join_mutex);
+        ready.swap (_ready_outputs);
+        if (ready.empty ())
+            _delivering = false;
     }
+}
+
+void
+X3aImageProcessCenter::process_buffer_done (ImageProcessor *processor, const SmartPtr<VideoBuffer> &buf)
+{
+    int32_t index = find_node (processor);
 
-    XCAM_ASSERT (i_pro != _image_processors.end());
-    if (i_pro == _image_processors.end()) {
+    XCAM_ASSERT (index >= 0);
+    if (index < 0) {
         XCAM_LOG_ERROR ("processor doesn't found from list of image center");
         return;
     }
 
-    if (++i_pro != _image_processors.end()) {
-        SmartPtr<ImageProcessor> &next_processor = *i_pro;
-        SmartPtr<VideoBuffer> cur_buf = buf;
-        XCAM_ASSERT (next_processor.ptr());
-        XCamReturn ret = next_processor->push_buffer (cur_buf);
-        if (ret != XCAM_RETURN_NO_ERROR) {
-            XCAM_LOG_ERROR ("processor(%s) failed in push_buffer", next_processor->get_name());
-        }
+    const ProcessorNode &node = _nodes[index];
+    if (!node.consumers.empty ()) {
+        push_to_consumers (node.consumers, buf);
+        return;
+    }
+
+    if (_need_join) {
+        join_frame (buf, node.leaf_mask, (uint32_t)index == _output_node);
         return;
     }
 
@@ -223,6 +487,24 @@ X3aImageProcessCenter::process_buffer_failed (ImageProcessor *processor, const S
         _callback->process_buffer_failed(processor, buf);
     else
         ImageProcessCallback::process_buffer_failed (processor, buf);
+
+    // frame never reaches leaves below the failed processor
+    int32_t index = find_node (processor);
+    if (_need_join && index >= 0)
+        join_frame (buf, _nodes[index].leaf_mask, false);
+}
+
+void
+X3aImageProcessCenter::process_buffer_dropped (ImageProcessor *processor, const SmartPtr<VideoBuffer> &buf)
+{
+    if (_callback)
+        _callback->process_buffer_dropped (processor, buf);
+    else
+        ImageProcessCallback::process_buffer_dropped (processor, buf);
+
+    int32_t index = find_node (processor);
+    if (_need_join && index >= 0)
+        join_frame (buf, _nodes[index].leaf_mask, false);
 }
 
 void
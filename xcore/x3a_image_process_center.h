@@ -23,22 +23,59 @@
 
 #include "xcam_utils.h"
 #include "image_processor.h"
+#include <vector>
+
+// frames waiting for side branches before the oldest is forced out
+#define XCAM_PROCESS_CENTER_MAX_PENDING 8
+// a frame no branch reported on for this long is forced out, ms
+#define XCAM_PROCESS_CENTER_JOIN_TIMEOUT 500
 
 namespace XCam {
 
+/*
+ * X3aImageProcessCenter
+ * processors form a tree by their input type, by default a chain in
+ * insertion order. Each frame is pushed to all processors of the same
+ * input at once, so independent branches run in parallel. The output of
+ * the last inserted processor goes to the callback, in capture order,
+ * after every branch finished that frame; other leaf outputs are dropped.
+ * Branches report failed and dropped frames so the join doesn't wait for
+ * them; a frame lost without a report is forced out after
+ * XCAM_PROCESS_CENTER_JOIN_TIMEOUT, checked as later frames come in.
+ */
 class X3aImageProcessCenter
     : public ImageProcessCallback
 {
     typedef std::list<SmartPtr<ImageProcessor> > ImageProcessorList;
     typedef std::list<SmartPtr<ImageProcessor> >::iterator ImageProcessorIter;
+
+    struct ProcessorNode {
+        ImageProcessor          *processor;
+        std::vector<uint32_t>    consumers;
+        uint32_t                 leaf_mask;  // leaves fed by this node
+    };
+
+    struct PendingFrame {
+        int64_t                  timestamp;
+        uint32_t                 waiting_mask;
+        int64_t                  queued_us;
+        SmartPtr<VideoBuffer>    output;
+    };
+    typedef std::list<PendingFrame> PendingFrameList;
+    typedef std::list<SmartPtr<VideoBuffer> > ReadyBufferList;
+
 public:
     explicit X3aImageProcessCenter();
     ~X3aImageProcessCenter();
 
     bool insert_processor (SmartPtr<ImageProcessor> &processor);
     bool has_processors ();
+    // processors are kept across stop/start until cleared
+    void clear_processors ();
     bool set_image_callback (ImageProcessCallback *callback);
 
+    // prepares processors not done yet in parallel, one thread each
+    XCamReturn prepare ();
     XCamReturn start ();
     XCamReturn stop ();
 
@@ -47,17 +84,38 @@ public:
     XCamReturn put_3a_results (X3aResultList &results);
     XCamReturn put_3a_result (SmartPtr<X3aResult> &result);
 
+    void introspect (IntrospectionWriter &writer);
+
     //derived from ImageProcessCallback
     virtual void process_buffer_done (ImageProcessor *processor, const SmartPtr<VideoBuffer> &buf);
     virtual void process_buffer_failed (ImageProcessor *processor, const SmartPtr<VideoBuffer> &buf);
+    virtual void process_buffer_dropped (ImageProcessor *processor, const SmartPtr<VideoBuffer> &buf);
     virtual void process_image_result_done (ImageProcessor *processor, const SmartPtr<X3aResult> &result);
 
 private:
+    XCamReturn build_graph ();
+    int32_t find_node (ImageProcessor *processor) const;
+    void push_to_consumers (const std::vector<uint32_t> &consumers, const SmartPtr<VideoBuffer> &buf);
+    void join_frame (const SmartPtr<VideoBuffer> &buf, uint32_t mask, bool is_output);
+    void collect_ready_frames (bool force_oldest);
+    void deliver_ready_frames ();
+
     XCAM_DEAD_COPY (X3aImageProcessCenter);
 
 private:
     ImageProcessorList             _image_processors;
     ImageProcessCallback          *_callback;
+
+    // built on start, fixed while running
+    std::vector<ProcessorNode>     _nodes;
+    std::vector<uint32_t>          _capture_consumers;
+    uint32_t                       _output_node;
+    bool                           _need_join;
+
+    Mutex                          _join_mutex;
+    PendingFrameList               _pending_frames;
+    ReadyBufferList                _ready_outputs;
+    bool                           _delivering;
 };
 
 };
@@ -29,11 +29,40 @@ x3a_list_remove_result (X3aResultList &list, uint32_t type)
         SmartPtr<X3aResult> &result = *i;
         XCAM_ASSERT (result.ptr ());
         if (result->get_type () == type) {
-            list.erase (i++);
+            i = list.erase (i);
             continue;
         }
         ++i;
     }
 }
 
+X3aMotionResult::X3aMotionResult (uint32_t grid_width, uint32_t grid_height)
+    : X3aResult (XCAM_3A_RESULT_MOTION_DETECTION, XCAM_IMAGE_PROCESS_POST)
+    , _data (sizeof (XCamMotionResult) + grid_width * grid_height, 0)
+{
+    XCamMotionResult &result = get_standard_result ();
+
+    set_ptr ((void*)&result);
+    result.head.type = XCAM_3A_RESULT_MOTION_DETECTION;
+    result.head.process_type = _process_type;
+    result.head.version = XCAM_VERSION;
+    result.grid_width = grid_width;
+    result.grid_height = grid_height;
+    result.event = XCAM_MOTION_EVENT_NONE;
+}
+
+uint8_t
+X3aMotionResult::get_motion_level (uint32_t x, uint32_t y) const
+{
+    const XCamMotionResult &result = get_standard_result ();
+    if (!result.grid_pixel_size)
+        return 0;
+
+    uint32_t grid_x = x / result.grid_pixel_size;
+    uint32_t grid_y = y / result.grid_pixel_size;
+    if (grid_x >= result.grid_width || grid_y >= result.grid_height)
+        return 0;
+    return result.mask[grid_y * result.grid_width + grid_x];
+}
+
 };
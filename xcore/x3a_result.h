@@ -23,8 +23,11 @@
 
 #include "xcam_utils.h"
 #include "smartptr.h"
+#include "small_vector.h"
 #include <base/xcam_3a_result.h>
+#include <base/xcam_smart_result.h>
 #include <list>
+#include <vector>
 
 namespace XCam {
 
@@ -91,7 +94,7 @@ protected:
     bool                  _processed;
 };
 
-typedef std::list<SmartPtr<X3aResult>>  X3aResultList;
+typedef SmallVector<SmartPtr<X3aResult>>  X3aResultList;
 
 void x3a_list_remove_result (X3aResultList &list, uint32_t type);
 
@@ -146,6 +149,29 @@ typedef X3aStandardResultT<XCam3aResultBayerNoiseReduction> X3aBayerNoiseReducti
 typedef X3aStandardResultT<XCam3aResultBrightness>      X3aBrightnessResult;
 typedef X3aStandardResultT<XCam3aResultTemporalNoiseReduction> X3aTemporalNoiseReduction;
 typedef X3aStandardResultT<XCam3aResultWaveletNoiseReduction> X3aWaveletNoiseReduction;
+
+/* !
+ * motion mask of 3a statistics grids, variable size
+ */
+class X3aMotionResult
+    : public X3aResult
+{
+public:
+    explicit X3aMotionResult (uint32_t grid_width, uint32_t grid_height);
+    ~X3aMotionResult () {}
+
+    XCamMotionResult &get_standard_result () {
+        return *(XCamMotionResult *)(&_data[0]);
+    }
+    const XCamMotionResult &get_standard_result () const {
+        return *(const XCamMotionResult *)(&_data[0]);
+    }
+    // motion level of the grid covering pixel (x, y), 0 still
+    uint8_t get_motion_level (uint32_t x, uint32_t y) const;
+
+private:
+    std::vector<uint8_t>  _data;
+};
 };
 
 #endif //XCAM_3A_RESULT_H
@@ -133,6 +133,9 @@ X3aResultFactory::create_3a_result (XCam3aResultHead *from)
     case XCAM_3A_RESULT_WAVELET_NOISE_REDUCTION:
         result = create_wavelet_noise_reduction ((XCam3aResultWaveletNoiseReduction*)from);
         break;
+    case XCAM_3A_RESULT_MOTION_DETECTION:
+        result = create_motion_detection ((XCamMotionResult*)from);
+        break;
     default:
         XCAM_LOG_WARNING ("create 3a result with unknow result type:%d", type);
         break;
@@ -266,6 +269,25 @@ X3aResultFactory::create_wavelet_noise_reduction (XCam3aResultWaveletNoiseReduct
 {
     XCAM_3A_RESULT_FACTORY (X3aWaveletNoiseReduction, XCAM_3A_RESULT_WAVELET_NOISE_REDUCTION, from);
 }
+
+SmartPtr<X3aMotionResult>
+X3aResultFactory::create_motion_detection (XCamMotionResult *from)
+{
+    XCAM_ASSERT (from);
+    XCAM_FAIL_RETURN (
+        WARNING,
+        from && xcam_3a_result_type (from) == XCAM_3A_RESULT_MOTION_DETECTION,
+        NULL,
+        "create motion detection result from wrong type");
+
+    X3aMotionResult *ret = new X3aMotionResult (from->grid_width, from->grid_height);
+    XCamMotionResult &result = ret->get_standard_result ();
+    result.grid_pixel_size = from->grid_pixel_size;
+    result.motion_grids = from->motion_grids;
+    result.event = from->event;
+    memcpy (result.mask, from->mask, from->grid_width * from->grid_height);
+    return ret;
+}
 };
 
 
@@ -57,6 +57,7 @@ public:
     SmartPtr<X3aBayerNoiseReduction> create_bayer_noise_reduction (XCam3aResultBayerNoiseReduction *from = NULL);
     SmartPtr<X3aBrightnessResult> create_brightness (XCam3aResultBrightness *from = NULL);
     SmartPtr<X3aWaveletNoiseReduction> create_wavelet_noise_reduction (XCam3aResultWaveletNoiseReduction *from = NULL);
+    SmartPtr<X3aMotionResult> create_motion_detection (XCamMotionResult *from);
 protected:
     explicit X3aResultFactory ();
 
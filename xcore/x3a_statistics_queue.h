@@ -82,6 +82,9 @@ public:
     ~X3aStatisticsQueue();
 
     void set_grid_info (const struct atomisp_grid_info &info);
+    const struct atomisp_grid_info &get_grid_info () const {
+        return _grid_info;
+    }
 
 protected:
     virtual bool fixate_video_info (VideoBufferInfo &info);
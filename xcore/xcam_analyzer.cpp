@@ -22,6 +22,7 @@
 
 #include "xcam_analyzer.h"
 #include "x3a_stats_pool.h"
+#include "perf_counters.h"
 
 namespace XCam {
 
@@ -73,7 +74,7 @@ AnalyzerThread::loop ()
     //    XCAM_LOG_WARNING ("lost 3a stats since 3a analyzer too slow");
     //}
 
-    XCamReturn ret = _analyzer->analyze (stats);
+    XCamReturn ret = _analyzer->timed_analyze (stats);
     if (ret == XCAM_RETURN_NO_ERROR || ret == XCAM_RETURN_BYPASS)
         return true;
 
@@ -130,7 +131,7 @@ XAnalyzer::~XAnalyzer()
 bool
 XAnalyzer::set_results_callback (AnalyzerCallback *callback)
 {
-    XCAM_ASSERT (!_callback);
+    XCAM_ASSERT (!_callback || _callback == callback);
     _callback = callback;
     return true;
 }
@@ -201,6 +202,7 @@ XAnalyzer::start ()
             return ret;
         }
     } else {
+        _analyzer_thread->triger_start ();
         if (_analyzer_thread->start () == false) {
             XCAM_LOG_WARNING ("analyzer thread start failed");
             stop ();
@@ -234,7 +236,7 @@ XAnalyzer::push_buffer (const SmartPtr<BufferProxy> &buffer)
 
     if (get_sync_mode ()) {
         SmartPtr<BufferProxy> data = buffer;
-        ret = analyze (data);
+        ret = timed_analyze (data);
     }
     else {
         if (!_analyzer_thread->is_running())
@@ -247,6 +249,34 @@ XAnalyzer::push_buffer (const SmartPtr<BufferProxy> &buffer)
     return ret;
 }
 
+XCamReturn
+XAnalyzer::timed_analyze (SmartPtr<BufferProxy> &buffer)
+{
+    struct timeval start;
+    gettimeofday (&start, NULL);
+
+    PerfStage perf_stage ("analyzer", XCAM_STR (_name));
+    XCamReturn ret = analyze (buffer);
+    _analyze_duration.add (start);
+    return ret;
+}
+
+void
+XAnalyzer::introspect (IntrospectionWriter &writer)
+{
+    writer.add ("name", XCAM_STR (_name));
+    writer.add ("sync", _sync);
+    writer.add ("running", _started);
+    writer.add ("width", _width);
+    writer.add ("height", _height);
+    writer.add ("framerate", _framerate);
+    if (!_sync && _analyzer_thread.ptr ())
+        writer.add ("stats_queue", _analyzer_thread->get_queue_size ());
+    writer.begin_object ("analyze");
+    _analyze_duration.introspect (writer);
+    writer.end_object ();
+}
+
 void
 XAnalyzer::set_results_timestamp (X3aResultList &results, int64_t timestamp)
 {
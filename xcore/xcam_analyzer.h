@@ -26,6 +26,7 @@
 #include "handler_interface.h"
 #include "xcam_thread.h"
 #include "buffer_pool.h"
+#include "introspection.h"
 
 namespace XCam {
 
@@ -38,10 +39,16 @@ public:
     AnalyzerThread (XAnalyzer *analyzer);
     ~AnalyzerThread ();
 
+    void triger_start () {
+        _stats_queue.resume_pop ();
+    }
     void triger_stop() {
         _stats_queue.pause_pop ();
     }
     bool push_stats (const SmartPtr<BufferProxy> &buffer);
+    uint32_t get_queue_size () {
+        return _stats_queue.size ();
+    }
 
 protected:
     virtual bool started ();
@@ -68,7 +75,9 @@ private:
 
 class AnalyzerThread;
 
-class XAnalyzer {
+class XAnalyzer
+    : public Introspectable
+{
     friend class AnalyzerThread;
 public:
     explicit XAnalyzer (const char *name = NULL);
@@ -103,6 +112,9 @@ public:
         return _name;
     }
 
+    //derived from Introspectable
+    virtual void introspect (IntrospectionWriter &writer);
+
 protected:
     /* virtual function list */
     virtual XCamReturn create_handlers () = 0;
@@ -121,6 +133,8 @@ protected:
 
 private:
 
+    XCamReturn timed_analyze (SmartPtr<BufferProxy> &buffer);
+
     XCAM_DEAD_COPY (XAnalyzer);
 
 protected:
@@ -134,6 +148,7 @@ private:
     uint32_t                 _height;
     double                   _framerate;
     AnalyzerCallback        *_callback;
+    DurationStats            _analyze_duration;
 };
 
 }
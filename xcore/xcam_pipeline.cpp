@@ -0,0 +1,790 @@
+/*
+ * xcam_pipeline.cpp - frame-at-a-time processing pipeline, C interface
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#include <base/xcam_pipeline.h>
+#include "xcam_utils.h"
+#include "xcam_thread.h"
+#include "x3a_image_process_center.h"
+#include "soft_image_processor.h"
+#include "soft_csc_handler.h"
+#include "soft_yuv_pipe_handler.h"
+#include "soft_lut3d_handler.h"
+#include "soft_lab_handler.h"
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <algorithm>
+#include <map>
+#include <vector>
+
+// completion thread wakes up this often to check for stop
+#define XCAM_PIPELINE_COMPLETION_WAIT_US 100000
+
+namespace XCam {
+
+static const char *pipeline_stage_names[] = {
+    "pipeline_csc",
+    "pipeline_yuv_pipe",
+    "pipeline_lut3d",
+    "pipeline_lab",
+    "pipeline_hdr_lab",
+};
+
+/*
+ * caller frame as VideoBuffer, no copy. Its timestamp is the pipeline key
+ * of the frame; dma-buf frames are mapped on first map and stay mapped
+ * until the buffer is released.
+ */
+class PipelineInputBuffer
+    : public VideoBuffer
+{
+public:
+    explicit PipelineInputBuffer (const VideoBufferInfo &info, const XCamFrame &frame, int64_t key)
+        : VideoBuffer (info, key)
+        , _data (frame.data)
+        , _dma_fd (frame.data ? -1 : frame.dma_fd)
+        , _mapped (NULL)
+    {}
+    ~PipelineInputBuffer () {
+        if (_mapped)
+            munmap (_mapped, get_size ());
+    }
+
+    //derived from VideoBuffer
+    virtual uint8_t *map ();
+    virtual bool unmap () {
+        return true;
+    }
+    virtual int get_fd () {
+        return _dma_fd;
+    }
+
+private:
+    XCAM_DEAD_COPY (PipelineInputBuffer);
+
+private:
+    uint8_t      *_data;
+    int           _dma_fd;
+    uint8_t      *_mapped;
+};
+
+uint8_t *
+PipelineInputBuffer::map ()
+{
+    if (_data)
+        return _data;
+    if (_mapped)
+        return _mapped;
+
+    void *ptr = mmap (NULL, get_size (), PROT_READ, MAP_SHARED, _dma_fd, 0);
+    XCAM_FAIL_RETURN (
+        WARNING, ptr != MAP_FAILED, NULL,
+        "pipeline map dma-buf(fd:%d) failed, errno:%d", _dma_fd, errno);
+    _mapped = (uint8_t *)ptr;
+    return _mapped;
+}
+
+// pipeline output handed to the caller, holds the VideoBuffer until unref
+class PipelineOutputBuffer
+    : public XCamVideoBuffer
+{
+public:
+    explicit PipelineOutputBuffer (const SmartPtr<VideoBuffer> &buf, int64_t timestamp);
+
+    static void     buf_ref (XCamVideoBuffer *data);
+    static void     buf_unref (XCamVideoBuffer *data);
+    static uint8_t *buf_map (XCamVideoBuffer *data);
+    static void     buf_unmap (XCamVideoBuffer *data);
+    static int      buf_get_fd (XCamVideoBuffer *data);
+
+private:
+    XCAM_DEAD_COPY (PipelineOutputBuffer);
+
+private:
+    RefCount                _ref;
+    SmartPtr<VideoBuffer>   _buf_ptr;
+};
+
+PipelineOutputBuffer::PipelineOutputBuffer (const SmartPtr<VideoBuffer> &buf, int64_t timestamp)
+    : _buf_ptr (buf)
+{
+    XCAM_ASSERT (buf.ptr ());
+
+    const VideoBufferInfo &video_info = buf->get_video_info ();
+    this->info = *((const XCamVideoBufferInfo*)&video_info);
+    this->mem_type = XCAM_MEM_TYPE_CPU;
+    this->timestamp = timestamp;
+
+    this->ref = PipelineOutputBuffer::buf_ref;
+    this->unref = PipelineOutputBuffer::buf_unref;
+    this->map = PipelineOutputBuffer::buf_map;
+    this->unmap = PipelineOutputBuffer::buf_unmap;
+    this->get_fd = PipelineOutputBuffer::buf_get_fd;
+}
+
+void
+PipelineOutputBuffer::buf_ref (XCamVideoBuffer *data)
+{
+    PipelineOutputBuffer *buf = (PipelineOutputBuffer*) data;
+    buf->_ref.ref ();
+}
+
+void
+PipelineOutputBuffer::buf_unref (XCamVideoBuffer *data)
+{
+    PipelineOutputBuffer *buf = (PipelineOutputBuffer*) data;
+    if (!buf->_ref.unref ())
+        delete buf;
+}
+
+uint8_t *
+PipelineOutputBuffer::buf_map (XCamVideoBuffer *data)
+{
+    PipelineOutputBuffer *buf = (PipelineOutputBuffer*) data;
+    return buf->_buf_ptr->map ();
+}
+
+void
+PipelineOutputBuffer::buf_unmap (XCamVideoBuffer *data)
+{
+    PipelineOutputBuffer *buf = (PipelineOutputBuffer*) data;
+    buf->_buf_ptr->unmap ();
+}
+
+int
+PipelineOutputBuffer::buf_get_fd (XCamVideoBuffer *data)
+{
+    PipelineOutputBuffer *buf = (PipelineOutputBuffer*) data;
+    return buf->_buf_ptr->get_fd ();
+}
+
+class PipelineCompletionThread;
+
+/*
+ * PipelineContext
+ * one SoftImageProcessor per stage chained in an X3aImageProcessCenter,
+ * each stage on its own thread. Frames are keyed by submission order;
+ * the key stands in for the capture timestamp inside the processors so
+ * outputs match their cookies. Stages keep submission order, so a frame
+ * coming out of the last stage means every frame submitted before it
+ * left the pipeline too, those not reported were lost on the way. A
+ * failed or dropped frame only finishes itself, frames before it may
+ * still be in later stages. Results are released in submission order.
+ */
+class PipelineContext
+    : public ImageProcessCallback
+{
+    friend class PipelineCompletionThread;
+
+    struct InFlightFrame {
+        void                    *cookie;
+        int64_t                  timestamp;
+        bool                     finished;
+        XCamReturn               status;
+        SmartPtr<VideoBuffer>    output;
+    };
+    typedef std::map<int64_t, InFlightFrame> InFlightMap;
+    typedef std::vector<XCamFrameResult> ResultList;
+
+public:
+    explicit PipelineContext (XCamPipeline *handle, const XCamPipelineConfig &config);
+    ~PipelineContext ();
+
+    XCamReturn init ();
+    XCamReturn set_callback (XCamPipelineCallback callback, void *user_data);
+    XCamReturn start ();
+    XCamReturn stop ();
+    XCamReturn submit (const XCamFrame *frames, uint32_t count, uint32_t &accepted);
+    XCamReturn drain (uint32_t timeout_us);
+    uint32_t reap (XCamFrameResult *results, uint32_t max);
+
+    int get_event_fd () const {
+        return _event_fd;
+    }
+
+    //derived from ImageProcessCallback
+    virtual void process_buffer_done (ImageProcessor *processor, const SmartPtr<VideoBuffer> &buf);
+    virtual void process_buffer_failed (ImageProcessor *processor, const SmartPtr<VideoBuffer> &buf);
+    virtual void process_buffer_dropped (ImageProcessor *processor, const SmartPtr<VideoBuffer> &buf);
+
+private:
+    bool check_frame (const XCamFrame &frame);
+    void complete_frame (int64_t key, XCamReturn status, const SmartPtr<VideoBuffer> &output);
+    void complete_all_frames ();
+    void release_finished_frames ();
+    void push_result (const InFlightFrame &frame);
+    void notify_results (bool was_empty);
+    bool deliver_results (bool wait);
+    void release_results ();
+
+    XCAM_DEAD_COPY (PipelineContext);
+
+private:
+    XCamPipeline                        *_handle;
+    XCamPipelineConfig                   _config;
+    SmartPtr<X3aImageProcessCenter>      _center;
+    XCamPipelineCallback                 _callback;
+    void                                *_user_data;
+    int                                  _event_fd;
+    bool                                 _started;
+    bool                                 _quit;
+    int64_t                              _next_key;
+
+    Mutex                                _submit_mutex;  // serializes submit with submit, start and stop
+    Mutex                                _mutex;
+    Cond                                 _results_cond;
+    Cond                                 _drain_cond;
+    InFlightMap                          _in_flight;
+    ResultList                           _results;
+    uint32_t                             _delivering;    // results in the running callback
+    SmartPtr<PipelineCompletionThread>   _completion_thread;
+    SmartPtr<PipelineCompletionThread>   _retired_thread; // stopped from its own callback
+};
+
+class PipelineCompletionThread
+    : public Thread
+{
+public:
+    explicit PipelineCompletionThread (PipelineContext *context)
+        : Thread ("pipeline_completion")
+        , _context (context)
+        , _self (0)
+    {}
+
+    bool is_current () const {
+        return pthread_equal (_self, pthread_self ());
+    }
+
+protected:
+    virtual bool started () {
+        _self = pthread_self ();
+        return Thread::started ();
+    }
+    virtual bool loop () {
+        return _context->deliver_results (true);
+    }
+
+private:
+    PipelineContext   *_context;
+    pthread_t          _self;
+};
+
+PipelineContext::PipelineContext (XCamPipeline *handle, const XCamPipelineConfig &config)
+    : _handle (handle)
+    , _config (config)
+    , _callback (NULL)
+    , _user_data (NULL)
+    , _event_fd (-1)
+    , _started (false)
+    , _quit (false)
+    , _next_key (1)
+    , _delivering (0)
+{
+    if (!_config.max_in_flight)
+        _config.max_in_flight = XCAM_PIPELINE_DEFAULT_IN_FLIGHT;
+}
+
+PipelineContext::~PipelineContext ()
+{
+    stop ();
+    if (_retired_thread.ptr ())
+        _retired_thread->stop ();
+    release_results ();
+    if (_event_fd >= 0)
+        close (_event_fd);
+}
+
+XCamReturn
+PipelineContext::init ()
+{
+    _event_fd = eventfd (0, EFD_NONBLOCK | EFD_CLOEXEC);
+    XCAM_FAIL_RETURN (
+        WARNING, _event_fd >= 0, XCAM_RETURN_ERROR_UNKNOWN,
+        "pipeline create eventfd failed, errno:%d", errno);
+
+    _center = new X3aImageProcessCenter ();
+    for (uint32_t i = 0; i < _config.stage_count; ++i) {
+        SmartPtr<SoftImageHandler> handler;
+
+        switch (_config.stages[i]) {
+        case XCAM_PIPELINE_STAGE_CSC:
+            handler = create_soft_csc_image_handler ();
+            break;
+        case XCAM_PIPELINE_STAGE_YUV_PIPE:
+            handler = create_soft_yuv_pipe_image_handler ();
+            break;
+        case XCAM_PIPELINE_STAGE_LUT3D:
+            handler = create_soft_lut3d_image_handler ();
+            break;
+        case XCAM_PIPELINE_STAGE_LAB:
+            handler = create_soft_lab_image_handler (SoftLabCsc);
+            break;
+        case XCAM_PIPELINE_STAGE_HDR_LAB:
+            handler = create_soft_lab_image_handler (SoftLabHdr);
+            break;
+        default:
+            XCAM_LOG_WARNING ("pipeline stage(%d) unknown", _config.stages[i]);
+            return XCAM_RETURN_ERROR_PARAM;
+        }
+        XCAM_FAIL_RETURN (
+            WARNING, handler.ptr (), XCAM_RETURN_ERROR_MEM,
+            "pipeline create handler of stage(%s) failed", pipeline_stage_names[_config.stages[i]]);
+        // frames in flight and results not reaped yet hold an output each
+        handler->set_pool_size (_config.max_in_flight);
+
+        SmartPtr<SoftImageProcessor> soft_processor =
+            new SoftImageProcessor (pipeline_stage_names[_config.stages[i]]);
+        soft_processor->add_handler (handler);
+        SmartPtr<ImageProcessor> processor = soft_processor;
+        _center->insert_processor (processor);
+    }
+    _center->set_image_callback (this);
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+PipelineContext::set_callback (XCamPipelineCallback callback, void *user_data)
+{
+    SmartLock locker (_mutex);
+    XCAM_FAIL_RETURN (
+        WARNING, !_started, XCAM_RETURN_ERROR_PARAM,
+        "pipeline callback must be set before start");
+
+    _callback = callback;
+    _user_data = user_data;
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+PipelineContext::start ()
+{
+    SmartLock submit_locker (_submit_mutex);
+    if (_started)
+        return XCAM_RETURN_NO_ERROR;
+
+    XCamReturn ret = _center->start ();
+    XCAM_FAIL_RETURN (
+        WARNING, ret == XCAM_RETURN_NO_ERROR, ret,
+        "pipeline start processors failed");
+
+    if (_retired_thread.ptr ()) {
+        // stopped from its callback, results of that stop go out first
+        _retired_thread->stop ();
+        _retired_thread.release ();
+        deliver_results (false);
+    }
+
+    if (_callback) {
+        _quit = false;
+        _completion_thread = new PipelineCompletionThread (this);
+        if (!_completion_thread->start ()) {
+            _completion_thread.release ();
+            _center->stop ();
+            XCAM_LOG_WARNING ("pipeline start completion thread failed");
+            return XCAM_RETURN_ERROR_THREAD;
+        }
+    }
+
+    SmartLock locker (_mutex);
+    _started = true;
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+PipelineContext::stop ()
+{
+    SmartPtr<PipelineCompletionThread> completion_thread;
+    {
+        SmartLock submit_locker (_submit_mutex);
+        {
+            SmartLock locker (_mutex);
+            if (!_started)
+                return XCAM_RETURN_NO_ERROR;
+            _started = false;
+        }
+
+        // no completion comes from processors once they stopped
+        _center->stop ();
+        complete_all_frames ();
+
+        completion_thread = _completion_thread;
+        _completion_thread.release ();
+    }
+
+    if (!completion_thread.ptr ())
+        return XCAM_RETURN_NO_ERROR;
+
+    // joined without _submit_mutex, a callback submitting meanwhile is refused
+    if (completion_thread->is_current ()) {
+        // stop from the callback, the thread delivers the rest until joined
+        SmartLock submit_locker (_submit_mutex);
+        _retired_thread = completion_thread;
+        return XCAM_RETURN_NO_ERROR;
+    }
+    {
+        SmartLock locker (_mutex);
+        _quit = true;
+        _results_cond.broadcast ();
+    }
+    completion_thread->stop ();
+
+    // results the thread had no time for
+    deliver_results (false);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+bool
+PipelineContext::check_frame (const XCamFrame &frame)
+{
+    XCAM_FAIL_RETURN (
+        WARNING,
+        frame.info.format && frame.info.width && frame.info.height && frame.info.size,
+        false,
+        "pipeline frame info invalid, format:%s size:%dx%d bytes:%d",
+        xcam_fourcc_to_string (frame.info.format), frame.info.width, frame.info.height, frame.info.size);
+    XCAM_FAIL_RETURN (
+        WARNING, frame.data || frame.dma_fd >= 0, false,
+        "pipeline frame has neither data nor dma-buf");
+    return true;
+}
+
+XCamReturn
+PipelineContext::submit (const XCamFrame *frames, uint32_t count, uint32_t &accepted)
+{
+    std::vector<SmartPtr<VideoBuffer> > buffers;
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+
+    accepted = 0;
+    SmartLock submit_locker (_submit_mutex);
+    {
+        SmartLock locker (_mutex);
+        XCAM_FAIL_RETURN (
+            WARNING, _started, XCAM_RETURN_ERROR_PARAM,
+            "pipeline submit before start");
+
+        // results not reaped yet still hold stage outputs
+        uint32_t held = _in_flight.size () + _results.size () + _delivering;
+        if (held >= _config.max_in_flight)
+            return XCAM_RETURN_BYPASS;
+        count = XCAM_MIN (count, _config.max_in_flight - held);
+
+        buffers.reserve (count);
+        for (uint32_t i = 0; i < count; ++i) {
+            if (!check_frame (frames[i])) {
+                ret = XCAM_RETURN_ERROR_PARAM;
+                break;
+            }
+
+            VideoBufferInfo info;
+            *((XCamVideoBufferInfo*)&info) = frames[i].info;
+            InFlightFrame &frame = _in_flight[_next_key];
+            frame.cookie = frames[i].cookie;
+            frame.timestamp = frames[i].timestamp;
+            frame.finished = false;
+            frame.status = XCAM_RETURN_NO_ERROR;
+            buffers.push_back (new PipelineInputBuffer (info, frames[i], _next_key));
+            ++_next_key;
+        }
+    }
+
+    for (; accepted < buffers.size (); ++accepted) {
+        if (!_center->put_buffer (buffers[accepted]))
+            break;
+    }
+
+    if (accepted < buffers.size ()) {
+        // the rest never entered the processors, give them back
+        SmartLock locker (_mutex);
+        _in_flight.erase (
+            _in_flight.find (buffers[accepted]->get_timestamp ()), _in_flight.end ());
+        _drain_cond.broadcast ();
+        ret = XCAM_RETURN_ERROR_UNKNOWN;
+        XCAM_LOG_WARNING ("pipeline queued %d of %d frames", accepted, (uint32_t)buffers.size ());
+    }
+
+    // frames before a failing one stay queued, accepted tells how many
+    return ret;
+}
+
+XCamReturn
+PipelineContext::drain (uint32_t timeout_us)
+{
+    SmartLock locker (_mutex);
+    while (!_in_flight.empty ()) {
+        if (!timeout_us) {
+            _drain_cond.wait (_mutex);
+        } else if (_drain_cond.timedwait (_mutex, timeout_us) == ETIMEDOUT) {
+            return XCAM_RETURN_ERROR_TIMEOUT;
+        }
+    }
+    return XCAM_RETURN_NO_ERROR;
+}
+
+void
+PipelineContext::push_result (const InFlightFrame &frame)
+{
+    XCamFrameResult result;
+    result.cookie = frame.cookie;
+    result.status = frame.status;
+    result.timestamp = frame.timestamp;
+    result.output = NULL;
+    if (frame.output.ptr ())
+        result.output = new PipelineOutputBuffer (frame.output, frame.timestamp);
+    _results.push_back (result);
+}
+
+// _mutex held, moves finished frames at the front to the results
+void
+PipelineContext::release_finished_frames ()
+{
+    bool was_empty = _results.empty ();
+    while (!_in_flight.empty () && _in_flight.begin ()->second.finished) {
+        push_result (_in_flight.begin ()->second);
+        _in_flight.erase (_in_flight.begin ());
+    }
+    notify_results (was_empty);
+}
+
+void
+PipelineContext::notify_results (bool was_empty)
+{
+    if (_callback) {
+        _results_cond.signal ();
+    } else if (was_empty && !_results.empty ()) {
+        uint64_t value = 1;
+        if (write (_event_fd, &value, sizeof (value)) != sizeof (value))
+            XCAM_LOG_WARNING ("pipeline eventfd write failed, errno:%d", errno);
+    }
+
+    if (_in_flight.empty ())
+        _drain_cond.broadcast ();
+}
+
+void
+PipelineContext::complete_frame (int64_t key, XCamReturn status, const SmartPtr<VideoBuffer> &output)
+{
+    SmartLock locker (_mutex);
+    InFlightMap::iterator found = _in_flight.find (key);
+    if (found == _in_flight.end ()) {
+        XCAM_LOG_WARNING ("pipeline got frame(%" PRId64 ") not in flight", key);
+        return;
+    }
+
+    if (status == XCAM_RETURN_NO_ERROR) {
+        // passed every stage, unfinished frames before it were lost on the way
+        for (InFlightMap::iterator i = _in_flight.begin (); i != found; ++i) {
+            if (!i->second.finished) {
+                i->second.finished = true;
+                i->second.status = XCAM_RETURN_BYPASS;
+            }
+        }
+    }
+
+    found->second.finished = true;
+    found->second.status = status;
+    found->second.output = output;
+    release_finished_frames ();
+}
+
+void
+PipelineContext::complete_all_frames ()
+{
+    SmartLock locker (_mutex);
+    for (InFlightMap::iterator i = _in_flight.begin (); i != _in_flight.end (); ++i) {
+        if (!i->second.finished) {
+            i->second.finished = true;
+            i->second.status = XCAM_RETURN_BYPASS;
+        }
+    }
+    release_finished_frames ();
+}
+
+void
+PipelineContext::process_buffer_done (ImageProcessor *processor, const SmartPtr<VideoBuffer> &buf)
+{
+    XCAM_UNUSED (processor);
+    complete_frame (buf->get_timestamp (), XCAM_RETURN_NO_ERROR, buf);
+}
+
+void
+PipelineContext::process_buffer_failed (ImageProcessor *processor, const SmartPtr<VideoBuffer> &buf)
+{
+    XCAM_LOG_WARNING (
+        "pipeline stage(%s) failed on frame(%" PRId64 ")",
+        XCAM_STR (processor->get_name ()), buf->get_timestamp ());
+    complete_frame (buf->get_timestamp (), XCAM_RETURN_ERROR_UNKNOWN, NULL);
+}
+
+void
+PipelineContext::process_buffer_dropped (ImageProcessor *processor, const SmartPtr<VideoBuffer> &buf)
+{
+    XCAM_LOG_DEBUG (
+        "pipeline stage(%s) dropped frame(%" PRId64 ")",
+        XCAM_STR (processor->get_name ()), buf->get_timestamp ());
+    complete_frame (buf->get_timestamp (), XCAM_RETURN_BYPASS, NULL);
+}
+
+// without wait delivers what is left after the completion thread stopped
+bool
+PipelineContext::deliver_results (bool wait)
+{
+    ResultList results;
+    {
+        SmartLock locker (_mutex);
+        if (_results.empty () && wait && !_quit)
+            _results_cond.timedwait (_mutex, XCAM_PIPELINE_COMPLETION_WAIT_US);
+        if (_results.empty ())
+            return true;
+        results.swap (_results);
+        _delivering = results.size ();
+    }
+
+    // one call per wake up, frames completing together come as one batch
+    _callback (_handle, &results[0], results.size (), _user_data);
+
+    SmartLock locker (_mutex);
+    _delivering = 0;
+    return true;
+}
+
+uint32_t
+PipelineContext::reap (XCamFrameResult *results, uint32_t max)
+{
+    SmartLock locker (_mutex);
+    uint32_t count = XCAM_MIN (max, (uint32_t)_results.size ());
+
+    std::copy (_results.begin (), _results.begin () + count, results);
+    _results.erase (_results.begin (), _results.begin () + count);
+
+    if (_results.empty ()) {
+        uint64_t value;
+        // nonblocking, only clears the counter
+        if (read (_event_fd, &value, sizeof (value)) < 0 && errno != EAGAIN)
+            XCAM_LOG_WARNING ("pipeline eventfd read failed, errno:%d", errno);
+    }
+    return count;
+}
+
+void
+PipelineContext::release_results ()
+{
+    SmartLock locker (_mutex);
+    for (ResultList::iterator i = _results.begin (); i != _results.end (); ++i) {
+        if (i->output)
+            xcam_video_buffer_unref (i->output);
+    }
+    _results.clear ();
+}
+
+};
+
+using namespace XCam;
+
+struct _XCamPipeline {
+    SmartPtr<PipelineContext>   context;
+};
+
+XCamPipeline *
+xcam_pipeline_create (const XCamPipelineConfig *config)
+{
+    XCAM_FAIL_RETURN (
+        WARNING,
+        config && config->stage_count && config->stage_count <= XCAM_PIPELINE_MAX_STAGES,
+        NULL,
+        "pipeline config invalid, 1 to %d stages", XCAM_PIPELINE_MAX_STAGES);
+
+    XCamPipeline *pipeline = new XCamPipeline;
+    pipeline->context = new PipelineContext (pipeline, *config);
+    if (pipeline->context->init () != XCAM_RETURN_NO_ERROR) {
+        delete pipeline;
+        return NULL;
+    }
+    return pipeline;
+}
+
+void
+xcam_pipeline_destroy (XCamPipeline *pipeline)
+{
+    delete pipeline;
+}
+
+XCamReturn
+xcam_pipeline_set_callback (XCamPipeline *pipeline, XCamPipelineCallback callback, void *user_data)
+{
+    XCAM_FAIL_RETURN (WARNING, pipeline, XCAM_RETURN_ERROR_PARAM, "pipeline is NULL");
+    return pipeline->context->set_callback (callback, user_data);
+}
+
+XCamReturn
+xcam_pipeline_start (XCamPipeline *pipeline)
+{
+    XCAM_FAIL_RETURN (WARNING, pipeline, XCAM_RETURN_ERROR_PARAM, "pipeline is NULL");
+    return pipeline->context->start ();
+}
+
+XCamReturn
+xcam_pipeline_stop (XCamPipeline *pipeline)
+{
+    XCAM_FAIL_RETURN (WARNING, pipeline, XCAM_RETURN_ERROR_PARAM, "pipeline is NULL");
+    return pipeline->context->stop ();
+}
+
+XCamReturn
+xcam_pipeline_submit (
+    XCamPipeline *pipeline, const XCamFrame *frames, uint32_t count, uint32_t *accepted)
+{
+    uint32_t queued = 0;
+
+    XCAM_FAIL_RETURN (
+        WARNING, pipeline && (frames || !count), XCAM_RETURN_ERROR_PARAM,
+        "pipeline submit with invalid parameters");
+
+    XCamReturn ret = pipeline->context->submit (frames, count, queued);
+    if (accepted)
+        *accepted = queued;
+    return ret;
+}
+
+XCamReturn
+xcam_pipeline_drain (XCamPipeline *pipeline, uint32_t timeout_us)
+{
+    XCAM_FAIL_RETURN (WARNING, pipeline, XCAM_RETURN_ERROR_PARAM, "pipeline is NULL");
+    return pipeline->context->drain (timeout_us);
+}
+
+int
+xcam_pipeline_get_event_fd (XCamPipeline *pipeline)
+{
+    XCAM_FAIL_RETURN (WARNING, pipeline, -1, "pipeline is NULL");
+    return pipeline->context->get_event_fd ();
+}
+
+uint32_t
+xcam_pipeline_reap (XCamPipeline *pipeline, XCamFrameResult *results, uint32_t max)
+{
+    XCAM_FAIL_RETURN (
+        WARNING, pipeline && (results || !max), 0,
+        "pipeline reap with invalid parameters");
+    return pipeline->context->reap (results, max);
+}
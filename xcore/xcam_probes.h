@@ -0,0 +1,88 @@
+/*
+ * xcam_probes.h - static tracepoints on frame lifecycle
+ *
+ *  Copyright (c) 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#ifndef XCAM_PROBES_H
+#define XCAM_PROBES_H
+
+#include "xcam_utils.h"
+
+/*
+ * USDT probes of provider "libxcam", listed in doc/usdt_probes.txt.
+ * Built in when configure finds <sys/sdt.h>, each one is a nop until
+ * bpftrace/perf attaches. Arguments are still evaluated, keep them to
+ * fields already at hand.
+ */
+#if HAVE_SYS_SDT_H
+#include <sys/sdt.h>
+
+#define XCAM_PROBE1(name, a1)                                   \
+    DTRACE_PROBE1 (libxcam, name, a1)
+#define XCAM_PROBE2(name, a1, a2)                               \
+    DTRACE_PROBE2 (libxcam, name, a1, a2)
+#define XCAM_PROBE3(name, a1, a2, a3)                           \
+    DTRACE_PROBE3 (libxcam, name, a1, a2, a3)
+#define XCAM_PROBE4(name, a1, a2, a3, a4)                       \
+    DTRACE_PROBE4 (libxcam, name, a1, a2, a3, a4)
+
+#else
+
+#define XCAM_PROBE1(name, a1)
+#define XCAM_PROBE2(name, a1, a2)
+#define XCAM_PROBE3(name, a1, a2, a3)
+#define XCAM_PROBE4(name, a1, a2, a3, a4)
+
+#endif
+
+namespace XCam {
+
+// handler_begin/handler_end around a handler execute scope
+class HandlerProbe
+{
+public:
+#if HAVE_SYS_SDT_H
+    explicit HandlerProbe (const char *name, int64_t timestamp)
+        : _name (name)
+        , _timestamp (timestamp)
+    {
+        XCAM_PROBE2 (handler_begin, _name, _timestamp);
+    }
+    ~HandlerProbe () {
+        XCAM_PROBE2 (handler_end, _name, _timestamp);
+    }
+#else
+    explicit HandlerProbe (const char *name, int64_t timestamp) {
+        XCAM_UNUSED (name);
+        XCAM_UNUSED (timestamp);
+    }
+#endif
+
+private:
+    XCAM_DEAD_COPY (HandlerProbe);
+
+#if HAVE_SYS_SDT_H
+private:
+    const char    *_name;
+    int64_t        _timestamp;
+#endif
+};
+
+};
+
+#endif //XCAM_PROBES_H
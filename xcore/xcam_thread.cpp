@@ -55,13 +55,8 @@ Thread::thread_func (void *user_data)
     while (true) {
         {
             SmartLock locker(thread->_mutex);
-            if (!thread->_started || ret == false) {
-                thread->_started = false;
-                thread->_thread_id = 0;
-                thread->_exit_cond.signal();
-                ret = false;
+            if (!thread->_started || ret == false)
                 break;
-            }
         }
 
         ret = thread->loop ();
@@ -69,6 +64,12 @@ Thread::thread_func (void *user_data)
 
     thread->stopped ();
 
+    // stop () may free the thread once signaled, nothing touches it after
+    SmartLock locker(thread->_mutex);
+    thread->_started = false;
+    thread->_thread_id = 0;
+    thread->_exit_cond.signal();
+
     return 0;
 }
 